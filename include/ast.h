@@ -49,8 +49,9 @@ TYM_DECLARE_MUTABLE_LIST_MK(term, struct TymTerm, struct TymTerms)
 
 struct TymAtom {
   const TymStr * predicate;
-  uint8_t arity;
+  size_t arity;
   struct TymTerm ** args;
+  bool negated; // Only body atoms (and queries) can be negated.
 };
 
 TYM_DECLARE_MUTABLE_LIST_TYPE(TymAtoms, atom, TymAtom)
@@ -58,33 +59,34 @@ TYM_DECLARE_MUTABLE_LIST_MK(atom, struct TymAtom, struct TymAtoms)
 
 struct TymClause {
   struct TymAtom * head;
-  uint8_t body_size;
+  size_t body_size;
   struct TymAtom ** body;
 };
 
 TYM_DECLARE_MUTABLE_LIST_TYPE(TymClauses, clause, TymClause)
 TYM_DECLARE_MUTABLE_LIST_MK(clause, struct TymClause, struct TymClauses)
+struct TymClauses * tym_reverse_clauses(struct TymClauses * clauses);
 
 struct TymProgram {
-  uint8_t no_clauses;
+  size_t no_clauses;
   struct TymClause ** program;
 };
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * tym_term_str(const struct TymTerm * const term, struct TymBufferInfo * dst);
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * tym_terms_str(const struct TymTerms * const terms, struct TymBufferInfo * dst);
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * tym_predicate_atom_str(const struct TymAtom * atom, struct TymBufferInfo * dst);
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * tym_atom_str(const struct TymAtom * const atom, struct TymBufferInfo * dst);
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * tym_clause_str(const struct TymClause * const clause, struct TymBufferInfo * dst);
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * tym_program_str(const struct TymProgram * const program, struct TymBufferInfo * dst);
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) tym_term_str(const struct TymTerm * const term, struct TymBufferInfo * dst);
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) tym_terms_str(const struct TymTerms * const terms, struct TymBufferInfo * dst);
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) tym_predicate_atom_str(const struct TymAtom * atom, struct TymBufferInfo * dst);
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) tym_atom_str(const struct TymAtom * const atom, struct TymBufferInfo * dst);
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) tym_clause_str(const struct TymClause * const clause, struct TymBufferInfo * dst);
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) tym_program_str(const struct TymProgram * const program, struct TymBufferInfo * dst);
 
 struct TymTerm * tym_mk_term(enum TymTermKind kind, const TymStr * identifier);
-struct TymAtom * tym_mk_atom(TymStr * predicate, uint8_t arity, struct TymTerms * args);
-struct TymClause * tym_mk_clause(struct TymAtom * head, uint8_t body_size, struct TymAtoms * body);
-struct TymProgram * tym_mk_program(uint8_t no_clauses, struct TymClauses * program);
+struct TymAtom * tym_mk_atom(TymStr * predicate, size_t arity, struct TymTerms * args);
+struct TymClause * tym_mk_clause(struct TymAtom * head, size_t body_size, struct TymAtoms * body);
+struct TymProgram * tym_mk_program(size_t no_clauses, struct TymClauses * program);
 
-TYM_DECLARE_U8_LIST_LEN(TymTerms)
-TYM_DECLARE_U8_LIST_LEN(TymAtoms)
-TYM_DECLARE_U8_LIST_LEN(TymClauses)
+TYM_DECLARE_CELL_LIST_LEN(TymTerms)
+TYM_DECLARE_CELL_LIST_LEN(TymAtoms)
+TYM_DECLARE_CELL_LIST_LEN(TymClauses)
 
 void tym_free_term(struct TymTerm * term);
 void tym_free_terms(struct TymTerms * terms);
@@ -94,9 +96,9 @@ void tym_free_clause(struct TymClause * clause);
 void tym_free_clauses(struct TymClauses * clauses);
 void tym_free_program(struct TymProgram * program);
 
-typedef struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * (*tym_x_str_t)(void *, struct TymBufferInfo * dst);
+typedef struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) (*tym_x_str_t)(void *, struct TymBufferInfo * dst);
 
-void tym_debug_out_syntax(void * x, struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * (*tym_x_str)(void *, struct TymBufferInfo * dst));
+void tym_debug_out_syntax(void * x, struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) (*tym_x_str)(void *, struct TymBufferInfo * dst));
 
 #if TYM_DEBUG
 #define TYM_DBG_SYNTAX tym_debug_out_syntax
@@ -121,8 +123,12 @@ bool tym_vars_contained(const struct TymTerm *, struct TymTerms *);
 struct TymTerms * tym_terms_difference(struct TymTerms *, struct TymTerms *);
 void tym_vars_of_atom(struct TymAtom *, struct TymTerms **);
 struct TymTerms * tym_hidden_vars_of_clause(const struct TymClause *);
+bool tym_range_restricted(const struct TymClause *);
+bool tym_ground_fact(const struct TymClause *);
+bool tym_has_negation(const struct TymClause *);
 
 TYM_DECLARE_LIST_SHALLOW_FREE(terms, , struct TymTerms)
+TYM_DECLARE_LIST_SHALLOW_FREE(clauses, , struct TymClauses)
 
 struct TymMdlValuation {
   const TymStr * var_name; // Variable identifier chosen by the user.
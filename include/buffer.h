@@ -33,6 +33,8 @@ This file: Buffer management.
 struct TymBufferInfo;
 
 struct TymBufferInfo * tym_mk_buffer(const size_t buffer_size);
+struct TymBufferInfo * tym_mk_sink_buffer(int fd, const size_t buffer_size);
+bool tym_flush_buffer(struct TymBufferInfo * buf);
 const char * tym_buffer_contents(struct TymBufferInfo * buf);
 size_t tym_buffer_len(struct TymBufferInfo * buf);
 size_t tym_buffer_size(struct TymBufferInfo * buf);
@@ -53,7 +55,7 @@ TYM_MAYBE_ERROR__ERRVAL_OF_DECL(TymBufferWriteResult, size_t, enum TymBufferErro
 TYM_MAYBE_ERROR__MKVAL_DECL(TymBufferWriteResult, size_t, enum TymBufferErrors)
 TYM_MAYBE_ERROR__MKERRVAL_DECL(TymBufferWriteResult, size_t, enum TymBufferErrors)
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * tym_buf_strcpy(struct TymBufferInfo * dst, const char * src);
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) tym_buf_strcpy(struct TymBufferInfo * dst, const char * src);
 
 void tym_buff_error_msg(void * x);
 TYM_ERROR_CHECK_DECL(TymBufferWriteResult, size_t, enum TymBufferErrors, buff_error_msg)
@@ -24,11 +24,33 @@ This file: Buffer management.
 #ifndef TYM_BUFFER_INTERNAL_H
 #define TYM_BUFFER_INTERNAL_H
 
+#include <stdbool.h>
+#include <stdlib.h>
+
+// Buffers consist of a chain of chunks, so they can grow without moving
+// what's already been written. The buffer's contents are the concatenation of
+// each chunk's first "used" bytes.
+struct TymBufferChunk {
+  struct TymBufferChunk * next;
+  struct TymBufferChunk * prev;
+  size_t size;
+  size_t used;
+  char data[];
+};
+
 struct TymBufferInfo {
-  char * buffer;
+  struct TymBufferChunk * head;
+  struct TymBufferChunk * tail; // The chunk being written to.
   size_t write_idx;
   size_t read_idx;
-  size_t buffer_size;
+  size_t buffer_size; // Total size of the chunks.
+  size_t chunk_size; // Minimum size of chunks added to the buffer.
+  // If not -1, then the buffer is a sink: chunks that have been filled are
+  // written to this file descriptor and reused, rather than kept.
+  int fd;
+  // Whether writing to fd failed, after which the sink's contents are
+  // discarded rather than written.
+  bool failed;
 };
 
 #endif /* TYM_BUFFER_INTERNAL_H */
@@ -0,0 +1,221 @@
+/*
+Copyright Nik Sultana, 2019
+
+This file is part of TYM Datalog. (https://www.github.com/niksu/tym)
+
+TYM Datalog is free software: you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License as published
+by the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+TYM Datalog is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details, a copy of which
+is included in the file called LICENSE distributed with TYM Datalog.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TYM Datalog.  If not, see <https://www.gnu.org/licenses/>.
+
+
+This file: Evaluation of Datalog programs, bottom-up (semi-naive) or top-down
+(tabled).
+*/
+
+#ifndef TYM_EVAL_H
+#define TYM_EVAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "ast.h"
+#include "hashtable.h"
+#include "string_idx.h"
+#include "symbols.h"
+
+// Beyond this many argument positions, tuples aren't indexed by the rest.
+#define TYM_EVAL_MAX_KEY 64
+
+// A relation's tuples, grouped by their values at some argument positions, so
+// that a join can go straight to the tuples that agree with the values that it
+// has for those positions. Each group is chained from its newest tuple.
+struct TymEvalIndex {
+  uint64_t positions; // One bit for each position in the key.
+  size_t * heads; // Open addressing: tuple index + 1 of a group's newest tuple, or 0 if the slot is empty.
+  size_t no_slots;
+  size_t no_keys;
+  size_t * next; // For each tuple: index + 1 of the next older tuple in its group, or 0.
+};
+
+struct TymEvalRelation {
+  const struct TymPredicate * predicate;
+  size_t arity;
+  uint32_t * tuples; // "count" tuples, each of "arity" identifiers.
+  size_t count;
+  size_t capacity;
+  // Tuples in [0, delta_lo) were known before the previous round,
+  // those in [delta_lo, delta_hi) were derived during the previous round,
+  // and those from delta_hi onwards are being derived in the current round.
+  size_t delta_lo;
+  size_t delta_hi;
+  size_t * set; // Open addressing: tuple index + 1, or 0 if the slot is empty.
+  size_t no_set_slots;
+  // The rules whose heads are about this relation are
+  // rules[first_rule, first_rule + no_rules) in the evaluator.
+  size_t first_rule;
+  size_t no_rules;
+  // The positions by which tuples are indexed are chosen from the rules'
+  // bodies, and from the calls and queries that are made.
+  struct TymEvalIndex * indexes;
+  size_t no_indexes;
+  size_t scc; // The strongly connected component that the relation is in.
+  bool complete; // Whether it holds all its tuples, not only its facts.
+};
+
+enum TymEvalSlotKind {TYM_EVAL_CONST, TYM_EVAL_BIND, TYM_EVAL_CHECK};
+
+struct TymEvalSlot {
+  enum TymEvalSlotKind kind;
+  uint32_t value; // Constant's identifier, or variable's index in the rule.
+};
+
+// NOTE "no index" for TymEvalAtom::index.
+#define TYM_EVAL_NO_INDEX SIZE_MAX
+
+struct TymEvalAtom {
+  struct TymEvalRelation * relation;
+  struct TymEvalSlot * slots;
+  // A negated atom is checked, once its variables have values, by looking its
+  // tuple up in the (complete) relation.
+  bool negated;
+  // The positions whose variables other body atoms share, by whose values
+  // the atom's tuples are split between threads (see TymEvalRule::part).
+  uint64_t join_key;
+  // The relation's index whose positions are those that are bound (to a
+  // constant, or to an earlier atom's variable) when the atom is joined.
+  size_t index;
+  // For leapfrog joins (see TymEvalRule): the atom's distinct variables, in
+  // the order in which the rule binds them, and the position of each one's
+  // first occurrence in the atom.
+  size_t no_vars;
+  uint32_t * vars;
+  size_t * columns;
+};
+
+// NOTE "no part" for TymEvalRule::part_atom: the rule's evaluation isn't split
+//      between threads, and one task does all of it.
+#define TYM_EVAL_NO_PART SIZE_MAX
+
+struct TymEvalBuffer;
+
+struct TymEvalRule {
+  struct TymEvalAtom head;
+  size_t body_size;
+  struct TymEvalAtom * body;
+  uint32_t no_vars;
+  // Whether the body is cyclic, in which case it's joined by Leapfrog
+  // Triejoin: one variable at a time, in "order", rather than one atom at a
+  // time.
+  bool leapfrog;
+  uint32_t no_order;
+  uint32_t * order;
+  uint32_t * env; // Scratch space: variables' current values.
+  uint32_t * head_tuple; // Scratch space: the tuple being derived.
+  // When a round is split between threads, each of the rule's tasks
+  // evaluates a copy of the rule (with its own scratch space) that only takes
+  // the tuples of body atom "part_atom" whose join key hashes to "part" (of
+  // "no_parts"), and that adds the tuples it derives to "out" rather than to
+  // the head's relation. Otherwise no_parts is 1 and out is NULL.
+  size_t part_atom;
+  uint32_t part;
+  uint32_t no_parts;
+  struct TymEvalBuffer * out;
+};
+
+// Marks the numbers of variables in a table's pattern, to tell them apart
+// from constants' identifiers.
+#define TYM_EVAL_VAR ((uint32_t)1 << 31)
+
+// A call that the tabled engine has made, identified up to variant by its
+// relation and a pattern that holds, for each argument, a constant's
+// identifier or TYM_EVAL_VAR plus the number of a variable (numbered in the
+// order of their first occurrence). Its answers are the relation's tuples
+// that match the pattern.
+struct TymEvalTable {
+  struct TymEvalRelation * relation;
+  uint32_t * pattern;
+  uint64_t hash;
+  struct TymEvalRelation answers;
+  size_t dfn; // The table's number, in the order in which tables were made.
+  size_t low; // The least number of an incomplete table that this one uses.
+  size_t stack_pos; // Position in the stack of incomplete tables.
+  bool complete; // Whether it has all its answers.
+  bool looped; // Whether it used the answers of an incomplete table.
+  bool seeded; // Whether its relation's facts were added to its answers.
+};
+
+struct TymEvalStream;
+
+struct TymPool;
+
+struct TymEvaluator {
+  // Constants are interned into dense identifiers, and relations are stored
+  // as flat arrays of tuples of such identifiers. The evaluator owns the
+  // strings in these sets.
+  // When TYM_STRING_TYPE is 3, strings already have dense identifiers (see
+  // tym_str_id), and the evaluator uses those for constants instead.
+#if TYM_STRING_TYPE != 3
+  struct TymStrSet dict;
+#endif
+  // Predicate names, whose identifiers index "relations".
+  struct TymStrSet predicates;
+  size_t no_relations;
+  struct TymEvalRelation * relations;
+  size_t no_rules;
+  struct TymEvalRule * rules;
+  // Identifiers of the Herbrand universe, over which we range any head
+  // variables that don't appear in a rule's body.
+  size_t universe_size;
+  uint32_t * universe;
+  // Whether each identifier less than no_in_universe is in the universe.
+  size_t no_in_universe;
+  bool * in_universe;
+  // The relations' strongly connected components, by how the rules' heads
+  // depend on their bodies, in an order in which each component only depends
+  // on those before it. Evaluating them in this order computes each relation
+  // before any rule negates it. Component c's relations are
+  // scc_relations[scc_starts[c], scc_starts[c + 1]).
+  size_t no_sccs;
+  size_t * scc_starts;
+  size_t * scc_relations;
+  size_t iterations;
+  // Over which bottom-up evaluation is split: components that don't depend on
+  // each other are evaluated at the same time, and so are the parts of
+  // rounds that are big enough. The pool is made when it's first needed.
+  unsigned no_threads;
+  struct TymPool * pool;
+  // State of the tabled engine (see tym_evaluator_tabled_query).
+  size_t no_tables;
+  size_t tables_capacity;
+  struct TymEvalTable ** tables;
+  uint32_t * table_slots; // Open addressing: table index + 1, or 0 if the slot is empty.
+  size_t no_table_slots;
+  struct TymEvalTable ** stack; // Incomplete tables, in the order they were made.
+  size_t stack_size;
+  size_t depth; // Of nested calls being solved.
+  size_t no_answers; // Of all tables, so we can tell when any of them grows.
+  struct TymEvalStream * stream; // Where the query's answers are sent.
+};
+
+struct TymEvaluator * tym_mk_evaluator(struct TymAtomDatabase * adb);
+void tym_free_evaluator(struct TymEvaluator * ev);
+void tym_evaluator_fixpoint(struct TymEvaluator * ev);
+size_t tym_evaluator_no_tuples(const struct TymEvaluator * ev);
+size_t tym_evaluator_query(struct TymEvaluator * ev, const struct TymAtom * query,
+    void (*on_answer)(struct TymMdlValuations *, void *), void * ctxt);
+void tym_evaluator_print_relations(const struct TymEvaluator * ev);
+size_t tym_evaluator_tabled_query(struct TymEvaluator * ev, const struct TymAtom * query,
+    void (*on_answer)(struct TymMdlValuations *, void *), void * ctxt);
+
+#endif /* TYM_EVAL_H */
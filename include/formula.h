@@ -39,7 +39,7 @@ extern char * TYM_UNIVERSE_TY;
 struct TymFmlaAtom {
   const TymStr * pred_name;
   const struct TymTerm * pred_const;
-  uint8_t arity;
+  size_t arity;
   struct TymTerm ** predargs;
 };
 
@@ -66,7 +66,7 @@ TYM_DECLARE_LIST_LEN(TymFmlas, , struct TymFmlas)
 TYM_DECLARE_LIST_REV(fmlas, , struct TymFmlas, )
 
 struct TymFmla * tym_mk_fmla_const(bool b);
-struct TymFmla * tym_mk_fmla_atom(const TymStr * pred_name, uint8_t arity, struct TymTerm ** predargs);
+struct TymFmla * tym_mk_fmla_atom(const TymStr * pred_name, size_t arity, struct TymTerm ** predargs);
 struct TymFmla * tym_mk_fmla_atom_varargs(const TymStr * pred_name, unsigned int arity, ...);
 struct TymFmla * tym_mk_fmla_quant(const enum TymFmlaKind quant, const TymStr * bv, struct TymFmla * body);
 struct TymFmla * tym_mk_fmla_quants(const enum TymFmlaKind quant, const struct TymTerms * const vars, struct TymFmla * body);
@@ -82,9 +82,9 @@ struct TymFmla * tym_copy_fmla(const struct TymFmla * const);
 
 struct TymFmlas * tym_mk_fmlas(unsigned int no_fmlas, ...);
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * tym_fmla_atom_str(struct TymFmlaAtom * at, struct TymBufferInfo * dst);
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * tym_fmla_quant_str(struct TymFmlaQuant * quant, struct TymBufferInfo * dst);
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * tym_fmla_str(const struct TymFmla * fmla, struct TymBufferInfo * dst);
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) tym_fmla_atom_str(struct TymFmlaAtom * at, struct TymBufferInfo * dst);
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) tym_fmla_quant_str(struct TymFmlaQuant * quant, struct TymBufferInfo * dst);
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) tym_fmla_str(const struct TymFmla * fmla, struct TymBufferInfo * dst);
 
 struct TymSymGen {
   const TymStr * prefix;
@@ -102,7 +102,7 @@ struct TymValuation {
 };
 
 size_t tym_valuation_len(const struct TymValuation * const v);
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * tym_valuation_str(struct TymValuation * v, struct TymBufferInfo * dst);
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) tym_valuation_str(struct TymValuation * v, struct TymBufferInfo * dst);
 
 bool tym_fmla_is_atom(const struct TymFmla * fmla);
 struct TymFmlaAtom * tym_fmla_as_atom(const struct TymFmla * fmla);
@@ -26,7 +26,7 @@ This file: Hashing for TYM Datalog.
 
 #include <stdint.h>
 
-#define TYM_HASH_VTYPE uint8_t
+#define TYM_HASH_VTYPE uint64_t
 
 TYM_HASH_VTYPE tym_hash_str(const char * str);
 
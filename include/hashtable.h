@@ -25,10 +25,13 @@ This file: Hash tabling for TYM Datalog.
 #define TYM_HASHTABLE_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "hash.h"
 #include "string_idx.h"
 
+// NOTE this is the initial number of buckets used by hash tables, which
+//      must be a power of 2.
 #define TYM_HASH_RANGE 256
 
 #define TYM_HVALUETYPE const TymStr *
@@ -39,19 +42,47 @@ This file: Hash tabling for TYM Datalog.
 #define TYM_HASHTABLE_CELL(typename) \
   struct TymHashTableCell_ ## typename
 
+// A cell is unoccupied if its key is NULL. We keep each key's full hash in
+// its cell, to avoid comparing keys whose hashes differ, and to avoid
+// rehashing keys when the table grows.
 #define TYM_DECL_HASHTABLE_CELL(typename, ktype, vtype) \
   TYM_HASHTABLE_CELL(typename) { \
     ktype k; \
     vtype v; \
-    TYM_HASHTABLE_CELL(typename) * next; \
+    TYM_HASH_VTYPE h; \
   };
 
+// Open addressing with linear probing. "capacity" is always a power of 2, and
+// the table is grown when it becomes more than 3/4 full.
 #define TYM_DECL_HASHTABLE(typename, ktype, vtype) \
   TYM_HASHTABLE(typename) { \
-    TYM_HASHTABLE_CELL(typename) * arr[TYM_HASH_RANGE]; \
+    TYM_HASHTABLE_CELL(typename) * arr; \
+    size_t capacity; \
+    size_t count; \
     void (*free_cell)(TYM_HASHTABLE_CELL(typename) *); \
   };
 
+// A set of strings, each of which gets a dense identifier: the number of
+// strings that were added before it. Callers can keep what they associate
+// with a string in an array indexed by its identifier. The strings are
+// borrowed, so they must outlive the set. Strings are compared by their text,
+// so this works for every TYM_STRING_TYPE. A zeroed set is empty.
+struct TymStrSet {
+  const TymStr ** strs; // Indexed by identifier.
+  TYM_HASH_VTYPE * hashes; // Indexed by identifier.
+  size_t count;
+  size_t capacity;
+  // Open addressing: identifier + 1, or 0 if the slot is empty. no_slots is
+  // a power of 2, and we keep the table at most half full.
+  uint32_t * slots;
+  size_t no_slots;
+};
+
+void tym_str_set_init(struct TymStrSet * set);
+bool tym_str_set_lookup(const struct TymStrSet * set, const TymStr * s, uint32_t * id);
+bool tym_str_set_add(struct TymStrSet * set, const TymStr * s, uint32_t * id);
+void tym_str_set_free(struct TymStrSet * set);
+
 // FIXME currently this only works if TYM_STRING_TYPE == 2.
 #if TYM_STRING_TYPE == 2
 TYM_HASHTABLE(String);
@@ -62,6 +93,7 @@ bool tym_ht_add(TYM_HASHTABLE(String) *, const char * key, TYM_HVALUETYPE value)
 TYM_HVALUETYPE tym_ht_lookup(TYM_HASHTABLE(String) *, const char * key);
 bool tym_ht_delete(TYM_HASHTABLE(String) *, const char * key);
 void tym_ht_dump(TYM_HASHTABLE(String) *);
+size_t tym_ht_count(TYM_HASHTABLE(String) *);
 void tym_ht_free(TYM_HASHTABLE(String) *);
 #endif // TYM_STRING_TYPE == 2
 
@@ -29,16 +29,23 @@ This file: Translation from formulas to Z3's API.
 
 #include "ast.h"
 #include "formula.h"
+#include "statement.h"
 #include "string_idx.h"
 #include "support.h"
 
-void tym_z3_begin(struct TymParams *);
-void tym_z3_end(void);
-enum TymSatisfiable tym_z3_satisfied(void);
-void tym_z3_check(void);
-void tym_z3_assert_smtlib2(const char * str);
+struct TymZ3Solver;
 
-void tym_z3_get_model(struct TymMdlValuations *);
-void tym_z3_print_model(void);
+struct TymZ3Solver * tym_z3_begin(struct TymParams *);
+void tym_z3_end(struct TymZ3Solver *);
+enum TymSatisfiable tym_z3_satisfied(struct TymZ3Solver *);
+void tym_z3_check(struct TymZ3Solver *);
+void tym_z3_assert_smtlib2(struct TymZ3Solver *, const char * str);
+bool tym_z3_assert_model(struct TymZ3Solver *, const struct TymModel * mdl);
+bool tym_z3_assert_fmla(struct TymZ3Solver *, const struct TymFmla * fmla);
+void tym_z3_push(struct TymZ3Solver *);
+void tym_z3_pop(struct TymZ3Solver *);
+
+void tym_z3_get_model(struct TymZ3Solver *, struct TymMdlValuations *);
+void tym_z3_print_model(struct TymZ3Solver *);
 
 #endif // TYM_INTERFACE_Z3_H
@@ -0,0 +1,46 @@
+/*
+Copyright Nik Sultana, 2019
+
+This file is part of TYM Datalog. (https://www.github.com/niksu/tym)
+
+TYM Datalog is free software: you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License as published
+by the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+TYM Datalog is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details, a copy of which
+is included in the file called LICENSE distributed with TYM Datalog.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TYM Datalog.  If not, see <https://www.gnu.org/licenses/>.
+
+
+This file: Magic-sets rewriting of programs.
+*/
+
+#ifndef TYM_MAGIC_H
+#define TYM_MAGIC_H
+
+#include <stdbool.h>
+
+#include "ast.h"
+
+// Rewrites a program into one whose evaluation only derives the facts that
+// are relevant to a query, given which of the query's arguments are bound
+// (i.e., are constants). A predicate "p" that has rules is specialised for
+// each binding pattern that it's used with, such as "bf" (the first argument
+// is bound, the second is free), into "adorned_bf_p", and its rules are
+// guarded by "magic_bf_p", which holds the bindings that are asked for.
+// Bindings are passed through rule bodies from left to right. Predicates
+// that only have facts are left as they are.
+// The rewritten query is made to "magic_query", and has the same variables
+// as the original query, so the original query can be used to print answers.
+// Clauses that the query doesn't reach are left out. If the program isn't
+// range-restricted then it's kept as it is, since leaving out constants would
+// shrink the universe over which unbound head variables range.
+bool tym_magic_program(struct TymProgram * program, const struct TymProgram * query, struct TymProgram ** magic_program, struct TymProgram ** magic_query);
+
+#endif /* TYM_MAGIC_H */
@@ -0,0 +1,36 @@
+/*
+Copyright Nik Sultana, 2019
+
+This file is part of TYM Datalog. (https://www.github.com/niksu/tym)
+
+TYM Datalog is free software: you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License as published
+by the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+TYM Datalog is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details, a copy of which
+is included in the file called LICENSE distributed with TYM Datalog.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TYM Datalog.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+This file: Module-level benchmark functions.
+*/
+
+#ifndef TYM_MODULE_BENCHMARKS_H
+#define TYM_MODULE_BENCHMARKS_H
+
+#include "string_idx.h"
+
+#if TYM_STRING_TYPE == 2 || TYM_STRING_TYPE == 3
+void tym_bench_string_idx(void);
+#endif
+void tym_bench_fmla_str(void);
+void tym_bench_model_str(void);
+
+#endif /* TYM_MODULE_BENCHMARKS_H */
@@ -24,9 +24,25 @@ This file: Module-level test functions.
 #ifndef TYM_MODULE_TESTS_H
 #define TYM_MODULE_TESTS_H
 
+#include <stddef.h>
+
+struct TymAtom;
+struct TymMdlValuations;
+
+// Helpers for the tests below.
+struct TymAtom * tym_test_atom(const char * predicate, size_t arity, ...);
+void tym_test_count_answer(struct TymMdlValuations * vals, void * ctxt);
+
 void tym_test_clause(void);
+void tym_test_symbols(void);
 void tym_test_formula(void);
 void tym_test_statement(void);
 void tym_test_clause_csyn(void);
+void tym_test_eval(void);
+void tym_test_translate(void);
+void tym_test_buffer(void);
+void tym_test_magic(void);
+void tym_test_plan(void);
+void tym_test_pool(void);
 
 #endif /* TYM_MODULE_TESTS_H */
@@ -0,0 +1,43 @@
+/*
+Copyright Nik Sultana, 2019
+
+This file is part of TYM Datalog. (https://www.github.com/niksu/tym)
+
+TYM Datalog is free software: you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License as published
+by the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+TYM Datalog is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details, a copy of which
+is included in the file called LICENSE distributed with TYM Datalog.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TYM Datalog.  If not, see <https://www.gnu.org/licenses/>.
+
+
+This file: Planning the order in which clause bodies are joined.
+*/
+
+#ifndef TYM_PLAN_H
+#define TYM_PLAN_H
+
+#include <stddef.h>
+
+#include "ast.h"
+#include "symbols.h"
+
+// Orders a clause's body atoms for joining, by filling "order" (which has
+// room for one index per body atom) with a permutation of the atoms' indices.
+// The atoms are chosen greedily: each is the one that's estimated to have
+// the fewest matches, given the variables that the atoms before it bind.
+// Estimates come from the statistics that the atom database keeps about
+// predicates: how many facts they have, and how many distinct constants
+// each argument takes. Ties are broken by the atoms' order in the clause.
+// A negated atom is put as soon as all its variables are bound, since it can
+// then only filter.
+void tym_plan_body(const struct TymClause * cl, struct TymAtomDatabase * adb, size_t * order);
+
+#endif /* TYM_PLAN_H */
@@ -0,0 +1,50 @@
+/*
+Copyright Nik Sultana, 2019
+
+This file is part of TYM Datalog. (https://www.github.com/niksu/tym)
+
+TYM Datalog is free software: you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License as published
+by the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+TYM Datalog is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details, a copy of which
+is included in the file called LICENSE distributed with TYM Datalog.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TYM Datalog.  If not, see <https://www.gnu.org/licenses/>.
+
+
+This file: A pool of threads that run tasks, balanced by work stealing.
+*/
+
+#ifndef TYM_POOL_H
+#define TYM_POOL_H
+
+#include <stddef.h>
+
+// Each of the pool's threads has a deque of tasks. A thread pushes the tasks
+// that it submits onto the bottom of its own deque, and takes tasks from the
+// bottom too, so it works on its newest tasks first. A thread whose deque is
+// empty steals from the top of another thread's deque, taking the oldest
+// (and usually biggest) tasks there. The thread that makes the pool is one of
+// its threads.
+struct TymPool;
+
+// Tasks are submitted in a group, whose tasks can be waited for. A thread that
+// waits runs tasks in the meantime, so a task can submit tasks and wait for
+// them.
+struct TymPoolGroup {
+  size_t pending; // Tasks that were submitted but haven't finished.
+};
+
+struct TymPool * tym_mk_pool(unsigned no_threads);
+void tym_free_pool(struct TymPool * pool);
+unsigned tym_pool_size(const struct TymPool * pool);
+void tym_pool_submit(struct TymPool * pool, struct TymPoolGroup * group, void (*fn)(void *), void * arg);
+void tym_pool_wait(struct TymPool * pool, struct TymPoolGroup * group);
+
+#endif /* TYM_POOL_H */
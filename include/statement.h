@@ -26,13 +26,21 @@ This file: Representation of statements (that affect logical models).
 
 #include "string_idx.h"
 
+// The universe is encoded either as an uninterpreted sort, whose elements are
+// constants that are asserted to be distinct and to exhaust the sort, as an
+// enumeration datatype, whose constructors are the elements, or as bit-vectors
+// that are wide enough to number the elements (see tym_bound_universe).
+enum TymUniverseEncoding {TYM_UNIVERSE_SORT=0, TYM_UNIVERSE_DATATYPE, TYM_UNIVERSE_BITVEC, TYM_NO_UNIVERSE_ENCODING};
+
 // NOTE only interested in finite models
 struct TymUniverse {
-  uint8_t cardinality;
+  size_t cardinality;
   const TymStr ** element;
+  enum TymUniverseEncoding encoding;
 };
 
 extern char * tym_bool_ty;
+extern char * tym_bvuleK;
 extern char * tym_distinctK;
 extern char * tym_eqK;
 
@@ -54,7 +62,8 @@ struct TymStmt {
 };
 
 struct TymUniverse * tym_mk_universe(struct TymTerms *);
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * tym_universe_str(const struct TymUniverse * const, struct TymBufferInfo * dst);
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) tym_universe_str(const struct TymUniverse * const, struct TymBufferInfo * dst);
+size_t tym_universe_width(const struct TymUniverse * uni);
 void tym_free_universe(struct TymUniverse *);
 
 struct TymStmt * tym_mk_stmt_axiom(struct TymFmla * axiom);
@@ -62,12 +71,12 @@ struct TymStmt * tym_mk_stmt_pred(const TymStr * pred_name, struct TymTerms * pa
 struct TymStmt * tym_split_stmt_pred(struct TymStmt * stmt);
 struct TymStmt * tym_mk_stmt_const(const TymStr * const_name, struct TymUniverse *, const TymStr * ty);
 struct TymStmt * tym_mk_stmt_const_def(const TymStr * const_name, struct TymUniverse * uni);
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * tym_stmt_str(const struct TymStmt * const, struct TymBufferInfo * dst);
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) tym_stmt_str(const struct TymStmt * const, struct TymBufferInfo * dst);
 void tym_free_stmt(const struct TymStmt *);
 
 TYM_DECLARE_MUTABLE_LIST_TYPE(TymStmts, stmt, TymStmt)
 TYM_DECLARE_MUTABLE_LIST_MK(stmt, struct TymStmt, struct TymStmts)
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * tym_stmts_str(const struct TymStmts * const, struct TymBufferInfo * dst);
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) tym_stmts_str(const struct TymStmts * const, struct TymBufferInfo * dst);
 void tym_free_stmts(const struct TymStmts *);
 
 TYM_DECLARE_LIST_REV(stmts, , struct TymStmts, )
@@ -75,10 +84,13 @@ TYM_DECLARE_LIST_REV(stmts, , struct TymStmts, )
 struct TymModel {
   struct TymUniverse * universe;
   struct TymStmts * stmts;
+  // Whether the model's quantifiers are to be expanded over the universe
+  // (see tym_ground_model).
+  bool grounded;
 };
 
 struct TymModel * tym_mk_model(struct TymUniverse *);
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * tym_model_str(const struct TymModel * const, struct TymBufferInfo * dst);
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) tym_model_str(const struct TymModel * const, struct TymBufferInfo * dst);
 void tym_free_model(const struct TymModel *);
 void tym_strengthen_model(struct TymModel *, struct TymStmt *);
 
@@ -86,5 +98,6 @@ struct TymTerm * tym_new_const_in_stmt(const struct TymStmt * stmt);
 struct TymTerms * tym_consts_in_stmt(const struct TymStmt * stmt);
 
 void tym_statementise_universe(struct TymModel * mdl);
+void tym_bound_universe(struct TymModel * mdl);
 
 #endif /* __TYM_STATEMENT_H__ */
@@ -25,12 +25,14 @@ This file: String representation.
 #define TYM_STRING_IDX_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 // TYM_STRING_TYPE values:
 // 0: C strings
 // 1: abstract type (of C strings)
 // 2: abstract type of hashconsed C strings
+// 3: dense symbol identifiers, whose text is interned in a string arena
 #ifndef TYM_STRING_TYPE
   #define TYM_STRING_TYPE 2
 #endif
@@ -57,6 +59,17 @@ This file: String representation.
   #define TYM_CSTR_DUPLICATE(s) tym_encode_str(strdup(s))
   void tym_force_free_str (const struct TymStrHashIdxStruct *);
   void tym_safe_free_str (const struct TymStrHashIdxStruct *);
+#elif TYM_STRING_TYPE == 3
+  struct TymStrSymStruct;
+  typedef struct TymStrSymStruct TymStr;
+  #define TYM_STR_DUPLICATE(s) s
+  #define TYM_CSTR_DUPLICATE(s) tym_encode_str(strdup(s))
+  void tym_force_free_str (const struct TymStrSymStruct *);
+  void tym_safe_free_str (const struct TymStrSymStruct *);
+  // Symbols are numbered densely from 0, in the order they're first encoded.
+  uint32_t tym_str_id (const struct TymStrSymStruct *);
+  const struct TymStrSymStruct * tym_str_of_id (uint32_t);
+  size_t tym_no_strs (void);
 #else
   #error "Unknown TYM_STRING_TYPE"
 #endif
@@ -72,6 +85,7 @@ const TymStr * tym_encode_str (const char *);
 void tym_free_str (const TymStr *);
 size_t tym_len_str (const TymStr *);
 int tym_cmp_str (const TymStr *, const TymStr *);
+bool tym_eq_str (const TymStr *, const TymStr *);
 const TymStr * tym_append_str (const TymStr *, const TymStr *);
 const TymStr * tym_append_str_destructive (const TymStr * s1, const TymStr * s2);
 const TymStr * tym_append_str_destructive1 (const TymStr * s1, const TymStr * s2);
@@ -27,9 +27,11 @@ This file: Support functions for TYM Datalog.
 #include "ast.h"
 #include "buffer.h"
 #include "buffer_list.h"
+#include "eval.h"
 #include "formula.h"
 #include "parser.h"
 #include "lexer.h"
+#include "magic.h"
 #include "statement.h"
 #include "symbols.h"
 #include "translate.h"
@@ -38,7 +40,7 @@ This file: Support functions for TYM Datalog.
 #define TYM_VERSION_MAJOR 1
 #define TYM_VERSION_MINOR 0
 
-enum TymFunction {TYM_NOTHING_FUNCTION=0, TYM_TEST_PARSING, TYM_CONVERT_TO_SMT, TYM_CONVERT_TO_SMT_AND_SOLVE, TYM_CONVERT_TO_C, TYM_DUMP_HILBERT_UNIVERSE, TYM_DUMP_ATOMS, TYM_NO_FUNCTION};
+enum TymFunction {TYM_NOTHING_FUNCTION=0, TYM_TEST_PARSING, TYM_CONVERT_TO_SMT, TYM_CONVERT_TO_SMT_AND_SOLVE, TYM_CONVERT_TO_C, TYM_DUMP_HILBERT_UNIVERSE, TYM_DUMP_ATOMS, TYM_EVALUATE, TYM_EVALUATE_TABLED, TYM_NO_FUNCTION};
 
 enum TymModelOutput {TYM_MODEL_OUTPUT_VALUATION=0, TYM_MODEL_OUTPUT_FACT, TYM_ALL_MODEL_OUTPUT/*Used for testing*/, TYM_NO_MODEL_OUTPUT};
 
@@ -47,9 +49,11 @@ extern const char * const TymDefaultSolverTimeout;
 
 extern const char * TymFunctionCommandMapping[];
 extern const char * TymModelOutputCommandMapping[];
+extern const char * TymUniverseEncodingCommandMapping[];
 
 const char * tym_functions(void);
 const char * tym_model_outputs(void);
+const char * tym_universe_encodings(void);
 
 extern enum TymSatisfiable TymState_LastSolverResult;
 
@@ -60,6 +64,14 @@ struct TymParams {
   enum TymFunction function;
   enum TymModelOutput model_output;
   const char * solver_timeout;
+  unsigned solver_threads;
+  unsigned solver_portfolio;
+  unsigned eval_threads;
+  unsigned translate_threads;
+  enum TymUniverseEncoding universe_encoding;
+  bool ground;
+  bool slice;
+  bool magic;
 };
 
 // NOTE return codes aren't always returned correctly!
@@ -68,7 +80,7 @@ struct TymParams {
 //      and terminates the entire process, and returns a code of 1,
 //      overriding TYM's preference to return the value of
 //      TYM_SOLVER_GAVEUP
-enum TymReturnCode {TYM_AOK=0, TYM_UNRECOGNISED_PARAMETER=1, TYM_NO_INPUT=2, TYM_INVALID_INPUT=3, TYM_SOLVER_GAVEUP=4, TYM_TIMESTAMP_ERROR=5};
+enum TymReturnCode {TYM_AOK=0, TYM_UNRECOGNISED_PARAMETER=1, TYM_NO_INPUT=2, TYM_INVALID_INPUT=3, TYM_SOLVER_GAVEUP=4, TYM_TIMESTAMP_ERROR=5, TYM_OUTPUT_ERROR=6};
 
 struct TymProgram * parse(const char * string);
 char * read_file(char * filename);
@@ -35,27 +35,55 @@ This file: Symbol table.
 #include "string_idx.h"
 #include "util.h"
 
-// NOTE value of TERM_DATABASE_SIZE must be >= the range of the hash function for terms.
+// NOTE the number of buckets must be a power of 2. The term database doubles
+//      its number of buckets whenever it holds more terms than buckets, since
+//      the Herbrand universe can be very large.
 #define TYM_TERM_DATABASE_SIZE TYM_HASH_RANGE
 
 struct TymTermDatabase {
   struct TymTerms * herbrand_universe;
-  struct TymTerms * term_database[TYM_TERM_DATABASE_SIZE];
+  struct TymTerms ** term_database;
+  size_t no_buckets;
+  size_t no_terms;
 };
 
 struct TymTermDatabase * tym_mk_term_database(void);
 bool tym_term_database_add(struct TymTerm * term, struct TymTermDatabase * tdb);
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * tym_term_database_str(struct TymTermDatabase * tdb, struct TymBufferInfo * dst);
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * tym_term_database_dump(struct TymTermDatabase * tdb, struct TymBufferInfo * dst);
+bool tym_term_database_member(const struct TymTerm * term, const struct TymTermDatabase * tdb);
+void tym_free_term_database(struct TymTermDatabase * tdb);
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) tym_term_database_str(struct TymTermDatabase * tdb, struct TymBufferInfo * dst);
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) tym_term_database_dump(struct TymTermDatabase * tdb, struct TymBufferInfo * dst);
+
+// The ground facts about a predicate, grouped by the constant that they have
+// at one argument position.
+struct TymFactIndex {
+  struct TymStrSet keys;
+  // Indexed by the key's identifier: shallow lists of the facts whose
+  // argument is the key.
+  struct TymClauses ** facts;
+  size_t capacity;
+};
 
 struct TymPredicate {
   const TymStr * predicate;
   struct TymClauses * bodies;
-  uint8_t arity;
+  size_t arity;
+  // Statistics, kept by tym_clause_database_add for planning joins.
+  size_t no_facts; // Ground facts among the bodies.
+  size_t no_rules; // The other bodies.
+  // The distinct constants that the ground facts have at each argument
+  // position.
+  struct TymStrSet * arg_values;
+  // One index for each argument position, or NULL if the facts aren't indexed
+  // (see tym_predicate_index_facts).
+  struct TymFactIndex * fact_index;
 };
 
-struct TymPredicate * tym_mk_pred(const TymStr * predicate, uint8_t arity);
+struct TymPredicate * tym_mk_pred(const TymStr * predicate, size_t arity);
 void tym_free_pred(struct TymPredicate * pred);
+void tym_predicate_index_facts(struct TymPredicate * pred);
+const struct TymClauses * tym_predicate_facts_at(const struct TymPredicate * pred, size_t arg, const TymStr * constant);
+size_t tym_predicate_distinct(const struct TymPredicate * pred, size_t arg);
 
 enum TymEqPredError {TYM_NO_ERROR_EQ_PRED, SAME_PREDICATE_DIFF_ARITY};
 
@@ -77,14 +105,16 @@ void tym_free_atom_database(struct TymAtomDatabase *);
 enum TymAdlLookupError {TYM_ADL_NO_ERROR = 0, TYM_DIFF_ARITY};
 
 bool tym_atom_database_member(const struct TymAtom * atom, struct TymAtomDatabase * adb, enum TymAdlLookupError * error_code, struct TymPredicate ** record);
+// Finds the predicate that has a given name, whatever its arity.
+struct TymPredicate * tym_atom_database_find_pred(const TymStr * predicate, struct TymAtomDatabase * adb);
 
 enum TymAdlAddError {TYM_NO_ATOM_DATABASE = 0};
 
 bool tym_atom_database_add(const struct TymAtom * atom, struct TymAtomDatabase * adb, enum TymAdlAddError * error_code, struct TymPredicate ** result);
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * tym_atom_database_str(struct TymAtomDatabase * adb, struct TymBufferInfo * dst);
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) tym_atom_database_str(struct TymAtomDatabase * adb, struct TymBufferInfo * dst);
 struct TymPredicates * tym_atom_database_to_predicates(struct TymAtomDatabase * adb);
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * tym_predicate_str(const struct TymPredicate * pred, struct TymBufferInfo * dst);
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) tym_predicate_str(const struct TymPredicate * pred, struct TymBufferInfo * dst);
 
 enum TymCdlAddError {TYM_CDL_ADL_DIFF_ARITY = 0, TYM_CDL_ADL_NO_ATOM_DATABASE};
 
@@ -28,14 +28,15 @@ This file: Translation between clause representations.
 
 #include "ast.h"
 #include "formula.h"
+#include "pool.h"
 #include "statement.h"
 #include "symbols.h"
 
 struct TymFmla * tym_translate_atom(const struct TymAtom * at);
 
-struct TymFmla * tym_translate_body(const struct TymClause * cl);
+struct TymFmla * tym_translate_body(const struct TymClause * cl, const size_t * order);
 
-struct TymFmlas * tym_translate_bodies(const struct TymClauses * cls);
+struct TymFmlas * tym_translate_bodies(const struct TymClauses * cls, struct TymAtomDatabase * adb);
 
 struct TymFmla * tym_translate_valuation(struct TymValuation * const v);
 
@@ -44,8 +45,13 @@ void tym_translate_query_fmla(struct TymModel * mdl, struct TymSymGen * cg, stru
 
 struct TymValuation * tym_translate_query(struct TymProgram * query, struct TymModel * mdl, struct TymSymGen * cg);
 
-struct TymModel * tym_translate_program(struct TymProgram * program, struct TymSymGen ** vg, struct TymAtomDatabase * adb);
+// If plan_bodies is set then clause bodies are translated in their planned
+// order (see tym_plan_body). If pool isn't NULL then the program's predicates
+// are translated as its tasks.
+struct TymModel * tym_translate_program(struct TymProgram * program, const struct TymProgram * query, struct TymSymGen ** vg, struct TymAtomDatabase * adb, bool plan_bodies, struct TymPool * pool);
 
 struct TymStmts * tym_order_statements(struct TymStmts * stmts);
 
+void tym_ground_model(struct TymModel * mdl, const struct TymStmts * program_stmts);
+
 #endif /* TYM_TRANSLATE_H */
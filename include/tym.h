@@ -26,9 +26,12 @@ This file: Gathering of all headers.
 
 #include "ast.h"
 #include "buffer.h"
+#include "eval.h"
 #include "formula.h"
 #include "parser.h"
 #include "lexer.h"
+#include "magic.h"
+#include "plan.h"
 #include "support.h"
 #include "statement.h"
 #include "symbols.h"
@@ -63,14 +63,14 @@ extern size_t TYM_BUF_SIZE;
     struct TYPE_NAME * next; \
   };
 
-#define TYM_DECLARE_U8_LIST_LEN(TYPE_NAME) \
-  uint8_t tym_len_ ## TYPE_NAME ## _cell(const struct TYPE_NAME * next);
+#define TYM_DECLARE_CELL_LIST_LEN(TYPE_NAME) \
+  size_t tym_len_ ## TYPE_NAME ## _cell(const struct TYPE_NAME * next);
 
-#define TYM_DEFINE_U8_LIST_LEN(TYPE_NAME) \
-  uint8_t \
+#define TYM_DEFINE_CELL_LIST_LEN(TYPE_NAME) \
+  size_t \
   tym_len_ ## TYPE_NAME ## _cell(const struct TYPE_NAME * next) \
   { \
-    uint8_t result = 0; \
+    size_t result = 0; \
     while (NULL != next) { \
       result++; \
       next = next->next; \
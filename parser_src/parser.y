@@ -70,6 +70,7 @@ struct TymProgram * parse(const char * string);
 %token TK_COMMA
 %token TK_IF
 %token TK_PERIOD
+%token TK_TILDE
 
 %right TK_COMMA
 
@@ -77,6 +78,7 @@ struct TymProgram * parse(const char * string);
 %type <term> term
 %type <atoms> atoms
 %type <atom> atom
+%type <atom> literal
 %type <clause> clause
 %type <clauses> clauses
 %type <program> program
@@ -117,14 +119,23 @@ atom : TK_CONST TK_L_RB terms
          free(predicate);
          $$ = atom; }
 
-atoms : atom
+// NOTE only body atoms can be negated in programs, but a query (which is
+//      parsed as a fact) can be negated too.
+literal : atom
+          { $$ = $1; }
+        | TK_TILDE atom
+          { struct TymAtom * atom = $2;
+            atom->negated = true;
+            $$ = atom; }
+
+atoms : literal
         { struct TymAtoms * ats = tym_mk_atom_cell($1, NULL);
           $$ = ats; }
-      | atom TK_COMMA atoms
+      | literal TK_COMMA atoms
         { struct TymAtoms * ats = tym_mk_atom_cell($1, $3);
           $$ = ats; }
 
-clause : atom TK_PERIOD
+clause : literal TK_PERIOD
          { struct TymClause * cl = tym_mk_clause($1, 0, NULL);
            $$ = cl; }
        | atom TK_IF atoms TK_PERIOD
@@ -132,15 +143,18 @@ clause : atom TK_PERIOD
            struct TymClause * cl = tym_mk_clause($1, tym_len_TymAtoms_cell(ats), ats);
            $$ = cl; }
 
+// NOTE this rule is left-recursive so that the parser's stack doesn't grow
+//      with the number of clauses. As a result, the clauses are accumulated
+//      in reverse order, and are put back in order by the "program" rule.
 clauses : clause
           { struct TymClauses * cls = tym_mk_clause_cell($1, NULL);
             $$ = cls; }
-        | clause clauses
-          { struct TymClauses * cls = tym_mk_clause_cell($1, $2);
+        | clauses clause
+          { struct TymClauses * cls = tym_mk_clause_cell($2, $1);
             $$ = cls; }
 
 program : clauses
-           { struct TymClauses * cls = $1;
+           { struct TymClauses * cls = tym_reverse_clauses($1);
              struct TymProgram * p = tym_mk_program(tym_len_TymClauses_cell(cls), cls);
              *program = p;
            }
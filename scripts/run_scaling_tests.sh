@@ -0,0 +1,92 @@
+#!/bin/bash
+#
+# Copyright Nik Sultana, 2019
+#
+# This file is part of TYM Datalog. (https://www.github.com/niksu/tym)
+#
+# TYM Datalog is free software: you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published
+# by the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# TYM Datalog is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Lesser General Public License for more details, a copy of which
+# is included in the file called LICENSE distributed with TYM Datalog.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with TYM Datalog.  If not, see <https://www.gnu.org/licenses/>.
+#
+#
+# Scaling tests: generate programs containing many facts, and check that
+# they're parsed, translated and emitted correctly, and that the time taken
+# per fact doesn't grow much with the size of the program.
+#
+# SIZES: numbers of facts to test with (in increasing order).
+# SLACK: how many times slower (per fact) the largest programs may be,
+#        compared to the smallest.
+
+[ -z "${TYMDIR}" ] && TYMDIR=.
+[ -z "${SIZES}" ] && SIZES="10000 100000 1000000"
+[ -z "${SLACK}" ] && SLACK=5
+if [ -n "${TYM_Z3_PATH}" ]
+then
+  export DYLD_LIBRARY_PATH=${TYM_Z3_PATH}/bin/
+fi
+
+TMPDIR=$(mktemp -d)
+trap "rm -rf ${TMPDIR}" EXIT
+
+FAILED=0
+BASE_NS_PER_FACT=
+
+function fail {
+  echo "FAIL ($1 facts): $2"
+  FAILED=1
+}
+
+for SIZE in ${SIZES}
+do
+  PROGRAM=${TMPDIR}/${SIZE}.test
+  # A chain of facts e(c0, c1), ..., e(c{n-1}, cn) together with a rule,
+  # so the universe contains n+1 constants.
+  awk -v n=${SIZE} 'BEGIN { for (i = 0; i < n; i++) printf "e(c%d, c%d).\n", i, i + 1;
+                            print "p(X) :- e(X, Y)." }' > ${PROGRAM}
+
+  START=$(date +%s%N)
+  ${TYMDIR}/out/tym -i ${PROGRAM} -f smt_output > ${TMPDIR}/${SIZE}.smt
+  RESULT=$?
+  END=$(date +%s%N)
+  NS=$((END - START))
+  NS_PER_FACT=$((NS / SIZE))
+  echo "${SIZE} facts: smt_output took $((NS / 1000000))ms (${NS_PER_FACT}ns per fact)"
+
+  if [ ${RESULT} -ne 0 ]
+  then
+    fail ${SIZE} "smt_output returned ${RESULT}"
+    continue
+  fi
+
+  CONSTS=$(grep -c "^(declare-const constant_" ${TMPDIR}/${SIZE}.smt)
+  if [ "${CONSTS}" != "$((SIZE + 1))" ]
+  then
+    fail ${SIZE} "expected $((SIZE + 1)) constants but found ${CONSTS}"
+  fi
+
+  ANSWERS=$(${TYMDIR}/out/tym -i ${PROGRAM} -f eval -q "p(X)." | grep -c "^X = constant_c")
+  if [ "${ANSWERS}" != "${SIZE}" ]
+  then
+    fail ${SIZE} "expected ${SIZE} answers but found ${ANSWERS}"
+  fi
+
+  if [ -z "${BASE_NS_PER_FACT}" ]
+  then
+    BASE_NS_PER_FACT=${NS_PER_FACT}
+  elif [ ${NS_PER_FACT} -gt $((SLACK * BASE_NS_PER_FACT)) ]
+  then
+    fail ${SIZE} "time per fact grew more than ${SLACK}-fold"
+  fi
+done
+
+exit ${FAILED}
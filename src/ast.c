@@ -22,6 +22,7 @@ This file: AST supporting functions.
 */
 
 #include <assert.h>
+#include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -34,24 +35,22 @@ struct TymTerm * tym_mdl_instantiate_valuation_term(struct TymTerm * term, struc
 struct TymAtom * tym_mdl_instantiate_valuation_atom(struct TymAtom * atom, struct TymMdlValuations * vals);
 struct TymClause * tym_mdl_instantiate_valuation_clause(struct TymClause * cl, struct TymMdlValuations * vals);
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) *
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult)
 tym_term_str(const struct TymTerm * const term, struct TymBufferInfo * dst)
 {
   assert(NULL != term);
   size_t initial_idx = tym_buffer_len(dst);
 
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = tym_buf_strcpy(dst, tym_decode_str(term->identifier));
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res = tym_buf_strcpy(dst, tym_decode_str(term->identifier));
   assert(TYM_MAYBE_ERROR__IS_OK_FNAME(TymBufferWriteResult)(res));
-  free(res);
 
   tym_unsafe_dec_idx(dst, 1); // chomp the trailing \0.
 
 #if TYM_DEBUG
   char local_buf[TYM_BUF_SIZE];
-  sprintf(local_buf, "{hash=%d}", tym_hash_term(term));
+  sprintf(local_buf, "{hash=%" PRIu64 "}", tym_hash_term(term));
   res = tym_buf_strcpy(dst, local_buf);
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
   tym_unsafe_dec_idx(dst, 1); // chomp the trailing \0.
 #endif
 
@@ -63,24 +62,22 @@ tym_term_str(const struct TymTerm * const term, struct TymBufferInfo * dst)
   }
 }
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) *
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult)
 tym_predicate_atom_str(const struct TymAtom * atom, struct TymBufferInfo * dst)
 {
   assert(NULL != atom);
   size_t initial_idx = tym_buffer_len(dst);
 
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = tym_buf_strcpy(dst, tym_decode_str(atom->predicate));
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res = tym_buf_strcpy(dst, tym_decode_str(atom->predicate));
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
 
   tym_unsafe_dec_idx(dst, 1); // chomp the trailing \0.
 
 #if TYM_DEBUG
   char local_buf[TYM_BUF_SIZE];
-  sprintf(local_buf, "{hash=%u}", tym_hash_str(tym_decode_str(atom->predicate)));
+  sprintf(local_buf, "{hash=%" PRIu64 "}", tym_hash_str(tym_decode_str(atom->predicate)));
   res = tym_buf_strcpy(dst, local_buf);
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
   tym_unsafe_dec_idx(dst, 1); // chomp the trailing \0.
 #endif
 
@@ -92,15 +89,22 @@ tym_predicate_atom_str(const struct TymAtom * atom, struct TymBufferInfo * dst)
   }
 }
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) *
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult)
 tym_atom_str(const struct TymAtom * const atom, struct TymBufferInfo * dst)
 {
   assert(NULL != atom);
   size_t initial_idx = tym_buffer_len(dst);
 
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = tym_predicate_atom_str(atom, dst);
+  if (atom->negated) {
+    if (tym_have_space(dst, 1)) {
+      tym_unsafe_buffer_char(dst, '~');
+    } else {
+      return tym_mkerrval_TymBufferWriteResult(BUFF_ERR_OVERFLOW);
+    }
+  }
+
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res = tym_predicate_atom_str(atom, dst);
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
 
   tym_unsafe_dec_idx(dst, 1); // chomp the trailing \0.
 
@@ -111,10 +115,9 @@ tym_atom_str(const struct TymAtom * const atom, struct TymBufferInfo * dst)
     return tym_mkerrval_TymBufferWriteResult(BUFF_ERR_OVERFLOW);
   }
 
-  for (int i = 0; i < atom->arity; i++) {
+  for (size_t i = 0; i < atom->arity; i++) {
     res = tym_term_str(atom->args[i], dst);
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
 
     tym_unsafe_dec_idx(dst, 1); // chomp the trailing \0.
 
@@ -136,10 +139,9 @@ tym_atom_str(const struct TymAtom * const atom, struct TymBufferInfo * dst)
 
 #if TYM_DEBUG
   char local_buf[TYM_BUF_SIZE];
-  sprintf(local_buf, "{hash=%d}", tym_hash_atom(atom));
+  sprintf(local_buf, "{hash=%" PRIu64 "}", tym_hash_atom(atom));
   res = tym_buf_strcpy(dst, local_buf);
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
   tym_unsafe_dec_idx(dst, 1); // chomp the trailing \0.
 #endif
 
@@ -158,7 +160,7 @@ tym_copy_clause(const struct TymClause * const cp_clause)
   struct TymAtom ** body = NULL;
   if (cp_clause->body_size > 0) {
     body = malloc(sizeof *body * cp_clause->body_size);
-    for (int i = 0; i < cp_clause->body_size; i++) {
+    for (size_t i = 0; i < cp_clause->body_size; i++) {
       body[i] = tym_copy_atom(cp_clause->body[i]);
     }
   }
@@ -170,15 +172,14 @@ tym_copy_clause(const struct TymClause * const cp_clause)
   return result;
 }
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) *
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult)
 tym_clause_str(const struct TymClause * const clause, struct TymBufferInfo * dst)
 {
   assert(NULL != clause);
   size_t initial_idx = tym_buffer_len(dst);
 
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = tym_atom_str(clause->head, dst);
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res = tym_atom_str(clause->head, dst);
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
 
   tym_unsafe_dec_idx(dst, 1); // chomp the trailing \0.
 
@@ -190,10 +191,9 @@ tym_clause_str(const struct TymClause * const clause, struct TymBufferInfo * dst
 
     tym_unsafe_buffer_str(dst, " :- ");
 
-    for (int i = 0; i < clause->body_size; i++) {
+    for (size_t i = 0; i < clause->body_size; i++) {
       res = tym_atom_str(clause->body[i], dst);
       assert(tym_is_ok_TymBufferWriteResult(res));
-      free(res);
 
       tym_unsafe_dec_idx(dst, 1); // chomp the trailing \0.
 
@@ -217,10 +217,9 @@ tym_clause_str(const struct TymClause * const clause, struct TymBufferInfo * dst
 
 #if TYM_DEBUG
   char local_buf[TYM_BUF_SIZE];
-  sprintf(local_buf, "{hash=%d}", tym_hash_clause(clause));
+  sprintf(local_buf, "{hash=%" PRIu64 "}", tym_hash_clause(clause));
   res = tym_buf_strcpy(dst, local_buf);
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
   tym_unsafe_dec_idx(dst, 1); // chomp the trailing \0.
 #endif
 
@@ -232,18 +231,17 @@ tym_clause_str(const struct TymClause * const clause, struct TymBufferInfo * dst
   }
 }
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) *
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult)
 tym_program_str(const struct TymProgram * const program, struct TymBufferInfo * dst)
 {
   assert(NULL != program);
   size_t initial_idx = tym_buffer_len(dst);
 
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = NULL;
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res;
 
-  for (int i = 0; i < program->no_clauses; i++) {
+  for (size_t i = 0; i < program->no_clauses; i++) {
     res = tym_clause_str(program->program[i], dst);
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
 
     if (i < program->no_clauses - 1) {
       tym_safe_buffer_replace_last(dst, '\n');
@@ -269,10 +267,10 @@ tym_mk_term(enum TymTermKind kind, const TymStr * identifier)
 
 TYM_DEFINE_MUTABLE_LIST_MK(term, term, struct TymTerm, struct TymTerms)
 
-TYM_DEFINE_U8_LIST_LEN(TymTerms)
+TYM_DEFINE_CELL_LIST_LEN(TymTerms)
 
 struct TymAtom *
-tym_mk_atom(TymStr * predicate, uint8_t arity, struct TymTerms * args) {
+tym_mk_atom(TymStr * predicate, size_t arity, struct TymTerms * args) {
   assert(NULL != predicate);
 
   struct TymAtom * at = malloc(sizeof *at);
@@ -281,13 +279,14 @@ tym_mk_atom(TymStr * predicate, uint8_t arity, struct TymTerms * args) {
   at->predicate = predicate;
   at->arity = arity;
   at->args = NULL;
+  at->negated = false;
 
   struct TymTerms * pre_position = NULL;
 
   if (at->arity > 0) {
     at->args = malloc(sizeof *at->args * at->arity);
     assert(NULL != at->args);
-    for (int i = 0; i < at->arity; i++) {
+    for (size_t i = 0; i < at->arity; i++) {
       at->args[i] = args->term;
       pre_position = args;
       args = args->next;
@@ -300,10 +299,10 @@ tym_mk_atom(TymStr * predicate, uint8_t arity, struct TymTerms * args) {
 
 TYM_DEFINE_MUTABLE_LIST_MK(atom, atom, struct TymAtom, struct TymAtoms)
 
-TYM_DEFINE_U8_LIST_LEN(TymAtoms)
+TYM_DEFINE_CELL_LIST_LEN(TymAtoms)
 
 struct TymClause *
-tym_mk_clause(struct TymAtom * head, uint8_t body_size, struct TymAtoms * body) {
+tym_mk_clause(struct TymAtom * head, size_t body_size, struct TymAtoms * body) {
   assert(NULL != head);
   assert((NULL != body && body_size > 0) || (NULL == body && 0 == body_size));
 
@@ -319,7 +318,7 @@ tym_mk_clause(struct TymAtom * head, uint8_t body_size, struct TymAtoms * body)
   if (cl->body_size > 0) {
     cl->body = malloc(sizeof *cl->body * body_size);
     assert(NULL != cl->body);
-    for (int i = 0; i < cl->body_size; i++) {
+    for (size_t i = 0; i < cl->body_size; i++) {
       cl->body[i] = body->atom;
       pre_position = body;
       body = body->next;
@@ -332,10 +331,25 @@ tym_mk_clause(struct TymAtom * head, uint8_t body_size, struct TymAtoms * body)
 
 TYM_DEFINE_MUTABLE_LIST_MK(clause, clause, struct TymClause, struct TymClauses)
 
-TYM_DEFINE_U8_LIST_LEN(TymClauses)
+TYM_DEFINE_CELL_LIST_LEN(TymClauses)
+
+// Unlike the functions defined by TYM_DEFINE_LIST_REV, this reverses the list
+// in place rather than building a new one.
+struct TymClauses *
+tym_reverse_clauses(struct TymClauses * clauses)
+{
+  struct TymClauses * result = NULL;
+  while (NULL != clauses) {
+    struct TymClauses * next = clauses->next;
+    clauses->next = result;
+    result = clauses;
+    clauses = next;
+  }
+  return result;
+}
 
 struct TymProgram *
-tym_mk_program(uint8_t no_clauses, struct TymClauses * program)
+tym_mk_program(size_t no_clauses, struct TymClauses * program)
 {
   struct TymProgram * p = malloc(sizeof *p);
   assert(NULL != p);
@@ -347,7 +361,7 @@ tym_mk_program(uint8_t no_clauses, struct TymClauses * program)
   if (no_clauses > 0) {
     p->program = malloc(sizeof *p->program * no_clauses);
     assert(NULL != p->program);
-    for (int i = 0; i < p->no_clauses; i++) {
+    for (size_t i = 0; i < p->no_clauses; i++) {
       p->program[i] = program->clause;
       pre_position = program;
       program = program->next;
@@ -377,12 +391,13 @@ tym_free_terms(struct TymTerms * terms)
 {
   assert(NULL != terms);
 
-  assert(NULL != terms->term);
-  tym_free_term(terms->term);
-  if (NULL != terms->next) {
-    tym_free_terms((void *)terms->next);
+  while (NULL != terms) {
+    struct TymTerms * next = (void *)terms->next;
+    assert(NULL != terms->term);
+    tym_free_term(terms->term);
+    free(terms);
+    terms = next;
   }
-  free(terms);
 }
 
 void
@@ -396,7 +411,7 @@ tym_free_atom(struct TymAtom * at)
   TYM_DBG("\n");
 
   tym_free_str(at->predicate);
-  for (int i = 0; i < at->arity; i++) {
+  for (size_t i = 0; i < at->arity; i++) {
     tym_free_term(at->args[i]);
   }
 
@@ -414,12 +429,13 @@ tym_free_atoms(struct TymAtoms * atoms)
 {
   assert(NULL != atoms);
 
-  assert(NULL != atoms->atom);
-  tym_free_atom(atoms->atom);
-  if (NULL != atoms->next) {
-    tym_free_atoms(atoms->next);
+  while (NULL != atoms) {
+    struct TymAtoms * next = atoms->next;
+    assert(NULL != atoms->atom);
+    tym_free_atom(atoms->atom);
+    free(atoms);
+    atoms = next;
   }
-  free(atoms);
 }
 
 void
@@ -431,7 +447,7 @@ tym_free_clause(struct TymClause * clause)
 
   assert((0 == clause->body_size && NULL == clause->body) ||
          (clause->body_size > 0 && NULL != clause->body));
-  for (int i = 0; i < clause->body_size; i++) {
+  for (size_t i = 0; i < clause->body_size; i++) {
     tym_free_atom(clause->body[i]);
   }
 
@@ -447,12 +463,13 @@ tym_free_clauses(struct TymClauses * clauses)
 {
   assert(NULL != clauses);
 
-  assert(NULL != clauses->clause);
-  tym_free_clause(clauses->clause);
-  if (NULL != clauses->next) {
-    tym_free_clauses((void *)clauses->next);
+  while (NULL != clauses) {
+    struct TymClauses * next = (void *)clauses->next;
+    assert(NULL != clauses->clause);
+    tym_free_clause(clauses->clause);
+    free(clauses);
+    clauses = next;
   }
-  free(clauses);
 }
 
 void
@@ -460,8 +477,8 @@ tym_free_program(struct TymProgram * program)
 {
   assert(NULL != program);
 
-  for (int i = 0; i < program->no_clauses; i++) {
-    TYM_DBG("Freeing clause %d: ", i);
+  for (size_t i = 0; i < program->no_clauses; i++) {
+    TYM_DBG("Freeing clause %zu: ", i);
     TYM_DBG_SYNTAX((void *)program->program[i], (tym_x_str_t)tym_clause_str);
     TYM_DBG("\n");
 
@@ -477,13 +494,12 @@ tym_free_program(struct TymProgram * program)
 }
 
 void
-tym_debug_out_syntax(void * x, struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * (*tym_x_str)(void *, struct TymBufferInfo * dst))
+tym_debug_out_syntax(void * x, struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) (*tym_x_str)(void *, struct TymBufferInfo * dst))
 {
   struct TymBufferInfo * outbuf = tym_mk_buffer(TYM_BUF_SIZE);
 
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = tym_x_str(x, outbuf);
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res = tym_x_str(x, outbuf);
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
 
   TYM_DBG("%s", tym_buffer_contents(outbuf));
 
@@ -507,8 +523,11 @@ tym_hash_atom(const struct TymAtom * atom)
   TYM_HASH_VTYPE result = tym_hash_str(tym_decode_str(atom->predicate));
 
   result ^= (TYM_HASH_VTYPE)atom->arity;
+  if (atom->negated) {
+    result = ~result;
+  }
 
-  for (int i = 0; i < atom->arity; i++) {
+  for (size_t i = 0; i < atom->arity; i++) {
     result ^= (TYM_HASH_VTYPE)((i + 1) * tym_hash_term(atom->args[i]));
   }
 
@@ -523,7 +542,7 @@ tym_hash_clause(const struct TymClause * clause) {
 
   result ^= (TYM_HASH_VTYPE)clause->body_size;
 
-  for (int i = 0; i < clause->body_size; i++) {
+  for (size_t i = 0; i < clause->body_size; i++) {
     result ^= (TYM_HASH_VTYPE)((i + 1) * tym_hash_atom(clause->body[i]));
   }
 
@@ -552,7 +571,7 @@ tym_eq_term(const struct TymTerm * const t1, const struct TymTerm * const t2,
     same_kind = true;
   }
 
-  if (0 == tym_cmp_str(t1->identifier, t2->identifier)) {
+  if (tym_eq_str(t1->identifier, t2->identifier)) {
     same_identifier = true;
   }
 
@@ -580,11 +599,13 @@ tym_test_clause(void) {
   at->arity = 1;
   at->args = malloc(sizeof *at->args * 1);
   at->args[0] = t;
+  at->negated = false;
 
   struct TymAtom * hd = malloc(sizeof *hd);
   hd->predicate = TYM_CSTR_DUPLICATE("hello");
   hd->arity = 0;
   hd->args = NULL;
+  hd->negated = false;
 
   struct TymClause * cl = malloc(sizeof *cl);
   cl->head = hd;
@@ -593,9 +614,8 @@ tym_test_clause(void) {
   cl->body[0] = at;
 
   struct TymBufferInfo * outbuf = tym_mk_buffer(TYM_BUF_SIZE);
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = tym_clause_str(cl, outbuf);
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res = tym_clause_str(cl, outbuf);
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
   TYM_DBG_BUFFER(outbuf, "test clause")
   tym_free_buffer(outbuf);
 
@@ -645,9 +665,8 @@ tym_terms_subsumed_by(const struct TymTerms * const ts, const struct TymTerms *
     if (!found) {
 #if TYM_DEBUG
       struct TymBufferInfo * outbuf = tym_mk_buffer(TYM_BUF_SIZE);
-      struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = tym_term_str(ss->term, outbuf);
+      struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res = tym_term_str(ss->term, outbuf);
       assert(tym_is_ok_TymBufferWriteResult(res));
-      free(res);
       TYM_DBG_BUFFER(outbuf, "unsubsumed")
       tym_free_buffer(outbuf);
 #endif
@@ -665,7 +684,7 @@ tym_terms_subsumed_by(const struct TymTerms * const ts, const struct TymTerms *
   return result;
 }
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) *
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult)
 tym_terms_str(const struct TymTerms * const terms, struct TymBufferInfo * dst)
 {
   assert(NULL != terms);
@@ -674,12 +693,11 @@ tym_terms_str(const struct TymTerms * const terms, struct TymBufferInfo * dst)
 
   const struct TymTerms * cursor = terms;
 
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = NULL;
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res;
 
   while (NULL != cursor) {
     res = tym_term_str(cursor->term, dst);
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
 
     if (NULL != terms->next) {
       tym_safe_buffer_replace_last(dst, ',');
@@ -709,11 +727,12 @@ tym_copy_atom(const struct TymAtom * const cp_atom)
   at->predicate = TYM_STR_DUPLICATE(cp_atom->predicate);
   at->arity = cp_atom->arity;
   at->args = NULL;
+  at->negated = cp_atom->negated;
 
   if (at->arity > 0) {
     at->args = malloc(sizeof *at->args * at->arity);
     assert(NULL != at->args);
-    for (int i = 0; i < at->arity; i++) {
+    for (size_t i = 0; i < at->arity; i++) {
       at->args[i] = tym_copy_term(cp_atom->args[i]);
     }
   }
@@ -757,7 +776,7 @@ tym_terms_difference(struct TymTerms * set1, struct TymTerms * set2)
 void
 tym_vars_of_atom(struct TymAtom * atom, struct TymTerms ** acc)
 {
-  for (int i = 0; i < atom->arity; i++) {
+  for (size_t i = 0; i < atom->arity; i++) {
     if ((TYM_VAR == atom->args[i]->kind) &&
         (!tym_vars_contained(atom->args[i], *acc))) {
       *acc = tym_mk_term_cell(atom->args[i], *acc);
@@ -771,7 +790,7 @@ tym_hidden_vars_of_clause(const struct TymClause * cl)
   struct TymTerms * head_vars = NULL;
   struct TymTerms * body_vars = NULL;
   tym_vars_of_atom(cl->head, &head_vars);
-  for (int i = 0; i < cl->body_size; i++) {
+  for (size_t i = 0; i < cl->body_size; i++) {
     tym_vars_of_atom(cl->body[i], &body_vars);
   }
 
@@ -781,7 +800,54 @@ tym_hidden_vars_of_clause(const struct TymClause * cl)
   return result;
 }
 
+// A clause is range-restricted if each variable in its head, or in a negated
+// atom in its body, also appears in a (non-negated) atom in its body.
+bool
+tym_range_restricted(const struct TymClause * cl)
+{
+  struct TymTerms * head_vars = NULL;
+  struct TymTerms * body_vars = NULL;
+  tym_vars_of_atom(cl->head, &head_vars);
+  for (size_t i = 0; i < cl->body_size; i++) {
+    tym_vars_of_atom(cl->body[i], cl->body[i]->negated ? &head_vars : &body_vars);
+  }
+
+  struct TymTerms * unbound_vars = tym_terms_difference(head_vars, body_vars);
+  bool result = (NULL == unbound_vars);
+  tym_shallow_free_terms(unbound_vars);
+  tym_shallow_free_terms(head_vars);
+  tym_shallow_free_terms(body_vars);
+  return result;
+}
+
+// Whether the clause's head, or any atom in its body, is negated.
+bool
+tym_has_negation(const struct TymClause * cl)
+{
+  bool result = cl->head->negated;
+  for (size_t i = 0; !result && i < cl->body_size; i++) {
+    result = cl->body[i]->negated;
+  }
+  return result;
+}
+
+// A ground fact has no body, and only constants in its head.
+bool
+tym_ground_fact(const struct TymClause * cl)
+{
+  if (cl->body_size > 0) {
+    return false;
+  }
+  for (size_t i = 0; i < cl->head->arity; i++) {
+    if (TYM_VAR == cl->head->args[i]->kind) {
+      return false;
+    }
+  }
+  return true;
+}
+
 TYM_DEFINE_LIST_SHALLOW_FREE(terms, , struct TymTerms)
+TYM_DEFINE_LIST_SHALLOW_FREE(clauses, , struct TymClauses)
 
 struct TymMdlValuations *
 tym_mdl_mk_valuations(const TymStr ** consts, const TymStr ** vars)
@@ -857,7 +923,7 @@ tym_mdl_instantiate_valuation_term(struct TymTerm * term, struct TymMdlValuation
   if (TYM_VAR == term->kind) {
     // FIXME inefficient -- linear time.
     for (unsigned i = 0; i < vals->count; i++) {
-      if (0 == tym_cmp_str(vals->v[i].var_name, term->identifier)) {
+      if (tym_eq_str(vals->v[i].var_name, term->identifier)) {
         result = malloc(sizeof(*result));
         result->identifier = TYM_STR_DUPLICATE(vals->v[i].value);
         result->kind = TYM_CONST;
@@ -879,10 +945,11 @@ tym_mdl_instantiate_valuation_atom(struct TymAtom * atom, struct TymMdlValuation
   result->predicate = TYM_STR_DUPLICATE(atom->predicate);
   result->arity = atom->arity;
   result->args = NULL;
+  result->negated = atom->negated;
   if (result->arity > 0) {
     result->args = malloc(sizeof(*(result->args)) * result->arity);
   }
-  for (int i = 0; i < atom->arity; i++) {
+  for (size_t i = 0; i < atom->arity; i++) {
     result->args[i] = tym_mdl_instantiate_valuation_term(atom->args[i], vals);
   }
   return result;
@@ -898,7 +965,7 @@ tym_mdl_instantiate_valuation_clause(struct TymClause * cl, struct TymMdlValuati
   if (result->body_size > 0) {
     result->body = malloc(sizeof(*(result->body)) * result->body_size);
   }
-  for (int i = 0; i < cl->body_size; i++) {
+  for (size_t i = 0; i < cl->body_size; i++) {
     result->body[i] = tym_mdl_instantiate_valuation_atom(cl->body[i], vals);
   }
   return result;
@@ -910,7 +977,7 @@ tym_mdl_instantiate_valuation(struct TymProgram * ParsedQuery, struct TymMdlValu
   struct TymProgram * result = malloc(sizeof(*result));
   result->no_clauses = ParsedQuery->no_clauses;
   result->program = malloc(sizeof(*(result->program)) * result->no_clauses);
-  for (int i = 0; i < ParsedQuery->no_clauses; i++) {
+  for (size_t i = 0; i < ParsedQuery->no_clauses; i++) {
     result->program[i] = tym_mdl_instantiate_valuation_clause(ParsedQuery->program[i], vals);
   }
   return result;
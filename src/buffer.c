@@ -21,16 +21,163 @@ along with TYM Datalog.  If not, see <https://www.gnu.org/licenses/>.
 This file: Buffer management.
 */
 
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 #include "buffer.h"
 #include "buffer_internal.h"
+#include "module_tests.h"
+
+// NOTE POSIX only guarantees that writev accepts this many buffers (_XOPEN_IOV_MAX).
+#define TYM_IOV_MAX 16
+
+static struct TymBufferChunk * mk_chunk(size_t size, struct TymBufferChunk * prev);
+static void flatten(struct TymBufferInfo * buf);
+static bool write_chunks(int fd, struct TymBufferChunk * from, struct TymBufferChunk * to);
+static void flush_filled_chunks(struct TymBufferInfo * buf);
+static void test_buffer_write(struct TymBufferInfo * buf, const char * s);
+
+static struct TymBufferChunk *
+mk_chunk(size_t size, struct TymBufferChunk * prev)
+{
+  struct TymBufferChunk * chunk = malloc(sizeof(*chunk) + sizeof(char) * size);
+  assert(NULL != chunk);
+  *chunk = (struct TymBufferChunk){.next = NULL, .prev = prev, .size = size, .used = 0};
+  chunk->data[0] = '\0';
+  return chunk;
+}
+
+// Gather the buffer's contents into a single chunk, so they can be read as a
+// C string. This happens at most once between writes that add chunks, and
+// it's the only time that written contents are copied.
+static void
+flatten(struct TymBufferInfo * buf)
+{
+  if (buf->head != buf->tail) {
+    struct TymBufferChunk * chunk = mk_chunk(buf->buffer_size, NULL);
+    struct TymBufferChunk * cursor = buf->head;
+    while (NULL != cursor) {
+      struct TymBufferChunk * next = cursor->next;
+      if (cursor->used > 0) {
+        memcpy(chunk->data + chunk->used, cursor->data, cursor->used);
+        chunk->used += cursor->used;
+      }
+      free(cursor);
+      cursor = next;
+    }
+    assert(chunk->used == buf->write_idx);
+    buf->head = chunk;
+    buf->tail = chunk;
+  }
+
+  // Terminate the contents, in case the last thing written to the buffer
+  // wasn't a \0.
+  if (buf->tail->used < buf->tail->size) {
+    buf->tail->data[buf->tail->used] = '\0';
+  }
+}
+
+// Write the contents of the chunks from "from" to "to" (inclusive), gathering
+// up to TYM_IOV_MAX chunks in each call to writev. Returns false, having
+// reported the error, if writing fails.
+static bool
+write_chunks(int fd, struct TymBufferChunk * from, struct TymBufferChunk * to)
+{
+  struct iovec iov[TYM_IOV_MAX];
+  struct TymBufferChunk * cursor = from;
+  bool done = false;
+  while (!done) {
+    int iovcnt = 0;
+    while (!done && iovcnt < TYM_IOV_MAX) {
+      if (cursor->used > 0) {
+        iov[iovcnt] = (struct iovec){.iov_base = cursor->data, .iov_len = cursor->used};
+        iovcnt++;
+      }
+      done = (cursor == to);
+      cursor = cursor->next;
+    }
+
+    // writev might write less than we asked it to, in which case we skip what
+    // was written and try again.
+    struct iovec * remaining = iov;
+    while (iovcnt > 0) {
+      ssize_t written = writev(fd, remaining, iovcnt);
+      if (written < 0) {
+        if (EINTR == errno) {
+          continue;
+        }
+        TYM_ERR("Writing output failed: %s\n", strerror(errno));
+        return false;
+      }
+      size_t w = (size_t)written;
+      while (iovcnt > 0 && w >= remaining->iov_len) {
+        w -= remaining->iov_len;
+        remaining++;
+        iovcnt--;
+      }
+      if (iovcnt > 0) {
+        remaining->iov_base = (char *)remaining->iov_base + w;
+        remaining->iov_len -= w;
+      }
+    }
+  }
+  return true;
+}
+
+// If the buffer is a sink, then write out the chunks before the most recent
+// one that holds contents, and move them to the end of the chain, to be
+// reused. We keep that chunk since printers might still revise its last
+// character, for example to remove a trailing \0.
+static void
+flush_filled_chunks(struct TymBufferInfo * buf)
+{
+  if (-1 == buf->fd) {
+    return;
+  }
+
+  struct TymBufferChunk * keep = buf->tail;
+  while (0 == keep->used && NULL != keep->prev) {
+    keep = keep->prev;
+  }
+  if (keep == buf->head) {
+    return;
+  }
+
+  if (!buf->failed) {
+    fflush(stdout); // In case the sink shares a file descriptor with stdout.
+    buf->failed = !write_chunks(buf->fd, buf->head, keep->prev);
+  }
+
+  struct TymBufferChunk * first = buf->head;
+  struct TymBufferChunk * last = keep->prev;
+  keep->prev = NULL;
+  buf->head = keep;
+
+  last->next = NULL;
+  for (struct TymBufferChunk * cursor = first; NULL != cursor; cursor = cursor->next) {
+    cursor->used = 0;
+  }
+
+  struct TymBufferChunk * end = buf->tail;
+  while (NULL != end->next) {
+    end = end->next;
+  }
+  first->prev = end;
+  end->next = first;
+}
 
 const char *
 tym_buffer_contents(struct TymBufferInfo * buf)
 {
-  return buf->buffer + buf->read_idx;
+  // The contents of a sink aren't retained.
+  assert(-1 == buf->fd);
+  flatten(buf);
+  return buf->head->data + buf->read_idx;
 }
 
 size_t
@@ -48,41 +195,127 @@ tym_buffer_size(struct TymBufferInfo * buf)
 struct TymBufferInfo *
 tym_mk_buffer(const size_t buffer_size)
 {
-  char * b = malloc(sizeof(char) * buffer_size);
-  assert(NULL != b);
-  memset(b, '\0', buffer_size);
+  assert(buffer_size > 0);
   struct TymBufferInfo * buf = malloc(sizeof *buf);
-  *buf = (struct TymBufferInfo){.buffer = b, .write_idx = 0, .buffer_size = buffer_size};
+  struct TymBufferChunk * chunk = mk_chunk(buffer_size, NULL);
+  *buf = (struct TymBufferInfo){.head = chunk, .tail = chunk, .write_idx = 0,
+    .read_idx = 0, .buffer_size = buffer_size, .chunk_size = buffer_size, .fd = -1, .failed = false};
   return buf;
 }
 
+// A sink buffer is written to like any other buffer, but its contents are
+// written to "fd" as chunks are filled, so the memory it uses doesn't grow
+// with the amount written. Call tym_flush_buffer once writing is done.
+struct TymBufferInfo *
+tym_mk_sink_buffer(int fd, const size_t buffer_size)
+{
+  assert(fd >= 0);
+  struct TymBufferInfo * buf = tym_mk_buffer(buffer_size);
+  buf->fd = fd;
+  return buf;
+}
+
+// Write out the remainder of a sink's contents, except for a trailing \0,
+// which only served to terminate what the printers wrote. Returns false if
+// any of the sink's contents couldn't be written.
+bool
+tym_flush_buffer(struct TymBufferInfo * buf)
+{
+  assert(-1 != buf->fd);
+
+  if (buf->write_idx > 0 && !buf->failed) {
+    struct TymBufferChunk * last = buf->tail;
+    while (0 == last->used) {
+      last = last->prev;
+    }
+    if ('\0' == last->data[last->used - 1]) {
+      last->used -= 1;
+    }
+    fflush(stdout);
+    buf->failed = !write_chunks(buf->fd, buf->head, buf->tail);
+  }
+
+  tym_reset_buffer(buf);
+  return !buf->failed;
+}
+
 void
 tym_reset_buffer(struct TymBufferInfo * buf)
 {
+  // We keep the chunks, to be reused by later writes.
+  for (struct TymBufferChunk * cursor = buf->head; NULL != cursor; cursor = cursor->next) {
+    cursor->used = 0;
+  }
+  buf->tail = buf->head;
   buf->write_idx = 0;
   buf->read_idx = 0;
-  buf->buffer[0] = '\0';
+  buf->head->data[0] = '\0';
 }
 
 void
 tym_free_buffer(struct TymBufferInfo * buf)
 {
-  free((void *)buf->buffer);
+  struct TymBufferChunk * cursor = buf->head;
+  while (NULL != cursor) {
+    struct TymBufferChunk * next = cursor->next;
+    free(cursor);
+    cursor = next;
+  }
   free((void *)buf);
 }
 
+// Ensures that the next n bytes (and a terminating \0) can be written
+// contiguously, moving on to another chunk if needed. Since the buffer grows
+// as needed, this always succeeds.
 bool
 tym_have_space(struct TymBufferInfo * buf, size_t n)
 {
-  assert(buf->buffer_size > 0);
-  assert(buf->buffer_size > buf->write_idx);
-  return (n < buf->buffer_size - buf->write_idx);
+  assert(buf->tail->size > buf->tail->used);
+  if (n < buf->tail->size - buf->tail->used) {
+    return true;
+  }
+
+  struct TymBufferChunk * next = buf->tail->next;
+  while (NULL != next && n >= next->size) {
+    // A chunk left over from before tym_reset_buffer, but too small.
+    buf->tail->next = next->next;
+    if (NULL != next->next) {
+      next->next->prev = buf->tail;
+    }
+    buf->buffer_size -= next->size;
+    free(next);
+    next = buf->tail->next;
+  }
+
+  if (NULL == next) {
+    size_t size = buf->chunk_size;
+    if (n >= size) {
+      size = n + 1;
+    }
+    next = mk_chunk(size, buf->tail);
+    next->next = buf->tail->next;
+    if (NULL != next->next) {
+      next->next->prev = next;
+    }
+    buf->tail->next = next;
+    buf->buffer_size += size;
+  }
+
+  buf->tail = next;
+  assert(0 == buf->tail->used);
+  flush_filled_chunks(buf);
+  return true;
 }
 
+// NOTE "unsafe" writes were previously unchecked, and some callers write a
+//      little more than they checked space for. Since checking for space is
+//      cheap, we move on to another chunk here if needed.
 inline void
 tym_unsafe_buffer_char(struct TymBufferInfo * buf, char c)
 {
-  buf->buffer[buf->write_idx] = c;
+  tym_have_space(buf, 1);
+  buf->tail->data[buf->tail->used] = c;
+  buf->tail->used += 1;
   buf->write_idx += 1;
 }
 
@@ -91,35 +324,66 @@ tym_safe_buffer_replace_last(struct TymBufferInfo * buf, char c)
 {
   assert(NULL != buf);
   assert(buf->write_idx > 0);
-  // buf->write_idx points at the next address to write, and here we change a location
-  // we've written to, so we go negative.
-  buf->buffer[buf->write_idx - 1] = c;
+  // The last character we wrote might be in an earlier chunk, if the
+  // current chunk is still empty.
+  struct TymBufferChunk * chunk = buf->tail;
+  while (NULL != chunk && 0 == chunk->used) {
+    chunk = chunk->prev;
+  }
+  if (NULL == chunk) {
+    // The character was in a chunk that a sink has already written out.
+    tym_buff_error_msg(buf);
+    return;
+  }
+  chunk->data[chunk->used - 1] = c;
 }
 
 inline void
 tym_unsafe_buffer_str(struct TymBufferInfo * buf, char * s)
 {
-  strcpy(buf->buffer + buf->write_idx, s);
+  size_t l = strlen(s);
+  tym_have_space(buf, l);
+  strcpy(buf->tail->data + buf->tail->used, s);
   // NOTE the updated write_idx doesn't include the terminating null character, which
   //      strcpy preserves.
-  buf->write_idx += strlen(s);
+  buf->tail->used += l;
+  buf->write_idx += l;
 }
 
+// A sink only retains the chunks since the last one it wrote out (see
+// flush_filled_chunks), so we refuse to go back further than those.
 inline void
 tym_unsafe_dec_idx(struct TymBufferInfo * buf, size_t n)
 {
-  // FIXME could be made safe by ensuring that "write_idx >= n"
+  struct TymBufferChunk * chunk = buf->tail;
+  size_t retained = chunk->used;
+  while (retained < n && NULL != chunk->prev) {
+    chunk = chunk->prev;
+    retained += chunk->used;
+  }
+  if (retained < n) {
+    tym_buff_error_msg(buf);
+    return;
+  }
+
   buf->write_idx -= n;
+  while (n > buf->tail->used) {
+    n -= buf->tail->used;
+    buf->tail->used = 0;
+    buf->tail = buf->tail->prev;
+  }
+  buf->tail->used -= n;
 }
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) *
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult)
 tym_buf_strcpy(struct TymBufferInfo * dst, const char * src)
 {
   assert(NULL != src);
 
   size_t l = strlen(src) + 1; // NOTE we include \0 in the size of the string.
   if (tym_have_space(dst, l)) {
-    strcpy(dst->buffer + dst->write_idx, src);
+    memcpy(dst->tail->data + dst->tail->used, src, l);
+    dst->tail->used += l;
     dst->write_idx += l;
     return tym_mkval_TymBufferWriteResult(l);
   } else {
@@ -139,13 +403,82 @@ void
 tym_buff_error_msg(void * x)
 {
   struct TymBufferInfo * buf = (struct TymBufferInfo *)x;
-  if (buf->write_idx >= buf->buffer_size) {
-    buf->write_idx = buf->buffer_size - 1;
+  if (-1 != buf->fd) {
+    // The contents of a sink aren't retained, and its write_idx counts what
+    // it has written out, so there's less we can say about it.
+    fprintf(stderr, "Buffer error (sink fd=%d, write_idx=%zu, size=%zu)\n",
+        buf->fd, buf->write_idx, buf->buffer_size);
+  } else {
+    fprintf(stderr, "Buffer error (write_idx=%zu, size=%zu, remaining=%zu)\n|%s|\n",
+        buf->write_idx, buf->buffer_size, buf->buffer_size - buf->write_idx,
+        tym_buffer_contents(buf) - buf->read_idx);
   }
-  buf->buffer[buf->write_idx] = '\0';
-  fprintf(stderr, "Buffer error (write_idx=%zu, size=%zu, remaining=%zu)\n|%s|\n",
-      buf->write_idx, buf->buffer_size, buf->buffer_size - buf->write_idx, buf->buffer);
   assert(false);
 }
 
 TYM_ERROR_CHECK_DEFN(TymBufferWriteResult, size_t, enum TymBufferErrors, tym_buff_error_msg)
+
+static void
+test_buffer_write(struct TymBufferInfo * buf, const char * s)
+{
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res = tym_buf_strcpy(buf, s);
+  assert(tym_is_ok_TymBufferWriteResult(res));
+  tym_unsafe_dec_idx(buf, 1); // chomp the trailing \0.
+}
+
+void
+tym_test_buffer(void)
+{
+  printf("***test_buffer***\n");
+  int fds[2];
+  int rc = pipe(fds);
+  assert(0 == rc);
+
+  // With such small chunks, nearly every write moves on to another chunk,
+  // and the sink writes out and recycles its chunks several times.
+  struct TymBufferInfo * buf = tym_mk_sink_buffer(fds[1], 4);
+  test_buffer_write(buf, "ab");
+  test_buffer_write(buf, "cd");
+  // Move on to an empty chunk, so that "ab" is written out, and then revise
+  // "cd" across the boundary between the empty chunk and the one before it.
+  tym_have_space(buf, 3);
+  assert(0 == buf->tail->used);
+  tym_safe_buffer_replace_last(buf, 'D');
+  tym_unsafe_dec_idx(buf, 1);
+  tym_unsafe_buffer_char(buf, 'E');
+  for (int i = 0; i < 20; i++) {
+    test_buffer_write(buf, "gh");
+    tym_have_space(buf, 3);
+    tym_safe_buffer_replace_last(buf, 'H');
+  }
+  assert(4 + 2 * 20 == tym_buffer_len(buf));
+  bool flushed = tym_flush_buffer(buf);
+  assert(flushed);
+  tym_free_buffer(buf);
+  close(fds[1]);
+
+  char expected[4 + 2 * 20 + 1] = "abcE";
+  for (int i = 0; i < 20; i++) {
+    strcat(expected, "gH");
+  }
+  char got[sizeof(expected)];
+  size_t got_len = 0;
+  ssize_t r;
+  while ((r = read(fds[0], got + got_len, sizeof(got) - got_len)) > 0) {
+    got_len += (size_t)r;
+  }
+  assert(got_len == strlen(expected));
+  assert(0 == memcmp(expected, got, got_len));
+
+  // Writing to the pipe's read end fails, and the failure is reported when
+  // the sink is flushed.
+  buf = tym_mk_sink_buffer(fds[0], 4);
+  for (int i = 0; i < 4; i++) {
+    test_buffer_write(buf, "ab");
+    tym_have_space(buf, 3);
+  }
+  flushed = tym_flush_buffer(buf);
+  assert(!flushed);
+  tym_free_buffer(buf);
+  close(fds[0]);
+}
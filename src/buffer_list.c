@@ -43,7 +43,7 @@ tym_progress_next_entry(struct TymBufferInfo * buf)
 
   if (result) {
     while (tym_more_to_read(buf) ||
-           ('\0' != buf->buffer[buf->read_idx])) {
+           ('\0' != *tym_buffer_contents(buf))) {
       buf->read_idx += 1;
     }
     if (tym_more_to_read(buf)) {
@@ -0,0 +1,2807 @@
+/*
+Copyright Nik Sultana, 2019
+
+This file is part of TYM Datalog. (https://www.github.com/niksu/tym)
+
+TYM Datalog is free software: you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License as published
+by the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+TYM Datalog is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details, a copy of which
+is included in the file called LICENSE distributed with TYM Datalog.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TYM Datalog.  If not, see <https://www.gnu.org/licenses/>.
+
+
+This file: Evaluation of Datalog programs, bottom-up (semi-naive) or top-down
+(tabled).
+*/
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "eval.h"
+#include "hash.h"
+#include "module_tests.h"
+#include "plan.h"
+#include "pool.h"
+#include "util.h"
+
+// NOTE must be a power of 2, since we mask hashes to get slot indices.
+#define TYM_EVAL_INITIAL_SLOTS 64
+
+// Marks a variable that has no value yet, in the tabled engine.
+#define TYM_EVAL_UNBOUND UINT32_MAX
+
+// Beyond this depth of nested calls, the tabled engine leaves new calls to be
+// solved by the oldest incomplete table, rather than solving them straight
+// away, so that long chains of calls don't exhaust the stack.
+#define TYM_EVAL_MAX_DEPTH 1000
+
+// Rounds of bottom-up evaluation in which the threads would split fewer
+// tuples than this are evaluated by one thread, since they'd gain less than
+// it costs to hand the work out.
+#define TYM_EVAL_MIN_PARALLEL 4096
+
+// A job whose tuples are split gets at most one part for each of this many
+// tuples (see job_parts), since each part scans all of them.
+#define TYM_EVAL_MIN_PART 1024
+
+struct TymEvalRange {
+  size_t from;
+  size_t to;
+};
+
+// Tuples that a task derived during a round, for one relation.
+struct TymEvalBuffer {
+  uint32_t * tuples;
+  size_t count;
+  size_t capacity;
+};
+
+// A rule's evaluation during a round, over the given ranges of its body
+// atoms' tuples. If it's split between threads, then each takes its part of
+// body atom part_atom's tuples (see TymEvalRule::part_atom).
+struct TymEvalJob {
+  struct TymEvalRule * rule;
+  size_t member; // The head relation's position in its component.
+  size_t part_atom;
+  struct TymEvalRange * ranges;
+};
+
+// A part of a job, which a task of the evaluator's pool evaluates into a
+// buffer of its own.
+struct TymEvalTask {
+  struct TymEvaluator * ev;
+  const struct TymEvalJob * job;
+  uint32_t part;
+  uint32_t no_parts;
+  struct TymEvalBuffer buffer;
+};
+
+// The tuples in a round's buffers (see TymEvalTask) for one of the
+// component's relations that hash to one part and that are new, kept once
+// each in "set". Since each tuple hashes to one part, the parts' sets are
+// disjoint.
+struct TymEvalShard {
+  const struct TymEvalRelation * rel;
+  size_t member; // The relation's position in its component.
+  const struct TymEvalTask * tasks;
+  size_t no_tasks;
+  uint32_t part;
+  uint32_t no_parts;
+  struct TymEvalRelation set;
+};
+
+struct TymEvalSchedule;
+
+// A component's evaluation, as a task of the evaluator's pool.
+struct TymEvalSccTask {
+  struct TymEvalSchedule * schedule;
+  size_t c;
+  size_t rounds;
+};
+
+// The components that remain to be evaluated, each of which is submitted to
+// the evaluator's pool once the components that it depends on are complete.
+// Component c's dependents are dependents[dependents_starts[c],
+// dependents_starts[c + 1]).
+struct TymEvalSchedule {
+  struct TymEvaluator * ev;
+  pthread_mutex_t lock; // Guards "waiting".
+  size_t * waiting; // Of each component, the number of its dependencies that are incomplete.
+  size_t * dependents_starts;
+  size_t * dependents;
+  struct TymEvalSccTask * tasks;
+  struct TymPoolGroup group;
+};
+
+// The tuples of a body atom's relation that match the atom, projected to the
+// atom's variables (see TymEvalAtom::vars), sorted and without duplicates.
+// Rows that share a prefix are adjacent, so the rows form a trie whose
+// levels are columns. A trie iterator is opened at one level at a time, and
+// at each level it holds its position and the end of the rows that share
+// the prefix above that level.
+struct TymEvalTrie {
+  uint32_t * rows;
+  size_t no_rows;
+  size_t width;
+  size_t level; // Number of levels that are open.
+  size_t * pos;
+  size_t * end;
+};
+
+// The query's table, whose new answers are sent to on_answer.
+struct TymEvalStream {
+  const struct TymEvalTable * root;
+  void (*on_answer)(struct TymMdlValuations *, void *);
+  void * ctxt;
+  struct TymMdlValuations * vals;
+  size_t * positions; // Of each variable's first occurrence in the query.
+};
+
+// State of Tarjan's algorithm over the relations (see find_sccs).
+struct TymEvalTarjan {
+  size_t counter;
+  size_t * number; // Of each relation, in the order they're visited from 1, or 0 if unvisited.
+  size_t * low; // The least number of a relation on the stack that each one reaches.
+  bool * on_stack;
+  size_t * stack;
+  size_t stack_size;
+  size_t no_found; // Relations that have been put in components.
+};
+
+static void dict_free(struct TymStrSet * dict);
+static uint32_t dict_intern(struct TymStrSet * dict, const TymStr * s);
+static uint32_t const_id(struct TymEvaluator * ev, const TymStr * s);
+static bool const_lookup(const struct TymEvaluator * ev, const TymStr * s, uint32_t * id);
+static const TymStr * const_of_id(const struct TymEvaluator * ev, uint32_t id);
+static bool universe_member(const struct TymEvaluator * ev, uint32_t id);
+static uint64_t hash_tuple(const uint32_t * tuple, size_t arity);
+static uint32_t * tuple_at(const struct TymEvalRelation * rel, size_t idx);
+static void relation_init(struct TymEvalRelation * rel, const struct TymPredicate * pred);
+static void relation_free(struct TymEvalRelation * rel);
+static bool relation_insert(struct TymEvalRelation * rel, const uint32_t * tuple);
+static bool relation_member(const struct TymEvalRelation * rel, const uint32_t * tuple);
+static uint64_t hash_key(const uint32_t * tuple, size_t arity, uint64_t positions);
+static bool eq_key(const uint32_t * tuple1, const uint32_t * tuple2, size_t arity, uint64_t positions);
+static size_t index_find(const struct TymEvalRelation * rel, const struct TymEvalIndex * idx, const uint32_t * key);
+static void index_add(struct TymEvalRelation * rel, struct TymEvalIndex * idx, size_t t);
+static size_t relation_index(struct TymEvalRelation * rel, uint64_t positions);
+static size_t index_first(const struct TymEvalRelation * rel, size_t index, const uint32_t * key, size_t to);
+static size_t * relation_lookup(struct TymEvalRelation * rel, const uint32_t * key, uint64_t positions, size_t * count);
+static bool match_slots(const struct TymEvalSlot * slots, size_t arity, const uint32_t * tuple, uint32_t * env);
+static uint32_t var_index(const TymStr ** names, uint32_t * no_names, const TymStr * name);
+static void compile_atom(struct TymEvaluator * ev, const struct TymAtom * at, struct TymEvalAtom * result, const TymStr ** names, uint32_t * no_names, bool * bound, bool in_body);
+static void compile_rule(struct TymEvaluator * ev, const struct TymClause * cl, struct TymEvalRule * rule, const size_t * order);
+static void emit_head(struct TymEvaluator * ev, struct TymEvalRule * rule, size_t pos);
+static void join(struct TymEvaluator * ev, struct TymEvalRule * rule, const struct TymEvalRange * ranges, size_t idx);
+static void join_negated(struct TymEvaluator * ev, struct TymEvalRule * rule, const struct TymEvalRange * ranges, size_t idx, size_t pos);
+static void scc_visit(struct TymEvaluator * ev, struct TymEvalTarjan * tj, size_t r);
+static bool find_sccs(struct TymEvaluator * ev);
+static bool cyclic_body(const struct TymEvalRule * rule);
+static void plan_leapfrog(struct TymEvalRule * rule);
+static int cmp_rows(const uint32_t * row1, const uint32_t * row2, size_t width);
+static void sort_rows(uint32_t * rows, uint32_t * scratch, size_t no_rows, size_t width);
+static void trie_build(struct TymEvalTrie * trie, const struct TymEvalRule * rule, size_t idx, size_t from, size_t to);
+static size_t trie_search(const struct TymEvalTrie * trie, size_t from, size_t to, uint32_t value, bool strict);
+static void trie_open(struct TymEvalTrie * trie);
+static uint32_t trie_key(const struct TymEvalTrie * trie);
+static bool trie_at_end(const struct TymEvalTrie * trie);
+static void trie_next(struct TymEvalTrie * trie);
+static void trie_seek(struct TymEvalTrie * trie, uint32_t value);
+static void leapfrog_level(struct TymEvaluator * ev, struct TymEvalRule * rule, struct TymEvalTrie * tries, size_t depth);
+static void leapfrog(struct TymEvaluator * ev, struct TymEvalRule * rule, const struct TymEvalRange * ranges);
+static bool in_part(const struct TymEvalRule * rule, size_t idx, const uint32_t * tuple);
+static void buffer_add(struct TymEvalBuffer * buffer, const uint32_t * tuple, size_t arity);
+static void run_job(struct TymEvaluator * ev, struct TymEvalRule * rule, const struct TymEvalRange * ranges);
+static uint32_t job_parts(const struct TymEvalJob * job, uint32_t no_threads);
+static void join_task(void * arg);
+static void merge_task(void * arg);
+static void run_round(struct TymEvaluator * ev, size_t c, const struct TymEvalJob * jobs, size_t no_jobs);
+static bool advance(struct TymEvaluator * ev, size_t c);
+static size_t evaluate_scc(struct TymEvaluator * ev, size_t c);
+static void scc_task(void * arg);
+static void evaluate_sccs(struct TymEvaluator * ev, const bool * selected);
+static bool match_pattern(const uint32_t * pattern, size_t arity, const uint32_t * tuple);
+static struct TymEvalTable * table_for(struct TymEvaluator * ev, struct TymEvalRelation * rel, const uint32_t * pattern, bool * is_new);
+static void table_free(struct TymEvalTable * table);
+static void stream_answer(struct TymEvaluator * ev, const uint32_t * tuple);
+static void table_add_answer(struct TymEvaluator * ev, struct TymEvalTable * table, const uint32_t * tuple);
+static void tabled_emit_head(struct TymEvaluator * ev, struct TymEvalTable * table, const struct TymEvalRule * rule, uint32_t * env, uint32_t * tuple, size_t pos);
+static struct TymEvalTable * tabled_call(struct TymEvaluator * ev, struct TymEvalTable * caller, struct TymEvalRelation * rel, const uint32_t * pattern);
+static void tabled_body(struct TymEvaluator * ev, struct TymEvalTable * table, const struct TymEvalRule * rule, uint32_t * env, size_t idx);
+static void tabled_negated(struct TymEvaluator * ev, struct TymEvalTable * table, const struct TymEvalRule * rule, uint32_t * env, size_t idx, size_t pos);
+static void tabled_pass(struct TymEvaluator * ev, struct TymEvalTable * table);
+static void tabled_complete(struct TymEvaluator * ev, struct TymEvalTable * leader);
+static void tabled_solve(struct TymEvaluator * ev, struct TymEvalTable * table);
+static void tabled_prepare(struct TymEvaluator * ev, const struct TymEvalRelation * query_rel, bool negated_query);
+
+// Frees a set of strings that the evaluator owns.
+static void
+dict_free(struct TymStrSet * dict)
+{
+  for (size_t i = 0; i < dict->count; i++) {
+    tym_free_str(dict->strs[i]);
+  }
+  tym_str_set_free(dict);
+}
+
+static uint32_t
+dict_intern(struct TymStrSet * dict, const TymStr * s)
+{
+  uint32_t id;
+  if (!tym_str_set_lookup(dict, s, &id)) {
+    bool added = tym_str_set_add(dict, TYM_STR_DUPLICATE(s), &id);
+    assert(added);
+  }
+  return id;
+}
+
+// Constants are identified by the string table's identifiers if it has them,
+// and otherwise by their identifiers in ev->dict.
+static uint32_t
+const_id(struct TymEvaluator * ev, const TymStr * s)
+{
+#if TYM_STRING_TYPE == 3
+  (void)ev;
+  return tym_str_id(s);
+#else
+  return dict_intern(&ev->dict, s);
+#endif
+}
+
+static bool
+const_lookup(const struct TymEvaluator * ev, const TymStr * s, uint32_t * id)
+{
+#if TYM_STRING_TYPE == 3
+  (void)ev;
+  *id = tym_str_id(s);
+  return true;
+#else
+  return tym_str_set_lookup(&ev->dict, s, id);
+#endif
+}
+
+static const TymStr *
+const_of_id(const struct TymEvaluator * ev, uint32_t id)
+{
+#if TYM_STRING_TYPE == 3
+  (void)ev;
+  return tym_str_of_id(id);
+#else
+  return ev->dict.strs[id];
+#endif
+}
+
+static bool
+universe_member(const struct TymEvaluator * ev, uint32_t id)
+{
+  return id < ev->no_in_universe && ev->in_universe[id];
+}
+
+static uint64_t
+hash_tuple(const uint32_t * tuple, size_t arity)
+{
+  uint64_t result = 0xcbf29ce484222325;
+  for (size_t i = 0; i < arity; i++) {
+    result ^= tuple[i];
+    result *= 0x100000001b3;
+  }
+  // Mix the high bits into the low bits, since the latter are used to index slots.
+  result ^= result >> 33;
+  result *= 0xff51afd7ed558ccd;
+  result ^= result >> 33;
+  return result;
+}
+
+static uint32_t *
+tuple_at(const struct TymEvalRelation * rel, size_t idx)
+{
+  // Nullary relations don't store any identifiers.
+  return (0 == rel->arity) ? NULL : rel->tuples + idx * rel->arity;
+}
+
+static void
+relation_init(struct TymEvalRelation * rel, const struct TymPredicate * pred)
+{
+  rel->predicate = pred;
+  rel->arity = pred->arity;
+  rel->tuples = NULL;
+  rel->count = 0;
+  rel->capacity = 0;
+  rel->delta_lo = 0;
+  rel->delta_hi = 0;
+  rel->no_set_slots = TYM_EVAL_INITIAL_SLOTS;
+  rel->set = calloc(rel->no_set_slots, sizeof *rel->set);
+  assert(NULL != rel->set);
+  rel->first_rule = 0;
+  rel->no_rules = 0;
+  rel->indexes = NULL;
+  rel->no_indexes = 0;
+  rel->scc = 0;
+  rel->complete = false;
+}
+
+static void
+relation_free(struct TymEvalRelation * rel)
+{
+  for (size_t i = 0; i < rel->no_indexes; i++) {
+    free(rel->indexes[i].heads);
+    free(rel->indexes[i].next);
+  }
+  free(rel->indexes);
+  free(rel->tuples);
+  free(rel->set);
+}
+
+static bool
+relation_insert(struct TymEvalRelation * rel, const uint32_t * tuple)
+{
+  size_t width = sizeof *tuple * rel->arity;
+  size_t mask = rel->no_set_slots - 1;
+  size_t i = (size_t)hash_tuple(tuple, rel->arity) & mask;
+  while (0 != rel->set[i]) {
+    if (0 == rel->arity ||
+        0 == memcmp(tuple_at(rel, rel->set[i] - 1), tuple, width)) {
+      return false;
+    }
+    i = (i + 1) & mask;
+  }
+
+  if (rel->count == rel->capacity) {
+    rel->capacity = (0 == rel->capacity) ? TYM_EVAL_INITIAL_SLOTS : 2 * rel->capacity;
+    if (rel->arity > 0) {
+      rel->tuples = realloc(rel->tuples, width * rel->capacity);
+      assert(NULL != rel->tuples);
+    }
+    for (size_t k = 0; k < rel->no_indexes; k++) {
+      rel->indexes[k].next = realloc(rel->indexes[k].next, sizeof *rel->indexes[k].next * rel->capacity);
+      assert(NULL != rel->indexes[k].next);
+    }
+  }
+
+  if (rel->arity > 0) {
+    memcpy(tuple_at(rel, rel->count), tuple, width);
+  }
+  rel->set[i] = rel->count + 1;
+  rel->count++;
+
+  // Keep the load factor at most 1/2.
+  if (2 * rel->count > rel->no_set_slots) {
+    free(rel->set);
+    rel->no_set_slots *= 2;
+    rel->set = calloc(rel->no_set_slots, sizeof *rel->set);
+    assert(NULL != rel->set);
+    mask = rel->no_set_slots - 1;
+    for (size_t t = 0; t < rel->count; t++) {
+      i = (size_t)hash_tuple(tuple_at(rel, t), rel->arity) & mask;
+      while (0 != rel->set[i]) {
+        i = (i + 1) & mask;
+      }
+      rel->set[i] = t + 1;
+    }
+  }
+
+  for (size_t k = 0; k < rel->no_indexes; k++) {
+    index_add(rel, &rel->indexes[k], rel->count - 1);
+  }
+
+  return true;
+}
+
+static bool
+relation_member(const struct TymEvalRelation * rel, const uint32_t * tuple)
+{
+  size_t width = sizeof *tuple * rel->arity;
+  size_t mask = rel->no_set_slots - 1;
+  size_t i = (size_t)hash_tuple(tuple, rel->arity) & mask;
+  while (0 != rel->set[i]) {
+    if (0 == rel->arity ||
+        0 == memcmp(tuple_at(rel, rel->set[i] - 1), tuple, width)) {
+      return true;
+    }
+    i = (i + 1) & mask;
+  }
+  return false;
+}
+
+// Like hash_tuple, but only over the given positions.
+static uint64_t
+hash_key(const uint32_t * tuple, size_t arity, uint64_t positions)
+{
+  uint64_t result = 0xcbf29ce484222325;
+  for (size_t i = 0; i < arity && i < TYM_EVAL_MAX_KEY; i++) {
+    if (0 != (positions & ((uint64_t)1 << i))) {
+      result ^= tuple[i];
+      result *= 0x100000001b3;
+    }
+  }
+  result ^= result >> 33;
+  result *= 0xff51afd7ed558ccd;
+  result ^= result >> 33;
+  return result;
+}
+
+static bool
+eq_key(const uint32_t * tuple1, const uint32_t * tuple2, size_t arity, uint64_t positions)
+{
+  for (size_t i = 0; i < arity && i < TYM_EVAL_MAX_KEY; i++) {
+    if (0 != (positions & ((uint64_t)1 << i)) && tuple1[i] != tuple2[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the slot of the group whose key is that of "key" (a tuple, of which
+// only the index's positions matter), or the empty slot where it would go.
+static size_t
+index_find(const struct TymEvalRelation * rel, const struct TymEvalIndex * idx, const uint32_t * key)
+{
+  size_t mask = idx->no_slots - 1;
+  size_t i = (size_t)hash_key(key, rel->arity, idx->positions) & mask;
+  while (0 != idx->heads[i] &&
+      !eq_key(tuple_at(rel, idx->heads[i] - 1), key, rel->arity, idx->positions)) {
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+// Adds the relation's t'th tuple to the index.
+static void
+index_add(struct TymEvalRelation * rel, struct TymEvalIndex * idx, size_t t)
+{
+  // Keep the load factor at most 1/2.
+  if (2 * (idx->no_keys + 1) > idx->no_slots) {
+    size_t * old_heads = idx->heads;
+    size_t old_no_slots = idx->no_slots;
+    idx->no_slots *= 2;
+    idx->heads = calloc(idx->no_slots, sizeof *idx->heads);
+    assert(NULL != idx->heads);
+    for (size_t i = 0; i < old_no_slots; i++) {
+      if (0 != old_heads[i]) {
+        idx->heads[index_find(rel, idx, tuple_at(rel, old_heads[i] - 1))] = old_heads[i];
+      }
+    }
+    free(old_heads);
+  }
+
+  size_t i = index_find(rel, idx, tuple_at(rel, t));
+  if (0 == idx->heads[i]) {
+    idx->no_keys++;
+  }
+  idx->next[t] = idx->heads[i];
+  idx->heads[i] = t + 1;
+}
+
+// Finds (or makes) the relation's index over the given positions, and
+// returns its number.
+static size_t
+relation_index(struct TymEvalRelation * rel, uint64_t positions)
+{
+  assert(0 != positions);
+  for (size_t k = 0; k < rel->no_indexes; k++) {
+    if (positions == rel->indexes[k].positions) {
+      return k;
+    }
+  }
+
+  rel->indexes = realloc(rel->indexes, sizeof *rel->indexes * (rel->no_indexes + 1));
+  assert(NULL != rel->indexes);
+  struct TymEvalIndex * idx = &rel->indexes[rel->no_indexes];
+  idx->positions = positions;
+  idx->no_slots = TYM_EVAL_INITIAL_SLOTS;
+  idx->no_keys = 0;
+  idx->heads = calloc(idx->no_slots, sizeof *idx->heads);
+  idx->next = malloc(sizeof *idx->next * (rel->capacity + 1));
+  assert(NULL != idx->heads);
+  assert(NULL != idx->next);
+  for (size_t t = 0; t < rel->count; t++) {
+    index_add(rel, idx, t);
+  }
+  return rel->no_indexes++;
+}
+
+// Returns index + 1 of the newest tuple that precedes "to" and agrees with
+// key at the index's positions, or 0 if there's none. Older such tuples are
+// then found by following the index's "next" links.
+static size_t
+index_first(const struct TymEvalRelation * rel, size_t index, const uint32_t * key, size_t to)
+{
+  const struct TymEvalIndex * idx = &rel->indexes[index];
+  size_t t = idx->heads[index_find(rel, idx, key)];
+  while (0 != t && t > to) {
+    t = idx->next[t - 1];
+  }
+  return t;
+}
+
+// Returns the indices of the relation's tuples that agree with key at the
+// given positions, in the order in which the tuples were added, through an
+// index over those positions (which is made if needed). Without positions,
+// all the tuples' indices are returned. The caller frees the result.
+static size_t *
+relation_lookup(struct TymEvalRelation * rel, const uint32_t * key, uint64_t positions, size_t * count)
+{
+  size_t * result;
+  if (0 == positions) {
+    result = malloc(sizeof *result * (rel->count + 1));
+    assert(NULL != result);
+    for (size_t t = 0; t < rel->count; t++) {
+      result[t] = t;
+    }
+    *count = rel->count;
+    return result;
+  }
+
+  size_t index = relation_index(rel, positions);
+  const size_t * next = rel->indexes[index].next;
+  size_t first = index_first(rel, index, key, rel->count);
+  *count = 0;
+  for (size_t t = first; 0 != t; t = next[t - 1]) {
+    (*count)++;
+  }
+  result = malloc(sizeof *result * (*count + 1));
+  assert(NULL != result);
+  // The index holds the tuples newest-first.
+  size_t i = *count;
+  for (size_t t = first; 0 != t; t = next[t - 1]) {
+    result[--i] = t - 1;
+  }
+  return result;
+}
+
+static bool
+match_slots(const struct TymEvalSlot * slots, size_t arity, const uint32_t * tuple, uint32_t * env)
+{
+  for (size_t i = 0; i < arity; i++) {
+    switch (slots[i].kind) {
+    case TYM_EVAL_CONST:
+      if (tuple[i] != slots[i].value) {
+        return false;
+      }
+      break;
+    case TYM_EVAL_BIND:
+      env[slots[i].value] = tuple[i];
+      break;
+    case TYM_EVAL_CHECK:
+      if (tuple[i] != env[slots[i].value]) {
+        return false;
+      }
+      break;
+    default:
+      assert(false);
+    }
+  }
+  return true;
+}
+
+static uint32_t
+var_index(const TymStr ** names, uint32_t * no_names, const TymStr * name)
+{
+  // FIXME linear-time lookup, but rules tend to have few variables.
+  for (uint32_t i = 0; i < *no_names; i++) {
+    if (tym_eq_str(names[i], name)) {
+      return i;
+    }
+  }
+  names[*no_names] = name;
+  return (*no_names)++;
+}
+
+static void
+compile_atom(struct TymEvaluator * ev, const struct TymAtom * at, struct TymEvalAtom * result, const TymStr ** names, uint32_t * no_names, bool * bound, bool in_body)
+{
+  uint32_t rel_idx;
+  bool found = tym_str_set_lookup(&ev->predicates, at->predicate, &rel_idx);
+  assert(found);
+  result->relation = &ev->relations[rel_idx];
+  assert(at->arity == result->relation->arity);
+
+  result->slots = NULL;
+  if (at->arity > 0) {
+    result->slots = malloc(sizeof *result->slots * at->arity);
+    assert(NULL != result->slots);
+  }
+
+  // The positions that have values before the atom is joined: those of
+  // constants, and of variables that earlier atoms bind.
+  uint64_t positions = 0;
+  for (size_t i = 0; i < at->arity && i < TYM_EVAL_MAX_KEY; i++) {
+    if (TYM_CONST == at->args[i]->kind ||
+        bound[var_index(names, no_names, at->args[i]->identifier)]) {
+      positions |= (uint64_t)1 << i;
+    }
+  }
+
+  for (size_t i = 0; i < at->arity; i++) {
+    if (TYM_VAR == at->args[i]->kind) {
+      uint32_t v = var_index(names, no_names, at->args[i]->identifier);
+      result->slots[i].kind = bound[v] ? TYM_EVAL_CHECK : TYM_EVAL_BIND;
+      result->slots[i].value = v;
+      bound[v] = true;
+    } else {
+      result->slots[i].kind = TYM_EVAL_CONST;
+      result->slots[i].value = const_id(ev, at->args[i]->identifier);
+    }
+  }
+
+  result->negated = at->negated;
+  result->no_vars = 0;
+  result->vars = NULL;
+  result->columns = NULL;
+
+  // A body atom is joined through the index over its bound positions.
+  result->index = TYM_EVAL_NO_INDEX;
+  if (in_body && !at->negated && 0 != positions) {
+    result->index = relation_index(result->relation, positions);
+  }
+}
+
+// The body's atoms are compiled in the given order, in which they'll be
+// joined.
+static void
+compile_rule(struct TymEvaluator * ev, const struct TymClause * cl, struct TymEvalRule * rule, const size_t * order)
+{
+  size_t max_vars = cl->head->arity;
+  for (size_t i = 0; i < cl->body_size; i++) {
+    max_vars += cl->body[i]->arity;
+  }
+  if (0 == max_vars) {
+    max_vars = 1;
+  }
+
+  const TymStr ** names = malloc(sizeof *names * max_vars);
+  bool * bound = calloc(max_vars, sizeof *bound);
+  uint32_t no_names = 0;
+
+  // The body is compiled first, so that head variables are bound by it.
+  rule->body_size = cl->body_size;
+  rule->body = NULL;
+  if (cl->body_size > 0) {
+    rule->body = malloc(sizeof *rule->body * cl->body_size);
+    assert(NULL != rule->body);
+  }
+  for (size_t i = 0; i < cl->body_size; i++) {
+    compile_atom(ev, cl->body[order[i]], &rule->body[i], names, &no_names, bound, true);
+  }
+  compile_atom(ev, cl->head, &rule->head, names, &no_names, bound, false);
+
+  rule->no_vars = no_names;
+  rule->env = malloc(sizeof *rule->env * max_vars);
+  rule->head_tuple = malloc(sizeof *rule->head_tuple * (cl->head->arity + 1));
+  plan_leapfrog(rule);
+  rule->part_atom = TYM_EVAL_NO_PART;
+  rule->part = 0;
+  rule->no_parts = 1;
+  rule->out = NULL;
+
+  // An atom's join key is made of the positions of the variables that other
+  // atoms share, or of all its positions if there are none.
+  for (size_t k = 0; k < rule->body_size; k++) {
+    struct TymEvalAtom * at = &rule->body[k];
+    at->join_key = 0;
+    for (size_t i = 0; i < at->relation->arity && i < TYM_EVAL_MAX_KEY; i++) {
+      if (TYM_EVAL_CONST == at->slots[i].kind) {
+        continue;
+      }
+      for (size_t l = 0; l < rule->body_size; l++) {
+        const struct TymEvalAtom * other = &rule->body[l];
+        for (size_t j = 0; l != k && j < other->relation->arity; j++) {
+          if (TYM_EVAL_CONST != other->slots[j].kind &&
+              other->slots[j].value == at->slots[i].value) {
+            at->join_key |= (uint64_t)1 << i;
+          }
+        }
+      }
+    }
+    if (0 == at->join_key) {
+      for (size_t i = 0; i < at->relation->arity && i < TYM_EVAL_MAX_KEY; i++) {
+        at->join_key |= (uint64_t)1 << i;
+      }
+    }
+  }
+
+  free(names);
+  free(bound);
+}
+
+// Visits relation r, and then (depth first) the relations that its rules'
+// bodies use. r's component is found once they've all been visited, unless
+// they reach a relation that was visited before r and is still on the stack,
+// in which case r is in that relation's component.
+static void
+scc_visit(struct TymEvaluator * ev, struct TymEvalTarjan * tj, size_t r)
+{
+  tj->number[r] = ++tj->counter;
+  tj->low[r] = tj->number[r];
+  tj->stack[tj->stack_size++] = r;
+  tj->on_stack[r] = true;
+
+  const struct TymEvalRelation * rel = &ev->relations[r];
+  for (size_t k = rel->first_rule; k < rel->first_rule + rel->no_rules; k++) {
+    const struct TymEvalRule * rule = &ev->rules[k];
+    for (size_t j = 0; j < rule->body_size; j++) {
+      size_t s = (size_t)(rule->body[j].relation - ev->relations);
+      if (0 == tj->number[s]) {
+        scc_visit(ev, tj, s);
+        if (tj->low[s] < tj->low[r]) {
+          tj->low[r] = tj->low[s];
+        }
+      } else if (tj->on_stack[s] && tj->number[s] < tj->low[r]) {
+        tj->low[r] = tj->number[s];
+      }
+    }
+  }
+
+  if (tj->low[r] == tj->number[r]) {
+    // The relations above r on the stack are in its component.
+    size_t c = ev->no_sccs++;
+    ev->scc_starts[c] = tj->no_found;
+    size_t s;
+    do {
+      s = tj->stack[--tj->stack_size];
+      tj->on_stack[s] = false;
+      ev->relations[s].scc = c;
+      ev->scc_relations[tj->no_found++] = s;
+    } while (s != r);
+  }
+}
+
+// Finds the relations' strongly connected components by Tarjan's algorithm,
+// which finds each component after those that it depends on. The program is
+// stratified if no rule negates a relation in its head's component, and then
+// each relation is complete by the time that any rule negates it.
+static bool
+find_sccs(struct TymEvaluator * ev)
+{
+  struct TymEvalTarjan tj;
+  tj.counter = 0;
+  tj.number = calloc(ev->no_relations + 1, sizeof *tj.number);
+  tj.low = malloc(sizeof *tj.low * (ev->no_relations + 1));
+  tj.on_stack = calloc(ev->no_relations + 1, sizeof *tj.on_stack);
+  tj.stack = malloc(sizeof *tj.stack * (ev->no_relations + 1));
+  assert(NULL != tj.number);
+  assert(NULL != tj.low);
+  assert(NULL != tj.on_stack);
+  assert(NULL != tj.stack);
+  tj.stack_size = 0;
+  tj.no_found = 0;
+
+  ev->scc_starts = malloc(sizeof *ev->scc_starts * (ev->no_relations + 1));
+  ev->scc_relations = malloc(sizeof *ev->scc_relations * (ev->no_relations + 1));
+  assert(NULL != ev->scc_starts);
+  assert(NULL != ev->scc_relations);
+  ev->no_sccs = 0;
+  for (size_t r = 0; r < ev->no_relations; r++) {
+    if (0 == tj.number[r]) {
+      scc_visit(ev, &tj, r);
+    }
+  }
+  ev->scc_starts[ev->no_sccs] = ev->no_relations;
+
+  free(tj.number);
+  free(tj.low);
+  free(tj.on_stack);
+  free(tj.stack);
+
+  for (size_t k = 0; k < ev->no_rules; k++) {
+    const struct TymEvalRule * rule = &ev->rules[k];
+    for (size_t j = 0; j < rule->body_size; j++) {
+      if (rule->body[j].negated &&
+          rule->body[j].relation->scc == rule->head.relation->scc) {
+        TYM_ERR("The program isn't stratified: %s depends on the negation of %s, recursively.\n",
+            tym_decode_str(rule->head.relation->predicate->predicate),
+            tym_decode_str(rule->body[j].relation->predicate->predicate));
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Returns NULL if the program isn't stratified (see find_sccs).
+
+struct TymEvaluator *
+tym_mk_evaluator(struct TymAtomDatabase * adb)
+{
+  assert(NULL != adb);
+
+  struct TymEvaluator * ev = malloc(sizeof *ev);
+  assert(NULL != ev);
+#if TYM_STRING_TYPE != 3
+  tym_str_set_init(&ev->dict);
+#endif
+  tym_str_set_init(&ev->predicates);
+  ev->iterations = 0;
+  ev->no_tables = 0;
+  ev->tables_capacity = 0;
+  ev->tables = NULL;
+  ev->no_table_slots = TYM_EVAL_INITIAL_SLOTS;
+  ev->table_slots = calloc(ev->no_table_slots, sizeof *ev->table_slots);
+  assert(NULL != ev->table_slots);
+  ev->stack = NULL;
+  ev->stack_size = 0;
+  ev->depth = 0;
+  ev->no_answers = 0;
+  ev->stream = NULL;
+  ev->no_sccs = 0;
+  ev->scc_starts = NULL;
+  ev->scc_relations = NULL;
+  ev->no_threads = 1;
+  ev->pool = NULL;
+
+  // Each predicate gets a relation, whose index is the predicate name's
+  // identifier in ev->predicates.
+  ev->no_relations = 0;
+  struct TymPredicates * preds = tym_atom_database_to_predicates(adb);
+  for (const struct TymPredicates * cursor = preds; NULL != cursor; cursor = cursor->next) {
+    ev->no_relations++;
+  }
+  ev->relations = malloc(sizeof *ev->relations * (ev->no_relations + 1));
+  assert(NULL != ev->relations);
+
+  size_t no_clauses = 0;
+  size_t i = 0;
+  while (NULL != preds) {
+    relation_init(&ev->relations[i], preds->predicate);
+    uint32_t id = dict_intern(&ev->predicates, preds->predicate->predicate);
+    assert(id == i);
+    no_clauses += tym_num_predicate_bodies(preds->predicate);
+    i++;
+
+    struct TymPredicates * pre_preds = preds;
+    preds = preds->next;
+    free(pre_preds);
+  }
+
+  ev->universe_size = 0;
+  ev->universe = NULL;
+  for (const struct TymTerms * cursor = adb->tdb->herbrand_universe; NULL != cursor; cursor = cursor->next) {
+    ev->universe_size++;
+  }
+  if (ev->universe_size > 0) {
+    ev->universe = malloc(sizeof *ev->universe * ev->universe_size);
+    assert(NULL != ev->universe);
+  }
+  ev->universe_size = 0;
+#if TYM_STRING_TYPE == 3
+  bool * seen = calloc(tym_no_strs() + 1, sizeof *seen);
+  assert(NULL != seen);
+#endif
+  for (const struct TymTerms * cursor = adb->tdb->herbrand_universe; NULL != cursor; cursor = cursor->next) {
+#if TYM_STRING_TYPE == 3
+    uint32_t id = tym_str_id(cursor->term->identifier);
+    bool is_new = !seen[id];
+    seen[id] = true;
+#else
+    size_t before = ev->dict.count;
+    uint32_t id = dict_intern(&ev->dict, cursor->term->identifier);
+    bool is_new = (id == before);
+#endif
+    if (is_new) {
+      // Only add constants the first time we see them.
+      ev->universe[ev->universe_size++] = id;
+    }
+  }
+#if TYM_STRING_TYPE == 3
+  free(seen);
+#endif
+  ev->no_in_universe = 0;
+  for (size_t u = 0; u < ev->universe_size; u++) {
+    if (ev->universe[u] >= ev->no_in_universe) {
+      ev->no_in_universe = (size_t)ev->universe[u] + 1;
+    }
+  }
+  ev->in_universe = calloc(ev->no_in_universe + 1, sizeof *ev->in_universe);
+  assert(NULL != ev->in_universe);
+  for (size_t u = 0; u < ev->universe_size; u++) {
+    ev->in_universe[ev->universe[u]] = true;
+  }
+
+  // Ground facts are loaded directly into their relations, and all other
+  // clauses are compiled into rules.
+  ev->no_rules = 0;
+  ev->rules = malloc(sizeof *ev->rules * (no_clauses + 1));
+  assert(NULL != ev->rules);
+  const struct TymClause ** clauses = malloc(sizeof *clauses * (no_clauses + 1));
+  assert(NULL != clauses);
+  size_t max_arity = 0;
+  for (size_t r = 0; r < ev->no_relations; r++) {
+    if (ev->relations[r].arity > max_arity) {
+      max_arity = ev->relations[r].arity;
+    }
+  }
+  uint32_t * tuple = malloc(sizeof *tuple * (max_arity + 1));
+
+  for (size_t r = 0; r < ev->no_relations; r++) {
+    // Predicates' bodies are stored in the reverse order to how they
+    // appeared in the program, so we restore that order here.
+    size_t n = 0;
+    for (const struct TymClauses * cursor = ev->relations[r].predicate->bodies; NULL != cursor; cursor = cursor->next) {
+      clauses[n++] = cursor->clause;
+    }
+    ev->relations[r].first_rule = ev->no_rules;
+    while (n > 0) {
+      const struct TymClause * cl = clauses[--n];
+      if (tym_ground_fact(cl)) {
+        for (size_t j = 0; j < cl->head->arity; j++) {
+          tuple[j] = const_id(ev, cl->head->args[j]->identifier);
+        }
+        (void)relation_insert(&ev->relations[r], tuple);
+      } else {
+        size_t order[cl->body_size + 1];
+        tym_plan_body(cl, adb, order);
+        compile_rule(ev, cl, &ev->rules[ev->no_rules], order);
+        ev->no_rules++;
+      }
+    }
+    ev->relations[r].no_rules = ev->no_rules - ev->relations[r].first_rule;
+    // A relation without rules only has its facts, so it has no delta.
+    ev->relations[r].complete = (0 == ev->relations[r].no_rules);
+    ev->relations[r].delta_lo = ev->relations[r].count;
+    ev->relations[r].delta_hi = ev->relations[r].count;
+  }
+
+  free(tuple);
+  free(clauses);
+
+  if (!find_sccs(ev)) {
+    tym_free_evaluator(ev);
+    return NULL;
+  }
+  return ev;
+}
+
+void
+tym_free_evaluator(struct TymEvaluator * ev)
+{
+  for (size_t i = 0; i < ev->no_rules; i++) {
+    struct TymEvalRule * rule = &ev->rules[i];
+    for (size_t j = 0; j < rule->body_size; j++) {
+      free(rule->body[j].slots);
+      free(rule->body[j].vars);
+      free(rule->body[j].columns);
+    }
+    free(rule->body);
+    free(rule->order);
+    free(rule->head.slots);
+    free(rule->env);
+    free(rule->head_tuple);
+  }
+  free(ev->rules);
+
+  for (size_t i = 0; i < ev->no_tables; i++) {
+    table_free(ev->tables[i]);
+  }
+  free(ev->tables);
+  free(ev->table_slots);
+  free(ev->stack);
+
+  for (size_t i = 0; i < ev->no_relations; i++) {
+    relation_free(&ev->relations[i]);
+  }
+  free(ev->relations);
+  free(ev->universe);
+  free(ev->in_universe);
+  free(ev->scc_starts);
+  free(ev->scc_relations);
+
+#if TYM_STRING_TYPE != 3
+  dict_free(&ev->dict);
+#endif
+  dict_free(&ev->predicates);
+  if (NULL != ev->pool) {
+    tym_free_pool(ev->pool);
+  }
+  free(ev);
+}
+
+static void
+emit_head(struct TymEvaluator * ev, struct TymEvalRule * rule, size_t pos)
+{
+  const struct TymEvalAtom * head = &rule->head;
+  for (; pos < head->relation->arity; pos++) {
+    const struct TymEvalSlot * slot = &head->slots[pos];
+    if (TYM_EVAL_BIND == slot->kind) {
+      // This variable doesn't appear in the body, so it ranges over the universe.
+      for (size_t u = 0; u < ev->universe_size; u++) {
+        rule->env[slot->value] = ev->universe[u];
+        rule->head_tuple[pos] = ev->universe[u];
+        emit_head(ev, rule, pos + 1);
+      }
+      return;
+    } else if (TYM_EVAL_CONST == slot->kind) {
+      rule->head_tuple[pos] = slot->value;
+    } else {
+      rule->head_tuple[pos] = rule->env[slot->value];
+    }
+  }
+  if (NULL == rule->out) {
+    (void)relation_insert(head->relation, rule->head_tuple);
+  } else {
+    buffer_add(rule->out, rule->head_tuple, head->relation->arity);
+  }
+}
+
+static void
+join(struct TymEvaluator * ev, struct TymEvalRule * rule, const struct TymEvalRange * ranges, size_t idx)
+{
+  if (idx == rule->body_size) {
+    emit_head(ev, rule, 0);
+    return;
+  }
+
+  const struct TymEvalAtom * at = &rule->body[idx];
+  const struct TymEvalRelation * rel = at->relation;
+  if (at->negated) {
+    join_negated(ev, rule, ranges, idx, 0);
+    return;
+  }
+  if (TYM_EVAL_NO_INDEX == at->index) {
+    for (size_t t = ranges[idx].from; t < ranges[idx].to; t++) {
+      // NOTE the tuple's address must be recomputed at each step, since
+      //      emit_head might have grown the relation we're scanning.
+      if (in_part(rule, idx, tuple_at(rel, t)) &&
+          match_slots(at->slots, rel->arity, tuple_at(rel, t), rule->env)) {
+        join(ev, rule, ranges, idx + 1);
+      }
+    }
+    return;
+  }
+
+  // Only visit the tuples that agree with the atom's bound positions.
+  uint32_t key[rel->arity];
+  for (size_t i = 0; i < rel->arity; i++) {
+    const struct TymEvalSlot * slot = &at->slots[i];
+    key[i] = (TYM_EVAL_CONST == slot->kind) ? slot->value :
+      (TYM_EVAL_CHECK == slot->kind) ? rule->env[slot->value] : 0;
+  }
+  // NOTE the tuples that emit_head adds are newer than those we visit, so
+  //      they don't join the chain that we're following; but the chain's
+  //      links might be moved when the relation grows.
+  for (size_t t = index_first(rel, at->index, key, ranges[idx].to);
+       0 != t && t > ranges[idx].from;
+       t = rel->indexes[at->index].next[t - 1]) {
+    if (in_part(rule, idx, tuple_at(rel, t - 1)) &&
+        match_slots(at->slots, rel->arity, tuple_at(rel, t - 1), rule->env)) {
+      join(ev, rule, ranges, idx + 1);
+    }
+  }
+}
+
+// Joins a negated atom: any of its variables that are still unbound range over
+// the universe, and the join continues for each tuple that isn't in the
+// relation.
+static void
+join_negated(struct TymEvaluator * ev, struct TymEvalRule * rule, const struct TymEvalRange * ranges, size_t idx, size_t pos)
+{
+  const struct TymEvalAtom * at = &rule->body[idx];
+  for (size_t i = pos; i < at->relation->arity; i++) {
+    if (TYM_EVAL_BIND == at->slots[i].kind) {
+      for (size_t u = 0; u < ev->universe_size; u++) {
+        rule->env[at->slots[i].value] = ev->universe[u];
+        join_negated(ev, rule, ranges, idx, i + 1);
+      }
+      return;
+    }
+  }
+
+  uint32_t tuple[at->relation->arity + 1];
+  for (size_t i = 0; i < at->relation->arity; i++) {
+    tuple[i] = (TYM_EVAL_CONST == at->slots[i].kind) ?
+      at->slots[i].value : rule->env[at->slots[i].value];
+  }
+  if (!relation_member(at->relation, tuple)) {
+    join(ev, rule, ranges, idx + 1);
+  }
+}
+
+// Whether the hypergraph that the body's atoms form over its variables is
+// cyclic, by GYO reduction: we repeatedly drop variables that only one atom
+// has, and atoms whose variables another atom has too. The body is acyclic
+// iff at most one atom remains.
+static bool
+cyclic_body(const struct TymEvalRule * rule)
+{
+  if (rule->body_size < 3 || rule->no_vars > 64) {
+    return false;
+  }
+
+  uint64_t masks[rule->body_size];
+  bool alive[rule->body_size];
+  for (size_t k = 0; k < rule->body_size; k++) {
+    masks[k] = 0;
+    alive[k] = true;
+    const struct TymEvalAtom * at = &rule->body[k];
+    for (size_t i = 0; i < at->relation->arity; i++) {
+      if (TYM_EVAL_CONST != at->slots[i].kind) {
+        masks[k] |= (uint64_t)1 << at->slots[i].value;
+      }
+    }
+  }
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (uint32_t v = 0; v < rule->no_vars; v++) {
+      uint64_t bit = (uint64_t)1 << v;
+      size_t owner = 0;
+      size_t count = 0;
+      for (size_t k = 0; k < rule->body_size; k++) {
+        if (alive[k] && 0 != (masks[k] & bit)) {
+          owner = k;
+          count++;
+        }
+      }
+      if (1 == count) {
+        masks[owner] &= ~bit;
+        changed = true;
+      }
+    }
+    for (size_t k = 0; k < rule->body_size; k++) {
+      for (size_t l = 0; alive[k] && l < rule->body_size; l++) {
+        if (k != l && alive[l] && masks[k] == (masks[k] & masks[l])) {
+          alive[k] = false;
+          changed = true;
+        }
+      }
+    }
+  }
+
+  size_t remaining = 0;
+  for (size_t k = 0; k < rule->body_size; k++) {
+    remaining += alive[k];
+  }
+  return remaining > 1;
+}
+
+// Decides whether the rule is joined by Leapfrog Triejoin and, if so, in
+// which order its variables are bound: those that more atoms share come
+// first, since they narrow the join the most.
+static void
+plan_leapfrog(struct TymEvalRule * rule)
+{
+  // Negated atoms are checked one at a time.
+  rule->leapfrog = cyclic_body(rule);
+  for (size_t k = 0; rule->leapfrog && k < rule->body_size; k++) {
+    rule->leapfrog = !rule->body[k].negated;
+  }
+  rule->no_order = 0;
+  rule->order = NULL;
+  if (!rule->leapfrog) {
+    return;
+  }
+
+  size_t no_atoms[rule->no_vars];
+  bool in_body[rule->no_vars];
+  for (uint32_t v = 0; v < rule->no_vars; v++) {
+    no_atoms[v] = 0;
+    in_body[v] = false;
+  }
+  for (size_t k = 0; k < rule->body_size; k++) {
+    const struct TymEvalAtom * at = &rule->body[k];
+    for (size_t i = 0; i < at->relation->arity; i++) {
+      if (TYM_EVAL_BIND == at->slots[i].kind) {
+        in_body[at->slots[i].value] = true;
+      }
+    }
+    // Count each atom once for each of its distinct variables.
+    for (size_t i = 0; i < at->relation->arity; i++) {
+      bool first = (TYM_EVAL_CONST != at->slots[i].kind);
+      for (size_t j = 0; first && j < i; j++) {
+        first = (TYM_EVAL_CONST == at->slots[j].kind || at->slots[j].value != at->slots[i].value);
+      }
+      if (first) {
+        no_atoms[at->slots[i].value]++;
+      }
+    }
+  }
+
+  // Variables are numbered in the order of their first occurrence in the
+  // body, which breaks ties.
+  rule->order = malloc(sizeof *rule->order * (rule->no_vars + 1));
+  assert(NULL != rule->order);
+  uint32_t rank[rule->no_vars + 1];
+  for (uint32_t v = 0; v < rule->no_vars; v++) {
+    if (!in_body[v]) {
+      continue;
+    }
+    uint32_t i = rule->no_order++;
+    while (i > 0 && no_atoms[rule->order[i - 1]] < no_atoms[v]) {
+      rule->order[i] = rule->order[i - 1];
+      i--;
+    }
+    rule->order[i] = v;
+  }
+  for (uint32_t i = 0; i < rule->no_order; i++) {
+    rank[rule->order[i]] = i;
+  }
+
+  for (size_t k = 0; k < rule->body_size; k++) {
+    struct TymEvalAtom * at = &rule->body[k];
+    size_t arity = at->relation->arity;
+    at->vars = malloc(sizeof *at->vars * (arity + 1));
+    at->columns = malloc(sizeof *at->columns * (arity + 1));
+    assert(NULL != at->vars);
+    assert(NULL != at->columns);
+    for (size_t i = 0; i < arity; i++) {
+      bool first = (TYM_EVAL_CONST != at->slots[i].kind);
+      for (size_t j = 0; first && j < at->no_vars; j++) {
+        first = (at->vars[j] != at->slots[i].value);
+      }
+      if (!first) {
+        continue;
+      }
+      // Insert the variable by its rank.
+      size_t j = at->no_vars++;
+      while (j > 0 && rank[at->vars[j - 1]] > rank[at->slots[i].value]) {
+        at->vars[j] = at->vars[j - 1];
+        at->columns[j] = at->columns[j - 1];
+        j--;
+      }
+      at->vars[j] = at->slots[i].value;
+      at->columns[j] = i;
+    }
+  }
+}
+
+static int
+cmp_rows(const uint32_t * row1, const uint32_t * row2, size_t width)
+{
+  for (size_t i = 0; i < width; i++) {
+    if (row1[i] != row2[i]) {
+      return (row1[i] < row2[i]) ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+// Merge sort, since qsort can't be told the rows' width.
+static void
+sort_rows(uint32_t * rows, uint32_t * scratch, size_t no_rows, size_t width)
+{
+  if (no_rows < 2) {
+    return;
+  }
+  size_t half = no_rows / 2;
+  sort_rows(rows, scratch, half, width);
+  sort_rows(rows + half * width, scratch, no_rows - half, width);
+
+  size_t i = 0;
+  size_t j = half;
+  size_t n = 0;
+  while (i < half || j < no_rows) {
+    size_t from = (j == no_rows ||
+        (i < half && cmp_rows(rows + i * width, rows + j * width, width) <= 0)) ? i++ : j++;
+    memcpy(scratch + n * width, rows + from * width, sizeof *rows * width);
+    n++;
+  }
+  memcpy(rows, scratch, sizeof *rows * width * no_rows);
+}
+
+// Builds the trie of the idx'th body atom's matches among the tuples in
+// [from, to) that are in the rule's part.
+static void
+trie_build(struct TymEvalTrie * trie, const struct TymEvalRule * rule, size_t idx, size_t from, size_t to)
+{
+  const struct TymEvalAtom * at = &rule->body[idx];
+  const struct TymEvalRelation * rel = at->relation;
+  size_t width = at->no_vars;
+  trie->width = width;
+  trie->level = 0;
+  trie->rows = malloc(sizeof *trie->rows * (width * (to - from) + 1));
+  trie->pos = malloc(sizeof *trie->pos * (width + 1));
+  trie->end = malloc(sizeof *trie->end * (width + 1));
+  assert(NULL != trie->rows);
+  assert(NULL != trie->pos);
+  assert(NULL != trie->end);
+
+  size_t n = 0;
+  for (size_t t = from; t < to; t++) {
+    const uint32_t * tuple = tuple_at(rel, t);
+    bool matches = in_part(rule, idx, tuple);
+    for (size_t i = 0; matches && i < rel->arity; i++) {
+      const struct TymEvalSlot * slot = &at->slots[i];
+      if (TYM_EVAL_CONST == slot->kind) {
+        matches = (tuple[i] == slot->value);
+      } else {
+        // A repeated variable must have the same value as its first
+        // occurrence.
+        for (size_t j = 0; j < i; j++) {
+          if (TYM_EVAL_CONST != at->slots[j].kind && slot->value == at->slots[j].value) {
+            matches = (tuple[i] == tuple[j]);
+            break;
+          }
+        }
+      }
+    }
+    if (!matches) {
+      continue;
+    }
+    for (size_t c = 0; c < width; c++) {
+      trie->rows[n * width + c] = tuple[at->columns[c]];
+    }
+    n++;
+    if (0 == width) {
+      // The atom has no variables, and we only need to know that it holds.
+      break;
+    }
+  }
+
+  uint32_t * scratch = malloc(sizeof *scratch * (width * n + 1));
+  assert(NULL != scratch);
+  sort_rows(trie->rows, scratch, n, width);
+  free(scratch);
+
+  trie->no_rows = 0;
+  for (size_t r = 0; r < n; r++) {
+    if (0 == trie->no_rows ||
+        0 != cmp_rows(trie->rows + (trie->no_rows - 1) * width, trie->rows + r * width, width)) {
+      memmove(trie->rows + trie->no_rows * width, trie->rows + r * width, sizeof *trie->rows * width);
+      trie->no_rows++;
+    }
+  }
+}
+
+// Returns the first row in [from, to) whose value at the current level is
+// at least (or, if strict, more than) "value". The rows in that range must
+// share their prefix above the current level.
+static size_t
+trie_search(const struct TymEvalTrie * trie, size_t from, size_t to, uint32_t value, bool strict)
+{
+  size_t col = trie->level - 1;
+  while (from < to) {
+    size_t mid = from + (to - from) / 2;
+    uint32_t x = trie->rows[mid * trie->width + col];
+    if (x < value || (strict && x == value)) {
+      from = mid + 1;
+    } else {
+      to = mid;
+    }
+  }
+  return from;
+}
+
+// Descends to the rows below the current key.
+static void
+trie_open(struct TymEvalTrie * trie)
+{
+  size_t l = trie->level;
+  if (0 == l) {
+    trie->pos[0] = 0;
+    trie->end[0] = trie->no_rows;
+  } else {
+    trie->pos[l] = trie->pos[l - 1];
+    trie->end[l] = trie_search(trie, trie->pos[l - 1], trie->end[l - 1], trie_key(trie), true);
+  }
+  trie->level++;
+}
+
+static uint32_t
+trie_key(const struct TymEvalTrie * trie)
+{
+  size_t col = trie->level - 1;
+  return trie->rows[trie->pos[col] * trie->width + col];
+}
+
+static bool
+trie_at_end(const struct TymEvalTrie * trie)
+{
+  size_t col = trie->level - 1;
+  return trie->pos[col] == trie->end[col];
+}
+
+static void
+trie_next(struct TymEvalTrie * trie)
+{
+  size_t col = trie->level - 1;
+  trie->pos[col] = trie_search(trie, trie->pos[col], trie->end[col], trie_key(trie), true);
+}
+
+static void
+trie_seek(struct TymEvalTrie * trie, uint32_t value)
+{
+  size_t col = trie->level - 1;
+  trie->pos[col] = trie_search(trie, trie->pos[col], trie->end[col], value, false);
+}
+
+// Binds the depth'th variable in the rule's order to each value that all the
+// atoms that have it agree on, by leapfrogging between their tries.
+static void
+leapfrog_level(struct TymEvaluator * ev, struct TymEvalRule * rule, struct TymEvalTrie * tries, size_t depth)
+{
+  if (depth == rule->no_order) {
+    emit_head(ev, rule, 0);
+    return;
+  }
+
+  uint32_t v = rule->order[depth];
+  struct TymEvalTrie * its[rule->body_size];
+  size_t k = 0;
+  for (size_t i = 0; i < rule->body_size; i++) {
+    const struct TymEvalAtom * at = &rule->body[i];
+    if (tries[i].level < at->no_vars && v == at->vars[tries[i].level]) {
+      trie_open(&tries[i]);
+      its[k++] = &tries[i];
+    }
+  }
+  assert(k > 0);
+
+  bool done = false;
+  for (size_t i = 0; !done && i < k; i++) {
+    done = trie_at_end(its[i]);
+  }
+  // Order the iterators by their keys.
+  for (size_t i = 1; i < k; i++) {
+    struct TymEvalTrie * it = its[i];
+    size_t j = i;
+    while (j > 0 && trie_key(its[j - 1]) > trie_key(it)) {
+      its[j] = its[j - 1];
+      j--;
+    }
+    its[j] = it;
+  }
+
+  size_t p = 0;
+  while (!done) {
+    uint32_t high = trie_key(its[(p + k - 1) % k]);
+    if (trie_key(its[p]) == high) {
+      // All the iterators agree.
+      rule->env[v] = high;
+      leapfrog_level(ev, rule, tries, depth + 1);
+      trie_next(its[p]);
+    } else {
+      trie_seek(its[p], high);
+    }
+    done = trie_at_end(its[p]);
+    p = (p + 1) % k;
+  }
+
+  for (size_t i = 0; i < k; i++) {
+    its[i]->level--;
+  }
+}
+
+// Joins the rule's body by Leapfrog Triejoin, which is worst-case optimal:
+// unlike a sequence of pairwise joins, it doesn't build intermediate results
+// that are larger than the body's result can be.
+static void
+leapfrog(struct TymEvaluator * ev, struct TymEvalRule * rule, const struct TymEvalRange * ranges)
+{
+  struct TymEvalTrie tries[rule->body_size];
+  bool empty = false;
+  for (size_t i = 0; i < rule->body_size; i++) {
+    trie_build(&tries[i], rule, i, ranges[i].from, ranges[i].to);
+    empty |= (0 == tries[i].no_rows);
+  }
+
+  // NOTE the tries are built before any tuples are derived, so they aren't
+  //      affected when the rule's head relation grows.
+  if (!empty) {
+    leapfrog_level(ev, rule, tries, 0);
+  }
+
+  for (size_t i = 0; i < rule->body_size; i++) {
+    free(tries[i].rows);
+    free(tries[i].pos);
+    free(tries[i].end);
+  }
+}
+
+// Whether the tuple, if it's for the rule's idx'th body atom, is in the rule's
+// part: its join key's hash picks the part. The hash's high bits are used,
+// since the low bits pick the slots of the relations' sets.
+static bool
+in_part(const struct TymEvalRule * rule, size_t idx, const uint32_t * tuple)
+{
+  if (1 == rule->no_parts || idx != rule->part_atom) {
+    return true;
+  }
+  const struct TymEvalAtom * at = &rule->body[idx];
+  uint64_t h = hash_key(tuple, at->relation->arity, at->join_key) >> 32;
+  return rule->part == (uint32_t)(h % rule->no_parts);
+}
+
+static void
+buffer_add(struct TymEvalBuffer * buffer, const uint32_t * tuple, size_t arity)
+{
+  if (buffer->count == buffer->capacity) {
+    buffer->capacity = (0 == buffer->capacity) ? TYM_EVAL_INITIAL_SLOTS : 2 * buffer->capacity;
+    buffer->tuples = realloc(buffer->tuples, sizeof *buffer->tuples * (arity * buffer->capacity + 1));
+    assert(NULL != buffer->tuples);
+  }
+  memcpy(buffer->tuples + arity * buffer->count, tuple, sizeof *tuple * arity);
+  buffer->count++;
+}
+
+static void
+run_job(struct TymEvaluator * ev, struct TymEvalRule * rule, const struct TymEvalRange * ranges)
+{
+  if (rule->leapfrog) {
+    leapfrog(ev, rule, ranges);
+  } else {
+    join(ev, rule, ranges, 0);
+  }
+}
+
+// A job is split into as many parts as the pool has threads, unless its
+// part_atom ranges over too few tuples for that.
+static uint32_t
+job_parts(const struct TymEvalJob * job, uint32_t no_threads)
+{
+  if (TYM_EVAL_NO_PART == job->part_atom) {
+    return 1;
+  }
+  const struct TymEvalRange * range = &job->ranges[job->part_atom];
+  size_t no_parts = 1 + (range->to - range->from) / TYM_EVAL_MIN_PART;
+  return (no_parts < no_threads) ? (uint32_t)no_parts : no_threads;
+}
+
+// Evaluates the task's part of its job, on a copy of the job's rule, while
+// the relations are only read.
+static void
+join_task(void * arg)
+{
+  struct TymEvalTask * task = arg;
+  const struct TymEvalJob * job = task->job;
+  struct TymEvalRule rule = *job->rule;
+  uint32_t env[rule.no_vars + 1];
+  uint32_t head_tuple[rule.head.relation->arity + 1];
+  rule.env = env;
+  rule.head_tuple = head_tuple;
+  rule.part_atom = job->part_atom;
+  rule.part = task->part;
+  rule.no_parts = task->no_parts;
+  rule.out = &task->buffer;
+  run_job(task->ev, &rule, job->ranges);
+}
+
+static void
+merge_task(void * arg)
+{
+  struct TymEvalShard * shard = arg;
+  const struct TymEvalRelation * rel = shard->rel;
+  relation_init(&shard->set, rel->predicate);
+  for (size_t k = 0; k < shard->no_tasks; k++) {
+    const struct TymEvalTask * task = &shard->tasks[k];
+    if (task->job->member != shard->member) {
+      continue;
+    }
+    for (size_t t = 0; t < task->buffer.count; t++) {
+      const uint32_t * tuple = task->buffer.tuples + rel->arity * t;
+      uint64_t h = hash_tuple(tuple, rel->arity) >> 32;
+      if (shard->part == (uint32_t)(h % shard->no_parts) &&
+          !relation_member(rel, tuple)) {
+        (void)relation_insert(&shard->set, tuple);
+      }
+    }
+  }
+}
+
+// Evaluates a round's jobs for component c. A big enough round is split into
+// tasks for the evaluator's pool: the tuples of each job's part_atom are
+// partitioned by their join key, and each part's task derives tuples into a
+// buffer of its own. Then the buffers are deduplicated in shards (one for each
+// of the component's relations and each thread), also as tasks, and the
+// shards are added to the relations. Jobs of different sizes get different
+// numbers of parts, and the pool's threads steal the parts that are left.
+static void
+run_round(struct TymEvaluator * ev, size_t c, const struct TymEvalJob * jobs, size_t no_jobs)
+{
+  size_t work = 0;
+  for (size_t i = 0; i < no_jobs; i++) {
+    if (TYM_EVAL_NO_PART != jobs[i].part_atom) {
+      const struct TymEvalRange * range = &jobs[i].ranges[jobs[i].part_atom];
+      work += range->to - range->from;
+    }
+  }
+  if (NULL == ev->pool || work < TYM_EVAL_MIN_PARALLEL) {
+    for (size_t i = 0; i < no_jobs; i++) {
+      run_job(ev, jobs[i].rule, jobs[i].ranges);
+    }
+    return;
+  }
+
+  uint32_t no_threads = tym_pool_size(ev->pool);
+  size_t no_tasks = 0;
+  for (size_t i = 0; i < no_jobs; i++) {
+    no_tasks += job_parts(&jobs[i], no_threads);
+  }
+  struct TymEvalTask * tasks = malloc(sizeof *tasks * no_tasks);
+  assert(NULL != tasks);
+  struct TymPoolGroup group = {.pending = 0};
+  size_t k = 0;
+  for (size_t i = 0; i < no_jobs; i++) {
+    uint32_t no_parts = job_parts(&jobs[i], no_threads);
+    for (uint32_t part = 0; part < no_parts; part++) {
+      tasks[k] = (struct TymEvalTask){
+        .ev = ev,
+        .job = &jobs[i],
+        .part = part,
+        .no_parts = no_parts,
+        .buffer = {.tuples = NULL, .count = 0, .capacity = 0}};
+      tym_pool_submit(ev->pool, &group, join_task, &tasks[k]);
+      k++;
+    }
+  }
+  tym_pool_wait(ev->pool, &group);
+
+  size_t start = ev->scc_starts[c];
+  size_t no_members = ev->scc_starts[c + 1] - start;
+  struct TymEvalShard * shards = malloc(sizeof *shards * no_members * no_threads);
+  assert(NULL != shards);
+  for (size_t m = 0; m < no_members; m++) {
+    for (uint32_t part = 0; part < no_threads; part++) {
+      struct TymEvalShard * shard = &shards[m * no_threads + part];
+      shard->rel = &ev->relations[ev->scc_relations[start + m]];
+      shard->member = m;
+      shard->tasks = tasks;
+      shard->no_tasks = no_tasks;
+      shard->part = part;
+      shard->no_parts = no_threads;
+      tym_pool_submit(ev->pool, &group, merge_task, shard);
+    }
+  }
+  tym_pool_wait(ev->pool, &group);
+
+  for (size_t m = 0; m < no_members; m++) {
+    struct TymEvalRelation * rel = &ev->relations[ev->scc_relations[start + m]];
+    for (uint32_t part = 0; part < no_threads; part++) {
+      struct TymEvalRelation * set = &shards[m * no_threads + part].set;
+      for (size_t t = 0; t < set->count; t++) {
+        (void)relation_insert(rel, tuple_at(set, t));
+      }
+      relation_free(set);
+    }
+  }
+  for (size_t i = 0; i < no_tasks; i++) {
+    free(tasks[i].buffer.tuples);
+  }
+  free(tasks);
+  free(shards);
+}
+
+static bool
+advance(struct TymEvaluator * ev, size_t c)
+{
+  bool changed = false;
+  for (size_t i = ev->scc_starts[c]; i < ev->scc_starts[c + 1]; i++) {
+    struct TymEvalRelation * rel = &ev->relations[ev->scc_relations[i]];
+    rel->delta_lo = rel->delta_hi;
+    rel->delta_hi = rel->count;
+    changed |= (rel->delta_lo < rel->delta_hi);
+  }
+  return changed;
+}
+
+// Computes the relations of component c, whose rules only use relations in c
+// and in components before it, which are complete. Returns the number of
+// rounds after the first.
+static size_t
+evaluate_scc(struct TymEvaluator * ev, size_t c)
+{
+  // Each rule is evaluated at most once for each body atom in a round.
+  size_t max_jobs = 0;
+  size_t max_ranges = 0;
+  for (size_t i = ev->scc_starts[c]; i < ev->scc_starts[c + 1]; i++) {
+    const struct TymEvalRelation * rel = &ev->relations[ev->scc_relations[i]];
+    for (size_t r = rel->first_rule; r < rel->first_rule + rel->no_rules; r++) {
+      size_t body_size = ev->rules[r].body_size;
+      size_t n = (0 == body_size) ? 1 : body_size;
+      max_jobs += n;
+      max_ranges += n * (body_size + 1);
+    }
+  }
+  struct TymEvalJob * jobs = malloc(sizeof *jobs * (max_jobs + 1));
+  struct TymEvalRange * ranges = malloc(sizeof *ranges * (max_ranges + 1));
+  assert(NULL != jobs);
+  assert(NULL != ranges);
+
+  bool recursive = false;
+  size_t rounds = 0;
+  for (size_t i = ev->scc_starts[c]; i < ev->scc_starts[c + 1]; i++) {
+    struct TymEvalRelation * rel = &ev->relations[ev->scc_relations[i]];
+    rel->delta_lo = rel->count;
+    rel->delta_hi = rel->count;
+  }
+
+  // Initially every rule is evaluated over all the tuples that are known,
+  // split (if the round is) by its first non-negated atom.
+  size_t no_jobs = 0;
+  struct TymEvalRange * next = ranges;
+  for (size_t i = ev->scc_starts[c]; i < ev->scc_starts[c + 1]; i++) {
+    const struct TymEvalRelation * rel = &ev->relations[ev->scc_relations[i]];
+    for (size_t r = rel->first_rule; r < rel->first_rule + rel->no_rules; r++) {
+      struct TymEvalRule * rule = &ev->rules[r];
+      struct TymEvalJob * job = &jobs[no_jobs++];
+      job->rule = rule;
+      job->member = i - ev->scc_starts[c];
+      job->part_atom = TYM_EVAL_NO_PART;
+      job->ranges = next;
+      next += rule->body_size + 1;
+      for (size_t k = 0; k < rule->body_size; k++) {
+        recursive |= (rule->body[k].relation->scc == c);
+        job->ranges[k] = (struct TymEvalRange){.from = 0, .to = rule->body[k].relation->delta_hi};
+        if (TYM_EVAL_NO_PART == job->part_atom && !rule->body[k].negated) {
+          job->part_atom = k;
+        }
+      }
+    }
+  }
+  run_round(ev, c, jobs, no_jobs);
+
+  // In each later round, every rule is evaluated once for each body atom
+  // whose relation grew during the previous round. That atom ranges over the
+  // previous round's new tuples (delta), the atoms before it range over
+  // tuples that are older than that, and the atoms after it range over
+  // all tuples that preceded this round. Only the component's relations can
+  // grow, so a component that doesn't use itself needs no more rounds.
+  // A split round is split by the delta.
+  while (advance(ev, c) && recursive) {
+    rounds++;
+    no_jobs = 0;
+    next = ranges;
+    for (size_t i = ev->scc_starts[c]; i < ev->scc_starts[c + 1]; i++) {
+      const struct TymEvalRelation * head_rel = &ev->relations[ev->scc_relations[i]];
+      for (size_t r = head_rel->first_rule; r < head_rel->first_rule + head_rel->no_rules; r++) {
+        struct TymEvalRule * rule = &ev->rules[r];
+        for (size_t j = 0; j < rule->body_size; j++) {
+          const struct TymEvalRelation * rel_j = rule->body[j].relation;
+          if (rel_j->delta_lo == rel_j->delta_hi) {
+            continue;
+          }
+
+          struct TymEvalJob * job = &jobs[no_jobs++];
+          job->rule = rule;
+          job->member = i - ev->scc_starts[c];
+          job->part_atom = j;
+          job->ranges = next;
+          next += rule->body_size + 1;
+          for (size_t k = 0; k < rule->body_size; k++) {
+            const struct TymEvalRelation * rel_k = rule->body[k].relation;
+            if (k < j) {
+              job->ranges[k] = (struct TymEvalRange){.from = 0, .to = rel_k->delta_lo};
+            } else if (k == j) {
+              job->ranges[k] = (struct TymEvalRange){.from = rel_k->delta_lo, .to = rel_k->delta_hi};
+            } else {
+              job->ranges[k] = (struct TymEvalRange){.from = 0, .to = rel_k->delta_hi};
+            }
+          }
+        }
+      }
+    }
+    run_round(ev, c, jobs, no_jobs);
+  }
+
+  free(jobs);
+  free(ranges);
+  for (size_t i = ev->scc_starts[c]; i < ev->scc_starts[c + 1]; i++) {
+    struct TymEvalRelation * rel = &ev->relations[ev->scc_relations[i]];
+    rel->delta_lo = rel->count;
+    rel->delta_hi = rel->count;
+    rel->complete = true;
+  }
+  return rounds;
+}
+
+// Evaluates a component, and then submits those of its dependents that no
+// longer wait for any component.
+static void
+scc_task(void * arg)
+{
+  struct TymEvalSccTask * task = arg;
+  struct TymEvalSchedule * schedule = task->schedule;
+  size_t c = task->c;
+  task->rounds = evaluate_scc(schedule->ev, c);
+
+  pthread_mutex_lock(&schedule->lock);
+  for (size_t i = schedule->dependents_starts[c]; i < schedule->dependents_starts[c + 1]; i++) {
+    size_t d = schedule->dependents[i];
+    schedule->waiting[d]--;
+    if (0 == schedule->waiting[d]) {
+      tym_pool_submit(schedule->ev->pool, &schedule->group, scc_task, &schedule->tasks[d]);
+    }
+  }
+  pthread_mutex_unlock(&schedule->lock);
+}
+
+// Evaluates the selected components that are incomplete, none before those
+// that it depends on, which must be selected or complete. With a single
+// thread they're evaluated in turn (see TymEvaluator::scc_starts). Otherwise
+// they're tasks for the evaluator's pool, so components that don't depend on
+// each other, such as the relations that a stratum negates, are evaluated at
+// the same time.
+static void
+evaluate_sccs(struct TymEvaluator * ev, const bool * selected)
+{
+  if (ev->no_threads > 1 && NULL == ev->pool) {
+    ev->pool = tym_mk_pool(ev->no_threads);
+  }
+
+  bool pending[ev->no_sccs + 1];
+  for (size_t c = 0; c < ev->no_sccs; c++) {
+    pending[c] = selected[c] && !ev->relations[ev->scc_relations[ev->scc_starts[c]]].complete;
+  }
+  if (NULL == ev->pool) {
+    for (size_t c = 0; c < ev->no_sccs; c++) {
+      if (pending[c]) {
+        ev->iterations += evaluate_scc(ev, c);
+      }
+    }
+    return;
+  }
+
+  struct TymEvalSchedule schedule;
+  schedule.ev = ev;
+  schedule.waiting = calloc(ev->no_sccs + 1, sizeof *schedule.waiting);
+  schedule.dependents_starts = calloc(ev->no_sccs + 2, sizeof *schedule.dependents_starts);
+  schedule.tasks = malloc(sizeof *schedule.tasks * (ev->no_sccs + 1));
+  // The last component that found each component among its dependencies,
+  // plus 1, so each dependency is counted once.
+  size_t * seen = calloc(ev->no_sccs + 1, sizeof *seen);
+  assert(NULL != schedule.waiting);
+  assert(NULL != schedule.dependents_starts);
+  assert(NULL != schedule.tasks);
+  assert(NULL != seen);
+
+  // Count each component's dependents, and then place them, in two passes
+  // over the pending components' rules.
+  size_t no_edges = 0;
+  schedule.dependents = NULL;
+  for (unsigned pass = 0; pass < 2; pass++) {
+    for (size_t c = 0; c < ev->no_sccs; c++) {
+      if (!pending[c]) {
+        continue;
+      }
+      for (size_t i = ev->scc_starts[c]; i < ev->scc_starts[c + 1]; i++) {
+        const struct TymEvalRelation * rel = &ev->relations[ev->scc_relations[i]];
+        for (size_t r = rel->first_rule; r < rel->first_rule + rel->no_rules; r++) {
+          const struct TymEvalRule * rule = &ev->rules[r];
+          for (size_t j = 0; j < rule->body_size; j++) {
+            size_t s = rule->body[j].relation->scc;
+            if (s == c || !pending[s] || seen[s] == c + 1) {
+              continue;
+            }
+            assert(s < c);
+            seen[s] = c + 1;
+            if (0 == pass) {
+              schedule.waiting[c]++;
+              schedule.dependents_starts[s + 1]++;
+            } else {
+              schedule.dependents[schedule.dependents_starts[s + 1]++] = c;
+            }
+          }
+        }
+      }
+    }
+    if (0 == pass) {
+      for (size_t c = 0; c < ev->no_sccs; c++) {
+        no_edges += schedule.dependents_starts[c + 1];
+        seen[c] = 0;
+      }
+      schedule.dependents = malloc(sizeof *schedule.dependents * (no_edges + 1));
+      assert(NULL != schedule.dependents);
+      // Each component's dependents are placed from where the previous
+      // component's dependents end.
+      for (size_t c = ev->no_sccs; c > 0; c--) {
+        schedule.dependents_starts[c] = schedule.dependents_starts[c - 1];
+      }
+      for (size_t c = 1; c <= ev->no_sccs; c++) {
+        schedule.dependents_starts[c] += schedule.dependents_starts[c - 1];
+      }
+    }
+  }
+  free(seen);
+
+  int rc = pthread_mutex_init(&schedule.lock, NULL);
+  assert(0 == rc);
+  schedule.group.pending = 0;
+  pthread_mutex_lock(&schedule.lock);
+  for (size_t c = 0; c < ev->no_sccs; c++) {
+    schedule.tasks[c] = (struct TymEvalSccTask){.schedule = &schedule, .c = c, .rounds = 0};
+    if (pending[c] && 0 == schedule.waiting[c]) {
+      tym_pool_submit(ev->pool, &schedule.group, scc_task, &schedule.tasks[c]);
+    }
+  }
+  pthread_mutex_unlock(&schedule.lock);
+  tym_pool_wait(ev->pool, &schedule.group);
+  pthread_mutex_destroy(&schedule.lock);
+
+  for (size_t c = 0; c < ev->no_sccs; c++) {
+    ev->iterations += schedule.tasks[c].rounds;
+  }
+  free(schedule.waiting);
+  free(schedule.dependents_starts);
+  free(schedule.dependents);
+  free(schedule.tasks);
+}
+
+// The components are evaluated in an order in which the relations that a
+// rule negates are complete before the rule is evaluated (see
+// evaluate_sccs).
+void
+tym_evaluator_fixpoint(struct TymEvaluator * ev)
+{
+  bool selected[ev->no_sccs + 1];
+  for (size_t c = 0; c < ev->no_sccs; c++) {
+    selected[c] = true;
+  }
+  evaluate_sccs(ev, selected);
+}
+
+size_t
+tym_evaluator_no_tuples(const struct TymEvaluator * ev)
+{
+  size_t result = 0;
+  for (size_t i = 0; i < ev->no_relations; i++) {
+    result += ev->relations[i].count;
+  }
+  return result;
+}
+
+size_t
+tym_evaluator_query(struct TymEvaluator * ev, const struct TymAtom * query,
+    void (*on_answer)(struct TymMdlValuations *, void *), void * ctxt)
+{
+  // A negated query's answers are the valuations of its variables, over the
+  // universe, for which the atom isn't in its relation. If the relation or
+  // one of the atom's constants is unknown then the atom is in no relation.
+  uint32_t rel_idx;
+  bool absent = false;
+  if (!tym_str_set_lookup(&ev->predicates, query->predicate, &rel_idx) ||
+      query->arity != ev->relations[rel_idx].arity) {
+    if (!query->negated) {
+      return 0;
+    }
+    absent = true;
+  }
+  struct TymEvalRelation * rel = absent ? NULL : &ev->relations[rel_idx];
+  assert(absent || !query->negated || rel->complete);
+
+  struct TymEvalSlot slots[query->arity + 1];
+  uint32_t key[query->arity + 1];
+  uint64_t positions = 0;
+  const TymStr * names[query->arity + 1];
+  uint32_t no_names = 0;
+  for (size_t i = 0; i < query->arity; i++) {
+    key[i] = 0;
+    if (TYM_VAR == query->args[i]->kind) {
+      uint32_t before = no_names;
+      slots[i].value = var_index(names, &no_names, query->args[i]->identifier);
+      slots[i].kind = (before < no_names) ? TYM_EVAL_BIND : TYM_EVAL_CHECK;
+    } else {
+      slots[i].kind = TYM_EVAL_CONST;
+      if (!const_lookup(ev, query->args[i]->identifier, &slots[i].value)) {
+        // The constant doesn't appear in the program, so nothing can match.
+        if (!query->negated) {
+          return 0;
+        }
+        absent = true;
+      }
+      key[i] = slots[i].value;
+      if (i < TYM_EVAL_MAX_KEY) {
+        positions |= (uint64_t)1 << i;
+      }
+    }
+  }
+  names[no_names] = NULL;
+
+  // Valuations are indexed by variable, and we don't use fresh constants.
+  struct TymMdlValuations * vals = tym_mdl_mk_valuations(names, names);
+  uint32_t env[no_names + 1];
+  size_t no_answers = 0;
+
+  if (query->negated) {
+    // Enumerate the valuations like an odometer, whose digits index the universe.
+    size_t digits[no_names + 1];
+    for (uint32_t v = 0; v < no_names; v++) {
+      if (0 == ev->universe_size) {
+        tym_mdl_free_valuations(vals);
+        return 0;
+      }
+      digits[v] = 0;
+    }
+    uint32_t tuple[query->arity + 1];
+    bool more = true;
+    while (more) {
+      for (uint32_t v = 0; v < no_names; v++) {
+        env[v] = ev->universe[digits[v]];
+      }
+      for (size_t i = 0; i < query->arity; i++) {
+        tuple[i] = (TYM_EVAL_CONST == slots[i].kind) ? slots[i].value : env[slots[i].value];
+      }
+      if (absent || !relation_member(rel, tuple)) {
+        for (uint32_t v = 0; v < no_names; v++) {
+          vals->v[v].value = TYM_STR_DUPLICATE(const_of_id(ev, env[v]));
+        }
+        on_answer(vals, ctxt);
+        tym_mdl_reset_valuations(vals);
+        no_answers++;
+      }
+      more = false;
+      for (uint32_t v = 0; !more && v < no_names; v++) {
+        digits[v] = (digits[v] + 1) % ev->universe_size;
+        more = (0 != digits[v]);
+      }
+    }
+    tym_mdl_free_valuations(vals);
+    return no_answers;
+  }
+
+  size_t count;
+  size_t * matches = relation_lookup(rel, key, positions, &count);
+  for (size_t m = 0; m < count; m++) {
+    if (match_slots(slots, rel->arity, tuple_at(rel, matches[m]), env)) {
+      for (uint32_t v = 0; v < no_names; v++) {
+        vals->v[v].value = TYM_STR_DUPLICATE(const_of_id(ev, env[v]));
+      }
+      on_answer(vals, ctxt);
+      tym_mdl_reset_valuations(vals);
+      no_answers++;
+    }
+  }
+  free(matches);
+
+  tym_mdl_free_valuations(vals);
+  return no_answers;
+}
+
+void
+tym_evaluator_print_relations(const struct TymEvaluator * ev)
+{
+  for (size_t i = 0; i < ev->no_relations; i++) {
+    const struct TymEvalRelation * rel = &ev->relations[i];
+    for (size_t t = 0; t < rel->count; t++) {
+      const uint32_t * tuple = tuple_at(rel, t);
+      printf("%s(", tym_decode_str(rel->predicate->predicate));
+      for (size_t j = 0; j < rel->arity; j++) {
+        printf("%s%s", tym_decode_str(const_of_id(ev, tuple[j])),
+            (j < rel->arity - 1) ? ", " : "");
+      }
+      printf(").\n");
+    }
+  }
+}
+
+// Whether a tuple is an instance of a table's pattern: it must agree with the
+// pattern's constants, and have equal values wherever the pattern repeats a
+// variable.
+static bool
+match_pattern(const uint32_t * pattern, size_t arity, const uint32_t * tuple)
+{
+  for (size_t i = 0; i < arity; i++) {
+    if (0 == (pattern[i] & TYM_EVAL_VAR)) {
+      if (tuple[i] != pattern[i]) {
+        return false;
+      }
+    } else {
+      for (size_t j = 0; j < i; j++) {
+        if (pattern[j] == pattern[i]) {
+          if (tuple[j] != tuple[i]) {
+            return false;
+          }
+          break;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// Finds the table for a call, making it if it's new. A new table is placed on
+// the stack of incomplete tables, but isn't solved.
+static struct TymEvalTable *
+table_for(struct TymEvaluator * ev, struct TymEvalRelation * rel, const uint32_t * pattern, bool * is_new)
+{
+  size_t arity = rel->arity;
+  uint64_t h = hash_tuple(pattern, arity) ^ (uint64_t)(rel - ev->relations);
+  size_t mask = ev->no_table_slots - 1;
+  size_t i = (size_t)h & mask;
+  while (0 != ev->table_slots[i]) {
+    struct TymEvalTable * table = ev->tables[ev->table_slots[i] - 1];
+    if (h == table->hash && rel == table->relation &&
+        (0 == arity || 0 == memcmp(pattern, table->pattern, sizeof *pattern * arity))) {
+      *is_new = false;
+      return table;
+    }
+    i = (i + 1) & mask;
+  }
+
+  struct TymEvalTable * table = malloc(sizeof *table);
+  assert(NULL != table);
+  table->relation = rel;
+  table->pattern = malloc(sizeof *table->pattern * (arity + 1));
+  assert(NULL != table->pattern);
+  if (arity > 0) {
+    memcpy(table->pattern, pattern, sizeof *pattern * arity);
+  }
+  table->hash = h;
+  relation_init(&table->answers, rel->predicate);
+  table->dfn = ev->no_tables;
+  table->low = table->dfn;
+  table->complete = false;
+  table->looped = false;
+  table->seeded = false;
+
+  if (ev->no_tables == ev->tables_capacity) {
+    ev->tables_capacity = (0 == ev->tables_capacity) ? TYM_EVAL_INITIAL_SLOTS : 2 * ev->tables_capacity;
+    ev->tables = realloc(ev->tables, sizeof *ev->tables * ev->tables_capacity);
+    ev->stack = realloc(ev->stack, sizeof *ev->stack * ev->tables_capacity);
+    assert(NULL != ev->tables);
+    assert(NULL != ev->stack);
+  }
+  ev->tables[ev->no_tables] = table;
+  ev->table_slots[i] = (uint32_t)ev->no_tables + 1;
+  ev->no_tables++;
+  table->stack_pos = ev->stack_size;
+  ev->stack[ev->stack_size++] = table;
+
+  // Keep the load factor at most 1/2.
+  if (2 * ev->no_tables > ev->no_table_slots) {
+    free(ev->table_slots);
+    ev->no_table_slots *= 2;
+    ev->table_slots = calloc(ev->no_table_slots, sizeof *ev->table_slots);
+    assert(NULL != ev->table_slots);
+    mask = ev->no_table_slots - 1;
+    for (size_t t = 0; t < ev->no_tables; t++) {
+      i = (size_t)ev->tables[t]->hash & mask;
+      while (0 != ev->table_slots[i]) {
+        i = (i + 1) & mask;
+      }
+      ev->table_slots[i] = (uint32_t)t + 1;
+    }
+  }
+
+  *is_new = true;
+  return table;
+}
+
+static void
+table_free(struct TymEvalTable * table)
+{
+  relation_free(&table->answers);
+  free(table->pattern);
+  free(table);
+}
+
+static void
+stream_answer(struct TymEvaluator * ev, const uint32_t * tuple)
+{
+  struct TymEvalStream * stream = ev->stream;
+  for (unsigned v = 0; v < stream->vals->count; v++) {
+    stream->vals->v[v].value = TYM_STR_DUPLICATE(const_of_id(ev, tuple[stream->positions[v]]));
+  }
+  stream->on_answer(stream->vals, stream->ctxt);
+  tym_mdl_reset_valuations(stream->vals);
+}
+
+static void
+table_add_answer(struct TymEvaluator * ev, struct TymEvalTable * table, const uint32_t * tuple)
+{
+  if (!match_pattern(table->pattern, table->answers.arity, tuple) ||
+      !relation_insert(&table->answers, tuple)) {
+    return;
+  }
+  ev->no_answers++;
+  // The query's answers are sent out as soon as they're found, rather than
+  // once its table is complete.
+  if (NULL != ev->stream && table == ev->stream->root) {
+    stream_answer(ev, tuple);
+  }
+}
+
+// Like emit_head, but the rule's variables are held in env, and the tuple
+// becomes an answer of the table.
+static void
+tabled_emit_head(struct TymEvaluator * ev, struct TymEvalTable * table, const struct TymEvalRule * rule, uint32_t * env, uint32_t * tuple, size_t pos)
+{
+  const struct TymEvalAtom * head = &rule->head;
+  for (; pos < head->relation->arity; pos++) {
+    const struct TymEvalSlot * slot = &head->slots[pos];
+    if (TYM_EVAL_CONST == slot->kind) {
+      tuple[pos] = slot->value;
+    } else if (TYM_EVAL_UNBOUND != env[slot->value]) {
+      // A variable that's only in the head ranges over the universe, as it
+      // does bottom-up (see emit_head), so a value that the call gave it
+      // must be in the universe.
+      if (TYM_EVAL_BIND == slot->kind && !universe_member(ev, env[slot->value])) {
+        return;
+      }
+      tuple[pos] = env[slot->value];
+    } else {
+      // Neither the call nor the body gave this variable a value, so it
+      // ranges over the universe.
+      for (size_t u = 0; u < ev->universe_size; u++) {
+        env[slot->value] = ev->universe[u];
+        tuple[pos] = ev->universe[u];
+        tabled_emit_head(ev, table, rule, env, tuple, pos + 1);
+      }
+      env[slot->value] = TYM_EVAL_UNBOUND;
+      return;
+    }
+  }
+  table_add_answer(ev, table, tuple);
+}
+
+// Finds (or makes and solves) the table of a call that's made while solving
+// "caller", and notes whether the caller depends on an incomplete table.
+static struct TymEvalTable *
+tabled_call(struct TymEvaluator * ev, struct TymEvalTable * caller, struct TymEvalRelation * rel, const uint32_t * pattern)
+{
+  bool is_new;
+  struct TymEvalTable * table = table_for(ev, rel, pattern, &is_new);
+  if (is_new) {
+    if (ev->depth < TYM_EVAL_MAX_DEPTH || 0 == rel->no_rules || rel->complete) {
+      tabled_solve(ev, table);
+    } else {
+      // Leave the table to be solved by the oldest incomplete table, which
+      // is solved at a shallow depth.
+      table->looped = true;
+      table->low = ev->stack[0]->dfn;
+    }
+  }
+  if (!table->complete) {
+    caller->looped = true;
+    if (table->low < caller->low) {
+      caller->low = table->low;
+    }
+  }
+  return table;
+}
+
+// Resolves the rule's body from the idx'th atom onwards, calling each atom
+// with the values that its variables have so far, and taking their values
+// from the call's answers.
+static void
+tabled_body(struct TymEvaluator * ev, struct TymEvalTable * table, const struct TymEvalRule * rule, uint32_t * env, size_t idx)
+{
+  if (idx == rule->body_size) {
+    uint32_t tuple[rule->head.relation->arity + 1];
+    tabled_emit_head(ev, table, rule, env, tuple, 0);
+    return;
+  }
+
+  const struct TymEvalAtom * at = &rule->body[idx];
+  if (at->negated) {
+    tabled_negated(ev, table, rule, env, idx, 0);
+    return;
+  }
+  size_t arity = at->relation->arity;
+  uint32_t pattern[arity + 1];
+  uint32_t no_vars = 0;
+  for (size_t i = 0; i < arity; i++) {
+    const struct TymEvalSlot * slot = &at->slots[i];
+    if (TYM_EVAL_CONST == slot->kind) {
+      pattern[i] = slot->value;
+    } else if (TYM_EVAL_UNBOUND != env[slot->value]) {
+      pattern[i] = env[slot->value];
+    } else {
+      pattern[i] = TYM_EVAL_VAR | no_vars;
+      for (size_t j = 0; j < i; j++) {
+        if (TYM_EVAL_CONST != at->slots[j].kind && slot->value == at->slots[j].value) {
+          pattern[i] = pattern[j];
+          break;
+        }
+      }
+      if ((TYM_EVAL_VAR | no_vars) == pattern[i]) {
+        no_vars++;
+      }
+    }
+  }
+
+  struct TymEvalTable * sub = tabled_call(ev, table, at->relation, pattern);
+  // NOTE the number of answers is read at each step, since the table might
+  //      grow while we're using it (e.g., if it's the table being solved).
+  for (size_t t = 0; t < sub->answers.count; t++) {
+    const uint32_t * answer = tuple_at(&sub->answers, t);
+    for (size_t i = 0; i < arity; i++) {
+      if (0 != (pattern[i] & TYM_EVAL_VAR)) {
+        env[at->slots[i].value] = answer[i];
+      }
+    }
+    tabled_body(ev, table, rule, env, idx + 1);
+    for (size_t i = 0; i < arity; i++) {
+      if (0 != (pattern[i] & TYM_EVAL_VAR)) {
+        env[at->slots[i].value] = TYM_EVAL_UNBOUND;
+      }
+    }
+  }
+}
+
+// Like join_negated: the negated atom's relation is complete (see
+// tabled_prepare), so it's looked up rather than called.
+static void
+tabled_negated(struct TymEvaluator * ev, struct TymEvalTable * table, const struct TymEvalRule * rule, uint32_t * env, size_t idx, size_t pos)
+{
+  const struct TymEvalAtom * at = &rule->body[idx];
+  for (size_t i = pos; i < at->relation->arity; i++) {
+    const struct TymEvalSlot * slot = &at->slots[i];
+    if (TYM_EVAL_CONST != slot->kind && TYM_EVAL_UNBOUND == env[slot->value]) {
+      for (size_t u = 0; u < ev->universe_size; u++) {
+        env[slot->value] = ev->universe[u];
+        tabled_negated(ev, table, rule, env, idx, i + 1);
+      }
+      env[slot->value] = TYM_EVAL_UNBOUND;
+      return;
+    }
+  }
+
+  uint32_t tuple[at->relation->arity + 1];
+  for (size_t i = 0; i < at->relation->arity; i++) {
+    tuple[i] = (TYM_EVAL_CONST == at->slots[i].kind) ?
+      at->slots[i].value : env[at->slots[i].value];
+  }
+  assert(at->relation->complete);
+  if (!relation_member(at->relation, tuple)) {
+    tabled_body(ev, table, rule, env, idx + 1);
+  }
+}
+
+// Derives what answers we can for a table, from its relation's facts and from
+// the rules about its relation. A complete relation's tuples are all its
+// answers.
+static void
+tabled_pass(struct TymEvaluator * ev, struct TymEvalTable * table)
+{
+  struct TymEvalRelation * rel = table->relation;
+  if (!table->seeded) {
+    table->seeded = true;
+    // The call's constants pick out the facts through an index.
+    uint64_t positions = 0;
+    for (size_t i = 0; i < rel->arity && i < TYM_EVAL_MAX_KEY; i++) {
+      if (0 == (table->pattern[i] & TYM_EVAL_VAR)) {
+        positions |= (uint64_t)1 << i;
+      }
+    }
+    size_t count;
+    size_t * matches = relation_lookup(rel, table->pattern, positions, &count);
+    for (size_t m = 0; m < count; m++) {
+      table_add_answer(ev, table, tuple_at(rel, matches[m]));
+    }
+    free(matches);
+  }
+
+  for (size_t r = rel->first_rule; !rel->complete && r < rel->first_rule + rel->no_rules; r++) {
+    const struct TymEvalRule * rule = &ev->rules[r];
+    uint32_t env[rule->no_vars + 1];
+    for (uint32_t v = 0; v < rule->no_vars; v++) {
+      env[v] = TYM_EVAL_UNBOUND;
+    }
+
+    // The call's constants give values to the head's variables.
+    bool unifies = true;
+    for (size_t i = 0; unifies && i < rel->arity; i++) {
+      uint32_t value = table->pattern[i];
+      const struct TymEvalSlot * slot = &rule->head.slots[i];
+      if (0 != (value & TYM_EVAL_VAR)) {
+        continue;
+      } else if (TYM_EVAL_CONST == slot->kind) {
+        unifies = (value == slot->value);
+      } else if (TYM_EVAL_UNBOUND == env[slot->value]) {
+        env[slot->value] = value;
+      } else {
+        unifies = (value == env[slot->value]);
+      }
+    }
+
+    if (unifies) {
+      tabled_body(ev, table, rule, env, 0);
+    }
+  }
+}
+
+// Completes the tables that depend on each other, from "leader" to the top of
+// the stack, by solving them again until none of them gains answers, unless
+// they turn out to depend on an older incomplete table.
+static void
+tabled_complete(struct TymEvaluator * ev, struct TymEvalTable * leader)
+{
+  size_t from = leader->stack_pos;
+  bool looped = false;
+  for (size_t i = from; i < ev->stack_size; i++) {
+    looped |= ev->stack[i]->looped;
+  }
+
+  if (looped) {
+    size_t no_answers;
+    size_t stack_size;
+    do {
+      no_answers = ev->no_answers;
+      stack_size = ev->stack_size;
+      // Newer tables are passed first, since they're usually the ones that
+      // older tables take answers from.
+      // NOTE the stack might grow during the pass; the new tables are
+      //      solved as they're made, or passed in the next sweep.
+      for (size_t i = stack_size; i > from; i--) {
+        tabled_pass(ev, ev->stack[i - 1]);
+      }
+    } while (no_answers != ev->no_answers || stack_size != ev->stack_size);
+
+    for (size_t i = from; i < ev->stack_size; i++) {
+      if (ev->stack[i]->low < leader->low) {
+        leader->low = ev->stack[i]->low;
+      }
+    }
+    if (leader->low < leader->dfn) {
+      return;
+    }
+  }
+
+  for (size_t i = from; i < ev->stack_size; i++) {
+    ev->stack[i]->complete = true;
+  }
+  ev->stack_size = from;
+}
+
+static void
+tabled_solve(struct TymEvaluator * ev, struct TymEvalTable * table)
+{
+  ev->depth++;
+  tabled_pass(ev, table);
+  if (table->low == table->dfn) {
+    tabled_complete(ev, table);
+  }
+  ev->depth--;
+}
+
+// Negation isn't resolved top-down: the relations that the query's rules
+// negate (and those of a negated query) are computed bottom-up beforehand,
+// together with the relations that they depend on, component by component.
+static void
+tabled_prepare(struct TymEvaluator * ev, const struct TymEvalRelation * query_rel, bool negated_query)
+{
+  bool reached[ev->no_sccs + 1];
+  bool needed[ev->no_sccs + 1];
+  for (size_t c = 0; c < ev->no_sccs; c++) {
+    reached[c] = false;
+    needed[c] = false;
+  }
+  reached[query_rel->scc] = true;
+  needed[query_rel->scc] = negated_query;
+
+  // Components only depend on those before them.
+  for (size_t c = ev->no_sccs; c > 0; c--) {
+    if (!reached[c - 1] && !needed[c - 1]) {
+      continue;
+    }
+    for (size_t i = ev->scc_starts[c - 1]; i < ev->scc_starts[c]; i++) {
+      const struct TymEvalRelation * rel = &ev->relations[ev->scc_relations[i]];
+      for (size_t r = rel->first_rule; r < rel->first_rule + rel->no_rules; r++) {
+        const struct TymEvalRule * rule = &ev->rules[r];
+        for (size_t j = 0; j < rule->body_size; j++) {
+          size_t s = rule->body[j].relation->scc;
+          reached[s] = true;
+          needed[s] |= needed[c - 1] || rule->body[j].negated;
+        }
+      }
+    }
+  }
+
+  evaluate_sccs(ev, needed);
+}
+
+// Answers a query top-down, by tabled resolution (in the manner of SLG
+// resolution), rather than computing the program's whole least model: only
+// the calls that the query leads to are solved, and each call's answers are
+// kept in a table that's shared by its variants, so recursive calls
+// terminate. Answers are sent to on_answer as soon as they're found.
+// Relations that are complete (see tym_evaluator_fixpoint and
+// tabled_prepare) are looked up rather than resolved.
+size_t
+tym_evaluator_tabled_query(struct TymEvaluator * ev, const struct TymAtom * query,
+    void (*on_answer)(struct TymMdlValuations *, void *), void * ctxt)
+{
+  uint32_t rel_idx;
+  bool known = tym_str_set_lookup(&ev->predicates, query->predicate, &rel_idx) &&
+    query->arity == ev->relations[rel_idx].arity;
+  if (query->negated) {
+    if (known) {
+      tabled_prepare(ev, &ev->relations[rel_idx], true);
+    }
+    return tym_evaluator_query(ev, query, on_answer, ctxt);
+  } else if (!known) {
+    return 0;
+  }
+  struct TymEvalRelation * rel = &ev->relations[rel_idx];
+  tabled_prepare(ev, rel, false);
+
+  uint32_t pattern[query->arity + 1];
+  size_t positions[query->arity + 1];
+  const TymStr * names[query->arity + 1];
+  uint32_t no_names = 0;
+  for (size_t i = 0; i < query->arity; i++) {
+    if (TYM_VAR == query->args[i]->kind) {
+      uint32_t before = no_names;
+      uint32_t v = var_index(names, &no_names, query->args[i]->identifier);
+      if (before < no_names) {
+        positions[v] = i;
+      }
+      pattern[i] = TYM_EVAL_VAR | v;
+    } else if (!const_lookup(ev, query->args[i]->identifier, &pattern[i])) {
+      // The constant doesn't appear in the program, so nothing can match.
+      return 0;
+    }
+  }
+  names[no_names] = NULL;
+
+  // Valuations are indexed by variable, and we don't use fresh constants.
+  struct TymEvalStream stream = {
+    .root = NULL,
+    .on_answer = on_answer,
+    .ctxt = ctxt,
+    .vals = tym_mdl_mk_valuations(names, names),
+    .positions = positions};
+  ev->stream = &stream;
+
+  bool is_new;
+  struct TymEvalTable * table = table_for(ev, rel, pattern, &is_new);
+  if (is_new) {
+    stream.root = table;
+    tabled_solve(ev, table);
+  } else {
+    // An earlier query made this table, so its answers are already known.
+    for (size_t t = 0; t < table->answers.count; t++) {
+      stream_answer(ev, tuple_at(&table->answers, t));
+    }
+  }
+  assert(table->complete);
+
+  ev->stream = NULL;
+  tym_mdl_free_valuations(stream.vals);
+  return table->answers.count;
+}
+
+void
+tym_test_eval(void)
+{
+  printf("***test_eval***\n");
+  // Transitive closure over a chain a -> b -> c -> d.
+  struct TymClause * cls[] = {
+    tym_mk_clause(tym_test_atom("e", 2, "a", "b"), 0, NULL),
+    tym_mk_clause(tym_test_atom("e", 2, "b", "c"), 0, NULL),
+    tym_mk_clause(tym_test_atom("e", 2, "c", "d"), 0, NULL),
+    tym_mk_clause(tym_test_atom("t", 2, "X", "Y"), 1,
+        tym_mk_atom_cell(tym_test_atom("e", 2, "X", "Y"), NULL)),
+    tym_mk_clause(tym_test_atom("t", 2, "X", "Z"), 2,
+        tym_mk_atom_cell(tym_test_atom("e", 2, "X", "Y"),
+          tym_mk_atom_cell(tym_test_atom("t", 2, "Y", "Z"), NULL))),
+  };
+
+  struct TymAtomDatabase * adb = tym_mk_atom_database();
+  for (size_t i = 0; i < sizeof(cls) / sizeof(cls[0]); i++) {
+    enum TymCdlAddError error_code;
+    bool success = tym_clause_database_add(cls[i], adb, &error_code);
+    assert(success);
+    tym_free_clause(cls[i]);
+  }
+
+  struct TymEvaluator * ev = tym_mk_evaluator(adb);
+  // The recursive rule joins t through an index over t's first argument,
+  // which e binds, and scans e.
+  for (size_t i = 0; i < ev->no_rules; i++) {
+    if (2 == ev->rules[i].body_size) {
+      const struct TymEvalAtom * t_atom = &ev->rules[i].body[1];
+      assert(TYM_EVAL_NO_INDEX == ev->rules[i].body[0].index);
+      assert(TYM_EVAL_NO_INDEX != t_atom->index);
+      assert(1 == t_atom->relation->indexes[t_atom->index].positions);
+    }
+  }
+  tym_evaluator_fixpoint(ev);
+  tym_evaluator_print_relations(ev);
+  assert(9 == tym_evaluator_no_tuples(ev));
+
+  size_t counted = 0;
+  struct TymAtom * query = tym_test_atom("t", 2, "a", "X");
+  assert(3 == tym_evaluator_query(ev, query, tym_test_count_answer, &counted));
+  assert(3 == counted);
+  tym_free_atom(query);
+
+  query = tym_test_atom("t", 2, "X", "X");
+  assert(0 == tym_evaluator_query(ev, query, tym_test_count_answer, &counted));
+  tym_free_atom(query);
+
+  tym_free_evaluator(ev);
+
+  // The same queries, answered top-down. Only the calls that t(a, X) leads to
+  // get tables: t and e for each of a, b, c and d.
+  ev = tym_mk_evaluator(adb);
+  counted = 0;
+  query = tym_test_atom("t", 2, "a", "X");
+  assert(3 == tym_evaluator_tabled_query(ev, query, tym_test_count_answer, &counted));
+  assert(3 == counted);
+  assert(8 == ev->no_tables);
+  tym_free_atom(query);
+
+  query = tym_test_atom("t", 2, "X", "X");
+  assert(0 == tym_evaluator_tabled_query(ev, query, tym_test_count_answer, &counted));
+  tym_free_atom(query);
+
+  tym_free_evaluator(ev);
+  tym_free_atom_database(adb);
+
+  // A triangle a -> b -> c -> a, with an edge c -> d that's in none. The
+  // rule's body is cyclic, so it's joined by leapfrogging.
+  struct TymClause * tri_cls[] = {
+    tym_mk_clause(tym_test_atom("e", 2, "a", "b"), 0, NULL),
+    tym_mk_clause(tym_test_atom("e", 2, "b", "c"), 0, NULL),
+    tym_mk_clause(tym_test_atom("e", 2, "c", "a"), 0, NULL),
+    tym_mk_clause(tym_test_atom("e", 2, "c", "d"), 0, NULL),
+    tym_mk_clause(tym_test_atom("p", 2, "X", "Z"), 3,
+        tym_mk_atom_cell(tym_test_atom("e", 2, "X", "Y"),
+          tym_mk_atom_cell(tym_test_atom("e", 2, "Y", "Z"),
+            tym_mk_atom_cell(tym_test_atom("e", 2, "Z", "X"), NULL)))),
+  };
+  adb = tym_mk_atom_database();
+  for (size_t i = 0; i < sizeof(tri_cls) / sizeof(tri_cls[0]); i++) {
+    enum TymCdlAddError error_code;
+    bool success = tym_clause_database_add(tri_cls[i], adb, &error_code);
+    assert(success);
+    tym_free_clause(tri_cls[i]);
+  }
+
+  ev = tym_mk_evaluator(adb);
+  assert(1 == ev->no_rules);
+  assert(ev->rules[0].leapfrog);
+  assert(3 == ev->rules[0].no_order);
+  tym_evaluator_fixpoint(ev);
+  assert(7 == tym_evaluator_no_tuples(ev));
+
+  counted = 0;
+  query = tym_test_atom("p", 2, "c", "X");
+  assert(1 == tym_evaluator_query(ev, query, tym_test_count_answer, &counted));
+  tym_free_atom(query);
+
+  tym_free_evaluator(ev);
+  tym_free_atom_database(adb);
+
+  // The edges that have no edge back: a <-> b -> c -> d. The rule that
+  // negates o in turn isn't stratified.
+  struct TymAtom * neg_atoms[] = {
+    tym_test_atom("e", 2, "Y", "X"),
+    tym_test_atom("q", 2, "Y", "X"),
+  };
+  for (size_t i = 0; i < sizeof(neg_atoms) / sizeof(neg_atoms[0]); i++) {
+    neg_atoms[i]->negated = true;
+  }
+  struct TymClause * neg_cls[] = {
+    tym_mk_clause(tym_test_atom("e", 2, "a", "b"), 0, NULL),
+    tym_mk_clause(tym_test_atom("e", 2, "b", "a"), 0, NULL),
+    tym_mk_clause(tym_test_atom("e", 2, "b", "c"), 0, NULL),
+    tym_mk_clause(tym_test_atom("e", 2, "c", "d"), 0, NULL),
+    tym_mk_clause(tym_test_atom("o", 2, "X", "Y"), 2,
+        tym_mk_atom_cell(tym_test_atom("e", 2, "X", "Y"),
+          tym_mk_atom_cell(neg_atoms[0], NULL))),
+    tym_mk_clause(tym_test_atom("q", 2, "X", "Y"), 2,
+        tym_mk_atom_cell(tym_test_atom("e", 2, "X", "Y"),
+          tym_mk_atom_cell(neg_atoms[1], NULL))),
+  };
+  adb = tym_mk_atom_database();
+  for (size_t i = 0; i < sizeof(neg_cls) / sizeof(neg_cls[0]) - 1; i++) {
+    enum TymCdlAddError error_code;
+    bool success = tym_clause_database_add(neg_cls[i], adb, &error_code);
+    assert(success);
+    tym_free_clause(neg_cls[i]);
+  }
+
+  ev = tym_mk_evaluator(adb);
+  assert(2 == ev->no_sccs);
+  tym_evaluator_fixpoint(ev);
+  assert(6 == tym_evaluator_no_tuples(ev));
+
+  // Every value of X, since a has no one-way edges.
+  counted = 0;
+  query = tym_test_atom("o", 2, "a", "X");
+  query->negated = true;
+  assert(4 == tym_evaluator_query(ev, query, tym_test_count_answer, &counted));
+  tym_free_atom(query);
+  tym_free_evaluator(ev);
+
+  ev = tym_mk_evaluator(adb);
+  query = tym_test_atom("o", 2, "X", "Y");
+  assert(2 == tym_evaluator_tabled_query(ev, query, tym_test_count_answer, &counted));
+  tym_free_atom(query);
+  tym_free_evaluator(ev);
+
+  struct TymClause * last = neg_cls[sizeof(neg_cls) / sizeof(neg_cls[0]) - 1];
+  enum TymCdlAddError error_code;
+  bool success = tym_clause_database_add(last, adb, &error_code);
+  assert(success);
+  tym_free_clause(last);
+  assert(NULL == tym_mk_evaluator(adb));
+  tym_free_atom_database(adb);
+
+  // A ring of edges that's big enough for rounds to be split between
+  // threads: the first round of each component, and u's second round, whose
+  // delta is all of e reversed.
+  const size_t ring_size = TYM_EVAL_MIN_PARALLEL + 1;
+  adb = tym_mk_atom_database();
+  for (size_t i = 0; i < ring_size + 3; i++) {
+    struct TymClause * cl;
+    if (i < ring_size) {
+      char from[32];
+      char to[32];
+      snprintf(from, sizeof from, "c%zu", i);
+      snprintf(to, sizeof to, "c%zu", (i + 1) % ring_size);
+      cl = tym_mk_clause(tym_test_atom("e", 2, from, to), 0, NULL);
+    } else if (ring_size == i) {
+      cl = tym_mk_clause(tym_test_atom("p", 2, "X", "Z"), 2,
+          tym_mk_atom_cell(tym_test_atom("e", 2, "X", "Y"),
+            tym_mk_atom_cell(tym_test_atom("e", 2, "Y", "Z"), NULL)));
+    } else if (ring_size + 1 == i) {
+      cl = tym_mk_clause(tym_test_atom("u", 2, "X", "Y"), 1,
+          tym_mk_atom_cell(tym_test_atom("e", 2, "X", "Y"), NULL));
+    } else {
+      cl = tym_mk_clause(tym_test_atom("u", 2, "Y", "X"), 1,
+          tym_mk_atom_cell(tym_test_atom("u", 2, "X", "Y"), NULL));
+    }
+    bool added = tym_clause_database_add(cl, adb, &error_code);
+    assert(added);
+    tym_free_clause(cl);
+  }
+
+  // p and u don't depend on each other, so with more than one thread they're
+  // evaluated at the same time, but in as many rounds.
+  size_t iterations = 0;
+  for (unsigned no_threads = 1; no_threads <= 4; no_threads *= 4) {
+    ev = tym_mk_evaluator(adb);
+    ev->no_threads = no_threads;
+    tym_evaluator_fixpoint(ev);
+    assert(4 * ring_size == tym_evaluator_no_tuples(ev));
+    if (1 == no_threads) {
+      iterations = ev->iterations;
+    }
+    assert(iterations == ev->iterations);
+
+    counted = 0;
+    query = tym_test_atom("u", 2, "c0", "X");
+    assert(2 == tym_evaluator_query(ev, query, tym_test_count_answer, &counted));
+    tym_free_atom(query);
+    tym_free_evaluator(ev);
+  }
+  tym_free_atom_database(adb);
+
+  // Y is only in the head of p2's rule, so it ranges over the universe, which
+  // doesn't include c1: p2(c1, Y) has no answers, neither bottom-up nor when
+  // the call p2(c1, Y) binds Y.
+  struct TymClause * head_cls[] = {
+    tym_mk_clause(tym_test_atom("p3", 1, "c0"), 0, NULL),
+    tym_mk_clause(tym_test_atom("p4", 1, "c2"), 0, NULL),
+    tym_mk_clause(tym_test_atom("p1", 1, "c0"), 0, NULL),
+    tym_mk_clause(tym_test_atom("p1", 1, "c2"), 0, NULL),
+    tym_mk_clause(tym_test_atom("p0", 0), 2,
+        tym_mk_atom_cell(tym_test_atom("p2", 2, "X", "X"),
+          tym_mk_atom_cell(tym_test_atom("p2", 2, "c1", "Y"), NULL))),
+    tym_mk_clause(tym_test_atom("p2", 2, "Y", "c0"), 1,
+        tym_mk_atom_cell(tym_test_atom("p4", 1, "Z"), NULL)),
+    tym_mk_clause(tym_test_atom("p3", 1, "Z"), 2,
+        tym_mk_atom_cell(tym_test_atom("p4", 1, "Y"),
+          tym_mk_atom_cell(tym_test_atom("p4", 1, "c0"), NULL))),
+  };
+  adb = tym_mk_atom_database();
+  for (size_t i = 0; i < sizeof(head_cls) / sizeof(head_cls[0]); i++) {
+    bool added = tym_clause_database_add(head_cls[i], adb, &error_code);
+    assert(added);
+    tym_free_clause(head_cls[i]);
+  }
+
+  query = tym_test_atom("p0", 0);
+  ev = tym_mk_evaluator(adb);
+  tym_evaluator_fixpoint(ev);
+  assert(0 == tym_evaluator_query(ev, query, tym_test_count_answer, &counted));
+  tym_free_evaluator(ev);
+
+  ev = tym_mk_evaluator(adb);
+  assert(0 == tym_evaluator_tabled_query(ev, query, tym_test_count_answer, &counted));
+  tym_free_evaluator(ev);
+  tym_free_atom(query);
+  tym_free_atom_database(adb);
+}
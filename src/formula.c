@@ -22,9 +22,12 @@ This file: Representation of formulas.
 */
 
 #include <assert.h>
+#include <stdio.h>
+#include <time.h>
 
 #include "ast.h"
 #include "formula.h"
+#include "module_benchmarks.h"
 #include "module_tests.h"
 #include "util.h"
 
@@ -33,7 +36,10 @@ char * TYM_UNIVERSE_TY = "Universe";
 
 TYM_DEFINE_LIST_REV(fmla, fmlas, tym_mk_fmla_cell, , struct TymFmlas, )
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * tym_fmla_junction_str(struct TymFmla ** fmla, struct TymBufferInfo * dst);
+static bool fmla_needs_parens(const struct TymFmla * fmla);
+static const struct TymFmla * fmla_subfmla(const struct TymFmla * fmla, size_t i);
+static void fmla_write(struct TymBufferInfo * dst, const char * s);
+static void fmla_head_str(const struct TymFmla * fmla, struct TymBufferInfo * dst);
 static struct TymFmlas * tym_copy_fmlas(const struct TymFmlas *);
 static struct TymFmlas * filter_before_juncts(struct TymFmlas * fmlas, bool is_and_behaviour);
 
@@ -50,7 +56,7 @@ tym_mk_fmla_const(bool b)
 }
 
 struct TymFmla *
-tym_mk_fmla_atom(const TymStr * pred_name, uint8_t arity, struct TymTerm ** predargs)
+tym_mk_fmla_atom(const TymStr * pred_name, size_t arity, struct TymTerm ** predargs)
 {
   struct TymFmlaAtom * result_content = malloc(sizeof *result_content);
   assert(NULL != result_content);
@@ -78,7 +84,7 @@ tym_mk_fmla_atom_varargs(const TymStr * pred_name, unsigned int arity, ...)
   va_start(varargs, arity);
   if (arity > 0) {
     args = malloc(sizeof *args * arity);
-    for (unsigned int i = 0; i < arity; i++) {
+    for (size_t i = 0; i < arity; i++) {
       args[i] = va_arg(varargs, struct TymTerm *);
     }
   }
@@ -411,18 +417,17 @@ tym_mk_fmla_imply(struct TymFmla * antecedent, struct TymFmla * consequent)
   return result;
 }
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) *
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult)
 tym_fmla_atom_str(struct TymFmlaAtom * at, struct TymBufferInfo * dst)
 {
   size_t initial_idx = tym_buffer_len(dst);
 
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = tym_buf_strcpy(dst, tym_decode_str(at->pred_name));
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res = tym_buf_strcpy(dst, tym_decode_str(at->pred_name));
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
 
   tym_unsafe_dec_idx(dst, 1); // chomp the trailing \0.
 
-  for (int i = 0; i < at->arity; i++) {
+  for (size_t i = 0; i < at->arity; i++) {
     if (tym_have_space(dst, 1)) {
       tym_unsafe_buffer_char(dst, ' ');
     } else {
@@ -431,7 +436,6 @@ tym_fmla_atom_str(struct TymFmlaAtom * at, struct TymBufferInfo * dst)
 
     res = tym_term_str(at->predargs[i], dst);
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
 
     tym_unsafe_dec_idx(dst, 1); // chomp the trailing \0.
   }
@@ -444,7 +448,7 @@ tym_fmla_atom_str(struct TymFmlaAtom * at, struct TymBufferInfo * dst)
   }
 }
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) *
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult)
 tym_fmla_quant_str(struct TymFmlaQuant * quant, struct TymBufferInfo * dst)
 {
   size_t initial_idx = tym_buffer_len(dst);
@@ -455,15 +459,13 @@ tym_fmla_quant_str(struct TymFmlaQuant * quant, struct TymBufferInfo * dst)
     return tym_mkerrval_TymBufferWriteResult(BUFF_ERR_OVERFLOW);
   }
 
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = tym_buf_strcpy(dst, tym_decode_str(quant->bv));
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res = tym_buf_strcpy(dst, tym_decode_str(quant->bv));
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
 
   tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
 
   res = tym_buf_strcpy(dst, TYM_UNIVERSE_TY);
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
 
   tym_safe_buffer_replace_last(dst, ')'); // replace the trailing \0.
 
@@ -472,135 +474,160 @@ tym_fmla_quant_str(struct TymFmlaQuant * quant, struct TymBufferInfo * dst)
 
   res = tym_fmla_str(quant->body, dst);
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
 
   return tym_mkval_TymBufferWriteResult(tym_buffer_len(dst) - initial_idx);
 }
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) *
-tym_fmla_junction_str(struct TymFmla ** fmla, struct TymBufferInfo * dst)
+// Whether a formula is printed in parentheses. This used to be decided by
+// checking whether tym_fmla_size(fmla) > 1, which is equivalent but made
+// printing quadratic in the formula's depth.
+static bool
+fmla_needs_parens(const struct TymFmla * fmla)
 {
-  size_t initial_idx = tym_buffer_len(dst);
-
-  while (NULL != *fmla) {
-    struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res =
-      tym_fmla_str(*fmla, dst);
-    assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
-
-    tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
-    fmla++;
+  switch (fmla->kind) {
+  case FMLA_CONST:
+    return false;
+  case FMLA_ATOM:
+    return fmla->param.atom->arity > 0;
+  case FMLA_AND:
+  case FMLA_OR:
+  case FMLA_IFF:
+    return NULL != fmla->param.args[0];
+  default:
+    return true;
   }
-
-  tym_safe_buffer_replace_last(dst, '\0');
-
-  return tym_mkval_TymBufferWriteResult(tym_buffer_len(dst) - initial_idx);
 }
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) *
-tym_fmla_str(const struct TymFmla * fmla, struct TymBufferInfo * dst)
+// Returns the i'th immediate subformula, or NULL if there are no more.
+static const struct TymFmla *
+fmla_subfmla(const struct TymFmla * fmla, size_t i)
 {
-  size_t initial_idx = tym_buffer_len(dst);
-
-  const size_t fmla_sz = tym_fmla_size(fmla);
-  if (fmla_sz > 1) {
-    if (tym_have_space(dst, 1)) {
-      tym_unsafe_buffer_char(dst, '(');
-    } else {
-      return tym_mkerrval_TymBufferWriteResult(BUFF_ERR_OVERFLOW);
-    }
+  switch (fmla->kind) {
+  case FMLA_AND:
+  case FMLA_OR:
+  case FMLA_IF:
+  case FMLA_IFF:
+    return fmla->param.args[i];
+  case FMLA_NOT:
+    return (0 == i) ? fmla->param.args[0] : NULL;
+  case FMLA_EX:
+  case FMLA_ALL:
+    return (0 == i) ? fmla->param.quant->body : NULL;
+  default:
+    return NULL;
   }
+}
+
+static void
+fmla_write(struct TymBufferInfo * dst, const char * s)
+{
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res = tym_buf_strcpy(dst, s);
+  error_check_TymBufferWriteResult(res, tym_buff_error_msg, dst);
+  tym_unsafe_dec_idx(dst, 1); // chomp the trailing \0.
+}
 
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = NULL;
+// Prints the formula's operator (and for quantifiers, the bound variable),
+// or all of it if it has no subformulas.
+static void
+fmla_head_str(const struct TymFmla * fmla, struct TymBufferInfo * dst)
+{
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res;
 
   switch (fmla->kind) {
   case FMLA_CONST:
-    if (fmla->param.const_value) {
-      res = tym_buf_strcpy(dst, "true");
-    } else {
-      res = tym_buf_strcpy(dst, "false");
-    }
-    assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
+    fmla_write(dst, fmla->param.const_value ? "true" : "false");
     break;
   case FMLA_ATOM:
     res = tym_fmla_atom_str(fmla->param.atom, dst);
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
+    tym_unsafe_dec_idx(dst, 1); // chomp the trailing \0.
     break;
   case FMLA_AND:
-    res = tym_buf_strcpy(dst, "and");
-    assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
-    tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
-    res = tym_fmla_junction_str(fmla->param.args, dst);
-    assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
+    fmla_write(dst, "and");
     break;
   case FMLA_OR:
-    res = tym_buf_strcpy(dst, "or");
-    assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
-    tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
-    res = tym_fmla_junction_str(fmla->param.args, dst);
-    assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
+    fmla_write(dst, "or");
     break;
   case FMLA_NOT:
-    res = tym_buf_strcpy(dst, "not");
-    assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
-    tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
-    res = tym_fmla_str(fmla->param.args[0], dst);
-    assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
+    fmla_write(dst, "not");
     break;
   case FMLA_EX:
-    res = tym_buf_strcpy(dst, "exists");
-    error_check_TymBufferWriteResult(res, tym_buff_error_msg, dst);
-    free(res);
-    tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
-    res = tym_fmla_quant_str(fmla->param.quant, dst);
-    assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
-    break;
   case FMLA_ALL:
-    res = tym_buf_strcpy(dst, "forall");
-    error_check_TymBufferWriteResult(res, tym_buff_error_msg, dst);
-    free(res);
-    tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
-    res = tym_fmla_quant_str(fmla->param.quant, dst);
-    assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
+    fmla_write(dst, (FMLA_EX == fmla->kind) ? "exists" : "forall");
+    fmla_write(dst, " ((");
+    fmla_write(dst, tym_decode_str(fmla->param.quant->bv));
+    fmla_write(dst, " ");
+    fmla_write(dst, TYM_UNIVERSE_TY);
+    fmla_write(dst, "))");
     break;
   case FMLA_IF:
-    res = tym_buf_strcpy(dst, "=>");
-    assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
-    tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
-    res = tym_fmla_junction_str(fmla->param.args, dst);
-    assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
+    fmla_write(dst, "=>");
     break;
   case FMLA_IFF:
-    res = tym_buf_strcpy(dst, "=");
-    assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
-    tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
-    res = tym_fmla_junction_str(fmla->param.args, dst);
-    assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
+    fmla_write(dst, "=");
     break;
   default:
-    return tym_mkerrval_TymBufferWriteResult(NON_BUFF_ERROR);
+    assert(false);
+    break;
   }
+}
 
-  if (fmla_sz > 1) {
-    tym_safe_buffer_replace_last(dst, ')'); // replace the trailing \0.
-  } else {
-    tym_unsafe_dec_idx(dst, 1);
+struct TymFmlaStrFrame {
+  const struct TymFmla * fmla;
+  size_t next_subfmla;
+};
+
+// NOTE this works in a single pass over the formula, and uses an explicit
+//      stack rather than recursion, since formulas such as the disjunction of
+//      a predicate's bodies can be very deep.
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult)
+tym_fmla_str(const struct TymFmla * fmla, struct TymBufferInfo * dst)
+{
+  size_t initial_idx = tym_buffer_len(dst);
+
+  size_t stack_size = 64;
+  size_t depth = 0;
+  struct TymFmlaStrFrame * stack = malloc(sizeof(*stack) * stack_size);
+  assert(NULL != stack);
+
+  const struct TymFmla * next = fmla;
+  while (NULL != next || depth > 0) {
+    if (NULL != next) {
+      // Start printing "next".
+      if (fmla_needs_parens(next)) {
+        fmla_write(dst, "(");
+      }
+      fmla_head_str(next, dst);
+
+      if (depth == stack_size) {
+        stack_size *= 2;
+        stack = realloc(stack, sizeof(*stack) * stack_size);
+        assert(NULL != stack);
+      }
+      stack[depth] = (struct TymFmlaStrFrame){.fmla = next, .next_subfmla = 0};
+      depth++;
+      next = NULL;
+    } else {
+      // Move on to the next subformula of the formula on top of the stack,
+      // or finish printing that formula.
+      struct TymFmlaStrFrame * top = &stack[depth - 1];
+      next = fmla_subfmla(top->fmla, top->next_subfmla);
+      if (NULL != next) {
+        if (FMLA_EX != top->fmla->kind && FMLA_ALL != top->fmla->kind) {
+          fmla_write(dst, " ");
+        }
+        top->next_subfmla++;
+      } else {
+        if (fmla_needs_parens(top->fmla)) {
+          fmla_write(dst, ")");
+        }
+        depth--;
+      }
+    }
   }
 
+  free(stack);
+
   if (tym_have_space(dst, 1)) {
     tym_unsafe_buffer_char(dst, '\0');
     return tym_mkval_TymBufferWriteResult(tym_buffer_len(dst) - initial_idx);
@@ -697,7 +724,7 @@ tym_mk_abstract_vars(const struct TymFmla * at, struct TymSymGen * vg, struct Ty
     *v = NULL;
 
     struct TymValuation * v_cursor;
-    for (int i = 0; i < atom->arity; i++) {
+    for (size_t i = 0; i < atom->arity; i++) {
       if (0 == i) {
         *v = malloc(sizeof **v);
         v_cursor = *v;
@@ -724,25 +751,23 @@ tym_mk_abstract_vars(const struct TymFmla * at, struct TymSymGen * vg, struct Ty
       atom->arity, var_args_T);
 }
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) *
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult)
 tym_valuation_str(struct TymValuation * v, struct TymBufferInfo * dst)
 {
   size_t initial_idx = tym_buffer_len(dst);
 
   struct TymValuation * v_cursor = v;
 
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = NULL;
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res;
 
   while (NULL != v_cursor) {
     res = tym_buf_strcpy(dst, tym_decode_str(v_cursor->var));
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
 
     tym_safe_buffer_replace_last(dst, '='); // replace the trailing \0.
 
     res = tym_term_str(v_cursor->val, dst);
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
 
     v_cursor = v_cursor->next;
 
@@ -774,12 +799,11 @@ tym_free_fmla_atom(struct TymFmlaAtom * at)
   tym_free_term((struct TymTerm *)at->pred_const);
 #pragma GCC diagnostic pop
 
-  for (int i = 0; i < at->arity; i++) {
+  for (size_t i = 0; i < at->arity; i++) {
     tym_free_term(at->predargs[i]);
   }
 
   if (NULL != at->predargs) {
-    assert(at->arity >= 0);
     free(at->predargs);
   } else {
     assert(0 == at->arity);
@@ -846,13 +870,13 @@ tym_free_fmla(const struct TymFmla * fmla)
 void
 tym_free_fmlas(const struct TymFmlas * fmlas)
 {
-  assert(NULL != fmlas->fmla);
-  tym_free_fmla(fmlas->fmla);
-  if (NULL != fmlas->next) {
-    tym_free_fmlas(fmlas->next);
+  while (NULL != fmlas) {
+    const struct TymFmlas * next = fmlas->next;
+    assert(NULL != fmlas->fmla);
+    tym_free_fmla(fmlas->fmla);
+    free((void *)fmlas);
+    fmlas = next;
   }
-
-  free((void *)fmlas);
 }
 #pragma GCC diagnostic pop
 
@@ -922,7 +946,7 @@ tym_copy_fmla(const struct TymFmla * const fmla)
 
     if (fmla->param.atom->arity > 0) {
       predargs_copy = malloc(sizeof *predargs_copy * fmla->param.atom->arity);
-      for (int i = 0; i < fmla->param.atom->arity; i++) {
+      for (size_t i = 0; i < fmla->param.atom->arity; i++) {
         predargs_copy[i] = tym_copy_term(fmla->param.atom->predargs[i]);
       }
     }
@@ -1006,9 +1030,8 @@ tym_test_formula(void)
       tym_copy_fmla(test_or));
 
   struct TymBufferInfo * outbuf = tym_mk_buffer(TYM_BUF_SIZE);
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = tym_fmla_str(test_quant, outbuf);
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res = tym_fmla_str(test_quant, outbuf);
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
   TYM_DBG_BUFFER(outbuf, "test formula")
   tym_free_buffer(outbuf);
   tym_free_fmla(test_and);
@@ -1033,21 +1056,18 @@ tym_test_formula(void)
   outbuf = tym_mk_buffer(TYM_BUF_SIZE);
   res = tym_fmla_str(test_atom, outbuf);
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
   TYM_DBG_BUFFER(outbuf, "test_atom formula")
   tym_free_buffer(outbuf);
 
   outbuf = tym_mk_buffer(TYM_BUF_SIZE);
   res = tym_fmla_str(test_and2, outbuf);
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
   TYM_DBG_BUFFER(outbuf, "test_and2 formula")
   tym_free_buffer(outbuf);
 
   outbuf = tym_mk_buffer(TYM_BUF_SIZE);
   res = tym_fmla_str(test_or, outbuf);
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
   TYM_DBG_BUFFER(outbuf, "test_or formula")
   tym_free_buffer(outbuf);
 
@@ -1107,8 +1127,8 @@ struct TymTerms *
 tym_arguments_of_atom(struct TymFmlaAtom * fmla)
 {
   struct TymTerms * result = NULL;
-  for (int i = fmla->arity - 1; i >= 0; i--) {
-    result = tym_mk_term_cell(tym_copy_term(fmla->predargs[i]), result);
+  for (size_t i = fmla->arity; i > 0; i--) {
+    result = tym_mk_term_cell(tym_copy_term(fmla->predargs[i - 1]), result);
   }
   return result;
 }
@@ -1175,7 +1195,7 @@ tym_consts_in_fmla(const struct TymFmla * fmla, struct TymTerms * acc, bool with
     }
 #pragma GCC diagnostic pop
 
-    for (int i = 0; i < fmla->param.atom->arity; i++) {
+    for (size_t i = 0; i < fmla->param.atom->arity; i++) {
       struct TymTerm * t = fmla->param.atom->predargs[i];
       if (TYM_CONST == t->kind) {
         result = tym_mk_term_cell(t, result);
@@ -1226,3 +1246,69 @@ tym_copy_fmlas(const struct TymFmlas * fmlas)
 
   return result;
 }
+
+// Returns a fresh "(exists ((V Universe))(and (q ci V) (r V)))", resembling
+// the translation of a clause body.
+static struct TymFmla *
+bench_body(size_t i)
+{
+  char name[32];
+  snprintf(name, sizeof(name), "c%zu", i);
+  struct TymFmla * q =
+    tym_mk_fmla_atom_varargs(TYM_CSTR_DUPLICATE("q"), 2,
+        tym_mk_term(TYM_CONST, TYM_CSTR_DUPLICATE(name)),
+        tym_mk_term(TYM_VAR, TYM_CSTR_DUPLICATE("V")));
+  struct TymFmla * r =
+    tym_mk_fmla_atom_varargs(TYM_CSTR_DUPLICATE("r"), 1,
+        tym_mk_term(TYM_VAR, TYM_CSTR_DUPLICATE("V")));
+  return tym_mk_fmla_quant(FMLA_EX, TYM_CSTR_DUPLICATE("V"),
+      tym_mk_fmla_and(q, r));
+}
+
+static void
+bench_fmla_str(const char * label, size_t n, const struct TymFmla * fmla)
+{
+  struct TymBufferInfo * outbuf = tym_mk_buffer(TYM_BUF_SIZE);
+  clock_t start = clock();
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res = tym_fmla_str(fmla, outbuf);
+  clock_t end = clock();
+  assert(tym_is_ok_TymBufferWriteResult(res));
+
+  printf("fmla_str: %s n=%zu %.1fns per body (%zu bytes)\n", label, n,
+      1e9 * (double)(end - start) / CLOCKS_PER_SEC / (double)n,
+      tym_val_of_TymBufferWriteResult(res));
+
+  tym_free_buffer(outbuf);
+}
+
+// Times tym_fmla_str on the definition of a predicate having n bodies,
+// "(forall ((X Universe))(= (p X) (or body1 ... bodyn)))", and on the same
+// bodies nested as "(or body1 (or body2 ...))".
+void
+tym_bench_fmla_str(void)
+{
+  for (size_t n = 1000; n <= 100000; n *= 10) {
+    struct TymFmlas * bodies = NULL;
+    for (size_t i = 0; i < n; i++) {
+      bodies = tym_mk_fmla_cell(bench_body(i), bodies);
+    }
+    struct TymFmla * head =
+      tym_mk_fmla_atom_varargs(TYM_CSTR_DUPLICATE("p"), 1,
+          tym_mk_term(TYM_VAR, TYM_CSTR_DUPLICATE("X")));
+    struct TymFmla * defn =
+      tym_mk_fmla_quant(FMLA_ALL, TYM_CSTR_DUPLICATE("X"),
+          tym_mk_fmla_iff(head, tym_mk_fmla_ors(bodies)));
+    bench_fmla_str("flat", n, defn);
+    tym_free_fmla(defn);
+  }
+
+  // NOTE tym_free_fmla is recursive, which limits how deep we can go here.
+  for (size_t n = 1000; n <= 10000; n *= 10) {
+    struct TymFmla * nested = bench_body(0);
+    for (size_t i = 1; i < n; i++) {
+      nested = tym_mk_fmla_or(bench_body(i), nested);
+    }
+    bench_fmla_str("nested", n, nested);
+    tym_free_fmla(nested);
+  }
+}
@@ -37,7 +37,7 @@ tym_hash_str(const char * str)
 {
   assert(NULL != str);
 
-  uint64_t result = FNV_OFFSET_BASIS;
+  TYM_HASH_VTYPE result = FNV_OFFSET_BASIS;
   const char * cursor = str;
 
   while ('\0' != *cursor) {
@@ -46,5 +46,5 @@ tym_hash_str(const char * str)
     cursor++;
   }
 
-  return (TYM_HASH_VTYPE)result;
+  return result;
 }
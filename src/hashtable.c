@@ -29,6 +29,108 @@ This file: Hash tabling for TYM Datalog.
 
 #include "hashtable.h"
 
+#define TYM_STR_SET_INITIAL_SLOTS 16
+
+static bool str_set_find(const struct TymStrSet * set, const TymStr * s, TYM_HASH_VTYPE h, size_t * slot);
+
+void
+tym_str_set_init(struct TymStrSet * set)
+{
+  *set = (struct TymStrSet){.strs = NULL, .hashes = NULL, .count = 0,
+    .capacity = 0, .slots = NULL, .no_slots = 0};
+}
+
+// Finds the slot that holds s, or the empty slot where s would go.
+static bool
+str_set_find(const struct TymStrSet * set, const TymStr * s, TYM_HASH_VTYPE h, size_t * slot)
+{
+  size_t mask = set->no_slots - 1;
+  size_t i = (size_t)h & mask;
+  while (0 != set->slots[i]) {
+    uint32_t id = set->slots[i] - 1;
+    if (h == set->hashes[id] && tym_eq_str(s, set->strs[id])) {
+      *slot = i;
+      return true;
+    }
+    i = (i + 1) & mask;
+  }
+  *slot = i;
+  return false;
+}
+
+bool
+tym_str_set_lookup(const struct TymStrSet * set, const TymStr * s, uint32_t * id)
+{
+  size_t slot;
+  if (0 == set->count ||
+      !str_set_find(set, s, tym_hash_str(tym_decode_str(s)), &slot)) {
+    return false;
+  }
+  *id = set->slots[slot] - 1;
+  return true;
+}
+
+// Gives s's identifier in id, adding s to the set if it's not already there.
+// Returns whether s was added.
+bool
+tym_str_set_add(struct TymStrSet * set, const TymStr * s, uint32_t * id)
+{
+  if (0 == set->no_slots) {
+    set->no_slots = TYM_STR_SET_INITIAL_SLOTS;
+    set->slots = calloc(set->no_slots, sizeof *set->slots);
+    assert(NULL != set->slots);
+  }
+
+  TYM_HASH_VTYPE h = tym_hash_str(tym_decode_str(s));
+  size_t slot;
+  if (str_set_find(set, s, h, &slot)) {
+    *id = set->slots[slot] - 1;
+    return false;
+  }
+
+  if (set->count == set->capacity) {
+    set->capacity = (0 == set->capacity) ? TYM_STR_SET_INITIAL_SLOTS : 2 * set->capacity;
+    set->strs = realloc(set->strs, sizeof *set->strs * set->capacity);
+    set->hashes = realloc(set->hashes, sizeof *set->hashes * set->capacity);
+    assert(NULL != set->strs);
+    assert(NULL != set->hashes);
+  }
+
+  assert(set->count < UINT32_MAX);
+  *id = (uint32_t)set->count;
+  set->strs[*id] = s;
+  set->hashes[*id] = h;
+  set->slots[slot] = *id + 1;
+  set->count++;
+
+  // Keep the table at most half full.
+  if (2 * set->count > set->no_slots) {
+    free(set->slots);
+    set->no_slots *= 2;
+    set->slots = calloc(set->no_slots, sizeof *set->slots);
+    assert(NULL != set->slots);
+    size_t mask = set->no_slots - 1;
+    for (uint32_t j = 0; j < set->count; j++) {
+      size_t i = (size_t)set->hashes[j] & mask;
+      while (0 != set->slots[i]) {
+        i = (i + 1) & mask;
+      }
+      set->slots[i] = j + 1;
+    }
+  }
+
+  return true;
+}
+
+// Frees the set's tables, but not its strings.
+void
+tym_str_set_free(struct TymStrSet * set)
+{
+  free(set->strs);
+  free(set->hashes);
+  free(set->slots);
+}
+
 // FIXME currently this only works if TYM_STRING_TYPE == 2.
 #if TYM_STRING_TYPE == 2
 // FIXME can factor out hashtable functions from symbols.c
@@ -36,6 +138,8 @@ TYM_DECL_HASHTABLE_CELL(String, const char *, const TymStr *)
 TYM_DECL_HASHTABLE(String, const char *, const TymStr *)
 
 static void free_cell(TYM_HASHTABLE_CELL(String) * cell);
+static TYM_HASHTABLE_CELL(String) * find_cell(TYM_HASHTABLE(String) * ht, const char * key, TYM_HASH_VTYPE h);
+static void grow(TYM_HASHTABLE(String) * ht);
 
 static void
 free_cell(TYM_HASHTABLE_CELL(String) * cell)
@@ -47,17 +151,60 @@ free_cell(TYM_HASHTABLE_CELL(String) * cell)
   //       "free" function specifically for "struct
   //       TymStrHashIdxStruct *" here to free it as well as
   //       the character string.
+  // NOTE cells are stored in the table's array, so we don't free the cell
+  //      itself.
   tym_force_free_str(cell->v);
-  free((void *)cell);
+}
+
+// Returns the cell containing "key", or otherwise the unoccupied cell at
+// which the probe for "key" ended.
+static TYM_HASHTABLE_CELL(String) *
+find_cell(TYM_HASHTABLE(String) * ht, const char * key, TYM_HASH_VTYPE h)
+{
+  size_t mask = ht->capacity - 1;
+  size_t i = (size_t)h & mask;
+  while (NULL != ht->arr[i].k) {
+    if (h == ht->arr[i].h && 0 == strcmp(key, ht->arr[i].k)) {
+      break;
+    }
+    i = (i + 1) & mask;
+  }
+  return &ht->arr[i];
+}
+
+static void
+grow(TYM_HASHTABLE(String) * ht)
+{
+  TYM_HASHTABLE_CELL(String) * old_arr = ht->arr;
+  size_t old_capacity = ht->capacity;
+
+  ht->capacity *= 2;
+  ht->arr = calloc(ht->capacity, sizeof(*ht->arr));
+  assert(NULL != ht->arr);
+
+  size_t mask = ht->capacity - 1;
+  for (size_t j = 0; j < old_capacity; ++j) {
+    if (NULL != old_arr[j].k) {
+      // Keys are distinct, so we only need to look for a free cell.
+      size_t i = (size_t)old_arr[j].h & mask;
+      while (NULL != ht->arr[i].k) {
+        i = (i + 1) & mask;
+      }
+      ht->arr[i] = old_arr[j];
+    }
+  }
+
+  free(old_arr);
 }
 
 TYM_HASHTABLE(String) *
 tym_ht_create(void)
 {
   TYM_HASHTABLE(String) * result = malloc(sizeof(*result));
-  for (int i = 0; i < TYM_HASH_RANGE; ++i) {
-    result->arr[i] = NULL;
-  }
+  result->capacity = TYM_HASH_RANGE;
+  result->count = 0;
+  result->arr = calloc(result->capacity, sizeof(*result->arr));
+  assert(NULL != result->arr);
   result->free_cell = &free_cell;
   return result;
 }
@@ -69,32 +216,15 @@ tym_ht_add(TYM_HASHTABLE(String) * ht, const char * key, TYM_HVALUETYPE value)
   assert(NULL != key);
   assert(NULL != value);
 
-  bool exists = false;
   TYM_HASH_VTYPE h = tym_hash_str(key);
-  TYM_HASHTABLE_CELL(String) * precursor = NULL;
-  TYM_HASHTABLE_CELL(String) * cursor = ht->arr[h];
-  while (NULL != cursor) {
-    if (0 == strcmp(key, cursor->k)) {
-      exists = true;
-      break;
-    } else {
-      precursor = cursor;
-      cursor = cursor->next;
-    }
-  }
+  TYM_HASHTABLE_CELL(String) * cell = find_cell(ht, key, h);
+  bool exists = (NULL != cell->k);
 
   if (!exists) {
-    if (NULL == precursor) {
-      // This is the first element we're adding to this bucket.
-      ht->arr[h] = malloc(sizeof(*precursor));
-      ht->arr[h]->next = NULL;
-      ht->arr[h]->k = key;
-      ht->arr[h]->v = value;
-    } else {
-      precursor->next = malloc(sizeof(*precursor->next));
-      precursor->next->next = NULL;
-      precursor->next->k = key;
-      precursor->next->v = value;
+    *cell = (TYM_HASHTABLE_CELL(String)){.k = key, .v = value, .h = h};
+    ht->count++;
+    if (4 * ht->count > 3 * ht->capacity) {
+      grow(ht);
     }
   }
 
@@ -107,33 +237,18 @@ tym_ht_lookup(TYM_HASHTABLE(String) * ht, const char * key)
   assert(NULL != ht);
   assert(NULL != key);
 
-  TYM_HVALUETYPE result = NULL;
-
-  TYM_HASH_VTYPE h = tym_hash_str(key);
-  TYM_HASHTABLE_CELL(String) * cursor = ht->arr[h];
-  while (NULL != cursor) {
-    if (0 == strcmp(key, cursor->k)) {
-      result = cursor->v;
-      break;
-    } else {
-      cursor = cursor->next;
-    }
-  }
-  return result;
+  return find_cell(ht, key, tym_hash_str(key))->v;
 }
 
 void
 tym_ht_free(TYM_HASHTABLE(String) * ht)
 {
-  TYM_HASHTABLE_CELL(String) * cursor;
-  for (int i = 0; i < TYM_HASH_RANGE; ++i) {
-    cursor = ht->arr[i];
-    while (NULL != cursor) {
-      ht->arr[i] = cursor;
-      cursor = cursor->next;
-      free_cell(ht->arr[i]);
+  for (size_t i = 0; i < ht->capacity; ++i) {
+    if (NULL != ht->arr[i].k) {
+      ht->free_cell(&ht->arr[i]);
     }
   }
+  free(ht->arr);
   free(ht);
 }
 
@@ -142,44 +257,54 @@ tym_ht_dump(TYM_HASHTABLE(String) * ht)
 {
   assert(NULL != ht);
 
-  for (int i = 0; i < TYM_HASH_RANGE; i++) {
-    TYM_HASHTABLE_CELL(String) * cursor = ht->arr[i];
-    while (NULL != cursor) {
-      printf("%s : %s\n", cursor->k, tym_decode_str(cursor->v));
-      cursor = cursor->next;
+  for (size_t i = 0; i < ht->capacity; i++) {
+    if (NULL != ht->arr[i].k) {
+      printf("%s : %s\n", ht->arr[i].k, tym_decode_str(ht->arr[i].v));
     }
   }
 }
 
+size_t
+tym_ht_count(TYM_HASHTABLE(String) * ht)
+{
+  assert(NULL != ht);
+  return ht->count;
+}
+
 bool
 tym_ht_delete(TYM_HASHTABLE(String) * ht, const char * key)
 {
   assert(NULL != ht);
   assert(NULL != key);
 
-  bool result = false;
+  TYM_HASHTABLE_CELL(String) * cell = find_cell(ht, key, tym_hash_str(key));
+  if (NULL == cell->k) {
+    return false;
+  }
 
-  TYM_HASH_VTYPE h = tym_hash_str(key);
-  TYM_HASHTABLE_CELL(String) * cursor = ht->arr[h];
-  TYM_HASHTABLE_CELL(String) * prev_cursor = NULL;
-  while (NULL != cursor) {
-    if (0 == strcmp(key, cursor->k)) {
-      if (cursor == ht->arr[h]) {
-        ht->arr[h] = cursor->next;
-      } else {
-        assert(NULL != prev_cursor);
-        prev_cursor->next = cursor->next;
-      }
-      ht->free_cell(cursor);
-      result = true;
+  ht->free_cell(cell);
+  ht->count--;
+
+  // Instead of leaving a tombstone, we move later cells in the probe sequence
+  // back into the gap, unless that would place them before their home cell.
+  size_t mask = ht->capacity - 1;
+  size_t gap = (size_t)(cell - ht->arr);
+  size_t i = gap;
+  while (true) {
+    i = (i + 1) & mask;
+    if (NULL == ht->arr[i].k) {
       break;
-    } else {
-      prev_cursor = cursor;
-      cursor = cursor->next;
+    }
+    size_t home = (size_t)ht->arr[i].h & mask;
+    // Move the cell if its home isn't cyclically in (gap, i].
+    if (((i - home) & mask) >= ((i - gap) & mask)) {
+      ht->arr[gap] = ht->arr[i];
+      gap = i;
     }
   }
+  ht->arr[gap] = (TYM_HASHTABLE_CELL(String)){.k = NULL, .v = NULL, .h = 0};
 
-  return result;
+  return true;
 }
 
 #endif // TYM_STRING_TYPE == 2
@@ -68,11 +68,13 @@ tym_test_clause_csyn(void) {
   at->arity = 1;
   at->args = malloc(sizeof *at->args * 1);
   at->args[0] = tym_copy_term(t);
+  at->negated = false;
 
   struct TymAtom * hd = malloc(sizeof *hd);
   hd->predicate = TYM_CSTR_DUPLICATE("hello");
   hd->arity = 0;
   hd->args = NULL;
+  hd->negated = false;
 
   struct TymClause * cl = malloc(sizeof *cl);
   cl->head = hd;
@@ -141,7 +143,7 @@ tym_csyntax_atom(struct TymSymGen * namegen, const struct TymAtom * atom)
   const char * str_buf_args = tym_decode_str(TymEmptyString);
   const struct TymCSyntax * sub_csyns[atom->arity];
   const TymStr * array[atom->arity];
-  for (int i = 0; i < atom->arity; i++) {
+  for (size_t i = 0; i < atom->arity; i++) {
     sub_csyns[i] = tym_csyntax_term(namegen, atom->args[i]);
 
     str_buf_args = tym_decode_str(tym_append_str_destructive2(sub_csyns[i]->serialised, tym_encode_str(str_buf_args)));
@@ -161,10 +163,10 @@ tym_csyntax_atom(struct TymSymGen * namegen, const struct TymAtom * atom)
   result->name = tym_mk_new_var(namegen);
   result->type = TYM_CSTR_DUPLICATE("struct TymAtom");
 
-  int buf_occupied = sprintf(str_buf, "%s %s = (%s){.predicate = TYM_CSTR_DUPLICATE(\"%s\"), .arity = %d, .args = %s};\n",
+  int buf_occupied = sprintf(str_buf, "%s %s = (%s){.predicate = TYM_CSTR_DUPLICATE(\"%s\"), .arity = %zu, .args = %s%s};\n",
     tym_decode_str(result->type), tym_decode_str(result->name),
     tym_decode_str(result->type), predicate, atom->arity,
-    tym_decode_str(args_identifier));
+    tym_decode_str(args_identifier), atom->negated ? ", .negated = true" : "");
   assert(buf_occupied > 0);
   assert(strlen(str_buf) == (unsigned long)buf_occupied);
 
@@ -175,7 +177,7 @@ tym_csyntax_atom(struct TymSymGen * namegen, const struct TymAtom * atom)
   result->kind = TYM_ATOM;
   result->original = atom;
 
-  for (int i = 0; i < atom->arity; i++) {
+  for (size_t i = 0; i < atom->arity; i++) {
     tym_csyntax_free(sub_csyns[i]);
   }
 
@@ -222,7 +224,7 @@ const struct TymCSyntax * tym_csyntax_clause(struct TymSymGen * namegen, const s
   const char * str_buf_args = tym_decode_str(TymEmptyString);
   const struct TymCSyntax * sub_csyns[cl->body_size];
   const TymStr * array[cl->body_size];
-  for (int i = 0; i < cl->body_size; i++) {
+  for (size_t i = 0; i < cl->body_size; i++) {
     sub_csyns[i] = tym_csyntax_atom(namegen, cl->body[i]);
 
     str_buf_args = tym_decode_str(tym_append_str_destructive2(sub_csyns[i]->serialised, tym_encode_str(str_buf_args)));
@@ -245,7 +247,7 @@ const struct TymCSyntax * tym_csyntax_clause(struct TymSymGen * namegen, const s
   result->name = tym_mk_new_var(namegen);
   result->type = TYM_CSTR_DUPLICATE("struct TymClause");
 
-  int buf_occupied = sprintf(str_buf, "%s %s = (%s){.head = %s, .body_size = %d, .body = %s};\n",
+  int buf_occupied = sprintf(str_buf, "%s %s = (%s){.head = %s, .body_size = %zu, .body = %s};\n",
     tym_decode_str(result->type), tym_decode_str(result->name),
     tym_decode_str(result->type), tym_decode_str(tym_csyntax_address_of(head)), cl->body_size,
     tym_decode_str(args_identifier));
@@ -260,7 +262,7 @@ const struct TymCSyntax * tym_csyntax_clause(struct TymSymGen * namegen, const s
   result->original = cl;
 
   tym_csyntax_free(head);
-  for (int i = 0; i < cl->body_size; i++) {
+  for (size_t i = 0; i < cl->body_size; i++) {
     tym_csyntax_free(sub_csyns[i]);
   }
 
@@ -272,9 +274,11 @@ const struct TymCSyntax * tym_csyntax_program(struct TymSymGen * namegen, const
   struct TymCSyntax * result = malloc(sizeof(*result));
 
   const char * str_buf_args = tym_decode_str(TymEmptyString);
-  const struct TymCSyntax * sub_csyns[prog->no_clauses];
-  const TymStr * array[prog->no_clauses];
-  for (int i = 0; i < prog->no_clauses; i++) {
+  // NOTE programs can have many clauses, so unlike in tym_csyntax_atom and
+  //      tym_csyntax_clause we don't allocate these arrays on the stack.
+  const struct TymCSyntax ** sub_csyns = malloc(sizeof(*sub_csyns) * (prog->no_clauses + 1));
+  const TymStr ** array = malloc(sizeof(*array) * (prog->no_clauses + 1));
+  for (size_t i = 0; i < prog->no_clauses; i++) {
     sub_csyns[i] = tym_csyntax_clause(namegen, prog->program[i]);
 
     str_buf_args = tym_decode_str(tym_append_str_destructive2(sub_csyns[i]->serialised, tym_encode_str(str_buf_args)));
@@ -293,7 +297,7 @@ const struct TymCSyntax * tym_csyntax_program(struct TymSymGen * namegen, const
   result->name = tym_mk_new_var(namegen);
   result->type = TYM_CSTR_DUPLICATE("struct TymProgram");
 
-  int buf_occupied = sprintf(str_buf, "%s %s = (%s){.no_clauses = %d, .program = %s};\n",
+  int buf_occupied = sprintf(str_buf, "%s %s = (%s){.no_clauses = %zu, .program = %s};\n",
     tym_decode_str(result->type), tym_decode_str(result->name),
     tym_decode_str(result->type), prog->no_clauses,
     tym_decode_str(args_identifier));
@@ -307,9 +311,11 @@ const struct TymCSyntax * tym_csyntax_program(struct TymSymGen * namegen, const
   result->kind = TYM_PROGRAM;
   result->original = prog;
 
-  for (int i = 0; i < prog->no_clauses; i++) {
+  for (size_t i = 0; i < prog->no_clauses; i++) {
     tym_csyntax_free(sub_csyns[i]);
   }
+  free(sub_csyns);
+  free(array);
 
   return result;
 }
@@ -22,49 +22,180 @@ This file: Translation from formulas to Z3's API.
 */
 
 #ifdef TYM_INTERFACE_Z3
+// For clock_gettime, which times the interruptions made during races.
+#define _POSIX_C_SOURCE 200809L
+
 #include "interface_z3.h"
 
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
 #include "stdlib.h"
 #include "string.h"
 
-static Z3_sort universe_sort = NULL;
-static Z3_context z3_ctxt = NULL;
-static Z3_solver z3_slvr = NULL;
-static Z3_model z3_mdl = NULL;
-static Z3_lbool z3_result = Z3_L_UNDEF;
+#include "hash.h"
 
-void
+// Declarations made while translating a model, so that later occurrences of
+// a predicate or constant don't need to be declared anew.
+// NOTE symbols' names are borrowed from the model, which must outlive the
+//      solver. This also means that the solver doesn't touch the string table,
+//      so different solvers can be used from different threads.
+struct TymZ3Symbol {
+  const TymStr * name; // NULL if the slot is empty.
+  TYM_HASH_VTYPE h;
+  Z3_func_decl decl;
+  Z3_ast app; // For constants, "decl" applied to no arguments.
+};
+
+#define TYM_Z3_INITIAL_SYMBOLS 256
+// How often the losers of a race are interrupted while we wait for them.
+#define TYM_Z3_INTERRUPT_INTERVAL_NS 10000000L
+
+// Each member of a solver has its own Z3 context, configured differently from
+// the other members' (see configure_member).
+struct TymZ3Member {
+  Z3_sort universe_sort;
+  // If the universe is encoded as bit-vectors then we need it to name the
+  // numerals in models, otherwise it's NULL.
+  const struct TymUniverse * bitvec_universe;
+  Z3_context ctxt;
+  Z3_solver slvr;
+  Z3_model mdl;
+  // Open addressing: no_symbol_slots is a power of 2, and we keep the table
+  // at most half full.
+  struct TymZ3Symbol * symbols;
+  size_t no_symbol_slots;
+  size_t no_symbols;
+  bool checking; // Whether the member is taking part in a race that's ongoing.
+  bool interrupted; // Whether the member was interrupted during the last race.
+};
+
+// A solver is a portfolio of members that are given the same assertions, and
+// which race each other on separate threads whenever it's checked. The first
+// member to reach a definitive result wins, and the others are interrupted.
+struct TymZ3Solver {
+  struct TymZ3Member * members;
+  unsigned no_members;
+  unsigned winner; // Member whose model is used after the last check.
+  Z3_lbool result;
+  // The following are used during races.
+  pthread_mutex_t race_lock;
+  pthread_cond_t race_cond;
+  bool race_decided;
+  unsigned no_checking;
+};
+
+struct TymZ3Racer {
+  struct TymZ3Solver * slv;
+  unsigned member;
+};
+
+// Maps the interpretation of constants in a model to a constant that's
+// interpreted in the same way, but which isn't fresh (i.e., it isn't one of
+// the query's constants).
+// The same table is used as a set of the query's constants, keyed by Z3's
+// identifier for their declarations.
+struct TymZ3Interp {
+  unsigned id; // Z3's identifier for the interpretation (or declaration).
+  Z3_func_decl decl; // NULL if the slot is empty.
+};
+
+static void configure_member(struct TymZ3Member * mbr, unsigned idx);
+static void * race_member(void * arg);
+static struct TymZ3Symbol * find_symbol(struct TymZ3Member * mbr, const TymStr * name, TYM_HASH_VTYPE h);
+static const struct TymZ3Symbol * lookup_symbol(struct TymZ3Member * mbr, const TymStr * name);
+static void add_symbol(struct TymZ3Member * mbr, const TymStr * name, Z3_func_decl decl, Z3_ast app);
+static Z3_sort sort_of_ty(struct TymZ3Member * mbr, const TymStr * ty);
+static Z3_ast term_to_z3(struct TymZ3Member * mbr, const struct TymTerm * term);
+static Z3_ast fmla_atom_to_z3(struct TymZ3Member * mbr, const struct TymFmlaAtom * atom);
+static Z3_ast fmla_to_z3(struct TymZ3Member * mbr, const struct TymFmla * fmla);
+static bool declare_const_def(struct TymZ3Member * mbr, const struct TymStmtConst * def);
+static void declare_universe_datatype(struct TymZ3Member * mbr, const struct TymUniverse * uni);
+static void declare_universe_bitvec(struct TymZ3Member * mbr, const struct TymUniverse * uni);
+static struct TymZ3Interp * find_interp(struct TymZ3Interp * interps, size_t no_slots, unsigned id);
+
+struct TymZ3Solver *
 tym_z3_begin(struct TymParams * params)
 {
-  if ((NULL != universe_sort) || (NULL != z3_ctxt)) {
-    assert(0);
-  } else {
+  assert(params->solver_portfolio > 0);
+  struct TymZ3Solver * slv = malloc(sizeof(*slv));
+  assert(NULL != slv);
+  slv->no_members = params->solver_portfolio;
+  slv->members = malloc(sizeof(*slv->members) * slv->no_members);
+  assert(NULL != slv->members);
+
+  for (unsigned i = 0; i < slv->no_members; i++) {
+    struct TymZ3Member * mbr = &slv->members[i];
+
     Z3_config cfg = Z3_mk_config();
     Z3_set_param_value(cfg, "model", "true");
     Z3_set_param_value(cfg, "smtlib2_compliant", "true");
     Z3_set_param_value(cfg, "timeout", params->solver_timeout);
-    z3_ctxt = Z3_mk_context(cfg);
+    mbr->ctxt = Z3_mk_context(cfg);
     Z3_del_config(cfg);
 
-    Z3_symbol universe_sort_name = Z3_mk_string_symbol(z3_ctxt, "Universe");
-    universe_sort = Z3_mk_uninterpreted_sort(z3_ctxt, universe_sort_name);
+    Z3_symbol universe_sort_name = Z3_mk_string_symbol(mbr->ctxt, "Universe");
+    mbr->universe_sort = Z3_mk_uninterpreted_sort(mbr->ctxt, universe_sort_name);
 
-    z3_slvr = Z3_mk_solver(z3_ctxt);
-    Z3_solver_inc_ref(z3_ctxt, z3_slvr);
+    mbr->slvr = Z3_mk_solver(mbr->ctxt);
+    Z3_solver_inc_ref(mbr->ctxt, mbr->slvr);
+    configure_member(mbr, i);
+
+    mbr->bitvec_universe = NULL;
+    mbr->mdl = NULL;
+    mbr->symbols = NULL;
+    mbr->no_symbol_slots = 0;
+    mbr->no_symbols = 0;
+    mbr->checking = false;
+    mbr->interrupted = false;
   }
+
+  slv->winner = 0;
+  slv->result = Z3_L_UNDEF;
+  pthread_mutex_init(&slv->race_lock, NULL);
+  pthread_cond_init(&slv->race_cond, NULL);
+  return slv;
 }
 
 void
-tym_z3_end(void)
+tym_z3_end(struct TymZ3Solver * slv)
 {
-  Z3_solver_dec_ref(z3_ctxt, z3_slvr);
-  Z3_del_context(z3_ctxt);
+  for (unsigned i = 0; i < slv->no_members; i++) {
+    struct TymZ3Member * mbr = &slv->members[i];
+    Z3_solver_dec_ref(mbr->ctxt, mbr->slvr);
+    Z3_del_context(mbr->ctxt);
+    free(mbr->symbols);
+  }
+  pthread_mutex_destroy(&slv->race_lock);
+  pthread_cond_destroy(&slv->race_cond);
+  free(slv->members);
+  free(slv);
+}
+
+// The first member uses Z3's default configuration. The others alternate
+// between disabling and enabling model-based quantifier instantiation, and
+// each pair of them uses a different random seed.
+static void
+configure_member(struct TymZ3Member * mbr, unsigned idx)
+{
+  if (0 == idx) {
+    return;
+  }
+  Z3_params prms = Z3_mk_params(mbr->ctxt);
+  Z3_params_inc_ref(mbr->ctxt, prms);
+  Z3_params_set_bool(mbr->ctxt, prms, Z3_mk_string_symbol(mbr->ctxt, "mbqi"),
+      (0 == idx % 2));
+  Z3_params_set_uint(mbr->ctxt, prms, Z3_mk_string_symbol(mbr->ctxt, "random_seed"),
+      (idx + 1) / 2);
+  Z3_solver_set_params(mbr->ctxt, mbr->slvr, prms);
+  Z3_params_dec_ref(mbr->ctxt, prms);
 }
 
 enum TymSatisfiable
-tym_z3_satisfied(void)
+tym_z3_satisfied(struct TymZ3Solver * slv)
 {
-  switch (z3_result) {
+  switch (slv->result) {
   case Z3_L_UNDEF:
     return TYM_SAT_UNKNOWN;
   case Z3_L_TRUE:
@@ -76,120 +207,645 @@ tym_z3_satisfied(void)
   }
 }
 
+static void *
+race_member(void * arg)
+{
+  const struct TymZ3Racer * racer = arg;
+  struct TymZ3Solver * slv = racer->slv;
+  struct TymZ3Member * mbr = &slv->members[racer->member];
+
+  pthread_mutex_lock(&slv->race_lock);
+  bool too_late = slv->race_decided;
+  pthread_mutex_unlock(&slv->race_lock);
+  Z3_lbool result = too_late ? Z3_L_UNDEF : Z3_solver_check(mbr->ctxt, mbr->slvr);
+
+  pthread_mutex_lock(&slv->race_lock);
+  if (Z3_L_UNDEF != result && !slv->race_decided) {
+    slv->race_decided = true;
+    slv->winner = racer->member;
+    slv->result = result;
+  }
+  mbr->checking = false;
+  slv->no_checking--;
+  pthread_cond_signal(&slv->race_cond);
+  pthread_mutex_unlock(&slv->race_lock);
+  return NULL;
+}
+
+void
+tym_z3_check(struct TymZ3Solver * slv)
+{
+  if (1 == slv->no_members) {
+    struct TymZ3Member * mbr = &slv->members[0];
+    slv->result = Z3_solver_check(mbr->ctxt, mbr->slvr);
+    return;
+  }
+
+  pthread_t * threads = malloc(sizeof(*threads) * slv->no_members);
+  struct TymZ3Racer * racers = malloc(sizeof(*racers) * slv->no_members);
+  assert(NULL != threads);
+  assert(NULL != racers);
+
+  slv->winner = 0;
+  slv->result = Z3_L_UNDEF;
+  slv->race_decided = false;
+  slv->no_checking = slv->no_members;
+  for (unsigned i = 0; i < slv->no_members; i++) {
+    slv->members[i].checking = true;
+    slv->members[i].interrupted = false;
+  }
+
+  for (unsigned i = 0; i < slv->no_members; i++) {
+    racers[i] = (struct TymZ3Racer){.slv = slv, .member = i};
+    int rc = pthread_create(&threads[i], NULL, race_member, &racers[i]);
+    assert(0 == rc);
+  }
+
+  pthread_mutex_lock(&slv->race_lock);
+  while (!slv->race_decided && slv->no_checking > 0) {
+    pthread_cond_wait(&slv->race_cond, &slv->race_lock);
+  }
+  // Each loser that's still checking is interrupted, and we wait for them all
+  // to stop. Losers that haven't started their check yet will see that the
+  // race is decided, and won't start it. A loser that's between deciding to
+  // check and its check getting going can miss an interruption, so losers
+  // are interrupted again every TYM_Z3_INTERRUPT_INTERVAL_NS until they stop.
+  while (slv->no_checking > 0) {
+    for (unsigned i = 0; i < slv->no_members; i++) {
+      if (slv->members[i].checking) {
+        Z3_interrupt(slv->members[i].ctxt);
+        slv->members[i].interrupted = true;
+      }
+    }
+    struct timespec deadline;
+    int rc = clock_gettime(CLOCK_REALTIME, &deadline);
+    assert(0 == rc);
+    deadline.tv_nsec += TYM_Z3_INTERRUPT_INTERVAL_NS;
+    if (deadline.tv_nsec >= 1000000000L) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000L;
+    }
+    rc = pthread_cond_timedwait(&slv->race_cond, &slv->race_lock, &deadline);
+    assert(0 == rc || ETIMEDOUT == rc);
+  }
+  pthread_mutex_unlock(&slv->race_lock);
+
+  for (unsigned i = 0; i < slv->no_members; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  // An interruption that arrives as a member's check is finishing can stay
+  // pending in the member's context, where it cancels part of the next thing
+  // we ask of the member. Without the following check, which is trivially
+  // unsatisfiable and consumes the interruption, a member can lose the
+  // statement that rules out the model that was just found, and give the
+  // same answer again.
+  for (unsigned i = 0; i < slv->no_members; i++) {
+    struct TymZ3Member * mbr = &slv->members[i];
+    if (mbr->interrupted) {
+      Z3_ast falsehood = Z3_mk_false(mbr->ctxt);
+      Z3_solver_check_assumptions(mbr->ctxt, mbr->slvr, 1, &falsehood);
+    }
+  }
+  free(racers);
+  free(threads);
+}
+
+void
+tym_z3_assert_smtlib2(struct TymZ3Solver * slv, const char * str)
+{
+  for (unsigned m = 0; m < slv->no_members; m++) {
+    struct TymZ3Member * mbr = &slv->members[m];
+    assert(NULL != mbr->ctxt);
+    Z3_ast_vector fmlas = Z3_parse_smtlib2_string(mbr->ctxt,
+        str, 0,
+        NULL,
+        NULL,
+        0,
+        NULL,
+        NULL);
+    Z3_ast_vector_inc_ref(mbr->ctxt, fmlas);
+    unsigned no_fmlas = Z3_ast_vector_size(mbr->ctxt, fmlas);
+    for (unsigned i = 0; i < no_fmlas; i++) {
+      Z3_solver_assert(mbr->ctxt, mbr->slvr, Z3_ast_vector_get(mbr->ctxt, fmlas, i));
+    }
+    Z3_ast_vector_dec_ref(mbr->ctxt, fmlas);
+  }
+}
+
+static struct TymZ3Symbol *
+find_symbol(struct TymZ3Member * mbr, const TymStr * name, TYM_HASH_VTYPE h)
+{
+  size_t mask = mbr->no_symbol_slots - 1;
+  size_t i = (size_t)h & mask;
+  while (NULL != mbr->symbols[i].name) {
+    if (h == mbr->symbols[i].h && tym_eq_str(name, mbr->symbols[i].name)) {
+      break;
+    }
+    i = (i + 1) & mask;
+  }
+  return &mbr->symbols[i];
+}
+
+static const struct TymZ3Symbol *
+lookup_symbol(struct TymZ3Member * mbr, const TymStr * name)
+{
+  if (0 == mbr->no_symbols) {
+    return NULL;
+  }
+  const struct TymZ3Symbol * result =
+    find_symbol(mbr, name, tym_hash_str(tym_decode_str(name)));
+  return (NULL == result->name) ? NULL : result;
+}
+
+static void
+add_symbol(struct TymZ3Member * mbr, const TymStr * name, Z3_func_decl decl, Z3_ast app)
+{
+  if (2 * (mbr->no_symbols + 1) > mbr->no_symbol_slots) {
+    struct TymZ3Symbol * old_symbols = mbr->symbols;
+    size_t old_no_slots = mbr->no_symbol_slots;
+    mbr->no_symbol_slots = (0 == old_no_slots) ? TYM_Z3_INITIAL_SYMBOLS : 2 * old_no_slots;
+    mbr->symbols = calloc(mbr->no_symbol_slots, sizeof(*mbr->symbols));
+    assert(NULL != mbr->symbols);
+    for (size_t i = 0; i < old_no_slots; i++) {
+      if (NULL != old_symbols[i].name) {
+        *find_symbol(mbr, old_symbols[i].name, old_symbols[i].h) = old_symbols[i];
+      }
+    }
+    free(old_symbols);
+  }
+
+  TYM_HASH_VTYPE h = tym_hash_str(tym_decode_str(name));
+  struct TymZ3Symbol * slot = find_symbol(mbr, name, h);
+  // Redeclaring a symbol with the same name replaces its earlier declaration.
+  if (NULL == slot->name) {
+    mbr->no_symbols++;
+  }
+  *slot = (struct TymZ3Symbol){
+    .name = name,
+    .h = h,
+    .decl = decl,
+    .app = app};
+}
+
+static Z3_sort
+sort_of_ty(struct TymZ3Member * mbr, const TymStr * ty)
+{
+  if (0 == strcmp(tym_decode_str(ty), TYM_UNIVERSE_TY)) {
+    return mbr->universe_sort;
+  } else {
+    assert(0 == strcmp(tym_decode_str(ty), tym_bool_ty));
+    return Z3_mk_bool_sort(mbr->ctxt);
+  }
+}
+
+// Constants are looked up among those declared in the model. Any other term
+// is a variable that's bound by an enclosing quantifier.
+// NOTE we cannot go by the term's kind here, since some bound variables are
+//      made as TYM_CONST terms (see tym_statementise_universe).
+static Z3_ast
+term_to_z3(struct TymZ3Member * mbr, const struct TymTerm * term)
+{
+  const struct TymZ3Symbol * sym = lookup_symbol(mbr, term->identifier);
+  if (NULL != sym && NULL != sym->app) {
+    return sym->app;
+  } else {
+    return Z3_mk_const(mbr->ctxt,
+        Z3_mk_string_symbol(mbr->ctxt, tym_decode_str(term->identifier)),
+        mbr->universe_sort);
+  }
+}
+
+// Returns NULL if the atom's predicate isn't known to the member.
+static Z3_ast
+fmla_atom_to_z3(struct TymZ3Member * mbr, const struct TymFmlaAtom * atom)
+{
+  Z3_ast * args = malloc(sizeof(*args) * (atom->arity + 1));
+  for (size_t i = 0; i < atom->arity; i++) {
+    args[i] = term_to_z3(mbr, atom->predargs[i]);
+  }
+
+  Z3_ast result;
+  const char * pred_name = tym_decode_str(atom->pred_name);
+  if (0 == strcmp(pred_name, tym_eqK)) {
+    assert(2 == atom->arity);
+    result = Z3_mk_eq(mbr->ctxt, args[0], args[1]);
+  } else if (0 == strcmp(pred_name, tym_distinctK)) {
+    result = Z3_mk_distinct(mbr->ctxt, (unsigned)atom->arity, args);
+  } else if (0 == strcmp(pred_name, tym_bvuleK)) {
+    assert(2 == atom->arity);
+    result = Z3_mk_bvule(mbr->ctxt, args[0], args[1]);
+  } else {
+    const struct TymZ3Symbol * sym = lookup_symbol(mbr, atom->pred_name);
+    if (NULL == sym) {
+      // This happens if a query mentions a predicate that the program doesn't.
+      // NOTE this might run on a solver's worker thread, so we leave it to
+      //      the caller to report the error.
+      result = NULL;
+    } else if (0 == atom->arity && NULL != sym->app) {
+      result = sym->app;
+    } else {
+      result = Z3_mk_app(mbr->ctxt, sym->decl, (unsigned)atom->arity, args);
+    }
+  }
+
+  free(args);
+  return result;
+}
+
+// Returns NULL if the formula mentions a predicate that isn't known to the
+// member, in which case nothing is made of the rest of the formula.
+static Z3_ast
+fmla_to_z3(struct TymZ3Member * mbr, const struct TymFmla * fmla)
+{
+  Z3_ast result = NULL;
+  unsigned no_args = 0;
+  Z3_ast * args = NULL;
+  Z3_app bound;
+  Z3_ast body;
+  Z3_ast lhs, rhs;
+
+  switch (fmla->kind) {
+  case FMLA_CONST:
+    result = fmla->param.const_value ? Z3_mk_true(mbr->ctxt) : Z3_mk_false(mbr->ctxt);
+    break;
+  case FMLA_ATOM:
+    result = fmla_atom_to_z3(mbr, fmla->param.atom);
+    break;
+  case FMLA_AND:
+  case FMLA_OR:
+    while (NULL != fmla->param.args[no_args]) {
+      no_args++;
+    }
+    args = malloc(sizeof(*args) * (no_args + 1));
+    for (unsigned i = 0; i < no_args; i++) {
+      args[i] = fmla_to_z3(mbr, fmla->param.args[i]);
+      if (NULL == args[i]) {
+        free(args);
+        return NULL;
+      }
+    }
+    if (FMLA_AND == fmla->kind) {
+      result = Z3_mk_and(mbr->ctxt, no_args, args);
+    } else {
+      result = Z3_mk_or(mbr->ctxt, no_args, args);
+    }
+    free(args);
+    break;
+  case FMLA_NOT:
+    body = fmla_to_z3(mbr, fmla->param.args[0]);
+    if (NULL != body) {
+      result = Z3_mk_not(mbr->ctxt, body);
+    }
+    break;
+  case FMLA_EX:
+  case FMLA_ALL:
+    // Occurrences of the bound variable in the body are constants having the
+    // variable's name, which Z3 abstracts when making the quantifier.
+    bound = Z3_to_app(mbr->ctxt, Z3_mk_const(mbr->ctxt,
+          Z3_mk_string_symbol(mbr->ctxt, tym_decode_str(fmla->param.quant->bv)),
+          mbr->universe_sort));
+    body = fmla_to_z3(mbr, fmla->param.quant->body);
+    if (NULL == body) {
+      result = NULL;
+    } else if (FMLA_EX == fmla->kind) {
+      result = Z3_mk_exists_const(mbr->ctxt, 0, 1, &bound, 0, NULL, body);
+    } else {
+      result = Z3_mk_forall_const(mbr->ctxt, 0, 1, &bound, 0, NULL, body);
+    }
+    break;
+  case FMLA_IF:
+  case FMLA_IFF:
+    assert(FMLA_IF == fmla->kind || NULL == fmla->param.args[2]);
+    lhs = fmla_to_z3(mbr, fmla->param.args[0]);
+    rhs = (NULL == lhs) ? NULL : fmla_to_z3(mbr, fmla->param.args[1]);
+    if (NULL == rhs) {
+      result = NULL;
+    } else if (FMLA_IF == fmla->kind) {
+      result = Z3_mk_implies(mbr->ctxt, lhs, rhs);
+    } else {
+      result = Z3_mk_eq(mbr->ctxt, lhs, rhs);
+    }
+    break;
+  default:
+    assert(0);
+  }
+
+  return result;
+}
+
+static bool
+declare_const_def(struct TymZ3Member * mbr, const struct TymStmtConst * def)
+{
+  size_t arity = tym_len_TymTerms_cell(def->params);
+  Z3_sort * domain = malloc(sizeof(*domain) * (arity + 1));
+  Z3_ast * params = malloc(sizeof(*params) * (arity + 1));
+  const struct TymTerms * cursor = def->params;
+  for (size_t i = 0; i < arity; i++) {
+    domain[i] = mbr->universe_sort;
+    params[i] = term_to_z3(mbr, cursor->term);
+    cursor = cursor->next;
+  }
+
+  Z3_func_decl decl = Z3_mk_func_decl(mbr->ctxt,
+      Z3_mk_string_symbol(mbr->ctxt, tym_decode_str(def->const_name)),
+      (unsigned)arity, domain, sort_of_ty(mbr, def->ty));
+  Z3_ast app = (0 == arity) ? Z3_mk_app(mbr->ctxt, decl, 0, NULL) : NULL;
+  add_symbol(mbr, def->const_name, decl, app);
+
+  bool success = true;
+  Z3_ast body = (NULL == def->body) ? NULL : fmla_to_z3(mbr, def->body);
+  if (NULL != def->body && NULL == body) {
+    success = false;
+  } else if (NULL != body) {
+    // As with define-fun, the body is the definition of the function.
+    Z3_ast defn = Z3_mk_eq(mbr->ctxt,
+        Z3_mk_app(mbr->ctxt, decl, (unsigned)arity, params), body);
+    if (arity > 0) {
+      Z3_app * bound = malloc(sizeof(*bound) * arity);
+      for (size_t i = 0; i < arity; i++) {
+        bound[i] = Z3_to_app(mbr->ctxt, params[i]);
+      }
+      defn = Z3_mk_forall_const(mbr->ctxt, 0, (unsigned)arity, bound, 0, NULL, defn);
+      free(bound);
+    }
+    Z3_solver_assert(mbr->ctxt, mbr->slvr, defn);
+  }
+
+  free(domain);
+  free(params);
+  return success;
+}
+
+// The universe's elements become the constructors of an enumeration sort,
+// which replaces the uninterpreted sort that the member started with.
+static void
+declare_universe_datatype(struct TymZ3Member * mbr, const struct TymUniverse * uni)
+{
+  assert(uni->cardinality > 0);
+  unsigned n = (unsigned)uni->cardinality;
+  Z3_symbol * names = malloc(sizeof(*names) * n);
+  Z3_func_decl * consts = malloc(sizeof(*consts) * n);
+  Z3_func_decl * testers = malloc(sizeof(*testers) * n);
+  for (unsigned i = 0; i < n; i++) {
+    names[i] = Z3_mk_string_symbol(mbr->ctxt, tym_decode_str(uni->element[i]));
+  }
+
+  mbr->universe_sort = Z3_mk_enumeration_sort(mbr->ctxt,
+      Z3_mk_string_symbol(mbr->ctxt, TYM_UNIVERSE_TY), n, names, consts, testers);
+  for (unsigned i = 0; i < n; i++) {
+    add_symbol(mbr, uni->element[i], consts[i], Z3_mk_app(mbr->ctxt, consts[i], 0, NULL));
+  }
+
+  free(names);
+  free(consts);
+  free(testers);
+}
+
+// The universe's elements become the numerals of a bit-vector sort, which
+// replaces the uninterpreted sort that the member started with. Elements
+// therefore have no declarations, only the numerals they stand for.
+static void
+declare_universe_bitvec(struct TymZ3Member * mbr, const struct TymUniverse * uni)
+{
+  assert(uni->cardinality > 0);
+  mbr->universe_sort = Z3_mk_bv_sort(mbr->ctxt, (unsigned)tym_universe_width(uni));
+  mbr->bitvec_universe = uni;
+  for (size_t i = 0; i < uni->cardinality; i++) {
+    add_symbol(mbr, uni->element[i], NULL,
+        Z3_mk_unsigned_int64(mbr->ctxt, (uint64_t)i, mbr->universe_sort));
+  }
+}
+
+// Gives the model's statements to the solver, without rendering them in
+// SMT-LIB. The statements must be ordered (see tym_order_statements), so that
+// symbols are declared before they're used.
+// Returns false if a statement mentions a predicate that isn't declared in the
+// model, in which case the solver is left partway through the model.
+bool
+tym_z3_assert_model(struct TymZ3Solver * slv, const struct TymModel * mdl)
+{
+  for (unsigned m = 0; m < slv->no_members; m++) {
+    struct TymZ3Member * mbr = &slv->members[m];
+    assert(NULL != mbr->ctxt);
+    if (TYM_UNIVERSE_DATATYPE == mdl->universe->encoding) {
+      declare_universe_datatype(mbr, mdl->universe);
+    } else if (TYM_UNIVERSE_BITVEC == mdl->universe->encoding) {
+      declare_universe_bitvec(mbr, mdl->universe);
+    }
+    const struct TymStmts * cursor = mdl->stmts;
+    while (NULL != cursor) {
+      Z3_ast axiom;
+      switch (cursor->stmt->kind) {
+      case TYM_STMT_AXIOM:
+        axiom = fmla_to_z3(mbr, cursor->stmt->param.axiom);
+        if (NULL == axiom) {
+          return false;
+        }
+        Z3_solver_assert(mbr->ctxt, mbr->slvr, axiom);
+        break;
+      case TYM_STMT_CONST_DEF:
+        if (!declare_const_def(mbr, cursor->stmt->param.const_def)) {
+          return false;
+        }
+        break;
+      default:
+        assert(0);
+      }
+      cursor = cursor->next;
+    }
+  }
+  return true;
+}
+
+// Asserts a formula over the symbols of a model that was given to the solver
+// earlier by tym_z3_assert_model.
+// Returns false if the formula mentions a predicate that isn't declared in the
+// model, in which case nothing is asserted.
+bool
+tym_z3_assert_fmla(struct TymZ3Solver * slv, const struct TymFmla * fmla)
+{
+  // Each member's formula is made before any of them is asserted, so that the
+  // members are left in step if one of them fails.
+  Z3_ast * asts = malloc(sizeof(*asts) * slv->no_members);
+  bool success = true;
+  for (unsigned m = 0; m < slv->no_members && success; m++) {
+    assert(NULL != slv->members[m].ctxt);
+    asts[m] = fmla_to_z3(&slv->members[m], fmla);
+    success = (NULL != asts[m]);
+  }
+  for (unsigned m = 0; m < slv->no_members && success; m++) {
+    Z3_solver_assert(slv->members[m].ctxt, slv->members[m].slvr, asts[m]);
+  }
+  free(asts);
+  return success;
+}
+
 void
-tym_z3_check(void)
+tym_z3_push(struct TymZ3Solver * slv)
 {
-  z3_result = Z3_solver_check(z3_ctxt, z3_slvr);
+  for (unsigned m = 0; m < slv->no_members; m++) {
+    Z3_solver_push(slv->members[m].ctxt, slv->members[m].slvr);
+  }
 }
 
 void
-tym_z3_assert_smtlib2(const char * str)
+tym_z3_pop(struct TymZ3Solver * slv)
 {
-  assert(NULL != z3_ctxt);
-  Z3_ast fmla = Z3_parse_smtlib2_string(z3_ctxt,
-      str, 0,
-      NULL,
-      NULL,
-      0,
-      NULL,
-      NULL);
-  Z3_solver_assert(z3_ctxt, z3_slvr, fmla);
+  for (unsigned m = 0; m < slv->no_members; m++) {
+    Z3_solver_pop(slv->members[m].ctxt, slv->members[m].slvr, 1);
+  }
 }
 
 void
-tym_z3_print_model(void)
+tym_z3_print_model(struct TymZ3Solver * slv)
 {
+  struct TymZ3Member * mbr = &slv->members[slv->winner];
   // NOTE this function displays the interpretations of all constants, not only
   //      those appearing in the query.
-  z3_mdl = Z3_solver_get_model(z3_ctxt, z3_slvr);
-  if (NULL != z3_mdl) {
-    Z3_model_inc_ref(z3_ctxt, z3_mdl);
-    printf("z3_mdl:\n%s\n", Z3_model_to_string(z3_ctxt, z3_mdl));
+  mbr->mdl = Z3_solver_get_model(mbr->ctxt, mbr->slvr);
+  if (NULL != mbr->mdl) {
+    Z3_model_inc_ref(mbr->ctxt, mbr->mdl);
+    printf("slv->mdl:\n%s\n", Z3_model_to_string(mbr->ctxt, mbr->mdl));
   }
 
-  unsigned c = Z3_model_get_num_consts(z3_ctxt, z3_mdl);
+  unsigned c = Z3_model_get_num_consts(mbr->ctxt, mbr->mdl);
   printf("Num consts: %d\n", c);
   for (unsigned i = 0; i < c; i++) {
-    Z3_func_decl d = Z3_model_get_const_decl(z3_ctxt, z3_mdl, i);
-    Z3_ast_opt a = Z3_model_get_const_interp(z3_ctxt, z3_mdl, d);
+    Z3_func_decl d = Z3_model_get_const_decl(mbr->ctxt, mbr->mdl, i);
+    Z3_ast_opt a = Z3_model_get_const_interp(mbr->ctxt, mbr->mdl, d);
     assert(NULL != a);
 
-    Z3_symbol symb = Z3_get_decl_name(z3_ctxt, d);
-    char const * s = Z3_get_symbol_string(z3_ctxt, symb);
+    Z3_symbol symb = Z3_get_decl_name(mbr->ctxt, d);
+    char const * s = Z3_get_symbol_string(mbr->ctxt, symb);
     printf("  symb: %s\n    ", s);
 
     for (unsigned j = 0; j < c; j++) {
-      Z3_func_decl d2 = Z3_model_get_const_decl(z3_ctxt, z3_mdl, j);
-      Z3_ast_opt a2 = Z3_model_get_const_interp(z3_ctxt, z3_mdl, d2);
+      Z3_func_decl d2 = Z3_model_get_const_decl(mbr->ctxt, mbr->mdl, j);
+      Z3_ast_opt a2 = Z3_model_get_const_interp(mbr->ctxt, mbr->mdl, d2);
       if (a2 == a) {
-        Z3_symbol symb2 = Z3_get_decl_name(z3_ctxt, d2);
-        char const * s2 = Z3_get_symbol_string(z3_ctxt, symb2);
+        Z3_symbol symb2 = Z3_get_decl_name(mbr->ctxt, d2);
+        char const * s2 = Z3_get_symbol_string(mbr->ctxt, symb2);
         printf("%s ", s2);
       }
     }
     printf("\n");
 
-    Z3_bool b = Z3_model_has_interp(z3_ctxt, z3_mdl, d);
+    Z3_bool b = Z3_model_has_interp(mbr->ctxt, mbr->mdl, d);
     assert(b == Z3_TRUE);
   }
 
-  if (NULL != z3_mdl) {
-    Z3_model_dec_ref(z3_ctxt, z3_mdl);
+  if (NULL != mbr->mdl) {
+    Z3_model_dec_ref(mbr->ctxt, mbr->mdl);
   }
 }
 
+static struct TymZ3Interp *
+find_interp(struct TymZ3Interp * interps, size_t no_slots, unsigned id)
+{
+  size_t mask = no_slots - 1;
+  // Z3's identifiers are small and dense, so we use them directly as hashes.
+  size_t i = (size_t)id & mask;
+  while (NULL != interps[i].decl && id != interps[i].id) {
+    i = (i + 1) & mask;
+  }
+  return &interps[i];
+}
+
+// NOTE this works in time linear in the number of constants in the model
+//      plus the number of the query's constants.
 void
-tym_z3_get_model(struct TymMdlValuations * vals)
+tym_z3_get_model(struct TymZ3Solver * slv, struct TymMdlValuations * vals)
 {
+  // The model is taken from the member that won the last check.
+  struct TymZ3Member * mbr = &slv->members[slv->winner];
   assert(NULL != vals);
-  z3_mdl = Z3_solver_get_model(z3_ctxt, z3_slvr);
-  if (NULL != z3_mdl) {
-    Z3_model_inc_ref(z3_ctxt, z3_mdl);
+  mbr->mdl = Z3_solver_get_model(mbr->ctxt, mbr->slvr);
+  if (NULL != mbr->mdl) {
+    Z3_model_inc_ref(mbr->ctxt, mbr->mdl);
   }
 
-  unsigned c = Z3_model_get_num_consts(z3_ctxt, z3_mdl);
-  for (unsigned i = 0; i < c; i++) {
-    Z3_func_decl d = Z3_model_get_const_decl(z3_ctxt, z3_mdl, i);
-    Z3_ast_opt a = Z3_model_get_const_interp(z3_ctxt, z3_mdl, d);
-    assert(NULL != a);
+  size_t no_fresh_slots = 8;
+  while (no_fresh_slots < 2 * (size_t)vals->count) {
+    no_fresh_slots *= 2;
+  }
+  struct TymZ3Interp * fresh_set = calloc(no_fresh_slots, sizeof(*fresh_set));
+  assert(NULL != fresh_set);
+  Z3_func_decl * fresh = malloc(sizeof(*fresh) * (vals->count + 1));
+  for (unsigned vi = 0; vi < vals->count; vi++) {
+    const struct TymZ3Symbol * sym = lookup_symbol(mbr, vals->v[vi].const_name);
+    fresh[vi] = (NULL == sym) ? NULL : sym->decl;
+    if (NULL != fresh[vi]) {
+      unsigned id = Z3_get_ast_id(mbr->ctxt, Z3_func_decl_to_ast(mbr->ctxt, fresh[vi]));
+      *find_interp(fresh_set, no_fresh_slots, id) = (struct TymZ3Interp){.id = id, .decl = fresh[vi]};
+    }
+  }
 
-    Z3_symbol symb = Z3_get_decl_name(z3_ctxt, d);
-    const TymStr * s = TYM_CSTR_DUPLICATE(Z3_get_symbol_string(z3_ctxt, symb));
-
-    for (unsigned vi = 0; vi < vals->count; vi++) {
-      if (0 == tym_cmp_str(vals->v[vi].const_name, s)) {
-        assert(NULL == vals->v[vi].value);
-
-        for (unsigned j = 0; j < c; j++) {
-          Z3_func_decl d2 = Z3_model_get_const_decl(z3_ctxt, z3_mdl, j);
-          Z3_ast_opt a2 = Z3_model_get_const_interp(z3_ctxt, z3_mdl, d2);
-          if (a2 == a) {
-            Z3_symbol symb2 = Z3_get_decl_name(z3_ctxt, d2);
-            const TymStr * s2 = TYM_CSTR_DUPLICATE(Z3_get_symbol_string(z3_ctxt, symb2));
-            bool is_a_fresh_const = false;
-            // Ensure that s2 doesn't correspond to any fresh constant, not just vals->v[vi].const_name
-            for (unsigned vj = 0; vj < vals->count; vj++) {
-              if (0 == tym_cmp_str(vals->v[vj].const_name, s2)) {
-                is_a_fresh_const = true;
-                break;
-              }
-            }
-
-            if (!is_a_fresh_const) {
-              vals->v[vi].value = s2;
-            } else {
-              tym_free_str(s2);
-            }
-          }
-        }
+  unsigned c = Z3_model_get_num_consts(mbr->ctxt, mbr->mdl);
+  size_t no_slots = TYM_Z3_INITIAL_SYMBOLS;
+  while (no_slots < 2 * (size_t)c) {
+    no_slots *= 2;
+  }
+  struct TymZ3Interp * interps = calloc(no_slots, sizeof(*interps));
+  assert(NULL != interps);
+
+  for (unsigned j = 0; j < c; j++) {
+    Z3_func_decl d = Z3_model_get_const_decl(mbr->ctxt, mbr->mdl, j);
+    bool is_a_fresh_const = NULL != find_interp(fresh_set, no_fresh_slots,
+        Z3_get_ast_id(mbr->ctxt, Z3_func_decl_to_ast(mbr->ctxt, d)))->decl;
 
+    if (!is_a_fresh_const) {
+      Z3_ast_opt a = Z3_model_get_const_interp(mbr->ctxt, mbr->mdl, d);
+      assert(NULL != a);
+      unsigned id = Z3_get_ast_id(mbr->ctxt, a);
+      // If several constants have the same interpretation, then we use the
+      // last of them.
+      *find_interp(interps, no_slots, id) = (struct TymZ3Interp){.id = id, .decl = d};
+    }
+  }
+
+  for (unsigned vi = 0; vi < vals->count; vi++) {
+    assert(NULL == vals->v[vi].value);
+    if (NULL == fresh[vi]) {
+      continue;
+    }
+
+    Z3_ast_opt a = Z3_model_get_const_interp(mbr->ctxt, mbr->mdl, fresh[vi]);
+    if (NULL != a) {
+      Z3_func_decl named = NULL;
+      // If the universe is a datatype, then the interpretation is one of its
+      // constructors, which are named after the universe's elements.
+      if (Z3_APP_AST == Z3_get_ast_kind(mbr->ctxt, a)) {
+        Z3_func_decl d = Z3_get_app_decl(mbr->ctxt, Z3_to_app(mbr->ctxt, a));
+        if (Z3_OP_DT_CONSTRUCTOR == Z3_get_decl_kind(mbr->ctxt, d)) {
+          named = d;
+        }
+      }
+      if (NULL == named) {
+        named = find_interp(interps, no_slots, Z3_get_ast_id(mbr->ctxt, a))->decl;
+      }
+      if (NULL != named) {
+        Z3_symbol symb = Z3_get_decl_name(mbr->ctxt, named);
+        vals->v[vi].value = TYM_CSTR_DUPLICATE(Z3_get_symbol_string(mbr->ctxt, symb));
+      } else if (NULL != mbr->bitvec_universe &&
+          Z3_NUMERAL_AST == Z3_get_ast_kind(mbr->ctxt, a)) {
+        // If the universe is encoded as bit-vectors, then the interpretation
+        // is the numeral of an element.
+        uint64_t idx;
+        if (Z3_get_numeral_uint64(mbr->ctxt, a, &idx) &&
+            idx < mbr->bitvec_universe->cardinality) {
+          vals->v[vi].value = TYM_STR_DUPLICATE(mbr->bitvec_universe->element[idx]);
+        }
       }
     }
-    tym_free_str(s);
   }
 
-  if (NULL != z3_mdl) {
-    Z3_model_dec_ref(z3_ctxt, z3_mdl);
+  free(interps);
+  free(fresh_set);
+  free(fresh);
+
+  if (NULL != mbr->mdl) {
+    Z3_model_dec_ref(mbr->ctxt, mbr->mdl);
   }
 }
 
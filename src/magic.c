@@ -0,0 +1,437 @@
+/*
+Copyright Nik Sultana, 2019
+
+This file is part of TYM Datalog. (https://www.github.com/niksu/tym)
+
+TYM Datalog is free software: you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License as published
+by the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+TYM Datalog is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details, a copy of which
+is included in the file called LICENSE distributed with TYM Datalog.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TYM Datalog.  If not, see <https://www.gnu.org/licenses/>.
+
+
+This file: Magic-sets rewriting of programs.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "eval.h"
+#include "magic.h"
+#include "module_tests.h"
+#include "symbols.h"
+
+// A predicate that's specialised to a binding pattern.
+struct TymMagicPred {
+  struct TymPredicate * pred;
+  char * adornment; // 'b' (bound) or 'f' (free) for each argument.
+  const TymStr * adorned;
+  const TymStr * magic;
+};
+
+struct TymMagic {
+  struct TymAtomDatabase * adb;
+  // Names of the predicates that have rules, rather than only facts.
+  struct TymStrSet idb;
+  // Specialised predicates' adorned names. Their identifiers index "preds",
+  // which holds the specialisations in the order they were found.
+  struct TymStrSet adorned;
+  struct TymMagicPred ** preds;
+  size_t capacity;
+  struct TymClauses * clauses; // The rewritten program, in reverse.
+  size_t no_clauses;
+};
+
+static bool is_idb(const struct TymMagic * m, const struct TymPredicate * pred);
+static const TymStr * mk_name(const char * prefix, const char * adornment, const TymStr * predicate);
+static struct TymMagicPred * adorn(struct TymMagic * m, struct TymPredicate * pred, const char * adornment);
+static bool is_bound(const TymStr * var, const TymStr ** bound, size_t no_bound);
+static char * adornment_of(const struct TymAtom * atom, const TymStr ** bound, size_t no_bound);
+static struct TymAtom * mk_adorned_atom(const TymStr * predicate, const struct TymAtom * atom, const char * adornment, bool only_bound);
+static bool eq_atom(const struct TymAtom * a1, const struct TymAtom * a2);
+static void emit(struct TymMagic * m, struct TymAtom * head, size_t body_size, struct TymAtom ** body);
+static void rewrite_clause(struct TymMagic * m, const struct TymMagicPred * mp, const struct TymClause * cl);
+static void rewrite_pred(struct TymMagic * m, const struct TymMagicPred * mp);
+
+static bool
+is_idb(const struct TymMagic * m, const struct TymPredicate * pred)
+{
+  uint32_t id;
+  return tym_str_set_lookup(&m->idb, pred->predicate, &id);
+}
+
+// Names are made by prefixing the predicate's name, so they can't clash with
+// the names of predicates that were parsed, which all carry the same prefix
+// (TYM_PREDICATE_PREFIX).
+static const TymStr *
+mk_name(const char * prefix, const char * adornment, const TymStr * predicate)
+{
+  const char * name = tym_decode_str(predicate);
+  char * result = malloc(strlen(prefix) + strlen(adornment) + strlen(name) + 2);
+  assert(NULL != result);
+  sprintf(result, "%s%s_%s", prefix, adornment, name);
+  return tym_encode_str(result);
+}
+
+// Finds the specialisation of a predicate to a binding pattern, making it
+// (and scheduling its clauses to be rewritten) if it's new.
+static struct TymMagicPred *
+adorn(struct TymMagic * m, struct TymPredicate * pred, const char * adornment)
+{
+  const TymStr * adorned = mk_name("adorned_", adornment, pred->predicate);
+  uint32_t id;
+  if (tym_str_set_lookup(&m->adorned, adorned, &id)) {
+    tym_free_str(adorned);
+    return m->preds[id];
+  }
+
+  struct TymMagicPred * mp = malloc(sizeof *mp);
+  assert(NULL != mp);
+  mp->pred = pred;
+  mp->adornment = strdup(adornment);
+  mp->adorned = adorned;
+  mp->magic = mk_name("magic_", adornment, pred->predicate);
+
+  bool added = tym_str_set_add(&m->adorned, mp->adorned, &id);
+  assert(added);
+  if (m->capacity < m->adorned.capacity) {
+    m->capacity = m->adorned.capacity;
+    m->preds = realloc(m->preds, sizeof *m->preds * m->capacity);
+    assert(NULL != m->preds);
+  }
+  m->preds[id] = mp;
+  return mp;
+}
+
+static bool
+is_bound(const TymStr * var, const TymStr ** bound, size_t no_bound)
+{
+  for (size_t i = 0; i < no_bound; i++) {
+    if (tym_eq_str(var, bound[i])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static char *
+adornment_of(const struct TymAtom * atom, const TymStr ** bound, size_t no_bound)
+{
+  char * result = malloc(atom->arity + 1);
+  assert(NULL != result);
+  for (size_t i = 0; i < atom->arity; i++) {
+    result[i] = (TYM_VAR != atom->args[i]->kind ||
+        is_bound(atom->args[i]->identifier, bound, no_bound)) ? 'b' : 'f';
+  }
+  result[atom->arity] = '\0';
+  return result;
+}
+
+// Makes an atom over "predicate" from a copy of the atom's arguments, or only
+// of its bound arguments.
+static struct TymAtom *
+mk_adorned_atom(const TymStr * predicate, const struct TymAtom * atom, const char * adornment, bool only_bound)
+{
+  struct TymTerms * args = NULL;
+  size_t arity = 0;
+  for (size_t i = atom->arity; i > 0; i--) {
+    if (!only_bound || 'b' == adornment[i - 1]) {
+      args = tym_mk_term_cell(tym_copy_term(atom->args[i - 1]), args);
+      arity++;
+    }
+  }
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+  return tym_mk_atom((TymStr *)TYM_STR_DUPLICATE(predicate), arity, args);
+#pragma GCC diagnostic pop
+}
+
+static bool
+eq_atom(const struct TymAtom * a1, const struct TymAtom * a2)
+{
+  if (!tym_eq_str(a1->predicate, a2->predicate) || a1->arity != a2->arity) {
+    return false;
+  }
+  for (size_t i = 0; i < a1->arity; i++) {
+    if (a1->args[i]->kind != a2->args[i]->kind ||
+        !tym_eq_str(a1->args[i]->identifier, a2->args[i]->identifier)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Adds a clause to the rewritten program. The clause takes the atoms, but not
+// the array that holds the body.
+static void
+emit(struct TymMagic * m, struct TymAtom * head, size_t body_size, struct TymAtom ** body)
+{
+  struct TymAtoms * atoms = NULL;
+  for (size_t i = body_size; i > 0; i--) {
+    atoms = tym_mk_atom_cell(body[i - 1], atoms);
+  }
+  m->clauses = tym_mk_clause_cell(tym_mk_clause(head, body_size, atoms), m->clauses);
+  m->no_clauses++;
+}
+
+// Rewrites "p(...) :- b1, ..., bn" for the binding pattern "mp" into
+//   adorned_p(...) :- magic_p(...), b1', ..., bn'
+// where bi' is bi specialised to the variables bound by the head's bound
+// arguments and by b1, ..., b(i-1), and adds the rule
+//   magic_bi'(...) :- magic_p(...), b1', ..., b(i-1)'
+// for each bi' whose predicate has rules.
+static void
+rewrite_clause(struct TymMagic * m, const struct TymMagicPred * mp, const struct TymClause * cl)
+{
+  const struct TymAtom * head = cl->head;
+  struct TymAtom ** body = malloc(sizeof *body * (cl->body_size + 1));
+  assert(NULL != body);
+  body[0] = mk_adorned_atom(mp->magic, head, mp->adornment, true);
+
+  size_t max_bound = head->arity;
+  for (size_t j = 0; j < cl->body_size; j++) {
+    max_bound += cl->body[j]->arity;
+  }
+  const TymStr ** bound = malloc(sizeof *bound * (max_bound + 1));
+  assert(NULL != bound);
+  size_t no_bound = 0;
+  for (size_t i = 0; i < head->arity; i++) {
+    if ('b' == mp->adornment[i] && TYM_VAR == head->args[i]->kind &&
+        !is_bound(head->args[i]->identifier, bound, no_bound)) {
+      bound[no_bound++] = head->args[i]->identifier;
+    }
+  }
+
+  for (size_t j = 0; j < cl->body_size; j++) {
+    const struct TymAtom * atom = cl->body[j];
+    struct TymPredicate * pred = tym_atom_database_find_pred(atom->predicate, m->adb);
+    assert(NULL != pred);
+    if (is_idb(m, pred)) {
+      char * adornment = adornment_of(atom, bound, no_bound);
+      const struct TymMagicPred * sub = adorn(m, pred, adornment);
+
+      struct TymAtom * magic_head = mk_adorned_atom(sub->magic, atom, adornment, true);
+      if (0 == j && eq_atom(magic_head, body[0])) {
+        // The rule would only restate its body, as happens with left
+        // recursion, so we leave it out.
+        tym_free_atom(magic_head);
+      } else {
+        struct TymAtom ** magic_body = malloc(sizeof *magic_body * (j + 1));
+        assert(NULL != magic_body);
+        for (size_t k = 0; k <= j; k++) {
+          magic_body[k] = tym_copy_atom(body[k]);
+        }
+        emit(m, magic_head, j + 1, magic_body);
+        free(magic_body);
+      }
+
+      body[j + 1] = mk_adorned_atom(sub->adorned, atom, adornment, false);
+      free(adornment);
+    } else {
+      body[j + 1] = tym_copy_atom(atom);
+    }
+
+    for (size_t i = 0; i < atom->arity; i++) {
+      if (TYM_VAR == atom->args[i]->kind &&
+          !is_bound(atom->args[i]->identifier, bound, no_bound)) {
+        bound[no_bound++] = atom->args[i]->identifier;
+      }
+    }
+  }
+
+  emit(m, mk_adorned_atom(mp->adorned, head, mp->adornment, false),
+      cl->body_size + 1, body);
+  free(body);
+  free(bound);
+}
+
+static void
+rewrite_pred(struct TymMagic * m, const struct TymMagicPred * mp)
+{
+  // The database holds a predicate's clauses in reverse, and we rewrite them
+  // in the order they were given.
+  size_t no_bodies = tym_num_predicate_bodies(mp->pred);
+  const struct TymClause ** bodies = malloc(sizeof *bodies * (no_bodies + 1));
+  assert(NULL != bodies);
+  size_t i = no_bodies;
+  for (const struct TymClauses * cursor = mp->pred->bodies; NULL != cursor; cursor = cursor->next) {
+    bodies[--i] = cursor->clause;
+  }
+  for (i = 0; i < no_bodies; i++) {
+    rewrite_clause(m, mp, bodies[i]);
+  }
+  free(bodies);
+}
+
+bool
+tym_magic_program(struct TymProgram * program, const struct TymProgram * query,
+    struct TymProgram ** magic_program, struct TymProgram ** magic_query)
+{
+  // NOTE we expect a query to contain exactly one clause.
+  assert(1 == query->no_clauses);
+  const struct TymAtom * q_atom = query->program[0]->head;
+
+  struct TymMagic m;
+  m.adb = tym_mk_atom_database();
+  for (size_t i = 0; i < program->no_clauses; i++) {
+    enum TymCdlAddError error_code;
+    if (!tym_clause_database_add(program->program[i], m.adb, &error_code)) {
+      tym_free_atom_database(m.adb);
+      return false;
+    }
+  }
+
+  tym_str_set_init(&m.idb);
+  // If a clause isn't range-restricted then its head's unbound variables
+  // range over the whole universe, which the rewriting could shrink by
+  // leaving out clauses (and their constants), so we don't rewrite.
+  // Nor do we rewrite if there's negation, since the rewritten program
+  // needn't be stratified even if the original is.
+  bool restricted = !tym_has_negation(query->program[0]);
+  for (size_t i = 0; i < program->no_clauses; i++) {
+    if (program->program[i]->body_size > 0) {
+      uint32_t id;
+      (void)tym_str_set_add(&m.idb, program->program[i]->head->predicate, &id);
+    }
+    restricted = restricted && tym_range_restricted(program->program[i]) &&
+      !tym_has_negation(program->program[i]);
+  }
+
+  tym_str_set_init(&m.adorned);
+  m.preds = NULL;
+  m.capacity = 0;
+  m.clauses = NULL;
+  m.no_clauses = 0;
+
+  // Clauses about predicates that only have facts are kept as they are.
+  for (size_t i = 0; i < program->no_clauses; i++) {
+    const struct TymPredicate * pred =
+      tym_atom_database_find_pred(program->program[i]->head->predicate, m.adb);
+    if (!is_idb(&m, pred)) {
+      m.clauses = tym_mk_clause_cell(tym_copy_clause(program->program[i]), m.clauses);
+      m.no_clauses++;
+    }
+  }
+
+  struct TymPredicate * q_pred = tym_atom_database_find_pred(q_atom->predicate, m.adb);
+  if (restricted && NULL != q_pred && is_idb(&m, q_pred) &&
+      q_pred->arity == q_atom->arity) {
+    char * adornment = adornment_of(q_atom, NULL, 0);
+    const struct TymMagicPred * mp = adorn(&m, q_pred, adornment);
+    // The seed: the bindings that the query asks about.
+    emit(&m, mk_adorned_atom(mp->magic, q_atom, adornment, true), 0, NULL);
+    *magic_query = tym_mk_program(1, tym_mk_clause_cell(
+          tym_mk_clause(mk_adorned_atom(mp->adorned, q_atom, adornment, false), 0, NULL),
+          NULL));
+    free(adornment);
+
+    // Specialisations are rewritten in the order in which they're found,
+    // and rewriting can find more of them.
+    for (size_t i = 0; i < m.adorned.count; i++) {
+      rewrite_pred(&m, m.preds[i]);
+    }
+  } else {
+    // Either we don't rewrite, or the query isn't about a predicate that
+    // has rules, so there's nothing to specialise. We keep the whole program.
+    for (size_t i = 0; i < program->no_clauses; i++) {
+      const struct TymPredicate * pred =
+        tym_atom_database_find_pred(program->program[i]->head->predicate, m.adb);
+      if (is_idb(&m, pred)) {
+        m.clauses = tym_mk_clause_cell(tym_copy_clause(program->program[i]), m.clauses);
+        m.no_clauses++;
+      }
+    }
+    *magic_query = tym_mk_program(1,
+        tym_mk_clause_cell(tym_copy_clause(query->program[0]), NULL));
+  }
+
+  *magic_program = tym_mk_program(m.no_clauses, tym_reverse_clauses(m.clauses));
+
+  for (size_t i = 0; i < m.adorned.count; i++) {
+    free(m.preds[i]->adornment);
+    tym_free_str(m.preds[i]->adorned);
+    tym_free_str(m.preds[i]->magic);
+    free(m.preds[i]);
+  }
+  tym_str_set_free(&m.adorned);
+  free(m.preds);
+  tym_str_set_free(&m.idb);
+  tym_free_atom_database(m.adb);
+  return true;
+}
+
+void
+tym_test_magic(void)
+{
+  printf("***test_magic***\n");
+  // Paths over the edges a -> b -> c and d -> e, queried from a.
+  struct TymClauses * cls =
+    tym_mk_clause_cell(tym_mk_clause(tym_test_atom("edge", 2, "a", "b"), 0, NULL),
+    tym_mk_clause_cell(tym_mk_clause(tym_test_atom("edge", 2, "b", "c"), 0, NULL),
+    tym_mk_clause_cell(tym_mk_clause(tym_test_atom("edge", 2, "d", "e"), 0, NULL),
+    tym_mk_clause_cell(tym_mk_clause(tym_test_atom("path", 2, "X", "Y"), 1,
+        tym_mk_atom_cell(tym_test_atom("edge", 2, "X", "Y"), NULL)),
+    tym_mk_clause_cell(tym_mk_clause(tym_test_atom("path", 2, "X", "Y"), 2,
+        tym_mk_atom_cell(tym_test_atom("edge", 2, "X", "Z"),
+          tym_mk_atom_cell(tym_test_atom("path", 2, "Z", "Y"), NULL))),
+      NULL)))));
+  struct TymProgram * program = tym_mk_program(5, cls);
+  struct TymProgram * query = tym_mk_program(1,
+      tym_mk_clause_cell(tym_mk_clause(tym_test_atom("path", 2, "a", "Y"), 0, NULL), NULL));
+
+  struct TymProgram * magic_program = NULL;
+  struct TymProgram * magic_query = NULL;
+  bool success = tym_magic_program(program, query, &magic_program, &magic_query);
+  assert(success);
+
+  struct TymBufferInfo * outbuf = tym_mk_buffer(TYM_BUF_SIZE);
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res = tym_program_str(magic_program, outbuf);
+  assert(tym_is_ok_TymBufferWriteResult(res));
+  printf("%s\n", tym_buffer_contents(outbuf));
+  assert(0 == strcmp(tym_buffer_contents(outbuf),
+        "edge(a, b).\n"
+        "edge(b, c).\n"
+        "edge(d, e).\n"
+        "magic_bf_path(a).\n"
+        "adorned_bf_path(X, Y) :- magic_bf_path(X), edge(X, Y).\n"
+        "magic_bf_path(Z) :- magic_bf_path(X), edge(X, Z).\n"
+        "adorned_bf_path(X, Y) :- magic_bf_path(X), edge(X, Z), adorned_bf_path(Z, Y)."));
+
+  tym_reset_buffer(outbuf);
+  res = tym_program_str(magic_query, outbuf);
+  assert(tym_is_ok_TymBufferWriteResult(res));
+  assert(0 == strcmp(tym_buffer_contents(outbuf), "adorned_bf_path(a, Y)."));
+  tym_free_buffer(outbuf);
+
+  // Evaluating the rewritten program gives the query's answers, b and c,
+  // without deriving paths from d.
+  struct TymAtomDatabase * adb = tym_mk_atom_database();
+  for (size_t i = 0; i < magic_program->no_clauses; i++) {
+    enum TymCdlAddError error_code;
+    success = tym_clause_database_add(magic_program->program[i], adb, &error_code);
+    assert(success);
+  }
+  struct TymEvaluator * ev = tym_mk_evaluator(adb);
+  tym_evaluator_fixpoint(ev);
+  // 3 edges, 3 magic facts (for a, b and c) and 3 paths.
+  assert(9 == tym_evaluator_no_tuples(ev));
+  size_t counted = 0;
+  assert(2 == tym_evaluator_query(ev, magic_query->program[0]->head,
+        tym_test_count_answer, &counted));
+  assert(2 == counted);
+  tym_free_evaluator(ev);
+  tym_free_atom_database(adb);
+
+  tym_free_program(magic_query);
+  tym_free_program(magic_program);
+  tym_free_program(query);
+  tym_free_program(program);
+}
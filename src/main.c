@@ -23,6 +23,7 @@ This file: Front-end tool.
 
 #include <assert.h>
 #include <getopt.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -30,6 +31,7 @@ This file: Front-end tool.
 #include <unistd.h>
 
 #include "tym.h"
+#include "module_benchmarks.h"
 #include "module_tests.h"
 
 #ifdef TYM_PRECODED
@@ -48,6 +50,7 @@ show_usage(const char * const argv_0)
   // FIXME include description of each parameter
   const char * function_choices = tym_functions();
   const char * model_output_choices = tym_model_outputs();
+  const char * universe_encoding_choices = tym_universe_encodings();
   printf("usage: %s PARAMETERS \n"
          " Mandatory PARAMETERS: \n"
          "   -i, --input_file FILENAME \n"
@@ -58,12 +61,22 @@ show_usage(const char * const argv_0)
          "   -v, --verbose \n"
          "   --max_var_width N \n"
          "   --solver_timeout N (in milliseconds). Default: %s\n"
-         "   --buffer_size N (in bytes). Default: %zd\n"
+         "   --solver_threads N (over which answers are sought). Default: 1\n"
+         "   --solver_portfolio N (solver configurations raced in each check). Default: 1\n"
+         "   --eval_threads N (over which eval is split). Default: 1\n"
+         "   --translate_threads N (over which predicates are translated). Default: 1\n"
+         "   --buffer_size N (in bytes, by which output buffers grow). Default: %zd\n"
+         "   --universe_encoding ENCODING (%s). Default: %s. Use bitvec with --ground\n"
+         "   --ground (expand quantifiers over the universe) \n"
+         "   --slice (translate only what the query depends on) \n"
+         "   --magic (specialise the program to the query's constants) \n"
          "   -h \n", argv_0, function_choices, model_output_choices,
          TymModelOutputCommandMapping[TymDefaultModelOutput],
-        TymDefaultSolverTimeout, TYM_BUF_SIZE);
+        TymDefaultSolverTimeout, TYM_BUF_SIZE, universe_encoding_choices,
+        TymUniverseEncodingCommandMapping[TYM_UNIVERSE_SORT]);
   free_const(function_choices);
   free_const(model_output_choices);
+  free_const(universe_encoding_choices);
 }
 
 int
@@ -75,15 +88,30 @@ main(int argc, char ** argv)
     .query = NULL,
     .function = TYM_NO_FUNCTION,
     .model_output = TymDefaultModelOutput,
-    .solver_timeout = TymDefaultSolverTimeout
+    .solver_timeout = TymDefaultSolverTimeout,
+    .solver_threads = 1,
+    .solver_portfolio = 1,
+    .eval_threads = 1,
+    .translate_threads = 1,
+    .universe_encoding = TYM_UNIVERSE_SORT,
+    .ground = false,
+    .slice = false,
+    .magic = false
   };
 
 #ifdef TYM_TESTING
   tym_init_str();
   tym_test_clause();
+  tym_test_symbols();
   tym_test_formula();
   tym_test_statement();
   tym_test_clause_csyn();
+  tym_test_eval();
+  tym_test_translate();
+  tym_test_buffer();
+  tym_test_magic();
+  tym_test_plan();
+  tym_test_pool();
 #ifdef TYM_DEBUG
   if (TymCanDumpStrings) {
     tym_dump_str();
@@ -93,6 +121,17 @@ main(int argc, char ** argv)
   exit(0);
 #endif // TYM_TESTING
 
+#ifdef TYM_BENCHMARK
+  tym_init_str();
+#if TYM_STRING_TYPE == 2 || TYM_STRING_TYPE == 3
+  tym_bench_string_idx();
+#endif
+  tym_bench_fmla_str();
+  tym_bench_model_str();
+  tym_fin_str();
+  exit(0);
+#endif // TYM_BENCHMARK
+
   static struct option long_options[] = {
 #define LONG_OPT_INPUT 1
     {"input_file", required_argument, NULL, LONG_OPT_INPUT},
@@ -109,7 +148,23 @@ main(int argc, char ** argv)
 #define LONG_OPT_SOLVER_TIMEOUT 7
     {"solver_timeout", required_argument, NULL, LONG_OPT_SOLVER_TIMEOUT},
 #define LONG_OPT_BUF_SIZE 8
-    {"buffer_size", required_argument, NULL, LONG_OPT_BUF_SIZE}
+    {"buffer_size", required_argument, NULL, LONG_OPT_BUF_SIZE},
+#define LONG_OPT_SOLVER_THREADS 9
+    {"solver_threads", required_argument, NULL, LONG_OPT_SOLVER_THREADS},
+#define LONG_OPT_SOLVER_PORTFOLIO 10
+    {"solver_portfolio", required_argument, NULL, LONG_OPT_SOLVER_PORTFOLIO},
+#define LONG_OPT_UNIVERSE_ENCODING 11
+    {"universe_encoding", required_argument, NULL, LONG_OPT_UNIVERSE_ENCODING},
+#define LONG_OPT_GROUND 12
+    {"ground", no_argument, NULL, LONG_OPT_GROUND},
+#define LONG_OPT_SLICE 13
+    {"slice", no_argument, NULL, LONG_OPT_SLICE},
+#define LONG_OPT_MAGIC 14
+    {"magic", no_argument, NULL, LONG_OPT_MAGIC},
+#define LONG_OPT_EVAL_THREADS 15
+    {"eval_threads", required_argument, NULL, LONG_OPT_EVAL_THREADS},
+#define LONG_OPT_TRANSLATE_THREADS 16
+    {"translate_threads", required_argument, NULL, LONG_OPT_TRANSLATE_THREADS}
   };
 
   int option_index = 0;
@@ -179,6 +234,48 @@ main(int argc, char ** argv)
       assert(v > 0);
       TYM_BUF_SIZE = (size_t)v;
       break;
+    case LONG_OPT_SOLVER_THREADS:
+      v = strtol(optarg, NULL, 10);
+      assert(v > 0 && v <= UINT_MAX);
+      Params.solver_threads = (unsigned)v;
+      break;
+    case LONG_OPT_SOLVER_PORTFOLIO:
+      v = strtol(optarg, NULL, 10);
+      assert(v > 0 && v <= UINT_MAX);
+      Params.solver_portfolio = (unsigned)v;
+      break;
+    case LONG_OPT_EVAL_THREADS:
+      v = strtol(optarg, NULL, 10);
+      assert(v > 0 && v <= UINT_MAX);
+      Params.eval_threads = (unsigned)v;
+      break;
+    case LONG_OPT_TRANSLATE_THREADS:
+      v = strtol(optarg, NULL, 10);
+      assert(v > 0 && v <= UINT_MAX);
+      Params.translate_threads = (unsigned)v;
+      break;
+    case LONG_OPT_UNIVERSE_ENCODING:
+      Params.universe_encoding = TYM_NO_UNIVERSE_ENCODING;
+      for (unsigned i = 0; i < TYM_NO_UNIVERSE_ENCODING; ++i) {
+         if (0 == strcmp(optarg, TymUniverseEncodingCommandMapping[i])) {
+            Params.universe_encoding = i;
+            break;
+         }
+      }
+      if (TYM_NO_UNIVERSE_ENCODING == Params.universe_encoding) {
+        TYM_ERR("Unrecognized universe encoding: %s\n", optarg);
+        return TYM_UNRECOGNISED_PARAMETER;
+      }
+      break;
+    case LONG_OPT_GROUND:
+      Params.ground = true;
+      break;
+    case LONG_OPT_SLICE:
+      Params.slice = true;
+      break;
+    case LONG_OPT_MAGIC:
+      Params.magic = true;
+      break;
     case 'h':
       show_usage(argv[0]);
       return TYM_AOK;
@@ -198,6 +295,13 @@ main(int argc, char ** argv)
     return TYM_UNRECOGNISED_PARAMETER;
   }
 
+  // Without grounding, the bit-vectors that don't number an element must be
+  // excluded from the range of each quantifier (see tym_bound_universe),
+  // which makes the model harder to solve than with the other encodings.
+  if (TYM_UNIVERSE_BITVEC == Params.universe_encoding && !Params.ground) {
+    TYM_ERR("Warning: the bitvec universe encoding is meant to be used with --ground\n");
+  }
+
   if (Params.verbosity > 0) {
 #ifdef TYM_DEBUG
     TYM_VERBOSE("TYM_DEBUG = %d\n", TYM_DEBUG);
@@ -223,6 +327,7 @@ main(int argc, char ** argv)
     TYM_VERBOSE("query = %s\n", Params.query);
     TYM_VERBOSE("function = %s\n", TymFunctionCommandMapping[Params.function]);
     TYM_VERBOSE("model_output = %s\n", TymModelOutputCommandMapping[Params.model_output]);
+    TYM_VERBOSE("universe_encoding = %s\n", TymUniverseEncodingCommandMapping[Params.universe_encoding]);
     TYM_VERBOSE("solver_timeout = %s\n", Params.solver_timeout);
   }
 
@@ -250,6 +355,8 @@ main(int argc, char ** argv)
   case TYM_CONVERT_TO_SMT:
   case TYM_CONVERT_TO_SMT_AND_SOLVE:
   case TYM_CONVERT_TO_C:
+  case TYM_EVALUATE:
+  case TYM_EVALUATE_TABLED:
     meta_program = process_program;
     break;
   default:
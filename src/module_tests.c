@@ -0,0 +1,62 @@
+/*
+Copyright Nik Sultana, 2019
+
+This file is part of TYM Datalog. (https://www.github.com/niksu/tym)
+
+TYM Datalog is free software: you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License as published
+by the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+TYM Datalog is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details, a copy of which
+is included in the file called LICENSE distributed with TYM Datalog.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TYM Datalog.  If not, see <https://www.gnu.org/licenses/>.
+
+
+This file: Helpers that are shared by the module-level tests.
+*/
+
+#include <assert.h>
+#include <stdarg.h>
+
+#include "ast.h"
+#include "module_tests.h"
+
+// Makes the atom predicate(args...) from "arity" strings, each of which is a
+// variable if it starts with an uppercase letter, and a constant otherwise.
+struct TymAtom *
+tym_test_atom(const char * predicate, size_t arity, ...)
+{
+  const char * args[arity + 1];
+  va_list ap;
+  va_start(ap, arity);
+  for (size_t i = 0; i < arity; i++) {
+    args[i] = va_arg(ap, const char *);
+  }
+  va_end(ap);
+
+  struct TymTerms * terms = NULL;
+  for (size_t i = arity; i > 0; i--) {
+    enum TymTermKind kind = ('A' <= args[i - 1][0] && args[i - 1][0] <= 'Z') ? TYM_VAR : TYM_CONST;
+    terms = tym_mk_term_cell(tym_mk_term(kind, TYM_CSTR_DUPLICATE(args[i - 1])), terms);
+  }
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+  return tym_mk_atom((TymStr *)TYM_CSTR_DUPLICATE(predicate), arity, terms);
+#pragma GCC diagnostic pop
+}
+
+// Counts an answer in the size_t that ctxt points to.
+void
+tym_test_count_answer(struct TymMdlValuations * vals, void * ctxt)
+{
+  for (unsigned i = 0; i < vals->count; i++) {
+    assert(NULL != vals->v[i].value);
+  }
+  (*(size_t *)ctxt)++;
+}
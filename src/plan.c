@@ -0,0 +1,200 @@
+/*
+Copyright Nik Sultana, 2019
+
+This file is part of TYM Datalog. (https://www.github.com/niksu/tym)
+
+TYM Datalog is free software: you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License as published
+by the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+TYM Datalog is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details, a copy of which
+is included in the file called LICENSE distributed with TYM Datalog.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TYM Datalog.  If not, see <https://www.gnu.org/licenses/>.
+
+
+This file: Planning the order in which clause bodies are joined.
+*/
+
+#include <stdio.h>
+
+#include "module_tests.h"
+#include "plan.h"
+
+static bool is_bound(const TymStr ** bound, size_t no_bound, const TymStr * var);
+static bool is_ready(const struct TymAtom * atom, const TymStr ** bound, size_t no_bound);
+static double estimate(const struct TymAtom * atom, struct TymAtomDatabase * adb, const TymStr ** bound, size_t no_bound);
+
+static bool
+is_bound(const TymStr ** bound, size_t no_bound, const TymStr * var)
+{
+  // FIXME linear-time lookup, but clauses tend to have few variables.
+  for (size_t i = 0; i < no_bound; i++) {
+    if (tym_eq_str(bound[i], var)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Whether all of the atom's variables are bound.
+static bool
+is_ready(const struct TymAtom * atom, const TymStr ** bound, size_t no_bound)
+{
+  for (size_t i = 0; i < atom->arity; i++) {
+    if (TYM_VAR == atom->args[i]->kind &&
+        !is_bound(bound, no_bound, atom->args[i]->identifier)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Estimates how many tuples match the atom, given the variables that are
+// bound. Each argument that's bound (to a constant or a variable) is taken
+// to divide the predicate's tuples by the number of distinct values that the
+// argument takes, and so does each repeated occurrence of a variable.
+// We don't know how many tuples a predicate's rules derive. Since
+// semi-naive evaluation mostly joins such a predicate through the tuples
+// that it gained in the previous round, we take those to number about as
+// many as the universe's terms.
+static double
+estimate(const struct TymAtom * atom, struct TymAtomDatabase * adb, const TymStr ** bound, size_t no_bound)
+{
+  const struct TymPredicate * pred = tym_atom_database_find_pred(atom->predicate, adb);
+  if (NULL == pred || atom->arity != pred->arity) {
+    return 0;
+  }
+
+  double no_terms = (0 == adb->tdb->no_terms) ? 1 : (double)adb->tdb->no_terms;
+  double result = (double)pred->no_facts;
+  if (pred->no_rules > 0) {
+    result += no_terms;
+  }
+
+  for (size_t i = 0; i < atom->arity; i++) {
+    bool selects = (TYM_CONST == atom->args[i]->kind) ||
+      is_bound(bound, no_bound, atom->args[i]->identifier);
+    for (size_t j = 0; !selects && j < i; j++) {
+      selects = (TYM_VAR == atom->args[j]->kind &&
+          tym_eq_str(atom->args[j]->identifier, atom->args[i]->identifier));
+    }
+    if (selects) {
+      double distinct = (pred->no_rules > 0) ? no_terms :
+        (double)tym_predicate_distinct(pred, i);
+      result /= (distinct < 1) ? 1 : distinct;
+    }
+  }
+  return result;
+}
+
+void
+tym_plan_body(const struct TymClause * cl, struct TymAtomDatabase * adb, size_t * order)
+{
+  size_t max_vars = 1;
+  for (size_t i = 0; i < cl->body_size; i++) {
+    max_vars += cl->body[i]->arity;
+  }
+  const TymStr ** bound = malloc(sizeof *bound * max_vars);
+  bool * used = calloc(cl->body_size + 1, sizeof *used);
+  assert(NULL != bound);
+  assert(NULL != used);
+  size_t no_bound = 0;
+
+  size_t no_positive = 0;
+  for (size_t i = 0; i < cl->body_size; i++) {
+    if (!cl->body[i]->negated) {
+      no_positive++;
+    }
+  }
+
+  for (size_t step = 0; step < cl->body_size; step++) {
+    size_t best = cl->body_size;
+    double best_estimate = 0;
+    for (size_t i = 0; i < cl->body_size; i++) {
+      if (used[i]) {
+        continue;
+      }
+      // A negated atom only filters what the others bind, so it goes as soon
+      // as its variables are bound (or as late as possible if some never are).
+      double e = 0;
+      if (cl->body[i]->negated) {
+        if (no_positive > 0 && !is_ready(cl->body[i], bound, no_bound)) {
+          continue;
+        }
+      } else {
+        e = estimate(cl->body[i], adb, bound, no_bound);
+      }
+      if (best == cl->body_size || e < best_estimate) {
+        best = i;
+        best_estimate = e;
+      }
+    }
+
+    order[step] = best;
+    used[best] = true;
+    const struct TymAtom * atom = cl->body[best];
+    if (!atom->negated) {
+      no_positive--;
+    }
+    for (size_t j = 0; j < atom->arity; j++) {
+      if (TYM_VAR == atom->args[j]->kind &&
+          !is_bound(bound, no_bound, atom->args[j]->identifier)) {
+        bound[no_bound++] = atom->args[j]->identifier;
+      }
+    }
+  }
+
+  free(bound);
+  free(used);
+}
+
+void
+tym_test_plan(void)
+{
+  printf("***test_plan***\n");
+  struct TymClause * cls[] = {
+    tym_mk_clause(tym_test_atom("big", 2, "a", "b"), 0, NULL),
+    tym_mk_clause(tym_test_atom("big", 2, "a", "c"), 0, NULL),
+    tym_mk_clause(tym_test_atom("big", 2, "b", "c"), 0, NULL),
+    tym_mk_clause(tym_test_atom("big", 2, "c", "c"), 0, NULL),
+    tym_mk_clause(tym_test_atom("small", 1, "a"), 0, NULL),
+    tym_mk_clause(tym_test_atom("p", 1, "X"), 2,
+        tym_mk_atom_cell(tym_test_atom("big", 2, "X", "Y"),
+          tym_mk_atom_cell(tym_test_atom("small", 1, "Y"), NULL))),
+  };
+
+  struct TymAtomDatabase * adb = tym_mk_atom_database();
+  for (size_t i = 0; i < sizeof(cls) / sizeof(cls[0]); i++) {
+    enum TymCdlAddError error_code;
+    bool success = tym_clause_database_add(cls[i], adb, &error_code);
+    assert(success);
+  }
+
+  const TymStr * name = TYM_CSTR_DUPLICATE("big");
+  const struct TymPredicate * big = tym_atom_database_find_pred(name, adb);
+  tym_free_str(name);
+  assert(NULL != big);
+  assert(4 == big->no_facts);
+  assert(0 == big->no_rules);
+  assert(3 == tym_predicate_distinct(big, 0));
+  assert(2 == tym_predicate_distinct(big, 1));
+
+  // small has a single tuple, so it is joined first, and then binds big's
+  // second argument.
+  const struct TymClause * rule = cls[sizeof(cls) / sizeof(cls[0]) - 1];
+  size_t order[3];
+  tym_plan_body(rule, adb, order);
+  assert(1 == order[0]);
+  assert(0 == order[1]);
+
+  tym_free_atom_database(adb);
+  for (size_t i = 0; i < sizeof(cls) / sizeof(cls[0]); i++) {
+    tym_free_clause(cls[i]);
+  }
+}
@@ -0,0 +1,357 @@
+/*
+Copyright Nik Sultana, 2019
+
+This file is part of TYM Datalog. (https://www.github.com/niksu/tym)
+
+TYM Datalog is free software: you can redistribute it and/or modify it
+under the terms of the GNU Lesser General Public License as published
+by the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+TYM Datalog is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details, a copy of which
+is included in the file called LICENSE distributed with TYM Datalog.
+
+You should have received a copy of the GNU Lesser General Public License
+along with TYM Datalog.  If not, see <https://www.gnu.org/licenses/>.
+
+
+This file: A pool of threads that run tasks, balanced by work stealing.
+*/
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "module_tests.h"
+#include "pool.h"
+
+// NOTE must be a power of 2, since we mask positions to get indices.
+#define TYM_POOL_INITIAL_TASKS 64
+
+struct TymPoolTask {
+  void (*fn)(void *);
+  void * arg;
+  struct TymPoolGroup * group;
+};
+
+// A ring of tasks: its oldest task is at "top", and its newest is just before
+// "bottom" (both counted from when the deque was made, modulo its capacity).
+struct TymPoolDeque {
+  pthread_mutex_t lock;
+  struct TymPoolTask * tasks;
+  size_t capacity;
+  size_t top;
+  size_t bottom;
+};
+
+struct TymPoolThread {
+  struct TymPool * pool;
+  unsigned index; // Of the thread's deque.
+};
+
+struct TymPool {
+  unsigned no_threads;
+  struct TymPoolDeque * deques;
+  struct TymPoolThread * threads;
+  pthread_t * handles; // Of the threads that the pool started, i.e., all but the first.
+  pthread_key_t self; // Each thread's TymPoolThread.
+  // Guards the counts below, and those of groups. Tasks are pushed while it's
+  // held, but they're taken without it, and so the count of queued tasks
+  // errs on the high side: a thread that counted a task might not find it,
+  // and then looks again.
+  pthread_mutex_t lock;
+  pthread_cond_t changed; // Signalled when a task is queued or finishes.
+  size_t queued;
+  bool stopping;
+};
+
+static void deque_push(struct TymPoolDeque * deque, const struct TymPoolTask * task);
+static bool deque_pop(struct TymPoolDeque * deque, struct TymPoolTask * task);
+static bool deque_steal(struct TymPoolDeque * deque, struct TymPoolTask * task);
+static unsigned self_index(struct TymPool * pool);
+static bool take_task(struct TymPool * pool, unsigned index, struct TymPoolTask * task);
+static void run_task(struct TymPool * pool, const struct TymPoolTask * task);
+static void * pool_thread(void * arg);
+static void test_pool_task(void * arg);
+
+static void
+deque_push(struct TymPoolDeque * deque, const struct TymPoolTask * task)
+{
+  pthread_mutex_lock(&deque->lock);
+  if (deque->bottom - deque->top == deque->capacity) {
+    struct TymPoolTask * tasks = malloc(sizeof *tasks * 2 * deque->capacity);
+    assert(NULL != tasks);
+    for (size_t i = deque->top; i < deque->bottom; i++) {
+      tasks[i & (2 * deque->capacity - 1)] = deque->tasks[i & (deque->capacity - 1)];
+    }
+    free(deque->tasks);
+    deque->tasks = tasks;
+    deque->capacity *= 2;
+  }
+  deque->tasks[deque->bottom & (deque->capacity - 1)] = *task;
+  deque->bottom++;
+  pthread_mutex_unlock(&deque->lock);
+}
+
+// Takes the deque's newest task, for its owner.
+static bool
+deque_pop(struct TymPoolDeque * deque, struct TymPoolTask * task)
+{
+  bool result = false;
+  pthread_mutex_lock(&deque->lock);
+  if (deque->bottom > deque->top) {
+    deque->bottom--;
+    *task = deque->tasks[deque->bottom & (deque->capacity - 1)];
+    result = true;
+  }
+  pthread_mutex_unlock(&deque->lock);
+  return result;
+}
+
+// Takes the deque's oldest task, for another thread.
+static bool
+deque_steal(struct TymPoolDeque * deque, struct TymPoolTask * task)
+{
+  bool result = false;
+  pthread_mutex_lock(&deque->lock);
+  if (deque->bottom > deque->top) {
+    *task = deque->tasks[deque->top & (deque->capacity - 1)];
+    deque->top++;
+    result = true;
+  }
+  pthread_mutex_unlock(&deque->lock);
+  return result;
+}
+
+// Threads that aren't the pool's use the first thread's deque.
+static unsigned
+self_index(struct TymPool * pool)
+{
+  const struct TymPoolThread * thread = pthread_getspecific(pool->self);
+  return (NULL == thread || thread->pool != pool) ? 0 : thread->index;
+}
+
+static bool
+take_task(struct TymPool * pool, unsigned index, struct TymPoolTask * task)
+{
+  bool found = deque_pop(&pool->deques[index], task);
+  for (unsigned k = 1; !found && k < pool->no_threads; k++) {
+    found = deque_steal(&pool->deques[(index + k) % pool->no_threads], task);
+  }
+  if (found) {
+    pthread_mutex_lock(&pool->lock);
+    pool->queued--;
+    pthread_mutex_unlock(&pool->lock);
+  }
+  return found;
+}
+
+static void
+run_task(struct TymPool * pool, const struct TymPoolTask * task)
+{
+  task->fn(task->arg);
+  pthread_mutex_lock(&pool->lock);
+  task->group->pending--;
+  pthread_cond_broadcast(&pool->changed);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+static void *
+pool_thread(void * arg)
+{
+  struct TymPoolThread * thread = arg;
+  struct TymPool * pool = thread->pool;
+  int rc = pthread_setspecific(pool->self, thread);
+  assert(0 == rc);
+
+  while (true) {
+    struct TymPoolTask task;
+    if (take_task(pool, thread->index, &task)) {
+      run_task(pool, &task);
+      continue;
+    }
+    pthread_mutex_lock(&pool->lock);
+    while (0 == pool->queued && !pool->stopping) {
+      pthread_cond_wait(&pool->changed, &pool->lock);
+    }
+    bool stop = (0 == pool->queued && pool->stopping);
+    pthread_mutex_unlock(&pool->lock);
+    if (stop) {
+      break;
+    }
+  }
+  return NULL;
+}
+
+// Starts no_threads - 1 threads: the calling thread is the pool's first.
+struct TymPool *
+tym_mk_pool(unsigned no_threads)
+{
+  assert(no_threads > 0);
+  struct TymPool * pool = malloc(sizeof *pool);
+  assert(NULL != pool);
+  pool->no_threads = no_threads;
+  pool->queued = 0;
+  pool->stopping = false;
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->changed, NULL);
+  int rc = pthread_key_create(&pool->self, NULL);
+  assert(0 == rc);
+
+  pool->deques = malloc(sizeof *pool->deques * no_threads);
+  pool->threads = malloc(sizeof *pool->threads * no_threads);
+  pool->handles = malloc(sizeof *pool->handles * no_threads);
+  assert(NULL != pool->deques);
+  assert(NULL != pool->threads);
+  assert(NULL != pool->handles);
+  for (unsigned i = 0; i < no_threads; i++) {
+    struct TymPoolDeque * deque = &pool->deques[i];
+    pthread_mutex_init(&deque->lock, NULL);
+    deque->capacity = TYM_POOL_INITIAL_TASKS;
+    deque->tasks = malloc(sizeof *deque->tasks * deque->capacity);
+    assert(NULL != deque->tasks);
+    deque->top = 0;
+    deque->bottom = 0;
+    pool->threads[i] = (struct TymPoolThread){.pool = pool, .index = i};
+  }
+
+  rc = pthread_setspecific(pool->self, &pool->threads[0]);
+  assert(0 == rc);
+  for (unsigned i = 1; i < no_threads; i++) {
+    rc = pthread_create(&pool->handles[i], NULL, pool_thread, &pool->threads[i]);
+    assert(0 == rc);
+  }
+  return pool;
+}
+
+// NOTE the pool's tasks must have finished.
+void
+tym_free_pool(struct TymPool * pool)
+{
+  pthread_mutex_lock(&pool->lock);
+  assert(0 == pool->queued);
+  pool->stopping = true;
+  pthread_cond_broadcast(&pool->changed);
+  pthread_mutex_unlock(&pool->lock);
+  for (unsigned i = 1; i < pool->no_threads; i++) {
+    int rc = pthread_join(pool->handles[i], NULL);
+    assert(0 == rc);
+  }
+
+  int rc = pthread_setspecific(pool->self, NULL);
+  assert(0 == rc);
+  pthread_key_delete(pool->self);
+  for (unsigned i = 0; i < pool->no_threads; i++) {
+    pthread_mutex_destroy(&pool->deques[i].lock);
+    free(pool->deques[i].tasks);
+  }
+  free(pool->deques);
+  free(pool->threads);
+  free(pool->handles);
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->changed);
+  free(pool);
+}
+
+unsigned
+tym_pool_size(const struct TymPool * pool)
+{
+  return pool->no_threads;
+}
+
+void
+tym_pool_submit(struct TymPool * pool, struct TymPoolGroup * group, void (*fn)(void *), void * arg)
+{
+  struct TymPoolTask task = {.fn = fn, .arg = arg, .group = group};
+  pthread_mutex_lock(&pool->lock);
+  group->pending++;
+  deque_push(&pool->deques[self_index(pool)], &task);
+  pool->queued++;
+  pthread_cond_broadcast(&pool->changed);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void
+tym_pool_wait(struct TymPool * pool, struct TymPoolGroup * group)
+{
+  unsigned index = self_index(pool);
+  while (true) {
+    pthread_mutex_lock(&pool->lock);
+    bool done = (0 == group->pending);
+    pthread_mutex_unlock(&pool->lock);
+    if (done) {
+      return;
+    }
+
+    struct TymPoolTask task;
+    if (take_task(pool, index, &task)) {
+      run_task(pool, &task);
+      continue;
+    }
+    // The group's remaining tasks are being run by other threads.
+    pthread_mutex_lock(&pool->lock);
+    while (0 != group->pending && 0 == pool->queued) {
+      pthread_cond_wait(&pool->changed, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+  }
+}
+
+struct TymTestPool {
+  struct TymPool * pool;
+  unsigned depth;
+  size_t * count;
+  pthread_mutex_t * lock;
+};
+
+// Counts itself, and submits two tasks of the next depth and waits for them.
+static void
+test_pool_task(void * arg)
+{
+  const struct TymTestPool * test = arg;
+  pthread_mutex_lock(test->lock);
+  (*test->count)++;
+  pthread_mutex_unlock(test->lock);
+  if (0 == test->depth) {
+    return;
+  }
+
+  struct TymPoolGroup group = {.pending = 0};
+  struct TymTestPool children[2];
+  for (size_t i = 0; i < 2; i++) {
+    children[i] = *test;
+    children[i].depth = test->depth - 1;
+    tym_pool_submit(test->pool, &group, test_pool_task, &children[i]);
+  }
+  tym_pool_wait(test->pool, &group);
+}
+
+void
+tym_test_pool(void)
+{
+  printf("***test_pool***\n");
+  pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+  for (unsigned no_threads = 1; no_threads <= 4; no_threads++) {
+    struct TymPool * pool = tym_mk_pool(no_threads);
+    assert(no_threads == tym_pool_size(pool));
+    size_t count = 0;
+    // Trees of tasks, each of which has 2^11 - 1 tasks.
+    struct TymTestPool roots[8];
+    struct TymPoolGroup group = {.pending = 0};
+    for (size_t i = 0; i < 8; i++) {
+      roots[i] = (struct TymTestPool){.pool = pool, .depth = 10, .count = &count, .lock = &lock};
+      tym_pool_submit(pool, &group, test_pool_task, &roots[i]);
+    }
+    tym_pool_wait(pool, &group);
+    assert(0 == group.pending);
+    assert(8 * 2047 == count);
+    tym_free_pool(pool);
+  }
+  pthread_mutex_destroy(&lock);
+}
@@ -23,25 +23,34 @@ This file: Representation of statements (that affect logical models).
 
 #include <assert.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "ast.h"
 #include "formula.h"
+#include "module_benchmarks.h"
 #include "module_tests.h"
 #include "statement.h"
 #include "util.h"
 
 char * tym_bool_ty = "Bool";
+char * tym_bvuleK = "bvule";
 char * tym_distinctK = "distinct";
 char * tym_eqK = "=";
 
+static struct TymFmla * bound_atom(const TymStr * identifier, const TymStr * max);
+static struct TymFmla * bound_fmla(const struct TymFmla * fmla, const TymStr * max);
+static size_t test_no_stmts(const struct TymModel * mdl);
+
 struct TymUniverse *
 tym_mk_universe(struct TymTerms * terms)
 {
   struct TymUniverse * result = malloc(sizeof *result);
   result->cardinality = 0;
   result->element = NULL;
+  result->encoding = TYM_UNIVERSE_SORT;
 
   const struct TymTerms * cursor = terms;
   while (NULL != cursor) {
@@ -55,7 +64,7 @@ tym_mk_universe(struct TymTerms * terms)
   }
 
   cursor = terms;
-  for (int i = 0; i < result->cardinality; i++) {
+  for (size_t i = 0; i < result->cardinality; i++) {
     result->element[i] = TYM_STR_DUPLICATE(cursor->term->identifier);
     cursor = cursor->next;
   }
@@ -63,29 +72,130 @@ tym_mk_universe(struct TymTerms * terms)
   return result;
 }
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) *
+// The number of bits needed to number the universe's elements.
+size_t
+tym_universe_width(const struct TymUniverse * uni)
+{
+  size_t width = 1;
+  while (width < 8 * sizeof(size_t) && ((size_t)1 << width) < uni->cardinality) {
+    width++;
+  }
+  return width;
+}
+
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult)
 tym_universe_str(const struct TymUniverse * const uni, struct TymBufferInfo * dst)
 {
   size_t initial_idx = tym_buffer_len(dst);
 
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = NULL;
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res;
+
+  if (TYM_UNIVERSE_BITVEC == uni->encoding) {
+    // Renders "(define-sort Universe () (_ BitVec k))" followed by
+    // "(define-fun ci () Universe (_ bvi k))" for each element.
+    assert(uni->cardinality > 0);
+    char local_buf[TYM_BUF_SIZE];
+    size_t width = tym_universe_width(uni);
+    sprintf(local_buf, "(define-sort %s () (_ BitVec %zu)", TYM_UNIVERSE_TY, width);
+    res = tym_buf_strcpy(dst, local_buf);
+    assert(tym_is_ok_TymBufferWriteResult(res));
+
+    tym_safe_buffer_replace_last(dst, ')'); // replace the trailing \0.
+
+    if (tym_have_space(dst, 1)) {
+      tym_unsafe_buffer_char(dst, '\n');
+    } else {
+      return tym_mkerrval_TymBufferWriteResult(BUFF_ERR_OVERFLOW);
+    }
+
+    for (size_t i = 0; i < uni->cardinality; i++) {
+      res = tym_buf_strcpy(dst, "(define-fun");
+      assert(tym_is_ok_TymBufferWriteResult(res));
+
+      tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
+
+      res = tym_buf_strcpy(dst, tym_decode_str(uni->element[i]));
+      assert(tym_is_ok_TymBufferWriteResult(res));
+
+      tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
+
+      sprintf(local_buf, "() %s (_ bv%zu %zu)", TYM_UNIVERSE_TY, i, width);
+      res = tym_buf_strcpy(dst, local_buf);
+      assert(tym_is_ok_TymBufferWriteResult(res));
+
+      tym_safe_buffer_replace_last(dst, ')'); // replace the trailing \0.
+
+      if (tym_have_space(dst, 1)) {
+        tym_unsafe_buffer_char(dst, '\n');
+      } else {
+        return tym_mkerrval_TymBufferWriteResult(BUFF_ERR_OVERFLOW);
+      }
+    }
+
+    return tym_mkval_TymBufferWriteResult(tym_buffer_len(dst) - initial_idx);
+  }
+
+  if (TYM_UNIVERSE_DATATYPE == uni->encoding) {
+    // Renders "(declare-datatypes ((Universe 0)) (((c1) ... (cn))))".
+    assert(uni->cardinality > 0);
+    res = tym_buf_strcpy(dst, "(declare-datatypes (");
+    assert(tym_is_ok_TymBufferWriteResult(res));
+
+    tym_safe_buffer_replace_last(dst, '('); // replace the trailing \0.
 
-  for (int i = 0; i < uni->cardinality; i++) {
+    res = tym_buf_strcpy(dst, TYM_UNIVERSE_TY);
+    assert(tym_is_ok_TymBufferWriteResult(res));
+
+    tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
+
+    if (tym_have_space(dst, 7)) {
+      tym_unsafe_buffer_str(dst, "0)) ((");
+    } else {
+      return tym_mkerrval_TymBufferWriteResult(BUFF_ERR_OVERFLOW);
+    }
+
+    for (size_t i = 0; i < uni->cardinality; i++) {
+      if (tym_have_space(dst, 1)) {
+        tym_unsafe_buffer_char(dst, '(');
+      } else {
+        return tym_mkerrval_TymBufferWriteResult(BUFF_ERR_OVERFLOW);
+      }
+
+      res = tym_buf_strcpy(dst, tym_decode_str(uni->element[i]));
+      assert(tym_is_ok_TymBufferWriteResult(res));
+
+      tym_safe_buffer_replace_last(dst, ')'); // replace the trailing \0.
+
+      if (i < uni->cardinality - 1) {
+        if (tym_have_space(dst, 1)) {
+          tym_unsafe_buffer_char(dst, ' ');
+        } else {
+          return tym_mkerrval_TymBufferWriteResult(BUFF_ERR_OVERFLOW);
+        }
+      }
+    }
+
+    if (tym_have_space(dst, 5)) {
+      tym_unsafe_buffer_str(dst, ")))\n");
+      return tym_mkval_TymBufferWriteResult(tym_buffer_len(dst) - initial_idx);
+    } else {
+      return tym_mkerrval_TymBufferWriteResult(BUFF_ERR_OVERFLOW);
+    }
+  }
+
+  for (size_t i = 0; i < uni->cardinality; i++) {
     res = tym_buf_strcpy(dst, "(declare-const");
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
 
     tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
 
     res = tym_buf_strcpy(dst, tym_decode_str(uni->element[i]));
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
 
     tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
 
     res = tym_buf_strcpy(dst, TYM_UNIVERSE_TY);
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
 
     tym_safe_buffer_replace_last(dst, ')'); // replace the trailing \0.
 
@@ -98,14 +208,12 @@ tym_universe_str(const struct TymUniverse * const uni, struct TymBufferInfo * ds
 
   res = tym_buf_strcpy(dst, "(assert (distinct");
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
 
   tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
 
-  for (int i = 0; i < uni->cardinality; i++) {
+  for (size_t i = 0; i < uni->cardinality; i++) {
     res = tym_buf_strcpy(dst, tym_decode_str(uni->element[i]));
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
 
     if (i < uni->cardinality - 1) {
       tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
@@ -126,7 +234,7 @@ void
 tym_free_universe(struct TymUniverse * uni)
 {
   if (uni->cardinality > 0) {
-    for (int i = 0; i < uni->cardinality; i++) {
+    for (size_t i = 0; i < uni->cardinality; i++) {
       tym_free_str(uni->element[i]);
     }
     free(uni->element);
@@ -165,10 +273,10 @@ tym_split_stmt_pred(struct TymStmt * stmt)
   struct TymFmla * def = stmt->param.const_def->body;
   stmt->param.const_def->body = NULL;
 
-  uint8_t length = tym_len_TymTerms_cell(stmt->param.const_def->params);
+  size_t length = tym_len_TymTerms_cell(stmt->param.const_def->params);
   struct TymTerm ** predargs = malloc(sizeof *predargs * length);
   struct TymTerms * cursor = stmt->param.const_def->params;
-  uint8_t i = 0;
+  size_t i = 0;
   while (NULL != cursor) {
     predargs[i] = tym_copy_term(cursor->term);
     i++;
@@ -223,7 +331,7 @@ tym_mk_stmt_const_def(const TymStr * const_name, struct TymUniverse * uni)
 
   struct TymFmlas * fmlas = NULL;
 
-  for (int i = 0; i < uni->cardinality; i++) {
+  for (size_t i = 0; i < uni->cardinality; i++) {
     if (i > 0) {
       // Currently terms must have disjoint strings, since these are freed
       // up independently (without checking if a shared string has already been
@@ -241,24 +349,22 @@ tym_mk_stmt_const_def(const TymStr * const_name, struct TymUniverse * uni)
   return tym_mk_stmt_axiom(tym_mk_fmla_ors(fmlas));
 }
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) *
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult)
 tym_stmt_str(const struct TymStmt * const stmt, struct TymBufferInfo * dst)
 {
   size_t initial_idx = tym_buffer_len(dst);
 
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = NULL;
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res;
 
   switch (stmt->kind) {
   case TYM_STMT_AXIOM:
     res = tym_buf_strcpy(dst, "(assert");
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
 
     tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
 
     res = tym_fmla_str(stmt->param.axiom, dst);
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
 
     tym_safe_buffer_replace_last(dst, ')'); // replace the trailing \0.
     break;
@@ -271,19 +377,16 @@ tym_stmt_str(const struct TymStmt * const stmt, struct TymBufferInfo * dst)
       // We're dealing with a nullary constant.
       res = tym_buf_strcpy(dst, "(declare-const");
       assert(tym_is_ok_TymBufferWriteResult(res));
-      free(res);
 
       tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
 
       res = tym_buf_strcpy(dst, tym_decode_str(stmt->param.const_def->const_name));
       assert(tym_is_ok_TymBufferWriteResult(res));
-      free(res);
 
       tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
 
       res = tym_buf_strcpy(dst, tym_decode_str(stmt->param.const_def->ty));
       assert(tym_is_ok_TymBufferWriteResult(res));
-      free(res);
 
       tym_safe_buffer_replace_last(dst, ')'); // replace the trailing \0.
     } else {
@@ -294,13 +397,11 @@ tym_stmt_str(const struct TymStmt * const stmt, struct TymBufferInfo * dst)
         res = tym_buf_strcpy(dst, "(define-fun");
       }
       assert(tym_is_ok_TymBufferWriteResult(res));
-      free(res);
 
       tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
 
       res = tym_buf_strcpy(dst, tym_decode_str(stmt->param.const_def->const_name));
       assert(tym_is_ok_TymBufferWriteResult(res));
-      free(res);
 
       tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
 
@@ -321,14 +422,12 @@ tym_stmt_str(const struct TymStmt * const stmt, struct TymBufferInfo * dst)
         if (!is_only_declaration) {
           res = tym_term_str(params_cursor->term, dst);
           assert(tym_is_ok_TymBufferWriteResult(res));
-          free(res);
 
           tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
         }
 
         res = tym_buf_strcpy(dst, TYM_UNIVERSE_TY);
         assert(tym_is_ok_TymBufferWriteResult(res));
-        free(res);
 
         tym_safe_buffer_replace_last(dst, ')'); // replace the trailing \0.
 
@@ -351,7 +450,6 @@ tym_stmt_str(const struct TymStmt * const stmt, struct TymBufferInfo * dst)
 
       res = tym_buf_strcpy(dst, tym_decode_str(stmt->param.const_def->ty));
       assert(tym_is_ok_TymBufferWriteResult(res));
-      free(res);
 
       if (!is_only_declaration) {
         tym_safe_buffer_replace_last(dst, '\n'); // replace the trailing \0.
@@ -368,7 +466,6 @@ tym_stmt_str(const struct TymStmt * const stmt, struct TymBufferInfo * dst)
       if (!is_only_declaration) {
         res = tym_fmla_str(stmt->param.const_def->body, dst);
         assert(tym_is_ok_TymBufferWriteResult(res));
-        free(res);
       }
 
       tym_safe_buffer_replace_last(dst, ')'); // replace the trailing \0.
@@ -416,18 +513,17 @@ tym_free_stmt(const struct TymStmt * stmt)
 
 TYM_DEFINE_MUTABLE_LIST_MK(stmt, stmt, struct TymStmt, struct TymStmts)
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) *
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult)
 tym_stmts_str(const struct TymStmts * const stmts, struct TymBufferInfo * dst)
 {
   size_t initial_idx = tym_buffer_len(dst);
   const struct TymStmts * cursor = stmts;
 
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = NULL;
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res;
 
   while (NULL != cursor) {
     res = tym_stmt_str(cursor->stmt, dst);
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
 
     tym_safe_buffer_replace_last(dst, '\n'); // replace the trailing \0.
 
@@ -447,12 +543,15 @@ tym_stmts_str(const struct TymStmts * const stmts, struct TymBufferInfo * dst)
 void
 tym_free_stmts(const struct TymStmts * stmts)
 {
-  assert(NULL != stmts->stmt);
-  tym_free_stmt(stmts->stmt);
-  if (NULL != stmts->next) {
-    tym_free_stmts(stmts->next);
+  // NOTE we iterate rather than recurse over the list, since it can be
+  //      as long as the program has facts.
+  while (NULL != stmts) {
+    const struct TymStmts * next = stmts->next;
+    assert(NULL != stmts->stmt);
+    tym_free_stmt(stmts->stmt);
+    free((void *)stmts);
+    stmts = next;
   }
-  free((void *)stmts);
 }
 #pragma GCC diagnostic pop
 
@@ -462,35 +561,41 @@ tym_mk_model(struct TymUniverse * uni)
   struct TymModel * result = malloc(sizeof *result);
   result->universe = uni;
   result->stmts = NULL;
+  result->grounded = false;
   return result;
 }
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) *
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult)
 tym_model_str(const struct TymModel * const mdl, struct TymBufferInfo * dst)
 {
   size_t initial_idx = tym_buffer_len(dst);
 
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = tym_buf_strcpy(dst, "(declare-sort");
-  assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res;
 
-  tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
+  if (TYM_UNIVERSE_DATATYPE == mdl->universe->encoding ||
+      TYM_UNIVERSE_BITVEC == mdl->universe->encoding) {
+    res = tym_universe_str(mdl->universe, dst);
+    assert(tym_is_ok_TymBufferWriteResult(res));
+  } else {
+    res = tym_buf_strcpy(dst, "(declare-sort");
+    assert(tym_is_ok_TymBufferWriteResult(res));
 
-  res = tym_buf_strcpy(dst, TYM_UNIVERSE_TY);
-  assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
+    tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
 
-  tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
+    res = tym_buf_strcpy(dst, TYM_UNIVERSE_TY);
+    assert(tym_is_ok_TymBufferWriteResult(res));
 
-  if (tym_have_space(dst, 3)) {
-    tym_unsafe_buffer_str(dst, "0)\n");
-  } else {
-    return tym_mkerrval_TymBufferWriteResult(BUFF_ERR_OVERFLOW);
+    tym_safe_buffer_replace_last(dst, ' '); // replace the trailing \0.
+
+    if (tym_have_space(dst, 3)) {
+      tym_unsafe_buffer_str(dst, "0)\n");
+    } else {
+      return tym_mkerrval_TymBufferWriteResult(BUFF_ERR_OVERFLOW);
+    }
   }
 
   res = tym_stmts_str(mdl->stmts, dst);
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
 
   return tym_mkval_TymBufferWriteResult(tym_buffer_len(dst) - initial_idx);
 }
@@ -515,6 +620,16 @@ tym_strengthen_model(struct TymModel * mdl, struct TymStmt * stmt)
   mdl->stmts = tym_mk_stmt_cell(stmt, stmts);
 }
 
+static size_t
+test_no_stmts(const struct TymModel * mdl)
+{
+  size_t result = 0;
+  for (const struct TymStmts * cursor = mdl->stmts; NULL != cursor; cursor = cursor->next) {
+    result++;
+  }
+  return result;
+}
+
 void
 tym_test_statement(void)
 {
@@ -551,10 +666,74 @@ tym_test_statement(void)
   tym_strengthen_model(mdl, s3BS);
 
   struct TymBufferInfo * outbuf = tym_mk_buffer(TYM_BUF_SIZE);
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = tym_model_str(mdl, outbuf);
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res = tym_model_str(mdl, outbuf);
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
   TYM_DBG_BUFFER(outbuf, "test model")
+
+  mdl->universe->encoding = TYM_UNIVERSE_DATATYPE;
+  tym_reset_buffer(outbuf);
+  res = tym_model_str(mdl, outbuf);
+  assert(tym_is_ok_TymBufferWriteResult(res));
+  TYM_DBG_BUFFER(outbuf, "test model (universe as datatype)")
+  assert(NULL != strstr(tym_buffer_contents(outbuf),
+        "(declare-datatypes ((Universe 0)) (((b) (a))))\n"));
+  assert(NULL == strstr(tym_buffer_contents(outbuf), "(declare-const b Universe)"));
+
+  // The datatype's constructors are distinct and exhaust it, so no axioms
+  // are needed about the universe.
+  size_t no_stmts = test_no_stmts(mdl);
+  tym_statementise_universe(mdl);
+  assert(no_stmts == test_no_stmts(mdl));
+  tym_reset_buffer(outbuf);
+  res = tym_model_str(mdl, outbuf);
+  assert(tym_is_ok_TymBufferWriteResult(res));
+  assert(NULL == strstr(tym_buffer_contents(outbuf), tym_distinctK));
+  assert(NULL == strstr(tym_buffer_contents(outbuf), "forall"));
+
+  mdl->universe->encoding = TYM_UNIVERSE_BITVEC;
+  tym_reset_buffer(outbuf);
+  res = tym_model_str(mdl, outbuf);
+  assert(tym_is_ok_TymBufferWriteResult(res));
+  TYM_DBG_BUFFER(outbuf, "test model (universe as bit-vectors)")
+  assert(NULL != strstr(tym_buffer_contents(outbuf),
+        "(define-sort Universe () (_ BitVec 1))\n"
+        "(define-fun b () Universe (_ bv0 1))\n"
+        "(define-fun a () Universe (_ bv1 1))\n"));
+  tym_free_model(mdl);
+
+  // Three elements need 2 bits, so the bit-vector 3 must be excluded from the
+  // range of quantifiers, and of the query's constant c0.
+  terms = tym_mk_term_cell(tym_mk_term(TYM_CONST, TYM_CSTR_DUPLICATE("a")), NULL);
+  terms = tym_mk_term_cell(tym_mk_term(TYM_CONST, TYM_CSTR_DUPLICATE("b")), terms);
+  terms = tym_mk_term_cell(tym_mk_term(TYM_CONST, TYM_CSTR_DUPLICATE("c")), terms);
+  mdl = tym_mk_model(tym_mk_universe(terms));
+  tym_free_terms(terms);
+  mdl->universe->encoding = TYM_UNIVERSE_BITVEC;
+  tym_statementise_universe(mdl);
+  assert(0 == test_no_stmts(mdl));
+
+  terms = tym_mk_term_cell(tym_mk_term(TYM_VAR, TYM_CSTR_DUPLICATE("X")), NULL);
+  tym_strengthen_model(mdl, tym_mk_stmt_pred(TYM_CSTR_DUPLICATE("p"), terms,
+        tym_mk_fmla_quant(FMLA_EX, TYM_CSTR_DUPLICATE("Y"),
+          tym_mk_fmla_atom_varargs(TYM_CSTR_DUPLICATE(tym_eqK), 2,
+            tym_mk_term(TYM_VAR, TYM_CSTR_DUPLICATE("X")),
+            tym_mk_term(TYM_VAR, TYM_CSTR_DUPLICATE("Y"))))));
+  tym_strengthen_model(mdl, tym_mk_stmt_const(TYM_CSTR_DUPLICATE("c0"),
+        mdl->universe, TYM_CSTR_DUPLICATE(TYM_UNIVERSE_TY)));
+  tym_bound_universe(mdl);
+
+  tym_reset_buffer(outbuf);
+  res = tym_model_str(mdl, outbuf);
+  assert(tym_is_ok_TymBufferWriteResult(res));
+  TYM_DBG_BUFFER(outbuf, "test model (universe as bit-vectors, bounded)")
+  assert(NULL != strstr(tym_buffer_contents(outbuf),
+        "(define-sort Universe () (_ BitVec 2))\n"
+        "(define-fun c () Universe (_ bv0 2))\n"
+        "(define-fun b () Universe (_ bv1 2))\n"
+        "(define-fun a () Universe (_ bv2 2))\n"));
+  assert(NULL != strstr(tym_buffer_contents(outbuf), "(assert (bvule c0 a))"));
+  assert(NULL != strstr(tym_buffer_contents(outbuf),
+        "(exists ((Y Universe))(and (bvule Y a) (= X Y)))"));
   tym_free_buffer(outbuf);
 
   tym_free_model(mdl);
@@ -610,7 +789,18 @@ tym_statementise_universe(struct TymModel * mdl)
     return;
   }
 
-  for (int i = 0; i < mdl->universe->cardinality; i++) {
+  if (TYM_UNIVERSE_DATATYPE == mdl->universe->encoding) {
+    // The datatype's constructors are distinct and exhaust the datatype, so
+    // there's nothing to assert (see tym_universe_str).
+    return;
+  } else if (TYM_UNIVERSE_BITVEC == mdl->universe->encoding) {
+    // The elements are defined to be distinct numerals (see tym_universe_str),
+    // and the bit-vectors that don't number an element are excluded by
+    // tym_bound_universe once the query has been added to the model.
+    return;
+  }
+
+  for (size_t i = 0; i < mdl->universe->cardinality; i++) {
     tym_strengthen_model(mdl,
         tym_mk_stmt_const(TYM_STR_DUPLICATE(mdl->universe->element[i]),
           mdl->universe, TYM_CSTR_DUPLICATE(TYM_UNIVERSE_TY)));
@@ -618,7 +808,7 @@ tym_statementise_universe(struct TymModel * mdl)
 
   assert(0 < mdl->universe->cardinality);
   struct TymTerm ** args = malloc(sizeof *args * mdl->universe->cardinality);
-  for (int i = 0; i < mdl->universe->cardinality; i++) {
+  for (size_t i = 0; i < mdl->universe->cardinality; i++) {
     args[i] = tym_mk_term(TYM_CONST, TYM_STR_DUPLICATE(mdl->universe->element[i]));
   }
   const TymStr * copied = TYM_CSTR_DUPLICATE(tym_distinctK);
@@ -626,12 +816,19 @@ tym_statementise_universe(struct TymModel * mdl)
     tym_mk_fmla_atom(copied, mdl->universe->cardinality, args);
   tym_strengthen_model(mdl, tym_mk_stmt_axiom(distinctness_fmla));
 
+  if (mdl->grounded) {
+    // Grounding would turn the domain-closure axiom into a tautology, so
+    // instead tym_ground_model expands the query over the values of its
+    // constants, which confines them to the elements.
+    return;
+  }
+
   struct TymSymGen * sg = tym_mk_sym_gen(TYM_CSTR_DUPLICATE("X"));
   const TymStr * varname = tym_mk_new_var(sg);
 
   struct TymFmlas * cardinality_fmlas = NULL;
 
-  for (int i = 0; i < mdl->universe->cardinality; i++) {
+  for (size_t i = 0; i < mdl->universe->cardinality; i++) {
     args = malloc(sizeof *args * 2);
     args[0] = tym_mk_term(TYM_CONST, TYM_STR_DUPLICATE(mdl->universe->element[i]));
     args[1] = tym_mk_term(TYM_CONST, TYM_STR_DUPLICATE(varname));
@@ -646,3 +843,149 @@ tym_statementise_universe(struct TymModel * mdl)
 
   tym_free_sym_gen(sg);
 }
+
+// "identifier <= max", as unsigned bit-vectors.
+static struct TymFmla *
+bound_atom(const TymStr * identifier, const TymStr * max)
+{
+  return tym_mk_fmla_atom_varargs(TYM_CSTR_DUPLICATE(tym_bvuleK), 2,
+      tym_mk_term(TYM_CONST, TYM_STR_DUPLICATE(identifier)),
+      tym_mk_term(TYM_CONST, TYM_STR_DUPLICATE(max)));
+}
+
+// Returns a copy of fmla in which quantifiers range only over bit-vectors
+// that are at most max.
+static struct TymFmla *
+bound_fmla(const struct TymFmla * fmla, const TymStr * max)
+{
+  struct TymFmla * result = NULL;
+  struct TymFmlas * fmlas = NULL;
+  size_t no_args = 0;
+  const TymStr * bv;
+
+  switch (fmla->kind) {
+  case FMLA_CONST:
+  case FMLA_ATOM:
+    result = tym_copy_fmla(fmla);
+    break;
+  case FMLA_AND:
+  case FMLA_OR:
+    while (NULL != fmla->param.args[no_args]) {
+      no_args++;
+    }
+    for (size_t i = no_args; i > 0; i--) {
+      fmlas = tym_mk_fmla_cell(bound_fmla(fmla->param.args[i - 1], max), fmlas);
+    }
+    result = (FMLA_AND == fmla->kind) ? tym_mk_fmla_ands(fmlas) : tym_mk_fmla_ors(fmlas);
+    break;
+  case FMLA_NOT:
+    result = tym_mk_fmla_not(bound_fmla(fmla->param.args[0], max));
+    break;
+  case FMLA_IF:
+    result = tym_mk_fmla_if(bound_fmla(fmla->param.args[0], max),
+        bound_fmla(fmla->param.args[1], max));
+    break;
+  case FMLA_IFF:
+    assert(NULL == fmla->param.args[2]);
+    result = tym_mk_fmla_iff(bound_fmla(fmla->param.args[0], max),
+        bound_fmla(fmla->param.args[1], max));
+    break;
+  case FMLA_EX:
+    bv = fmla->param.quant->bv;
+    result = tym_mk_fmla_quant(FMLA_EX, TYM_STR_DUPLICATE(bv),
+        tym_mk_fmla_and(bound_atom(bv, max), bound_fmla(fmla->param.quant->body, max)));
+    break;
+  case FMLA_ALL:
+    bv = fmla->param.quant->bv;
+    result = tym_mk_fmla_quant(FMLA_ALL, TYM_STR_DUPLICATE(bv),
+        tym_mk_fmla_if(bound_atom(bv, max), bound_fmla(fmla->param.quant->body, max)));
+    break;
+  default:
+    assert(0);
+  }
+
+  return result;
+}
+
+// If the universe is encoded as bit-vectors, then the bit-vectors that don't
+// number an element need to be excluded from the range of quantifiers and of
+// the query's constants. This is unnecessary when the universe's cardinality
+// is a power of 2, and when the model was grounded (see tym_ground_model),
+// since no quantifiers remain then and the query's constants are confined to
+// the elements.
+void
+tym_bound_universe(struct TymModel * mdl)
+{
+  const struct TymUniverse * uni = mdl->universe;
+  if (TYM_UNIVERSE_BITVEC != uni->encoding || mdl->grounded ||
+      ((size_t)1 << tym_universe_width(uni)) == uni->cardinality) {
+    return;
+  }
+
+  const TymStr * max = uni->element[uni->cardinality - 1];
+  struct TymStmts * bounds = NULL;
+  for (struct TymStmts * cursor = mdl->stmts; NULL != cursor; cursor = cursor->next) {
+    struct TymStmt * stmt = cursor->stmt;
+    if (TYM_STMT_AXIOM == stmt->kind) {
+      const struct TymFmla * axiom = stmt->param.axiom;
+      stmt->param.axiom = bound_fmla(axiom, max);
+      tym_free_fmla(axiom);
+    } else if (NULL != stmt->param.const_def->body) {
+      struct TymFmla * body = stmt->param.const_def->body;
+      stmt->param.const_def->body = bound_fmla(body, max);
+      tym_free_fmla(body);
+    } else if (NULL == stmt->param.const_def->params &&
+        0 == strcmp(tym_decode_str(stmt->param.const_def->ty), TYM_UNIVERSE_TY)) {
+      // The elements aren't declared as constants in this encoding, so this
+      // is one of the query's constants.
+      bounds = tym_mk_stmt_cell(tym_mk_stmt_axiom(
+            bound_atom(stmt->param.const_def->const_name, max)), bounds);
+    }
+  }
+
+  while (NULL != bounds) {
+    struct TymStmts * next = bounds->next;
+    tym_strengthen_model(mdl, bounds->stmt);
+    free(bounds);
+    bounds = next;
+  }
+}
+
+// Times tym_model_str on models resembling those of programs with n facts:
+// n+1 constants, the axioms about the universe, and an axiom for each fact.
+void
+tym_bench_model_str(void)
+{
+  for (size_t n = 1000; n <= 1000000; n *= 10) {
+    char name[32];
+    struct TymTerms * terms = NULL;
+    for (size_t i = 0; i <= n; i++) {
+      snprintf(name, sizeof(name), "c%zu", i);
+      terms = tym_mk_term_cell(tym_mk_term(TYM_CONST, TYM_CSTR_DUPLICATE(name)), terms);
+    }
+    struct TymModel * mdl = tym_mk_model(tym_mk_universe(terms));
+    tym_free_terms(terms);
+    tym_statementise_universe(mdl);
+
+    for (size_t i = 0; i < n; i++) {
+      struct TymFmla * fmla =
+        tym_mk_fmla_atom_varargs(TYM_CSTR_DUPLICATE("e"), 2,
+            tym_mk_term(TYM_CONST, TYM_STR_DUPLICATE(mdl->universe->element[i])),
+            tym_mk_term(TYM_CONST, TYM_STR_DUPLICATE(mdl->universe->element[i + 1])));
+      tym_strengthen_model(mdl, tym_mk_stmt_axiom(fmla));
+    }
+
+    struct TymBufferInfo * outbuf = tym_mk_buffer(TYM_BUF_SIZE);
+    clock_t start = clock();
+    struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res = tym_model_str(mdl, outbuf);
+    clock_t end = clock();
+    assert(tym_is_ok_TymBufferWriteResult(res));
+
+    printf("model_str: n=%zu %.1fns per fact (%zu bytes)\n", n,
+        1e9 * (double)(end - start) / CLOCKS_PER_SEC / (double)n,
+        tym_val_of_TymBufferWriteResult(res));
+
+    tym_free_buffer(outbuf);
+    tym_free_model(mdl);
+  }
+}
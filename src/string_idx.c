@@ -22,13 +22,28 @@ This file: String representation.
 */
 
 #include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
+#include "module_benchmarks.h"
 #include "string_idx.h"
 
 static void init_str(void);
 
+#if TYM_STRING_TYPE == 2 || TYM_STRING_TYPE == 3
+#define TYM_BENCH_STR_FMT "bench_%zu"
+#define TYM_BENCH_STR_SIZE 32
+
+static double
+ns_per_op(clock_t start, clock_t end, size_t n)
+{
+  return 1e9 * (double)(end - start) / CLOCKS_PER_SEC / (double)n;
+}
+#endif
+
 #if TYM_STRING_TYPE == 0
 void
 tym_init_str(void)
@@ -81,6 +96,12 @@ tym_cmp_str (const TymStr * s1, const TymStr * s2)
 {
   return strcmp(s1, s2);
 }
+
+bool
+tym_eq_str (const TymStr * s1, const TymStr * s2)
+{
+  return 0 == strcmp(s1, s2);
+}
 #elif TYM_STRING_TYPE == 1
 struct TymStrIdxStruct {
   const char * content;
@@ -140,10 +161,19 @@ tym_cmp_str (const struct TymStrIdxStruct * s1, const struct TymStrIdxStruct * s
 {
   return strcmp(s1->content, s2->content);
 }
+
+bool
+tym_eq_str (const struct TymStrIdxStruct * s1, const struct TymStrIdxStruct * s2)
+{
+  return 0 == strcmp(s1->content, s2->content);
+}
 #elif TYM_STRING_TYPE == 2
 #include "hashtable.h"
 
 TYM_HASHTABLE(String) * stringhash = NULL;
+// Strings can be encoded by several threads at once (see
+// tym_translate_program), so the table is changed under this lock.
+static pthread_mutex_t stringhash_lock = PTHREAD_MUTEX_INITIALIZER;
 struct TymStrHashIdxStruct {
   const char * content;
 };
@@ -191,13 +221,16 @@ tym_encode_str (const char * s)
 {
   assert(NULL != stringhash);
 
+  pthread_mutex_lock(&stringhash_lock);
   const struct TymStrHashIdxStruct * pre_result = tym_ht_lookup(stringhash, s);
   if (NULL == pre_result) {
     struct TymStrHashIdxStruct * result = malloc(sizeof(*result));
     result->content = s;
     assert(tym_ht_add(stringhash, s, result));
+    pthread_mutex_unlock(&stringhash_lock);
     return result;
   } else {
+    pthread_mutex_unlock(&stringhash_lock);
     if (s != pre_result->content) {
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wcast-qual"
@@ -257,11 +290,56 @@ tym_safe_free_str (const struct TymStrHashIdxStruct * s)
   assert(NULL != s->content);
 
   if (!tym_is_special_string(s)) {
+    pthread_mutex_lock(&stringhash_lock);
     assert(tym_ht_delete(stringhash, s->content));
+    pthread_mutex_unlock(&stringhash_lock);
   }
 }
 #pragma GCC diagnostic pop
 
+// Times the interning, lookup and removal of n fresh strings, for n from
+// 10^3 to 10^7. If the table scales then the per-operation times should stay
+// roughly flat as n grows.
+void
+tym_bench_string_idx(void)
+{
+  assert(NULL != stringhash);
+  size_t initial_count = tym_ht_count(stringhash);
+
+  for (size_t n = 1000; n <= 10000000; n *= 10) {
+    const TymStr ** strs = malloc(sizeof(*strs) * n);
+    assert(NULL != strs);
+    char buf[TYM_BENCH_STR_SIZE];
+
+    clock_t start = clock();
+    for (size_t i = 0; i < n; i++) {
+      char * s = malloc(TYM_BENCH_STR_SIZE);
+      snprintf(s, TYM_BENCH_STR_SIZE, TYM_BENCH_STR_FMT, i);
+      strs[i] = tym_encode_str(s);
+    }
+    clock_t end_insert = clock();
+    assert(initial_count + n == tym_ht_count(stringhash));
+
+    for (size_t i = 0; i < n; i++) {
+      snprintf(buf, TYM_BENCH_STR_SIZE, TYM_BENCH_STR_FMT, i);
+      assert(strs[i] == tym_ht_lookup(stringhash, buf));
+    }
+    clock_t end_lookup = clock();
+
+    for (size_t i = 0; i < n; i++) {
+      tym_safe_free_str(strs[i]);
+    }
+    clock_t end_delete = clock();
+    assert(initial_count == tym_ht_count(stringhash));
+
+    printf("string_idx: n=%zu insert=%.1fns lookup=%.1fns delete=%.1fns\n",
+        n, ns_per_op(start, end_insert, n), ns_per_op(end_insert, end_lookup, n),
+        ns_per_op(end_lookup, end_delete, n));
+
+    free(strs);
+  }
+}
+
 size_t
 tym_len_str (const struct TymStrHashIdxStruct * s)
 {
@@ -277,6 +355,358 @@ tym_cmp_str (const struct TymStrHashIdxStruct * s1, const struct TymStrHashIdxSt
 
   return strcmp(s1->content, s2->content);
 }
+
+bool
+tym_eq_str (const struct TymStrHashIdxStruct * s1, const struct TymStrHashIdxStruct * s2)
+{
+  assert(NULL != stringhash);
+
+  // Strings are hash-consed, so equal strings are represented by the same object.
+  return s1 == s2;
+}
+#elif TYM_STRING_TYPE == 3
+#include "hash.h"
+
+// Symbol records are kept in fixed-size pages, and their text in fixed-size
+// arena chunks, so that neither moves once created, and TymStr pointers
+// remain valid until tym_fin_str.
+#define TYM_SYM_PAGE_BITS 12
+#define TYM_SYM_PAGE_SIZE ((size_t)1 << TYM_SYM_PAGE_BITS)
+#define TYM_STR_ARENA_CHUNK_SIZE 65536
+#define TYM_SYM_INITIAL_SLOTS 256 // Must be a power of 2.
+
+struct TymStrSymStruct {
+  uint32_t id;
+  uint32_t len;
+  const char * content; // Points into the string arena.
+};
+
+struct TymSymTable {
+  struct TymStrSymStruct ** pages;
+  size_t no_pages;
+  uint64_t * hashes; // Indexed by identifier.
+  size_t count;
+  size_t capacity; // Of "hashes", and the number of records in "pages".
+  uint32_t * slots; // Open addressing: identifier + 1, or 0 if the slot is empty.
+  size_t no_slots;
+  char ** chunks;
+  size_t no_chunks;
+  size_t chunk_used; // Bytes used in the last chunk.
+  size_t chunk_size; // Size of the last chunk.
+};
+
+static struct TymSymTable * symtab = NULL;
+// Strings can be encoded by several threads at once (see
+// tym_translate_program), so the table is changed under this lock.
+// NOTE tym_str_of_id and tym_no_strs don't take it, so they mustn't be used
+//      while other threads encode strings.
+static pthread_mutex_t symtab_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const struct TymStrSymStruct * find_sym(const char * s, uint64_t h, size_t * slot);
+static const struct TymStrSymStruct * encode_sym(const char * s);
+static const char * arena_copy(const char * s, size_t len);
+
+void
+tym_init_str(void)
+{
+  assert(NULL == symtab);
+  symtab = malloc(sizeof(*symtab));
+  assert(NULL != symtab);
+  *symtab = (struct TymSymTable){.pages = NULL, .no_pages = 0,
+    .hashes = NULL, .count = 0, .capacity = 0,
+    .slots = calloc(TYM_SYM_INITIAL_SLOTS, sizeof(uint32_t)), .no_slots = TYM_SYM_INITIAL_SLOTS,
+    .chunks = NULL, .no_chunks = 0, .chunk_used = 0, .chunk_size = 0};
+  assert(NULL != symtab->slots);
+  init_str();
+}
+
+void
+tym_fin_str(void)
+{
+  assert(NULL != symtab);
+
+  for (size_t i = 0; i < symtab->no_pages; i++) {
+    free(symtab->pages[i]);
+  }
+  free(symtab->pages);
+  for (size_t i = 0; i < symtab->no_chunks; i++) {
+    free(symtab->chunks[i]);
+  }
+  free(symtab->chunks);
+  free(symtab->hashes);
+  free(symtab->slots);
+  free(symtab);
+
+  symtab = NULL;
+}
+
+const bool TymCanDumpStrings = true;
+void
+tym_dump_str(void)
+{
+  assert(NULL != symtab);
+
+  for (uint32_t id = 0; id < symtab->count; id++) {
+    printf("%u : %s\n", id, tym_str_of_id(id)->content);
+  }
+}
+
+// Returns the symbol whose text is "s", if any, and sets "slot" to where the
+// search ended.
+static const struct TymStrSymStruct *
+find_sym(const char * s, uint64_t h, size_t * slot)
+{
+  size_t mask = symtab->no_slots - 1;
+  size_t i = (size_t)h & mask;
+  while (0 != symtab->slots[i]) {
+    uint32_t id = symtab->slots[i] - 1;
+    if (h == symtab->hashes[id]) {
+      const struct TymStrSymStruct * sym = tym_str_of_id(id);
+      if (0 == strcmp(s, sym->content)) {
+        *slot = i;
+        return sym;
+      }
+    }
+    i = (i + 1) & mask;
+  }
+  *slot = i;
+  return NULL;
+}
+
+static const char *
+arena_copy(const char * s, size_t len)
+{
+  if (len + 1 > symtab->chunk_size - symtab->chunk_used) {
+    size_t chunk_size = TYM_STR_ARENA_CHUNK_SIZE;
+    if (len + 1 > chunk_size) {
+      chunk_size = len + 1;
+    }
+    symtab->chunks = realloc(symtab->chunks, sizeof(*symtab->chunks) * (symtab->no_chunks + 1));
+    assert(NULL != symtab->chunks);
+    symtab->chunks[symtab->no_chunks] = malloc(chunk_size);
+    assert(NULL != symtab->chunks[symtab->no_chunks]);
+    symtab->no_chunks++;
+    symtab->chunk_used = 0;
+    symtab->chunk_size = chunk_size;
+  }
+
+  char * result = symtab->chunks[symtab->no_chunks - 1] + symtab->chunk_used;
+  memcpy(result, s, len + 1);
+  symtab->chunk_used += len + 1;
+  return result;
+}
+
+// NOTE as with TYM_STRING_TYPE == 2, tym_encode_str takes ownership of "s",
+//      which might not be available after the call. Its text is copied into
+//      the arena.
+const struct TymStrSymStruct *
+tym_encode_str (const char * s)
+{
+  assert(NULL != symtab);
+  assert(NULL != s);
+
+  pthread_mutex_lock(&symtab_lock);
+  const struct TymStrSymStruct * result = encode_sym(s);
+  pthread_mutex_unlock(&symtab_lock);
+  return result;
+}
+
+static const struct TymStrSymStruct *
+encode_sym(const char * s)
+{
+  uint64_t h = tym_hash_str(s);
+  size_t slot;
+  const struct TymStrSymStruct * result = find_sym(s, h, &slot);
+  if (NULL != result) {
+    if (s != result->content) {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+      free((void *)s);
+#pragma GCC diagnostic pop
+    }
+    return result;
+  }
+
+  size_t len = strlen(s);
+  assert(len <= UINT32_MAX);
+  assert(symtab->count < UINT32_MAX);
+  uint32_t id = (uint32_t)symtab->count;
+
+  if (symtab->count == symtab->capacity) {
+    symtab->pages = realloc(symtab->pages, sizeof(*symtab->pages) * (symtab->no_pages + 1));
+    assert(NULL != symtab->pages);
+    symtab->pages[symtab->no_pages] = malloc(sizeof(**symtab->pages) * TYM_SYM_PAGE_SIZE);
+    assert(NULL != symtab->pages[symtab->no_pages]);
+    symtab->no_pages++;
+    symtab->capacity += TYM_SYM_PAGE_SIZE;
+    symtab->hashes = realloc(symtab->hashes, sizeof(*symtab->hashes) * symtab->capacity);
+    assert(NULL != symtab->hashes);
+  }
+
+  struct TymStrSymStruct * sym =
+    &symtab->pages[id >> TYM_SYM_PAGE_BITS][id & (TYM_SYM_PAGE_SIZE - 1)];
+  *sym = (struct TymStrSymStruct){.id = id, .len = (uint32_t)len,
+    .content = arena_copy(s, len)};
+  symtab->hashes[id] = h;
+  symtab->slots[slot] = id + 1;
+  symtab->count++;
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+  free((void *)s);
+#pragma GCC diagnostic pop
+
+  // Keep the table at most half full.
+  if (2 * symtab->count > symtab->no_slots) {
+    size_t no_slots = 2 * symtab->no_slots;
+    uint32_t * slots = calloc(no_slots, sizeof(*slots));
+    assert(NULL != slots);
+    for (uint32_t i = 0; i < symtab->count; i++) {
+      size_t j = (size_t)symtab->hashes[i] & (no_slots - 1);
+      while (0 != slots[j]) {
+        j = (j + 1) & (no_slots - 1);
+      }
+      slots[j] = i + 1;
+    }
+    free(symtab->slots);
+    symtab->slots = slots;
+    symtab->no_slots = no_slots;
+  }
+
+  return sym;
+}
+
+const char *
+tym_decode_str (const struct TymStrSymStruct * s)
+{
+  assert(NULL != symtab);
+
+  return s->content;
+}
+
+void
+tym_free_str (const struct TymStrSymStruct * s)
+{
+  assert(NULL != symtab);
+
+  assert(NULL != s);
+
+  // Do nothing -- everything will be freed when "fin" is called.
+}
+
+void
+tym_force_free_str (const struct TymStrSymStruct * s)
+{
+  assert(NULL != symtab);
+
+  assert(NULL != s);
+
+  // Do nothing -- a symbol's identifier and text remain valid until "fin"
+  // is called, since other terms might share the symbol.
+}
+
+void
+tym_safe_free_str (const struct TymStrSymStruct * s)
+{
+  assert(NULL != symtab);
+
+  assert(NULL != s);
+
+  // Do nothing -- see tym_force_free_str.
+}
+
+uint32_t
+tym_str_id (const struct TymStrSymStruct * s)
+{
+  return s->id;
+}
+
+const struct TymStrSymStruct *
+tym_str_of_id (uint32_t id)
+{
+  assert(NULL != symtab);
+  assert(id < symtab->count);
+
+  return &symtab->pages[id >> TYM_SYM_PAGE_BITS][id & (TYM_SYM_PAGE_SIZE - 1)];
+}
+
+size_t
+tym_no_strs (void)
+{
+  assert(NULL != symtab);
+
+  return symtab->count;
+}
+
+// Times the interning and lookup of n fresh strings, for n from 10^3 to
+// 10^7, and compares the cost of equality on symbols with that on their text.
+void
+tym_bench_string_idx(void)
+{
+  assert(NULL != symtab);
+
+  for (size_t n = 1000; n <= 10000000; n *= 10) {
+    const TymStr ** strs = malloc(sizeof(*strs) * n);
+    assert(NULL != strs);
+    char buf[TYM_BENCH_STR_SIZE];
+    size_t initial_count = tym_no_strs();
+
+    clock_t start = clock();
+    for (size_t i = 0; i < n; i++) {
+      char * s = malloc(TYM_BENCH_STR_SIZE);
+      snprintf(s, TYM_BENCH_STR_SIZE, TYM_BENCH_STR_FMT "_%zu", n, i);
+      strs[i] = tym_encode_str(s);
+    }
+    clock_t end_insert = clock();
+    assert(initial_count + n == tym_no_strs());
+
+    for (size_t i = 0; i < n; i++) {
+      snprintf(buf, TYM_BENCH_STR_SIZE, TYM_BENCH_STR_FMT "_%zu", n, i);
+      size_t slot;
+      assert(strs[i] == find_sym(buf, tym_hash_str(buf), &slot));
+    }
+    clock_t end_lookup = clock();
+
+    // Compare each string with its neighbour, whose text shares a long prefix.
+    size_t no_equal = 0;
+    for (size_t i = 0; i + 1 < n; i++) {
+      no_equal += tym_eq_str(strs[i], strs[i + 1]);
+    }
+    clock_t end_eq_id = clock();
+    for (size_t i = 0; i + 1 < n; i++) {
+      no_equal += (0 == strcmp(strs[i]->content, strs[i + 1]->content));
+    }
+    clock_t end_eq_text = clock();
+    assert(0 == no_equal);
+
+    printf("string_idx: n=%zu insert=%.1fns lookup=%.1fns eq_id=%.1fns eq_text=%.1fns\n",
+        n, ns_per_op(start, end_insert, n), ns_per_op(end_insert, end_lookup, n),
+        ns_per_op(end_lookup, end_eq_id, n), ns_per_op(end_eq_id, end_eq_text, n));
+
+    free(strs);
+  }
+}
+
+size_t
+tym_len_str (const struct TymStrSymStruct * s)
+{
+  return s->len;
+}
+
+int
+tym_cmp_str (const struct TymStrSymStruct * s1, const struct TymStrSymStruct * s2)
+{
+  if (s1 == s2) {
+    return 0;
+  }
+  return strcmp(s1->content, s2->content);
+}
+
+bool
+tym_eq_str (const struct TymStrSymStruct * s1, const struct TymStrSymStruct * s2)
+{
+  return s1->id == s2->id;
+}
 #else
   #error "Unknown TYM_STRING_TYPE"
 #endif
@@ -21,7 +21,12 @@ along with TYM Datalog.  If not, see <https://www.gnu.org/licenses/>.
 This file: Support functions for TYM Datalog.
 */
 
+#include <time.h>
+#include <unistd.h>
+
 #ifdef TYM_INTERFACE_Z3
+#include <pthread.h>
+
 #include "interface_z3.h"
 #endif
 #include "interface_c.h"
@@ -33,10 +38,44 @@ This file: Support functions for TYM Datalog.
 TYM_DEFINE_LIST_SHALLOW_FREE(stmts, const, struct TymStmts)
 #pragma GCC diagnostic pop
 
+struct TymAnswerContext {
+  struct TymParams * params;
+  struct TymProgram * ParsedQuery;
+  struct TymBufferInfo * result_outbuf;
+};
+
 #ifdef TYM_INTERFACE_Z3
-static struct TymFmla * solver_invoke(struct TymParams *, struct TymProgram *, struct TymMdlValuations *, struct TymValuation *, struct TymBufferInfo *);
-static void solver_loop(struct TymParams *, struct TymModel **, struct TymValuation *, struct TymProgram *, struct TymBufferInfo *);
+// Each worker enumerates the answers that lie in its own part of the search
+// space, using its own solver.
+struct TymSolverWorker {
+  struct TymParams * params;
+  const struct TymModel * mdl;
+  struct TymValuation * varmap;
+  struct TymProgram * ParsedQuery;
+  // Constrains the query's first constant, if the search space is split
+  // among several workers. Otherwise it's NULL.
+  struct TymFmla * cube;
+  struct TymMdlValuations * vals;
+  struct TymBufferInfo * result_outbuf;
+  struct TymStmts * blocking_stmts; // Statements that rule out models found.
+  enum TymSatisfiable last_result;
+  bool invalid; // Set if the solver couldn't be given the model.
+};
+
+// Workers take this lock to use state that they share, such as the string
+// table and stdout.
+static pthread_mutex_t solver_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void print_answer(struct TymParams *, struct TymProgram *, struct TymMdlValuations *, struct TymBufferInfo *);
+static void print_answer_callback(struct TymMdlValuations *, void *);
+static enum TymReturnCode evaluate_program(struct TymParams *, struct TymProgram *, struct TymProgram *, struct TymProgram *);
+#ifdef TYM_INTERFACE_Z3
+static struct TymFmla * solver_invoke(struct TymSolverWorker *, struct TymZ3Solver *);
+static void * solver_worker(void *);
+static enum TymReturnCode solver_loop(struct TymParams *, struct TymModel **, struct TymValuation *, struct TymProgram *);
 static const struct TymValuation * find_valuation_for(const TymStr *, struct TymValuation *);
+static bool declares_predicate(const struct TymModel *, const TymStr *);
 #endif
 static const char * tym_show_choices(const char ** choices, const unsigned choice_terminator);
 
@@ -53,6 +92,8 @@ const char * TymFunctionCommandMapping[] =
    "c_output",
    "dump_hilbert_universe",
    "dump_atoms",
+   "eval",
+   "tabled_eval",
    NULL
   };
 
@@ -63,6 +104,13 @@ const char * TymModelOutputCommandMapping[] =
    NULL
   };
 
+const char * TymUniverseEncodingCommandMapping[] =
+  {"sort",
+   "datatype",
+   "bitvec",
+   NULL
+  };
+
 const char *
 tym_show_choices(const char ** choices, const unsigned choice_terminator)
 {
@@ -96,6 +144,12 @@ tym_model_outputs(void)
   return tym_show_choices(TymModelOutputCommandMapping, TYM_NO_MODEL_OUTPUT);
 }
 
+const char *
+tym_universe_encodings(void)
+{
+  return tym_show_choices(TymUniverseEncodingCommandMapping, TYM_NO_UNIVERSE_ENCODING);
+}
+
 struct TymProgram *
 tym_parse_input_file(struct TymParams * Params)
 {
@@ -107,7 +161,7 @@ tym_parse_input_file(struct TymParams * Params)
     }
     result = parse(InputFileContents);
     if (Params->verbosity > 0 && NULL != InputFileContents) {
-      TYM_VERBOSE("input : %d clauses\n", result->no_clauses);
+      TYM_VERBOSE("input : %zu clauses\n", result->no_clauses);
     }
     free(InputFileContents);
   } else if (TYM_TEST_PARSING == Params->function) {
@@ -126,7 +180,7 @@ tym_parse_query(struct TymParams * Params)
     }
     result = parse(Params->query);
     if (Params->verbosity > 0 && NULL != Params->query) {
-      TYM_VERBOSE("query : %d clauses\n", result->no_clauses);
+      TYM_VERBOSE("query : %zu clauses\n", result->no_clauses);
     }
   } else if (TYM_TEST_PARSING == Params->function) {
     printf("(no query given)\n");
@@ -139,12 +193,11 @@ print_parsed_program(struct TymParams * Params, struct TymProgram * ParsedInputF
   struct TymProgram * ParsedQuery)
 {
   struct TymBufferInfo * outbuf = tym_mk_buffer(TYM_BUF_SIZE);
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = NULL;
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res;
 
   if (NULL != Params->input_file) {
     res = tym_program_str(ParsedInputFileContents, outbuf);
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
     TYM_DBG_PRINT_BUFFER(printf, outbuf, "stringed file contents")
   }
 
@@ -152,7 +205,6 @@ print_parsed_program(struct TymParams * Params, struct TymProgram * ParsedInputF
     tym_reset_buffer(outbuf);
     res = tym_program_str(ParsedQuery, outbuf);
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
     TYM_DBG_PRINT_BUFFER(printf, outbuf, "stringed query")
   }
 
@@ -160,13 +212,117 @@ print_parsed_program(struct TymParams * Params, struct TymProgram * ParsedInputF
   return TYM_AOK;
 }
 
+static void
+print_answer(struct TymParams * params, struct TymProgram * ParsedQuery, struct TymMdlValuations * vals, struct TymBufferInfo * result_outbuf)
+{
+  if (TYM_MODEL_OUTPUT_VALUATION == params->model_output ||
+      TYM_ALL_MODEL_OUTPUT == params->model_output) {
+    tym_mdl_print_valuations(vals);
+  }
+
+  if (TYM_MODEL_OUTPUT_FACT == params->model_output ||
+      TYM_ALL_MODEL_OUTPUT == params->model_output) {
+    struct TymProgram * instance = tym_mdl_instantiate_valuation(ParsedQuery, vals);
+
+    struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res;
+    tym_reset_buffer(result_outbuf);
+    res = tym_program_str(instance, result_outbuf);
+    assert(tym_is_ok_TymBufferWriteResult(res));
+    printf("%s\n", tym_buffer_contents(result_outbuf));
+    tym_free_program(instance);
+  }
+}
+
+static void
+print_answer_callback(struct TymMdlValuations * vals, void * ctxt)
+{
+  struct TymAnswerContext * answer_ctxt = ctxt;
+  print_answer(answer_ctxt->params, answer_ctxt->ParsedQuery, vals,
+      answer_ctxt->result_outbuf);
+}
+
+// Computes the program's least model bottom-up, without involving a solver,
+// and then answers the query (if any) by looking it up in that model.
+// For tabled evaluation, the query is instead answered top-down, and its
+// answers are printed as they're found.
+// Answers are printed as instances of ParsedQuery, which has the same
+// variables as the query.
+static enum TymReturnCode
+evaluate_program(struct TymParams * params, struct TymProgram * ParsedInputFileContents,
+  struct TymProgram * query, struct TymProgram * ParsedQuery)
+{
+  struct TymAtomDatabase * adb = tym_mk_atom_database();
+  for (size_t i = 0; i < ParsedInputFileContents->no_clauses; i++) {
+    enum TymCdlAddError error_code;
+    if (!tym_clause_database_add(ParsedInputFileContents->program[i], adb, &error_code)) {
+      tym_free_atom_database(adb);
+      return TYM_INVALID_INPUT;
+    }
+  }
+
+  struct TymEvaluator * ev = tym_mk_evaluator(adb);
+  if (NULL == ev) {
+    tym_free_atom_database(adb);
+    return TYM_INVALID_INPUT;
+  }
+  ev->no_threads = params->eval_threads;
+  if (TYM_EVALUATE_TABLED == params->function) {
+    enum TymReturnCode result = TYM_AOK;
+    if (NULL == query) {
+      TYM_ERR("Tabled evaluation needs a query.\n");
+      result = TYM_INVALID_INPUT;
+    } else {
+      // NOTE we expect a query to contain exactly one clause.
+      assert(1 == query->no_clauses);
+      struct TymAnswerContext answer_ctxt = {
+        .params = params,
+        .ParsedQuery = ParsedQuery,
+        .result_outbuf = tym_mk_buffer(TYM_BUF_SIZE)};
+      size_t no_answers = tym_evaluator_tabled_query(ev, query->program[0]->head,
+          print_answer_callback, &answer_ctxt);
+      tym_free_buffer(answer_ctxt.result_outbuf);
+      if (params->verbosity > 0) {
+        TYM_VERBOSE("tabled_eval : %zu tables, %zu answers\n", ev->no_tables,
+            no_answers);
+      }
+    }
+    tym_free_evaluator(ev);
+    tym_free_atom_database(adb);
+    return result;
+  }
+
+  tym_evaluator_fixpoint(ev);
+  if (params->verbosity > 0) {
+    TYM_VERBOSE("eval : %zu iterations, %zu tuples\n", ev->iterations,
+        tym_evaluator_no_tuples(ev));
+  }
+
+  if (NULL == query) {
+    tym_evaluator_print_relations(ev);
+  } else {
+    // NOTE we expect a query to contain exactly one clause.
+    assert(1 == query->no_clauses);
+    struct TymAnswerContext answer_ctxt = {
+      .params = params,
+      .ParsedQuery = ParsedQuery,
+      .result_outbuf = tym_mk_buffer(TYM_BUF_SIZE)};
+    (void)tym_evaluator_query(ev, query->program[0]->head,
+        print_answer_callback, &answer_ctxt);
+    tym_free_buffer(answer_ctxt.result_outbuf);
+  }
+
+  tym_free_evaluator(ev);
+  tym_free_atom_database(adb);
+  return TYM_AOK;
+}
+
 #ifdef TYM_INTERFACE_Z3
 static const struct TymValuation *
 find_valuation_for(const TymStr * var_name, struct TymValuation * varmap)
 {
   const struct TymValuation * varmap_cursor = varmap;
   while (NULL != varmap_cursor) {
-    if (0 == tym_cmp_str(var_name, varmap_cursor->var)) {
+    if (tym_eq_str(var_name, varmap_cursor->var)) {
       struct TymTerm * val = varmap_cursor->val;
       assert(TYM_VAR == val->kind);
       // If we could change "vals", this line would map the constant's name
@@ -180,23 +336,23 @@ find_valuation_for(const TymStr * var_name, struct TymValuation * varmap)
 }
 
 static struct TymFmla *
-solver_invoke(struct TymParams * params, struct TymProgram * ParsedQuery, struct TymMdlValuations * vals, struct TymValuation * varmap, struct TymBufferInfo * result_outbuf)
+solver_invoke(struct TymSolverWorker * worker, struct TymZ3Solver * slv)
 {
+  struct TymMdlValuations * vals = worker->vals;
   struct TymFmla * found_model = NULL;
-  tym_z3_check();
-  TymState_LastSolverResult = tym_z3_satisfied();
+  worker->last_result = tym_z3_satisfied(slv);
 #if TYM_DEBUG
-  printf("sat=%d\n", (int)result);
+  printf("sat=%d\n", (int)worker->last_result);
 #endif
-  switch (TymState_LastSolverResult) {
+  switch (worker->last_result) {
   case TYM_SAT_YES:
 #if TYM_DEBUG
-    tym_z3_print_model();
+    tym_z3_print_model(slv);
 #endif
-    tym_z3_get_model(vals);
+    tym_z3_get_model(slv, vals);
     for (unsigned i = 0; i < vals->count; i++) {
       const struct TymValuation * mapped_var =
-        find_valuation_for(vals->v[i].const_name, varmap);
+        find_valuation_for(vals->v[i].const_name, worker->varmap);
       assert(NULL != mapped_var);
       struct TymFmla * atom =
         tym_mk_fmla_atom_varargs(TYM_CSTR_DUPLICATE(tym_eqK), 2,
@@ -210,24 +366,7 @@ solver_invoke(struct TymParams * params, struct TymProgram * ParsedQuery, struct
       }
     }
 
-    if (TYM_MODEL_OUTPUT_VALUATION == params->model_output ||
-        TYM_ALL_MODEL_OUTPUT == params->model_output) {
-      tym_mdl_print_valuations(vals);
-    }
-
-    if (TYM_MODEL_OUTPUT_FACT == params->model_output ||
-        TYM_ALL_MODEL_OUTPUT == params->model_output) {
-      struct TymProgram * instance = tym_mdl_instantiate_valuation(ParsedQuery, vals);
-
-      struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = NULL;
-      tym_reset_buffer(result_outbuf);
-      res = tym_program_str(instance, result_outbuf);
-      assert(tym_is_ok_TymBufferWriteResult(res));
-      free(res);
-      printf("%s\n", tym_buffer_contents(result_outbuf));
-      tym_free_program(instance);
-    }
-
+    print_answer(worker->params, worker->ParsedQuery, vals, worker->result_outbuf);
     tym_mdl_reset_valuations(vals);
     break;
   case TYM_SAT_NO:
@@ -239,12 +378,70 @@ solver_invoke(struct TymParams * params, struct TymProgram * ParsedQuery, struct
   return found_model;
 }
 
-static void
-solver_loop(struct TymParams * params, struct TymModel ** mdl, struct TymValuation * varmap, struct TymProgram * ParsedQuery, struct TymBufferInfo * outbuf)
+// NOTE only the solver's checks, and the translation of statements for the
+//      solver, happen outside of solver_lock.
+static void *
+solver_worker(void * arg)
 {
-  tym_z3_begin(params);
-  tym_z3_assert_smtlib2(tym_buffer_contents(outbuf));
+  struct TymSolverWorker * worker = arg;
+  struct TymZ3Solver * slv = tym_z3_begin(worker->params);
+
+  clock_t start = clock();
+  if (!tym_z3_assert_model(slv, worker->mdl)) {
+    worker->invalid = true;
+    tym_z3_end(slv);
+    return NULL;
+  }
+  // clock() measures the whole process's time, so we only report it if
+  // there's a single worker.
+  if (worker->params->verbosity > 0 && NULL == worker->cube) {
+    TYM_VERBOSE("solver : model given in %.1fms\n",
+        1e3 * (double)(clock() - start) / CLOCKS_PER_SEC);
+  }
+  if (NULL != worker->cube && !tym_z3_assert_fmla(slv, worker->cube)) {
+    worker->invalid = true;
+    tym_z3_end(slv);
+    return NULL;
+  }
 
+  // The statements that rule out models are asserted in their own scope,
+  // leaving the model's statements at the solver's base level.
+  tym_z3_push(slv);
+
+  struct TymFmla * found_model = NULL;
+  while (1) {
+#if TYM_DEBUG
+    printf("Invoking...\n");
+#endif
+    tym_z3_check(slv);
+    pthread_mutex_lock(&solver_lock);
+    found_model = solver_invoke(worker, slv);
+    pthread_mutex_unlock(&solver_lock);
+#if TYM_DEBUG
+    printf("...Invoked\n");
+#endif
+    if (NULL == found_model) {
+      break;
+    } else {
+      // Rather than give the solver the whole model again, we only give it
+      // the statement that rules out the model it found.
+      struct TymStmt * stmt = tym_mk_stmt_axiom(tym_mk_fmla_not(found_model));
+      worker->blocking_stmts = tym_mk_stmt_cell(stmt, worker->blocking_stmts);
+      if (!tym_z3_assert_fmla(slv, stmt->param.axiom)) {
+        worker->invalid = true;
+        break;
+      }
+    }
+  }
+
+  tym_z3_pop(slv);
+  tym_z3_end(slv);
+  return NULL;
+}
+
+static enum TymReturnCode
+solver_loop(struct TymParams * params, struct TymModel ** mdl, struct TymValuation * varmap, struct TymProgram * ParsedQuery)
+{
   size_t num_vars = tym_valuation_len(varmap);
   const TymStr ** consts = malloc(sizeof(*consts) * (num_vars + 1));
   const TymStr ** vars = malloc(sizeof(*vars) * (num_vars + 1));
@@ -256,47 +453,113 @@ solver_loop(struct TymParams * params, struct TymModel ** mdl, struct TymValuati
   }
   consts[num_vars] = NULL;
   vars[num_vars] = NULL;
-  struct TymMdlValuations * vals = tym_mdl_mk_valuations(consts, vars);
 
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = NULL;
-  struct TymFmla * found_model = NULL;
+  // If there are several workers, then we split the search space among them
+  // by the value of the query's first constant.
+  const struct TymUniverse * uni = (*mdl)->universe;
+  unsigned no_workers = params->solver_threads;
+  if (0 == num_vars || 0 == no_workers) {
+    no_workers = 1;
+  } else if (no_workers > uni->cardinality) {
+    no_workers = (unsigned)uni->cardinality;
+  }
 
-  struct TymBufferInfo * result_outbuf = tym_mk_buffer(TYM_BUF_SIZE);
+  struct TymSolverWorker * workers = malloc(sizeof(*workers) * no_workers);
+  for (unsigned k = 0; k < no_workers; k++) {
+    struct TymFmla * cube = NULL;
+    if (no_workers > 1) {
+      struct TymFmlas * fmlas = NULL;
+      for (size_t i = k; i < uni->cardinality; i += no_workers) {
+        struct TymFmla * fmla =
+          tym_mk_fmla_atom_varargs(TYM_CSTR_DUPLICATE(tym_eqK), 2,
+              tym_mk_term(TYM_CONST, TYM_STR_DUPLICATE(consts[0])),
+              tym_mk_term(TYM_CONST, TYM_STR_DUPLICATE(uni->element[i])));
+        fmlas = tym_mk_fmla_cell(fmla, fmlas);
+      }
+      cube = tym_mk_fmla_ors(fmlas);
+    }
 
-  while (1) {
-#if TYM_DEBUG
-    printf("Invoking...\n");
-#endif
-    found_model = solver_invoke(params, ParsedQuery, vals, varmap, result_outbuf);
-#if TYM_DEBUG
-    printf("...Invoked\n");
-#endif
-    if (NULL == found_model) {
-      break;
-    } else {
-      struct TymStmt * stmt = tym_mk_stmt_axiom(tym_mk_fmla_not(found_model));
+    workers[k] = (struct TymSolverWorker){
+      .params = params,
+      .mdl = *mdl,
+      .varmap = varmap,
+      .ParsedQuery = ParsedQuery,
+      .cube = cube,
+      .vals = tym_mdl_mk_valuations(consts, vars),
+      .result_outbuf = tym_mk_buffer(TYM_BUF_SIZE),
+      .blocking_stmts = NULL,
+      .last_result = TYM_SAT_NONE,
+      .invalid = false};
+  }
 
-      tym_strengthen_model(*mdl, stmt);
+  if (1 == no_workers) {
+    solver_worker(&workers[0]);
+  } else {
+    pthread_t * threads = malloc(sizeof(*threads) * no_workers);
+    for (unsigned k = 0; k < no_workers; k++) {
+      int rc = pthread_create(&threads[k], NULL, solver_worker, &workers[k]);
+      assert(0 == rc);
+    }
+    for (unsigned k = 0; k < no_workers; k++) {
+      int rc = pthread_join(threads[k], NULL);
+      assert(0 == rc);
+    }
+    free(threads);
+  }
 
-      // FIXME annoying -- but necessary in general every time the model is updated?
-      struct TymStmts * reordered_stmts =
-        tym_order_statements((*mdl)->stmts);
-      tym_shallow_free_stmts((*mdl)->stmts);
-      (*mdl)->stmts = reordered_stmts;
+  // The solver gave up if any of the workers' solvers gave up.
+  TymState_LastSolverResult = workers[0].last_result;
+  enum TymReturnCode result = TYM_AOK;
+  for (unsigned k = 0; k < no_workers; k++) {
+    if (TYM_SAT_UNKNOWN == workers[k].last_result) {
+      TymState_LastSolverResult = TYM_SAT_UNKNOWN;
+    }
+    if (workers[k].invalid) {
+      result = TYM_INVALID_INPUT;
+    }
+  }
+  // This is reported once, here, rather than by each worker.
+  if (TYM_INVALID_INPUT == result) {
+    TYM_ERR("The model mentions a predicate that it doesn't declare.\n");
+  }
 
-      tym_reset_buffer(outbuf);
-      res = tym_model_str(*mdl, outbuf); // FIXME ideally make Z3 work incrementally instead of giving it the whole model each time.
-      assert(tym_is_ok_TymBufferWriteResult(res));
-      free(res);
-      tym_z3_assert_smtlib2(tym_buffer_contents(outbuf));
+  for (unsigned k = 0; k < no_workers; k++) {
+    // NOTE the model is no longer rendered after this, so we needn't
+    //      reorder its statements.
+    struct TymStmts * cursor = workers[k].blocking_stmts;
+    while (NULL != cursor) {
+      tym_strengthen_model(*mdl, cursor->stmt);
+      cursor = cursor->next;
+    }
+    if (NULL != workers[k].blocking_stmts) {
+      tym_shallow_free_stmts(workers[k].blocking_stmts);
+    }
+
+    if (NULL != workers[k].cube) {
+      tym_free_fmla(workers[k].cube);
     }
+    tym_free_buffer(workers[k].result_outbuf);
+    tym_mdl_free_valuations(workers[k].vals);
   }
 
-  tym_free_buffer(result_outbuf);
-  tym_mdl_free_valuations(vals);
+  free(workers);
   free(consts);
   free(vars);
-  tym_z3_end();
+  return result;
+}
+
+static bool
+declares_predicate(const struct TymModel * mdl, const TymStr * pred_name)
+{
+  const struct TymStmts * cursor = mdl->stmts;
+  while (NULL != cursor) {
+    if (TYM_STMT_CONST_DEF == cursor->stmt->kind &&
+        tym_eq_str(pred_name, cursor->stmt->param.const_def->const_name)) {
+      return true;
+    }
+    cursor = cursor->next;
+  }
+  return false;
 }
 #endif // TYM_INTERFACE_Z3
 
@@ -311,6 +574,40 @@ process_program(struct TymParams * Params, struct TymProgram * ParsedInputFileCo
     TYM_ERR("Input file (%s) is devoid of clauses.\n", Params->input_file);
     return TYM_INVALID_INPUT;
   }
+  // Only body atoms can be negated.
+  for (size_t i = 0; i < ParsedInputFileContents->no_clauses; i++) {
+    const struct TymAtom * head = ParsedInputFileContents->program[i]->head;
+    if (head->negated) {
+      TYM_ERR("The head of a clause can't be negated: %s\n",
+          tym_decode_str(head->predicate));
+      return TYM_INVALID_INPUT;
+    }
+  }
+
+  // The rewritten program and query replace the originals in evaluation and
+  // translation, but answers are printed using the original query, since it
+  // has the same variables.
+  struct TymProgram * program = ParsedInputFileContents;
+  struct TymProgram * query = ParsedQuery;
+  if (Params->magic && NULL != ParsedQuery &&
+      TYM_CONVERT_TO_C != Params->function) {
+    if (!tym_magic_program(ParsedInputFileContents, ParsedQuery, &program, &query)) {
+      return TYM_INVALID_INPUT;
+    }
+    if (Params->verbosity > 0) {
+      TYM_VERBOSE("magic : %zu clauses\n", program->no_clauses);
+    }
+  }
+
+  if (TYM_EVALUATE == Params->function ||
+      TYM_EVALUATE_TABLED == Params->function) {
+    enum TymReturnCode result = evaluate_program(Params, program, query, ParsedQuery);
+    if (program != ParsedInputFileContents) {
+      tym_free_program(program);
+      tym_free_program(query);
+    }
+    return result;
+  }
 
   struct TymSymGen ** vg = malloc(sizeof *vg);
   *vg = NULL;
@@ -321,15 +618,35 @@ process_program(struct TymParams * Params, struct TymProgram * ParsedInputFileCo
   struct TymModel * mdl = NULL;
   struct TymAtomDatabase * adb = tym_mk_atom_database();
   if (NULL != ParsedInputFileContents) {
-    mdl = tym_translate_program(ParsedInputFileContents, vg, adb);
+    struct TymPool * pool = (Params->translate_threads > 1) ?
+      tym_mk_pool(Params->translate_threads) : NULL;
+    // Planning only pays off when grounding, which decides a body's conjuncts
+    // in order, so otherwise bodies keep the order in which they're written.
+    mdl = tym_translate_program(program, Params->slice ? query : NULL, vg, adb,
+        Params->ground, pool);
+    if (NULL != pool) {
+      tym_free_pool(pool);
+    }
+    // A datatype must have at least one constructor.
+    if (mdl->universe->cardinality > 0) {
+      mdl->universe->encoding = Params->universe_encoding;
+    }
+    mdl->grounded = Params->ground;
     tym_statementise_universe(mdl);
   }
 
   struct TymValuation * varmap = NULL;
-  if (NULL != ParsedQuery &&
+  const struct TymStmts * program_stmts = (NULL == mdl) ? NULL : mdl->stmts;
+  if (NULL != query &&
       // If mdl is NULL then it means that the universe is empty, and there's nothing to be reasoned about.
       NULL != mdl) {
-    varmap = tym_translate_query(ParsedQuery, mdl, cg);
+    varmap = tym_translate_query(query, mdl, cg);
+  }
+  if (NULL != mdl && mdl->grounded) {
+    tym_ground_model(mdl, program_stmts);
+  }
+  if (NULL != mdl) {
+    tym_bound_universe(mdl);
   }
 #if TYM_DEBUG
   else {
@@ -338,14 +655,14 @@ process_program(struct TymParams * Params, struct TymProgram * ParsedInputFileCo
 #endif
 
   struct TymBufferInfo * outbuf = tym_mk_buffer(TYM_BUF_SIZE);
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = NULL;
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res;
+  enum TymReturnCode result = TYM_AOK;
 
   if (TYM_DUMP_HILBERT_UNIVERSE == Params->function) {
     tym_reset_buffer(outbuf);
     res = tym_term_database_dump(adb->tdb, outbuf);
 //    res = tym_term_database_str(adb->tdb, outbuf);
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
     printf("Hilbert universe:\n");
 //    printf("  %s\n", tym_buffer_contents(outbuf));
     tym_reset_read_idx(outbuf);
@@ -356,7 +673,6 @@ process_program(struct TymParams * Params, struct TymProgram * ParsedInputFileCo
     tym_reset_buffer(outbuf);
     res = tym_atom_database_str(adb, outbuf);
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
     printf("Atoms:\n%s", tym_buffer_contents(outbuf));
   } else if (TYM_CONVERT_TO_C == Params->function) {
     emit_c_program(ParsedInputFileContents, ParsedQuery);
@@ -365,7 +681,6 @@ process_program(struct TymParams * Params, struct TymProgram * ParsedInputFileCo
     tym_reset_buffer(outbuf);
     res = tym_model_str(mdl, outbuf);
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
     TYM_DBG_BUFFER(outbuf, "PREmodel")
 #endif
 
@@ -374,17 +689,37 @@ process_program(struct TymParams * Params, struct TymProgram * ParsedInputFileCo
     tym_shallow_free_stmts(mdl->stmts);
     mdl->stmts = reordered_stmts;
 
-    tym_reset_buffer(outbuf);
-    res = tym_model_str(mdl, outbuf);
-    assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
-    TYM_DBG_BUFFER(outbuf, "model")
-
     if (TYM_CONVERT_TO_SMT == Params->function) {
-      printf("%s", tym_buffer_contents(outbuf));
+      // Rather than render the whole model before printing it, we stream it
+      // to stdout as it's rendered.
+      struct TymBufferInfo * sink = tym_mk_sink_buffer(STDOUT_FILENO, TYM_BUF_SIZE);
+      res = tym_model_str(mdl, sink);
+      assert(tym_is_ok_TymBufferWriteResult(res));
+      if (!tym_flush_buffer(sink)) {
+        result = TYM_OUTPUT_ERROR;
+      }
+      tym_free_buffer(sink);
     } else if (TYM_CONVERT_TO_SMT_AND_SOLVE == Params->function) {
+#if TYM_DEBUG
+      tym_reset_buffer(outbuf);
+      res = tym_model_str(mdl, outbuf);
+      assert(tym_is_ok_TymBufferWriteResult(res));
+      TYM_DBG_BUFFER(outbuf, "model")
+#endif
+
 #ifdef TYM_INTERFACE_Z3
-      solver_loop(Params, &mdl, varmap, ParsedQuery, outbuf);
+      // We check the query's predicate once, here, before any solver or
+      // worker thread is made, rather than have each of them discover it.
+      const struct TymAtom * q_head =
+        (NULL == query) ? NULL : query->program[0]->head;
+      if (NULL != q_head && !declares_predicate(mdl, q_head->predicate)) {
+        TYM_ERR("Unknown predicate: %s\n", tym_decode_str(q_head->predicate));
+        result = TYM_INVALID_INPUT;
+      } else {
+        // The model is given to the solver directly, rather than being
+        // rendered in SMT-LIB for the solver to parse.
+        result = solver_loop(Params, &mdl, varmap, ParsedQuery);
+      }
 #else
       assert(0);
 #endif // TYM_INTERFACE_Z3
@@ -408,9 +743,16 @@ process_program(struct TymParams * Params, struct TymProgram * ParsedInputFileCo
 
   tym_free_atom_database(adb);
 
+  if (program != ParsedInputFileContents) {
+    tym_free_program(program);
+    tym_free_program(query);
+  }
+
   // If we used a solver, check if it timed out or gave up,
   // so we can communicate this upwards through the return code.
-  if (TYM_CONVERT_TO_SMT_AND_SOLVE == Params->function &&
+  if (TYM_AOK != result) {
+    return result;
+  } else if (TYM_CONVERT_TO_SMT_AND_SOLVE == Params->function &&
       TYM_SAT_UNKNOWN == TymState_LastSolverResult) {
     return TYM_SOLVER_GAVEUP;
   } else {
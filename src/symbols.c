@@ -21,26 +21,65 @@ along with TYM Datalog.  If not, see <https://www.gnu.org/licenses/>.
 This file: Symbol table.
 */
 
+#include <stdio.h>
+
 #include "buffer_list.h"
 #include "hash.h"
+#include "module_tests.h"
 #include "symbols.h"
 
+static void term_database_grow(struct TymTermDatabase * tdb);
+static void fact_index_add(struct TymFactIndex * idx, const TymStr * key, struct TymClause * fact);
+static void fact_index_free(struct TymFactIndex * idx);
+static void predicate_index_fact(struct TymPredicate * pred, struct TymClause * fact);
+static void predicate_add_body(struct TymPredicate * pred, const struct TymClause * clause);
+
 struct TymTermDatabase *
 tym_mk_term_database(void)
 {
   struct TymTermDatabase * result = malloc(sizeof *result);
   result ->herbrand_universe = NULL;
-  for (int i = 0; i < TYM_TERM_DATABASE_SIZE; i++) {
+  result->no_buckets = TYM_TERM_DATABASE_SIZE;
+  result->no_terms = 0;
+  result->term_database = malloc(sizeof *result->term_database * result->no_buckets);
+  assert(NULL != result->term_database);
+  for (size_t i = 0; i < result->no_buckets; i++) {
     result->term_database[i] = NULL;
   }
   return result;
 }
 
+static void
+term_database_grow(struct TymTermDatabase * tdb)
+{
+  size_t no_buckets = 2 * tdb->no_buckets;
+  struct TymTerms ** term_database = malloc(sizeof *term_database * no_buckets);
+  assert(NULL != term_database);
+  for (size_t i = 0; i < no_buckets; i++) {
+    term_database[i] = NULL;
+  }
+
+  for (size_t i = 0; i < tdb->no_buckets; i++) {
+    struct TymTerms * cursor = tdb->term_database[i];
+    while (NULL != cursor) {
+      struct TymTerms * next = cursor->next;
+      size_t h = (size_t)tym_hash_term(cursor->term) & (no_buckets - 1);
+      cursor->next = term_database[h];
+      term_database[h] = cursor;
+      cursor = next;
+    }
+  }
+
+  free(tdb->term_database);
+  tdb->term_database = term_database;
+  tdb->no_buckets = no_buckets;
+}
+
 bool
 tym_term_database_add(struct TymTerm * term, struct TymTermDatabase * tdb)
 {
   bool exists = false;
-  uint8_t h = tym_hash_term(term);
+  size_t h = (size_t)tym_hash_term(term) & (tdb->no_buckets - 1);
 
   TYM_DBG("Trying adding to Herbrand universe: %s\n", tym_decode_str(term->identifier));
 
@@ -54,17 +93,24 @@ tym_term_database_add(struct TymTerm * term, struct TymTermDatabase * tdb)
     TYM_DBG("Added to Herbrand universe: %s\n", tym_decode_str(term->identifier));
   } else {
     struct TymTerms * cursor = tdb->term_database[h];
-    do {
+    while (true) {
       bool result;
       enum TymEqTermError error_code;
       if (tym_eq_term(term, cursor->term, &error_code, &result)) {
-          exists = result;
+        if (result) {
+          exists = true;
           break;
+        }
       } else {
         printf("Error when comparing terms for equality: %d", error_code);
         assert(false);
       }
-    } while (NULL != cursor->next);
+
+      if (NULL == cursor->next) {
+        break;
+      }
+      cursor = cursor->next;
+    }
 
     if (!exists) {
       cursor->next = tym_mk_term_cell(tym_copy_term(term), NULL);
@@ -73,10 +119,67 @@ tym_term_database_add(struct TymTerm * term, struct TymTermDatabase * tdb)
     }
   }
 
+  if (!exists) {
+    tdb->no_terms++;
+    if (tdb->no_terms > tdb->no_buckets) {
+      term_database_grow(tdb);
+    }
+  }
+
   return exists;
 }
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) *
+bool
+tym_term_database_member(const struct TymTerm * term, const struct TymTermDatabase * tdb)
+{
+  if (TYM_CONST != term->kind) {
+    return false;
+  }
+
+  size_t h = (size_t)tym_hash_term(term) & (tdb->no_buckets - 1);
+  const struct TymTerms * cursor = tdb->term_database[h];
+  while (NULL != cursor) {
+    bool result;
+    enum TymEqTermError error_code;
+    if (tym_eq_term(term, cursor->term, &error_code, &result)) {
+      if (result) {
+        return true;
+      }
+    } else {
+      printf("Error when comparing terms for equality: %d", error_code);
+      assert(false);
+    }
+    cursor = cursor->next;
+  }
+  return false;
+}
+
+void
+tym_free_term_database(struct TymTermDatabase * tdb)
+{
+  for (size_t i = 0; i < tdb->no_buckets; i++) {
+    struct TymTerms * cursor = tdb->term_database[i];
+    while (NULL != cursor) {
+      struct TymTerms * pre_cursor = cursor;
+      cursor = cursor->next;
+      tym_free_term(pre_cursor->term);
+      free(pre_cursor);
+    }
+  }
+  {
+    struct TymTerms * cursor = tdb->herbrand_universe;
+    while (NULL != cursor) {
+      struct TymTerms * pre_cursor = cursor;
+      cursor = cursor->next;
+      tym_free_term(pre_cursor->term);
+      free(pre_cursor);
+    }
+  }
+  free(tdb->term_database);
+  free(tdb);
+}
+
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult)
 tym_term_database_str(struct TymTermDatabase * tdb, struct TymBufferInfo * dst)
 {
   assert(NULL != tdb);
@@ -86,12 +189,11 @@ tym_term_database_str(struct TymTermDatabase * tdb, struct TymBufferInfo * dst)
 
   const struct TymTerms * cursor = tdb->herbrand_universe;
 
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = NULL;
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res;
 
   while (NULL != cursor) {
     res = tym_term_str(cursor->term, dst);
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
 
     tym_safe_buffer_replace_last(dst, '\n');
 
@@ -101,7 +203,7 @@ tym_term_database_str(struct TymTermDatabase * tdb, struct TymBufferInfo * dst)
   return tym_mkval_TymBufferWriteResult(tym_buffer_len(dst) - initial_idx);
 }
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) *
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult)
 tym_term_database_dump(struct TymTermDatabase * tdb, struct TymBufferInfo * dst)
 {
   assert(NULL != tdb);
@@ -111,12 +213,11 @@ tym_term_database_dump(struct TymTermDatabase * tdb, struct TymBufferInfo * dst)
 
   const struct TymTerms * cursor = tdb->herbrand_universe;
 
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = NULL;
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res;
 
   while (NULL != cursor) {
     res = tym_term_str(cursor->term, dst);
     assert(tym_is_ok_TymBufferWriteResult(res));
-    free(res);
 
     cursor = cursor->next;
   }
@@ -125,7 +226,7 @@ tym_term_database_dump(struct TymTermDatabase * tdb, struct TymBufferInfo * dst)
 }
 
 struct TymPredicate *
-tym_mk_pred(const TymStr * predicate, uint8_t arity)
+tym_mk_pred(const TymStr * predicate, size_t arity)
 {
   assert(NULL != predicate);
 
@@ -135,6 +236,11 @@ tym_mk_pred(const TymStr * predicate, uint8_t arity)
   p->predicate = predicate;
   p->arity = arity;
   p->bodies = NULL;
+  p->no_facts = 0;
+  p->no_rules = 0;
+  p->arg_values = calloc(arity + 1, sizeof *p->arg_values);
+  assert(NULL != p->arg_values);
+  p->fact_index = NULL;
   return p;
 }
 
@@ -145,9 +251,124 @@ tym_free_pred(struct TymPredicate * pred)
   if (NULL != pred->bodies) {
     tym_free_clauses(pred->bodies);
   }
+  if (NULL != pred->fact_index) {
+    for (size_t i = 0; i < pred->arity; i++) {
+      fact_index_free(&pred->fact_index[i]);
+    }
+    free(pred->fact_index);
+  }
+  for (size_t i = 0; i < pred->arity; i++) {
+    tym_str_set_free(&pred->arg_values[i]);
+  }
+  free(pred->arg_values);
   free(pred);
 }
 
+// The number of distinct constants that pred's ground facts have at
+// argument position arg.
+size_t
+tym_predicate_distinct(const struct TymPredicate * pred, size_t arg)
+{
+  assert(arg < pred->arity);
+  return pred->arg_values[arg].count;
+}
+
+// Adds a copy of the clause to pred's bodies, and updates pred's statistics
+// and fact index.
+static void
+predicate_add_body(struct TymPredicate * pred, const struct TymClause * clause)
+{
+  pred->bodies = tym_mk_clause_cell(tym_copy_clause(clause), pred->bodies);
+  struct TymClause * copy = pred->bodies->clause;
+  if (!tym_ground_fact(copy)) {
+    pred->no_rules++;
+    return;
+  }
+
+  pred->no_facts++;
+  for (size_t i = 0; i < pred->arity; i++) {
+    // The value is the copy's own string, which lives as long as the copy.
+    uint32_t id;
+    (void)tym_str_set_add(&pred->arg_values[i], copy->head->args[i]->identifier, &id);
+  }
+  if (NULL != pred->fact_index) {
+    predicate_index_fact(pred, copy);
+  }
+}
+
+static void
+fact_index_add(struct TymFactIndex * idx, const TymStr * key, struct TymClause * fact)
+{
+  uint32_t id;
+  if (tym_str_set_add(&idx->keys, key, &id)) {
+    if (idx->capacity < idx->keys.capacity) {
+      idx->capacity = idx->keys.capacity;
+      idx->facts = realloc(idx->facts, sizeof *idx->facts * idx->capacity);
+      assert(NULL != idx->facts);
+    }
+    idx->facts[id] = NULL;
+  }
+  idx->facts[id] = tym_mk_clause_cell(fact, idx->facts[id]);
+}
+
+static void
+fact_index_free(struct TymFactIndex * idx)
+{
+  for (size_t i = 0; i < idx->keys.count; i++) {
+    tym_shallow_free_clauses(idx->facts[i]);
+  }
+  tym_str_set_free(&idx->keys);
+  free(idx->facts);
+}
+
+static void
+predicate_index_fact(struct TymPredicate * pred, struct TymClause * fact)
+{
+  for (size_t i = 0; i < pred->arity; i++) {
+    // The key is the fact's own string, which lives as long as the fact.
+    fact_index_add(&pred->fact_index[i], fact->head->args[i]->identifier, fact);
+  }
+}
+
+// Indexes a predicate's ground facts by each argument position, so that the
+// facts having a given constant at a position can be found without scanning
+// all the bodies. Once made, the index is kept up to date by
+// tym_clause_database_add.
+void
+tym_predicate_index_facts(struct TymPredicate * pred)
+{
+  if (NULL != pred->fact_index) {
+    return;
+  }
+  pred->fact_index = calloc(pred->arity + 1, sizeof *pred->fact_index);
+  assert(NULL != pred->fact_index);
+  // NOTE bodies are held newest-first, so we index them oldest-first to keep
+  //      each list in the same order as the bodies. The reversal is done in
+  //      place, and undone afterwards.
+  struct TymClauses * reversed = tym_reverse_clauses(pred->bodies);
+  for (struct TymClauses * cursor = reversed; NULL != cursor; cursor = cursor->next) {
+    if (tym_ground_fact(cursor->clause)) {
+      predicate_index_fact(pred, cursor->clause);
+    }
+  }
+  pred->bodies = tym_reverse_clauses(reversed);
+}
+
+// The ground facts about pred that have the given constant at argument
+// position arg, in the same order as pred's bodies.
+const struct TymClauses *
+tym_predicate_facts_at(const struct TymPredicate * pred, size_t arg, const TymStr * constant)
+{
+  assert(NULL != pred->fact_index);
+  assert(arg < pred->arity);
+  const struct TymFactIndex * idx = &pred->fact_index[arg];
+  uint32_t id;
+  if (!tym_str_set_lookup(&idx->keys, constant, &id)) {
+    return NULL;
+  }
+  return idx->facts[id];
+}
+
 TYM_DEFINE_MUTABLE_LIST_MK(predicate, pred, struct TymPredicate, struct TymPredicates)
 
 bool
@@ -160,7 +381,7 @@ tym_eq_pred(struct TymPredicate p1, struct TymPredicate p2, enum TymEqPredError
     return true;
   }
 
-  if (0 != tym_cmp_str(p1.predicate, p2.predicate)) {
+  if (!tym_eq_str(p1.predicate, p2.predicate)) {
     *result = false;
     return true;
   } else {
@@ -193,7 +414,7 @@ tym_atom_database_member(const struct TymAtom * atom, struct TymAtomDatabase * a
     success = true;
     *record = NULL;
   } else {
-    uint8_t h = tym_hash_str(tym_decode_str(atom->predicate));
+    size_t h = (size_t)(tym_hash_str(tym_decode_str(atom->predicate)) % TYM_ATOM_DATABASE_SIZE);
 
     if (NULL == adb->atom_database[h]) {
       success = true;
@@ -222,6 +443,7 @@ tym_atom_database_member(const struct TymAtom * atom, struct TymAtomDatabase * a
 
         cursor = cursor->next;
       } while (success && NULL != cursor);
+      tym_free_pred(pred);
     }
   }
 
@@ -229,6 +451,19 @@ tym_atom_database_member(const struct TymAtom * atom, struct TymAtomDatabase * a
   return success;
 }
 
+struct TymPredicate *
+tym_atom_database_find_pred(const TymStr * predicate, struct TymAtomDatabase * adb)
+{
+  assert(NULL != adb);
+  size_t h = (size_t)(tym_hash_str(tym_decode_str(predicate)) % TYM_ATOM_DATABASE_SIZE);
+  for (struct TymPredicates * cursor = adb->atom_database[h]; NULL != cursor; cursor = cursor->next) {
+    if (tym_eq_str(predicate, cursor->predicate->predicate)) {
+      return cursor->predicate;
+    }
+  }
+  return NULL;
+}
+
 bool
 tym_atom_database_add(const struct TymAtom * atom, struct TymAtomDatabase * adb, enum TymAdlAddError * error_code, struct TymPredicate ** result)
 {
@@ -238,7 +473,7 @@ tym_atom_database_add(const struct TymAtom * atom, struct TymAtomDatabase * adb,
     *error_code = TYM_NO_ATOM_DATABASE;
     success = false;
   } else {
-    uint8_t h = tym_hash_str(tym_decode_str(atom->predicate));
+    size_t h = (size_t)(tym_hash_str(tym_decode_str(atom->predicate)) % TYM_ATOM_DATABASE_SIZE);
 
     struct TymPredicate * pred =
       tym_mk_pred(TYM_STR_DUPLICATE(atom->predicate), atom->arity);
@@ -252,9 +487,13 @@ tym_atom_database_add(const struct TymAtom * atom, struct TymAtomDatabase * adb,
         enum TymEqPredError eq_pred_error_code;
         bool eq_pred_result;
         if (tym_eq_pred(*pred, *cursor->predicate, &eq_pred_error_code, &eq_pred_result)) {
-          tym_free_pred(pred);
-          pred = cursor->predicate;
-          exists = true;
+          // Predicates whose names share a bucket are kept apart.
+          if (eq_pred_result) {
+            tym_free_pred(pred);
+            pred = cursor->predicate;
+            exists = true;
+            break;
+          }
         } else {
           printf("Error when comparing terms for equality: %d", eq_pred_error_code);
           assert(false);
@@ -269,10 +508,10 @@ tym_atom_database_add(const struct TymAtom * atom, struct TymAtomDatabase * adb,
     *result = pred;
     success = true;
 
-    TYM_DBG("Added atom: %s{hash=%u}\n", tym_decode_str(atom->predicate), h);
+    TYM_DBG("Added atom: %s{hash=%zu}\n", tym_decode_str(atom->predicate), h);
 
     assert(NULL != adb->tdb);
-    for (int i = 0; i < atom->arity; i++) {
+    for (size_t i = 0; i < atom->arity; i++) {
       // NOTE we don't need to check return value here, since it simply
       //      indicates whether ther term already existed or not in the term
       //      database.
@@ -283,28 +522,25 @@ tym_atom_database_add(const struct TymAtom * atom, struct TymAtomDatabase * adb,
   return success;
 }
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) *
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult)
 tym_atom_database_str(struct TymAtomDatabase * adb, struct TymBufferInfo * dst)
 {
   assert(NULL != adb);
 
   size_t initial_idx = tym_buffer_len(dst);
 
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = tym_buf_strcpy(dst, "Terms:");
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res = tym_buf_strcpy(dst, "Terms:");
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
 
   tym_safe_buffer_replace_last(dst, '\n');
 
   res = tym_term_database_str(adb->tdb, dst);
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
 
   tym_safe_buffer_replace_last(dst, '\n');
 
   res = tym_buf_strcpy(dst, "Predicates:");
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
 
   tym_safe_buffer_replace_last(dst, '\n');
 
@@ -315,7 +551,6 @@ tym_atom_database_str(struct TymAtomDatabase * adb, struct TymBufferInfo * dst)
     while (NULL != cursor) {
       res = tym_predicate_str(cursor->predicate, dst);
       assert(tym_is_ok_TymBufferWriteResult(res));
-      free(res);
 
       tym_safe_buffer_replace_last(dst, '\n');
 
@@ -332,7 +567,6 @@ tym_atom_database_str(struct TymAtomDatabase * adb, struct TymBufferInfo * dst)
 
         res = tym_clause_str(clause_cursor->clause, dst);
         assert(tym_is_ok_TymBufferWriteResult(res));
-        free(res);
 
         tym_safe_buffer_replace_last(dst, '\n');
 
@@ -348,24 +582,22 @@ tym_atom_database_str(struct TymAtomDatabase * adb, struct TymBufferInfo * dst)
   return tym_mkval_TymBufferWriteResult(tym_buffer_len(dst) - initial_idx);
 }
 
-struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) *
+struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult)
 tym_predicate_str(const struct TymPredicate * pred, struct TymBufferInfo * dst)
 {
   size_t initial_idx = tym_buffer_len(dst);
 
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = tym_buf_strcpy(dst, tym_decode_str(pred->predicate));
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res = tym_buf_strcpy(dst, tym_decode_str(pred->predicate));
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
 
   tym_safe_buffer_replace_last(dst, '/');
 
-  char buf[TYM_BUF_SIZE];
-  int check = sprintf(buf, "%u", pred->arity);
+  char buf[32]; // Large enough to hold any size_t in decimal.
+  int check = sprintf(buf, "%zu", pred->arity);
   assert(check > 0);
 
   res = tym_buf_strcpy(dst, buf);
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
 
   return tym_mkval_TymBufferWriteResult(tym_buffer_len(dst) - initial_idx);
 }
@@ -416,7 +648,7 @@ tym_clause_database_add(struct TymClause * clause, struct TymAtomDatabase * adb,
   } else if (NULL == record) {
     struct TymPredicate * result;
     success = tym_atom_database_add(clause->head, adb, &adl_add_error, &result);
-    result->bodies = tym_mk_clause_cell(tym_copy_clause(clause), NULL);
+    predicate_add_body(result, clause);
     if (!success) {
       assert(TYM_NO_ATOM_DATABASE == adl_add_error);
       *cdl_add_error = TYM_CDL_ADL_NO_ATOM_DATABASE;
@@ -426,19 +658,18 @@ tym_clause_database_add(struct TymClause * clause, struct TymAtomDatabase * adb,
     }
   } else if (success && NULL != record) {
     assert(NULL != adb->tdb);
-    for (int i = 0; i < clause->head->arity; i++) {
+    for (size_t i = 0; i < clause->head->arity; i++) {
       // NOTE we don't need to check return value here, since it simply
       //      indicates whether ther term already existed or not in the term
       //      database.
       (void)tym_term_database_add(clause->head->args[i], adb->tdb);
     }
 
-    struct TymClauses * remainder = record->bodies;
-    record->bodies = tym_mk_clause_cell(tym_copy_clause(clause), remainder);
+    predicate_add_body(record, clause);
   }
 
   if (success) {
-    for (int i = 0; success && i < clause->body_size; i++) {
+    for (size_t i = 0; success && i < clause->body_size; i++) {
       success &= tym_atom_database_member(clause->body[i], adb, &adl_lookup_error, &record);
       if (!success) {
         assert(TYM_DIFF_ARITY == adl_lookup_error);
@@ -478,25 +709,7 @@ tym_num_predicate_bodies (struct TymPredicate * p)
 void
 tym_free_atom_database(struct TymAtomDatabase * adb)
 {
-  for (int i = 0; i < TYM_TERM_DATABASE_SIZE; i++) {
-    struct TymTerms * cursor = adb->tdb->term_database[i];
-    while (NULL != cursor) {
-      struct TymTerms * pre_cursor = cursor;
-      cursor = cursor->next;
-      tym_free_term(pre_cursor->term);
-      free(pre_cursor);
-    }
-  }
-  {
-    struct TymTerms * cursor = adb->tdb->herbrand_universe;
-    while (NULL != cursor) {
-      struct TymTerms * pre_cursor = cursor;
-      cursor = cursor->next;
-      tym_free_term(pre_cursor->term);
-      free(pre_cursor);
-    }
-  }
-  free(adb->tdb);
+  tym_free_term_database(adb->tdb);
 
   for (int i = 0; i < TYM_ATOM_DATABASE_SIZE; i++) {
     struct TymPredicates * cursor = adb->atom_database[i];
@@ -510,3 +723,45 @@ tym_free_atom_database(struct TymAtomDatabase * adb)
 
   free(adb);
 }
+
+void
+tym_test_symbols(void)
+{
+  printf("***test_symbols***\n");
+  // Find a predicate whose name shares p's bucket in the atom database.
+  size_t bucket = (size_t)(tym_hash_str("p") % TYM_ATOM_DATABASE_SIZE);
+  char other[32];
+  for (unsigned i = 0; ; i++) {
+    snprintf(other, sizeof other, "p%u", i);
+    if (bucket == (size_t)(tym_hash_str(other) % TYM_ATOM_DATABASE_SIZE)) {
+      break;
+    }
+  }
+
+  // The two predicates are kept apart, and adding either one again finds it.
+  struct TymAtom * atoms[] = {
+    tym_test_atom("p", 1, "a"),
+    tym_test_atom(other, 1, "b"),
+    tym_test_atom("p", 1, "c"),
+    tym_test_atom(other, 1, "d"),
+  };
+  struct TymPredicate * preds[4];
+  struct TymAtomDatabase * adb = tym_mk_atom_database();
+  for (size_t i = 0; i < 4; i++) {
+    enum TymAdlAddError error_code;
+    bool success = tym_atom_database_add(atoms[i], adb, &error_code, &preds[i]);
+    assert(success);
+  }
+  assert(preds[0] != preds[1]);
+  assert(preds[0] == preds[2]);
+  assert(preds[1] == preds[3]);
+  assert(tym_eq_str(atoms[0]->predicate, preds[0]->predicate));
+  assert(tym_eq_str(atoms[1]->predicate, preds[1]->predicate));
+  assert(preds[0] == tym_atom_database_find_pred(atoms[0]->predicate, adb));
+  assert(preds[1] == tym_atom_database_find_pred(atoms[1]->predicate, adb));
+
+  for (size_t i = 0; i < 4; i++) {
+    tym_free_atom(atoms[i]);
+  }
+  tym_free_atom_database(adb);
+}
@@ -21,8 +21,81 @@ along with TYM Datalog.  If not, see <https://www.gnu.org/licenses/>.
 This file: Translation between clause representations.
 */
 
+#include "hash.h"
+#include "module_tests.h"
+#include "plan.h"
 #include "translate.h"
 
+// A ground atom whose truth value is fixed by the (grounded) axioms.
+struct TymGroundAtom {
+  const struct TymFmlaAtom * atom;
+  bool value;
+};
+
+// The universe's elements, hashed so that we can tell whether a constant is an
+// element, and the ground atoms whose values we know. Used while grounding
+// (see tym_ground_model).
+struct TymGrounder {
+  const struct TymUniverse * uni;
+  const TymStr ** elements; // Open addressing: NULL marks an empty slot.
+  size_t no_slots;
+  struct TymGroundAtom * atoms; // Open addressing: NULL atom marks an empty slot.
+  size_t no_atom_slots;
+  size_t no_atoms;
+};
+
+// The predicates in a query's cone of influence: those on which the query's
+// atoms depend, directly or through the bodies of clauses. Used while slicing
+// the program (see tym_translate_program).
+struct TymCone {
+  struct TymStrSet names; // The predicates' names.
+  bool * used; // Indexed by name: whether the named predicate appears in the body of a clause in the cone.
+  const struct TymPredicate ** pending; // Predicates whose bodies are yet to be explored.
+  size_t no_pending;
+};
+
+// The statements that characterise a predicate's provability (see
+// translate_predicate).
+struct TymPredTranslation {
+  const struct TymPredicate * predicate;
+  // The statistics that the bodies are planned from, or NULL to translate
+  // them in the clauses' order.
+  struct TymAtomDatabase * adb;
+  // Names the predicate's variables, from the index that follows the
+  // variables of the predicates translated before it.
+  struct TymSymGen * vg;
+  struct TymStmt * pred;
+  struct TymStmt * def;
+};
+
+static bool cone_member(const struct TymCone * cone, const struct TymPredicate * pred);
+static void cone_add_atom(struct TymCone * cone, const struct TymAtom * atom, struct TymAtomDatabase * adb, bool in_body);
+static struct TymCone * mk_cone(const struct TymProgram * query, struct TymAtomDatabase * adb, size_t no_preds);
+static void free_cone(struct TymCone * cone);
+static bool query_atom_narrows(const struct TymAtom * atom, const struct TymPredicate * pred);
+static struct TymPredicate * narrow_facts(const struct TymCone * cone, struct TymPredicate * pred, const struct TymProgram * query);
+static void free_narrowed(struct TymPredicate * pred, struct TymAtomDatabase * adb);
+static struct TymPredicates * slice_predicates(const struct TymCone * cone, struct TymPredicates * preds, const struct TymProgram * query);
+static void add_atom_consts(const struct TymAtom * atom, struct TymTermDatabase * tdb);
+static struct TymUniverse * slice_universe(const struct TymPredicates * preds, const struct TymProgram * query, struct TymAtomDatabase * adb);
+static void translate_predicate(void * arg);
+static bool is_element(const struct TymGrounder * g, const TymStr * s);
+static bool is_builtin(const struct TymFmlaAtom * atom);
+static TYM_HASH_VTYPE hash_atom(const struct TymFmlaAtom * atom);
+static bool eq_atom(const struct TymFmlaAtom * a1, const struct TymFmlaAtom * a2);
+static struct TymGroundAtom * find_atom(const struct TymGrounder * g, const struct TymFmlaAtom * atom);
+static void record_atom(struct TymGrounder * g, const struct TymFmlaAtom * atom, bool value);
+static void record_units(struct TymGrounder * g, const struct TymFmla * fmla);
+static bool mentions(const struct TymFmla * fmla, const TymStr * name);
+static struct TymFmla * fold_not(struct TymFmla * sub);
+static struct TymFmla * fold_implication(enum TymFmlaKind kind, struct TymFmla * l, struct TymFmla * r);
+static struct TymFmla * fold_atom(const struct TymGrounder * g, struct TymFmla * fmla);
+static const TymStr * one_point(const struct TymFmla * body, const TymStr * bv);
+static struct TymFmla * instantiate_fmla(const struct TymGrounder * g, const struct TymFmla * fmla, const TymStr * var, const TymStr * val);
+static struct TymFmla * ground_fmla(const struct TymGrounder * g, const struct TymFmla * fmla);
+static struct TymFmla * ground_consts(const struct TymGrounder * g, const struct TymFmla * fmla, const TymStr ** consts, size_t no_consts);
+static bool test_folded(const struct TymFmla * fmla, const char * predicate);
+
 struct TymFmla *
 tym_translate_atom(const struct TymAtom * at)
 {
@@ -30,47 +103,88 @@ tym_translate_atom(const struct TymAtom * at)
   struct TymTerm ** args = NULL;
   if (at->arity > 0) {
     args = malloc(sizeof *args * at->arity);
-    for (int i = 0; i < at->arity; i++) {
+    for (size_t i = 0; i < at->arity; i++) {
       args[i] = tym_copy_term(at->args[i]);
     }
   }
-  return tym_mk_fmla_atom(TYM_STR_DUPLICATE(at->predicate), at->arity, args);
+  struct TymFmla * result = tym_mk_fmla_atom(TYM_STR_DUPLICATE(at->predicate), at->arity, args);
+  return at->negated ? tym_mk_fmla_not(result) : result;
 }
 
+// Translates a clause's body, taking its atoms in the given order (see
+// tym_plan_body), or in the clause's order if "order" is NULL. Grounding
+// decides the conjunct of order[0] first, and expands the existential
+// quantifiers of the variables that are bound earlier in the order before
+// those of the variables that are bound later.
 struct TymFmla *
-tym_translate_body(const struct TymClause * cl)
+tym_translate_body(const struct TymClause * cl, const size_t * order)
 {
   struct TymFmlas * fmlas = NULL;
   struct TymTerms * hidden_vars = tym_hidden_vars_of_clause(cl);
-  for (int i = 0; i < cl->body_size; i++) {
-    fmlas = tym_mk_fmla_cell(tym_translate_atom(cl->body[i]), fmlas);
+  for (size_t i = 0; i < cl->body_size; i++) {
+    size_t k = (NULL == order) ? i : order[i];
+    fmlas = tym_mk_fmla_cell(tym_translate_atom(cl->body[k]), fmlas);
+  }
+
+  // Order the hidden variables by the position (in "order") of the first atom
+  // that binds them, keeping the clause's order among ties.
+  size_t no_hidden = 0;
+  for (const struct TymTerms * cursor = hidden_vars; NULL != cursor; cursor = cursor->next) {
+    no_hidden++;
+  }
+  const TymStr * vars[no_hidden + 1];
+  size_t ranks[no_hidden + 1];
+  size_t n = 0;
+  for (const struct TymTerms * cursor = hidden_vars; NULL != cursor; cursor = cursor->next) {
+    size_t rank = 0;
+    bool found = false;
+    for (; !found && rank < cl->body_size; rank++) {
+      const struct TymAtom * atom = cl->body[(NULL == order) ? rank : order[rank]];
+      for (size_t j = 0; !found && j < atom->arity; j++) {
+        found = (TYM_VAR == atom->args[j]->kind &&
+            tym_eq_str(atom->args[j]->identifier, cursor->term->identifier));
+      }
+    }
+    size_t i = n++;
+    while (i > 0 && ranks[i - 1] > rank) {
+      vars[i] = vars[i - 1];
+      ranks[i] = ranks[i - 1];
+      i--;
+    }
+    vars[i] = cursor->term->identifier;
+    ranks[i] = rank;
   }
 
+  // The first variable ends up outermost.
   struct TymFmla * result = tym_mk_fmla_ands(fmlas);
-  struct TymTerms * cursor = hidden_vars;
-  while (NULL != cursor) {
-    result = tym_mk_fmla_quant(FMLA_EX, TYM_STR_DUPLICATE(cursor->term->identifier), result);
-    cursor = cursor->next;
+  for (size_t i = no_hidden; i > 0; i--) {
+    result = tym_mk_fmla_quant(FMLA_EX, TYM_STR_DUPLICATE(vars[i - 1]), result);
   }
   tym_shallow_free_terms(hidden_vars);
 
   return result;
 }
 
+// Translates the bodies of clauses, each with its atoms in the order planned
+// from adb's statistics, or in the clause's order if adb is NULL.
 struct TymFmlas *
-tym_translate_bodies(const struct TymClauses * cls)
+tym_translate_bodies(const struct TymClauses * cls, struct TymAtomDatabase * adb)
 {
   const struct TymClauses * cursor = cls;
   struct TymFmlas * result = NULL;
   struct TymFmlas * result_end = NULL;
   while (NULL != cursor) {
-    if (NULL == result && NULL == result_end) {
-      result = tym_mk_fmla_cell(tym_translate_body(cursor->clause), NULL);
-      result_end = result;
+    size_t order[cursor->clause->body_size + 1];
+    if (NULL != adb) {
+      tym_plan_body(cursor->clause, adb, order);
+    }
+    struct TymFmlas * cell = tym_mk_fmla_cell(tym_translate_body(cursor->clause, (NULL == adb) ? NULL : order), NULL);
+    if (NULL == result) {
+      result = cell;
     } else {
-      result_end->next = tym_mk_fmla_cell(tym_translate_body(cursor->clause), NULL);
-      result_end = result_end->next;
+      result_end->next = cell;
     }
+    result_end = cell;
     cursor = cursor->next;
   }
   return result;
@@ -96,7 +210,7 @@ tym_translate_query_fmla_atom(struct TymModel * mdl, struct TymSymGen * cg, stru
   struct TymTerm ** args = NULL;
   if (at->arity > 0) {
     args = malloc(sizeof *args * at->arity);
-    for (int i = 0; i < at->arity; i++) {
+    for (size_t i = 0; i < at->arity; i++) {
       if (TYM_VAR == at->predargs[i]->kind) {
         const TymStr * placeholder = tym_mk_new_var(cg);
         args[i] = tym_mk_term(TYM_CONST, placeholder);
@@ -143,7 +257,9 @@ tym_translate_query_fmla(struct TymModel * mdl, struct TymSymGen * cg, struct Ty
     assert(false); // Disjunctions cannot appear in queries at the moment.
     break;
   case FMLA_NOT:
-    assert(false); // Negations cannot appear in queries at the moment.
+    // A negated query's answers are the values of its variables for which
+    // the atom doesn't hold.
+    tym_translate_query_fmla(mdl, cg, fmla->param.args[0], varmap);
     break;
   case FMLA_EX:
     assert(false); // Existential quantifier cannot appear in queries.
@@ -157,7 +273,7 @@ tym_translate_query_fmla(struct TymModel * mdl, struct TymSymGen * cg, struct Ty
 struct TymValuation *
 tym_translate_query(struct TymProgram * query, struct TymModel * mdl, struct TymSymGen * cg)
 {
-  TYM_DBG("|query|=%d\n", query->no_clauses);
+  TYM_DBG("|query|=%zu\n", query->no_clauses);
   // NOTE we expect a query to contain exactly one clause.
   assert(1 == query->no_clauses);
   const struct TymClause * q_cl = query->program[0];
@@ -166,20 +282,24 @@ tym_translate_query(struct TymProgram * query, struct TymModel * mdl, struct Tym
 
 #if TYM_DEBUG
   struct TymBufferInfo * outbuf = tym_mk_buffer(TYM_BUF_SIZE);
-  struct TymLiftedTymBufferWriteResult * res = tym_fmla_str(q_fmla, outbuf);
+  struct TymLiftedTymBufferWriteResult res = tym_fmla_str(q_fmla, outbuf);
   assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
   TYM_DBG_BUFFER(outbuf, "q_fmla")
   tym_free_buffer(outbuf);
 #endif
 
   // Reject the query if it containts constants that don't appear in the program.
-  struct TymTerms * cursor = tym_consts_in_fmla(q_fmla, NULL, false);
+  // NOTE a negated query's constants are looked for in its atom, since
+  //      tym_consts_in_fmla includes the predicate constants of atoms under a
+  //      negation.
+  const struct TymFmla * q_atom_fmla = (FMLA_NOT == q_fmla->kind) ?
+    q_fmla->param.args[0] : q_fmla;
+  struct TymTerms * cursor = tym_consts_in_fmla(q_atom_fmla, NULL, false);
   while (NULL != cursor) {
     if (TYM_CONST == cursor->term->kind) {
       bool found = false;
-      for (int i = 0; i < mdl->universe->cardinality; i++) { // FIXME linear-time lookup
-        if (0 == tym_cmp_str(cursor->term->identifier, mdl->universe->element[i])) {
+      for (size_t i = 0; i < mdl->universe->cardinality; i++) { // FIXME linear-time lookup
+        if (tym_eq_str(cursor->term->identifier, mdl->universe->element[i])) {
           found = true;
           break;
         }
@@ -202,191 +322,519 @@ tym_translate_query(struct TymProgram * query, struct TymModel * mdl, struct Tym
   return varmap;
 }
 
-struct TymModel *
-tym_translate_program(struct TymProgram * program, struct TymSymGen ** vg, struct TymAtomDatabase * adb)
+static bool
+cone_member(const struct TymCone * cone, const struct TymPredicate * pred)
 {
-  for (int i = 0; i < program->no_clauses; i++) {
-    (void)tym_clause_database_add(program->program[i], adb, NULL);
+  uint32_t id;
+  return tym_str_set_lookup(&cone->names, pred->predicate, &id);
+}
+
+static void
+cone_add_atom(struct TymCone * cone, const struct TymAtom * atom, struct TymAtomDatabase * adb, bool in_body)
+{
+  // We look the predicate up by name alone, so that if the atom's arity
+  // differs from the predicate's then the solver reports the mismatch as it
+  // would for the whole program.
+  struct TymPredicate * record = tym_atom_database_find_pred(atom->predicate, adb);
+  // An atom whose predicate isn't in the database (e.g., a query about an
+  // unknown predicate) contributes nothing to the cone.
+  if (NULL == record) {
+    return;
   }
-  struct TymBufferInfo * outbuf = tym_mk_buffer(TYM_BUF_SIZE);
-  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) * res = tym_atom_database_str(adb, outbuf);
-  assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
-  TYM_DBG_BUFFER(outbuf, "clause database")
 
+  uint32_t id;
+  bool added = tym_str_set_add(&cone->names, record->predicate, &id);
+  cone->used[id] |= in_body;
+  if (added) {
+    cone->pending[cone->no_pending++] = record;
+  }
+}
 
-  // 1. Generate prologue: universe sort, and its inhabitants.
-  struct TymModel * mdl = tym_mk_model(tym_mk_universe(adb->tdb->herbrand_universe));
+static struct TymCone *
+mk_cone(const struct TymProgram * query, struct TymAtomDatabase * adb, size_t no_preds)
+{
+  struct TymCone * cone = malloc(sizeof *cone);
+  tym_str_set_init(&cone->names);
+  cone->used = calloc(no_preds + 1, sizeof *cone->used);
+  cone->pending = malloc(sizeof *cone->pending * (no_preds + 1));
+  cone->no_pending = 0;
 
-#if TYM_DEBUG
-  tym_reset_buffer(outbuf);
-  res = tym_model_str(mdl, outbuf);
-  assert(tym_is_ok_TymBufferWriteResult(res));
-  free(res);
-  TYM_DBG_BUFFER(outbuf, "model")
-#endif
+  for (size_t i = 0; i < query->no_clauses; i++) {
+    const struct TymClause * cl = query->program[i];
+    cone_add_atom(cone, cl->head, adb, false);
+    for (size_t j = 0; j < cl->body_size; j++) {
+      cone_add_atom(cone, cl->body[j], adb, false);
+    }
+  }
 
+  // Follow the dependency graph: a predicate depends on those that appear in
+  // the bodies of its clauses.
+  while (cone->no_pending > 0) {
+    const struct TymPredicate * pred = cone->pending[--cone->no_pending];
+    const struct TymClauses * cursor = pred->bodies;
+    while (NULL != cursor) {
+      for (size_t j = 0; j < cursor->clause->body_size; j++) {
+        cone_add_atom(cone, cursor->clause->body[j], adb, true);
+      }
+      cursor = cursor->next;
+    }
+  }
 
-  // 2. Add axiom characterising the provability of all elements of the Hilbert base.
-  struct TymPredicates * preds_cursor = tym_atom_database_to_predicates(adb);
-  while (NULL != preds_cursor) {
-    TYM_DBG("no_bodies = %zu\n", tym_num_predicate_bodies(preds_cursor->predicate));
+  return cone;
+}
 
-    struct TymFmlas * fmlas = (struct TymFmlas *)tym_translate_bodies(preds_cursor->predicate->bodies);
-#if TYM_DEBUG
-    tym_reset_buffer(outbuf);
-    struct TymFmlas * fmlas_c = fmlas;
-    while (NULL != fmlas_c) {
-      res = tym_fmla_str(fmlas_c->fmla, outbuf);
-      assert(tym_is_ok_TymBufferWriteResult(res));
-      free(res);
-      fmlas_c = fmlas_c->next;
-    }
-    TYM_DBG_BUFFER_PRINT(outbuf, ">-")
-#endif
+static void
+free_cone(struct TymCone * cone)
+{
+  tym_str_set_free(&cone->names);
+  free(cone->used);
+  free(cone->pending);
+  free(cone);
+}
 
-    struct TymFmlas * fmlas_cursor = fmlas;
+// Whether a query atom about pred lets us narrow pred's facts: it must have
+// pred's arity, and a constant argument.
+static bool
+query_atom_narrows(const struct TymAtom * atom, const struct TymPredicate * pred)
+{
+  if (atom->arity != pred->arity) {
+    return false;
+  }
+  for (size_t i = 0; i < atom->arity; i++) {
+    if (TYM_CONST == atom->args[i]->kind) {
+      return true;
+    }
+  }
+  return false;
+}
 
-    if (NULL == preds_cursor->predicate->bodies) {
-      // "No bodies" means that the atom never appears as the head of a clause.
+// If pred consists of ground facts, and is only used by the query, then only
+// the facts that match the query's atoms about pred can affect the query's
+// answers. We find these through pred's fact index, and return them as a new
+// predicate, whose bodies are shared with pred. Otherwise we return NULL.
+static struct TymPredicate *
+narrow_facts(const struct TymCone * cone, struct TymPredicate * pred, const struct TymProgram * query)
+{
+  uint32_t id;
+  bool member = tym_str_set_lookup(&cone->names, pred->predicate, &id);
+  assert(member);
+  if (0 == pred->no_facts || pred->no_facts != tym_num_predicate_bodies(pred) ||
+      cone->used[id]) {
+    return NULL;
+  }
 
-      struct TymTerm ** var_args = NULL;
+  size_t no_atoms = 0;
+  for (size_t i = 0; i < query->no_clauses; i++) {
+    const struct TymClause * cl = query->program[i];
+    for (size_t j = 0; j <= cl->body_size; j++) {
+      const struct TymAtom * atom = (0 == j) ? cl->head : cl->body[j - 1];
+      if (tym_eq_str(atom->predicate, pred->predicate)) {
+        if (!query_atom_narrows(atom, pred)) {
+          return NULL;
+        }
+        no_atoms++;
+      }
+    }
+  }
+  assert(no_atoms > 0);
 
-      if (preds_cursor->predicate->arity > 0) {
-        var_args = malloc(sizeof *var_args * preds_cursor->predicate->arity);
+  tym_predicate_index_facts(pred);
+  struct TymPredicate * result = tym_mk_pred(TYM_STR_DUPLICATE(pred->predicate), pred->arity);
+  struct TymClauses * result_end = NULL;
+  for (size_t i = 0; i < query->no_clauses; i++) {
+    const struct TymClause * cl = query->program[i];
+    for (size_t j = 0; j <= cl->body_size; j++) {
+      const struct TymAtom * atom = (0 == j) ? cl->head : cl->body[j - 1];
+      if (!tym_eq_str(atom->predicate, pred->predicate)) {
+        continue;
+      }
 
-        for (int i = 0; i < preds_cursor->predicate->arity; i++) {
-          var_args[i] = tym_mk_term(TYM_VAR, tym_mk_new_var(*vg));
+      // Probe the index at the atom's first constant, then check the others.
+      size_t arg = 0;
+      while (TYM_CONST != atom->args[arg]->kind) {
+        arg++;
+      }
+      const struct TymClauses * cursor =
+        tym_predicate_facts_at(pred, arg, atom->args[arg]->identifier);
+      for (; NULL != cursor; cursor = cursor->next) {
+        const struct TymAtom * fact = cursor->clause->head;
+        bool matches = true;
+        for (size_t k = arg + 1; matches && k < atom->arity; k++) {
+          matches = TYM_VAR == atom->args[k]->kind ||
+            tym_eq_str(atom->args[k]->identifier, fact->args[k]->identifier);
+        }
+        // FIXME linear-time check for duplicates, but queries tend to have
+        //       few atoms, and so few matching facts.
+        for (const struct TymClauses * kept = result->bodies; matches && NULL != kept; kept = kept->next) {
+          matches = (kept->clause != cursor->clause);
+        }
+        if (matches) {
+          struct TymClauses * cell = tym_mk_clause_cell(cursor->clause, NULL);
+          if (NULL == result_end) {
+            result->bodies = cell;
+          } else {
+            result_end->next = cell;
+          }
+          result_end = cell;
+          result->no_facts++;
         }
       }
+    }
+  }
+  return result;
+}
 
-      struct TymFmla * atom =
-        tym_mk_fmla_atom(TYM_STR_DUPLICATE(preds_cursor->predicate->predicate),
-          preds_cursor->predicate->arity, var_args);
+// Frees a predicate if it was made by narrow_facts, rather than belonging to
+// the atom database.
+static void
+free_narrowed(struct TymPredicate * pred, struct TymAtomDatabase * adb)
+{
+  if (pred == tym_atom_database_find_pred(pred->predicate, adb)) {
+    return;
+  }
+  tym_shallow_free_clauses(pred->bodies);
+  pred->bodies = NULL;
+  tym_free_pred(pred);
+}
 
-      res = tym_fmla_str(atom, outbuf);
-      assert(tym_is_ok_TymBufferWriteResult(res));
-      free(res);
-      TYM_DBG_BUFFER_PRINT(outbuf, "bodyless")
-
-      struct TymStmt * pred =
-        tym_mk_stmt_pred(TYM_STR_DUPLICATE(preds_cursor->predicate->predicate),
-            tym_arguments_of_atom(tym_fmla_as_atom(atom)),
-            tym_mk_fmla_const(false));
-      struct TymStmt * def = tym_split_stmt_pred(pred);
-      tym_strengthen_model(mdl, pred);
-      tym_strengthen_model(mdl, def);
-
-      tym_free_fmla(atom);
+static struct TymPredicates *
+slice_predicates(const struct TymCone * cone, struct TymPredicates * preds, const struct TymProgram * query)
+{
+  struct TymPredicates * result = NULL;
+  struct TymPredicates * result_end = NULL;
+  while (NULL != preds) {
+    struct TymPredicates * next = preds->next;
+    if (cone_member(cone, preds->predicate)) {
+      struct TymPredicate * narrowed = narrow_facts(cone, preds->predicate, query);
+      if (NULL != narrowed) {
+        preds->predicate = narrowed;
+      }
+      preds->next = NULL;
+      if (NULL == result) {
+        result = preds;
+      } else {
+        result_end->next = preds;
+      }
+      result_end = preds;
     } else {
-      const struct TymClauses * body_cursor = preds_cursor->predicate->bodies;
-      const struct TymFmla * abs_head_fmla = NULL;
+      free(preds);
+    }
+    preds = next;
+  }
+  return result;
+}
+
+static void
+add_atom_consts(const struct TymAtom * atom, struct TymTermDatabase * tdb)
+{
+  for (size_t i = 0; i < atom->arity; i++) {
+    (void)tym_term_database_add(atom->args[i], tdb);
+  }
+}
 
-      while (NULL != body_cursor) {
-        TYM_DBG(">");
+// Restricts the Herbrand universe to the constants that the sliced program's
+// clauses and the query mention. If a clause isn't range-restricted then its
+// head's unbound variables range over the whole universe, so we keep it all.
+static struct TymUniverse *
+slice_universe(const struct TymPredicates * preds, const struct TymProgram * query, struct TymAtomDatabase * adb)
+{
+  struct TymTermDatabase * tdb = tym_mk_term_database();
+  bool restricted = true;
+  for (const struct TymPredicates * preds_cursor = preds; restricted && NULL != preds_cursor; preds_cursor = preds_cursor->next) {
+    const struct TymClauses * cursor = preds_cursor->predicate->bodies;
+    while (restricted && NULL != cursor) {
+      restricted = tym_range_restricted(cursor->clause);
+      add_atom_consts(cursor->clause->head, tdb);
+      for (size_t j = 0; j < cursor->clause->body_size; j++) {
+        add_atom_consts(cursor->clause->body[j], tdb);
+      }
+      cursor = cursor->next;
+    }
+  }
 
-        struct TymSymGen * vg_copy = tym_copy_sym_gen(*vg);
+  // A negated query's variables range over the whole universe too.
+  for (size_t i = 0; restricted && i < query->no_clauses; i++) {
+    restricted = !tym_has_negation(query->program[i]);
+  }
 
-        const struct TymAtom * head_atom = body_cursor->clause->head;
-        struct TymTerm ** args = NULL;
+  if (!restricted) {
+    tym_free_term_database(tdb);
+    return tym_mk_universe(adb->tdb->herbrand_universe);
+  }
 
-        if (head_atom->arity > 0) {
-          args = malloc(sizeof *args * head_atom->arity);
+  for (size_t i = 0; i < query->no_clauses; i++) {
+    add_atom_consts(query->program[i]->head, tdb);
+    for (size_t j = 0; j < query->program[i]->body_size; j++) {
+      add_atom_consts(query->program[i]->body[j], tdb);
+    }
+  }
 
-          for (int i = 0; i < head_atom->arity; i++) {
-            args[i] = tym_copy_term(head_atom->args[i]);
-          }
-        }
+  // Keep the elements in the order in which they appear in the full universe.
+  // This also leaves out the query's constants that the program doesn't
+  // mention, so that the query is rejected as before.
+  struct TymTerms * terms = NULL;
+  struct TymTerms * terms_end = NULL;
+  for (struct TymTerms * cursor = adb->tdb->herbrand_universe; NULL != cursor; cursor = cursor->next) {
+    if (tym_term_database_member(cursor->term, tdb)) {
+      struct TymTerms * cell = tym_mk_term_cell(cursor->term, NULL);
+      if (NULL == terms) {
+        terms = cell;
+      } else {
+        terms_end->next = cell;
+      }
+      terms_end = cell;
+    }
+  }
+
+  // The query's variables need a non-empty universe to range over, even if the
+  // sliced program doesn't mention any constants.
+  struct TymUniverse * result =
+    tym_mk_universe((NULL == terms) ? adb->tdb->herbrand_universe : terms);
+  tym_shallow_free_terms(terms);
+  tym_free_term_database(tdb);
+  return result;
+}
+
+// Translates a predicate's clauses into the statements that characterise its
+// provability. Each call has its own buffer and its own TymSymGen, so
+// predicates can be translated at the same time.
+static void
+translate_predicate(void * arg)
+{
+  struct TymPredTranslation * tr = arg;
+  struct TymBufferInfo * outbuf = tym_mk_buffer(TYM_BUF_SIZE);
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res;
 
-        // Abstract the atom's parameters.
-        const struct TymFmla * head_fmla =
-          tym_mk_fmla_atom(TYM_STR_DUPLICATE(head_atom->predicate),
-              head_atom->arity, args);
+  TYM_DBG("no_bodies = %zu\n", tym_num_predicate_bodies(tr->predicate));
 
+  struct TymFmlas * fmlas = (struct TymFmlas *)tym_translate_bodies(tr->predicate->bodies, tr->adb);
 #if TYM_DEBUG
-        res = tym_fmla_str(head_fmla, outbuf);
-        assert(tym_is_ok_TymBufferWriteResult(res));
-        free(res);
-        TYM_DBG_BUFFER_PRINT(outbuf, "from")
+  tym_reset_buffer(outbuf);
+  struct TymFmlas * fmlas_c = fmlas;
+  while (NULL != fmlas_c) {
+    res = tym_fmla_str(fmlas_c->fmla, outbuf);
+    assert(tym_is_ok_TymBufferWriteResult(res));
+    fmlas_c = fmlas_c->next;
+  }
+  TYM_DBG_BUFFER_PRINT(outbuf, ">-")
 #endif
 
-        struct TymValuation ** val = malloc(sizeof *val);
-        *val = NULL;
-        if (NULL != abs_head_fmla) {
-          tym_free_fmla(abs_head_fmla);
+  struct TymFmlas * fmlas_cursor = fmlas;
+
+  if (NULL == tr->predicate->bodies) {
+    // "No bodies" means that the atom never appears as the head of a clause.
+
+    struct TymTerm ** var_args = NULL;
+
+    if (tr->predicate->arity > 0) {
+      var_args = malloc(sizeof *var_args * tr->predicate->arity);
+
+      for (size_t i = 0; i < tr->predicate->arity; i++) {
+        var_args[i] = tym_mk_term(TYM_VAR, tym_mk_new_var(tr->vg));
+      }
+    }
+
+    struct TymFmla * atom =
+      tym_mk_fmla_atom(TYM_STR_DUPLICATE(tr->predicate->predicate),
+        tr->predicate->arity, var_args);
+
+    res = tym_fmla_str(atom, outbuf);
+    assert(tym_is_ok_TymBufferWriteResult(res));
+    TYM_DBG_BUFFER_PRINT(outbuf, "bodyless")
+
+    struct TymStmt * pred =
+      tym_mk_stmt_pred(TYM_STR_DUPLICATE(tr->predicate->predicate),
+          tym_arguments_of_atom(tym_fmla_as_atom(atom)),
+          tym_mk_fmla_const(false));
+    tr->def = tym_split_stmt_pred(pred);
+    tr->pred = pred;
+
+    tym_free_fmla(atom);
+  } else {
+    const struct TymClauses * body_cursor = tr->predicate->bodies;
+    const struct TymFmla * abs_head_fmla = NULL;
+
+    while (NULL != body_cursor) {
+      TYM_DBG(">");
+
+      struct TymSymGen * vg_copy = tym_copy_sym_gen(tr->vg);
+
+      const struct TymAtom * head_atom = body_cursor->clause->head;
+      struct TymTerm ** args = NULL;
+
+      if (head_atom->arity > 0) {
+        args = malloc(sizeof *args * head_atom->arity);
+
+        for (size_t i = 0; i < head_atom->arity; i++) {
+          args[i] = tym_copy_term(head_atom->args[i]);
         }
-        abs_head_fmla = tym_mk_abstract_vars(head_fmla, vg_copy, val);
-        res = tym_fmla_str(abs_head_fmla, outbuf);
-        assert(tym_is_ok_TymBufferWriteResult(res));
-        free(res);
-        TYM_DBG_BUFFER_PRINT(outbuf, "to")
+      }
+
+      // Abstract the atom's parameters.
+      const struct TymFmla * head_fmla =
+        tym_mk_fmla_atom(TYM_STR_DUPLICATE(head_atom->predicate),
+            head_atom->arity, args);
 
 #if TYM_DEBUG
-        res = tym_valuation_str(*val, outbuf);
-        assert(tym_is_ok_TymBufferWriteResult(res));
-        if (0 == tym_val_of_TymBufferWriteResult(res)) {
-          TYM_DBG("  where: (no substitutions)\n");
-        } else {
-          TYM_DBG_BUFFER_PRINT(outbuf, "  where")
-        }
-        free(res);
+      res = tym_fmla_str(head_fmla, outbuf);
+      assert(tym_is_ok_TymBufferWriteResult(res));
+      TYM_DBG_BUFFER_PRINT(outbuf, "from")
 #endif
 
-        struct TymFmla * valuation_fmla = tym_translate_valuation(*val);
-        fmlas_cursor->fmla = tym_mk_fmla_and(fmlas_cursor->fmla, valuation_fmla);
-        struct TymTerms * ts = tym_filter_var_values(*val);
-        const struct TymFmla * quantified_fmla =
-          tym_mk_fmla_quants(FMLA_EX, ts, fmlas_cursor->fmla);
-        fmlas_cursor->fmla = tym_copy_fmla(quantified_fmla);
-        if (NULL != ts) {
-          tym_free_terms(ts);
-        }
-        tym_free_fmla(quantified_fmla);
+      struct TymValuation ** val = malloc(sizeof *val);
+      *val = NULL;
+      if (NULL != abs_head_fmla) {
+        tym_free_fmla(abs_head_fmla);
+      }
+      abs_head_fmla = tym_mk_abstract_vars(head_fmla, vg_copy, val);
+      res = tym_fmla_str(abs_head_fmla, outbuf);
+      assert(tym_is_ok_TymBufferWriteResult(res));
+      TYM_DBG_BUFFER_PRINT(outbuf, "to")
 
-        res = tym_fmla_str(fmlas_cursor->fmla, outbuf);
-        assert(tym_is_ok_TymBufferWriteResult(res));
-        free(res);
-        TYM_DBG_BUFFER_PRINT_ENCLOSE(outbuf, "  :|", "|")
+#if TYM_DEBUG
+      res = tym_valuation_str(*val, outbuf);
+      assert(tym_is_ok_TymBufferWriteResult(res));
+      if (0 == tym_val_of_TymBufferWriteResult(res)) {
+        TYM_DBG("  where: (no substitutions)\n");
+      } else {
+        TYM_DBG_BUFFER_PRINT(outbuf, "  where")
+      }
+#endif
 
-        tym_free_fmla(head_fmla);
-        if (NULL != *val) {
-          // i.e., the predicate isn't nullary.
-          tym_free_valuation(*val);
-        }
-        free(val);
-
-        body_cursor = body_cursor->next;
-        fmlas_cursor = fmlas_cursor->next;
-        if (NULL == body_cursor) {
-          struct TymSymGen * tmp = *vg;
-          *vg = vg_copy;
-          vg_copy = tmp;
-        }
-        tym_free_sym_gen(vg_copy);
+      struct TymFmla * valuation_fmla = tym_translate_valuation(*val);
+      fmlas_cursor->fmla = tym_mk_fmla_and(fmlas_cursor->fmla, valuation_fmla);
+      struct TymTerms * ts = tym_filter_var_values(*val);
+      const struct TymFmla * quantified_fmla =
+        tym_mk_fmla_quants(FMLA_EX, ts, fmlas_cursor->fmla);
+      fmlas_cursor->fmla = tym_copy_fmla(quantified_fmla);
+      if (NULL != ts) {
+        tym_free_terms(ts);
       }
+      tym_free_fmla(quantified_fmla);
 
-      struct TymFmla * fmla = tym_mk_fmla_ors((struct TymFmlas *)fmlas);
-      res = tym_fmla_str(fmla, outbuf);
+      res = tym_fmla_str(fmlas_cursor->fmla, outbuf);
       assert(tym_is_ok_TymBufferWriteResult(res));
-      free(res);
-      TYM_DBG_BUFFER_PRINT(outbuf, "pre-result")
+      TYM_DBG_BUFFER_PRINT_ENCLOSE(outbuf, "  :|", "|")
+
+      tym_free_fmla(head_fmla);
+      if (NULL != *val) {
+        // i.e., the predicate isn't nullary.
+        tym_free_valuation(*val);
+      }
+      free(val);
 
-      struct TymFmlaAtom * head = tym_fmla_as_atom(abs_head_fmla);
-      struct TymStmt * pred =
-        tym_mk_stmt_pred(TYM_STR_DUPLICATE(head->pred_name),
-            tym_arguments_of_atom(head),
-            fmla);
-      struct TymStmt * def = tym_split_stmt_pred(pred);
-      tym_strengthen_model(mdl, pred);
-      tym_strengthen_model(mdl, def);
-      tym_free_fmla(abs_head_fmla);
+      body_cursor = body_cursor->next;
+      fmlas_cursor = fmlas_cursor->next;
+      if (NULL == body_cursor) {
+        struct TymSymGen * tmp = tr->vg;
+        tr->vg = vg_copy;
+        vg_copy = tmp;
+      }
+      tym_free_sym_gen(vg_copy);
+    }
+
+    struct TymFmla * fmla = tym_mk_fmla_ors((struct TymFmlas *)fmlas);
+    res = tym_fmla_str(fmla, outbuf);
+    assert(tym_is_ok_TymBufferWriteResult(res));
+    TYM_DBG_BUFFER_PRINT(outbuf, "pre-result")
+
+    struct TymFmlaAtom * head = tym_fmla_as_atom(abs_head_fmla);
+    struct TymStmt * pred =
+      tym_mk_stmt_pred(TYM_STR_DUPLICATE(head->pred_name),
+          tym_arguments_of_atom(head),
+          fmla);
+    tr->def = tym_split_stmt_pred(pred);
+    tr->pred = pred;
+    tym_free_fmla(abs_head_fmla);
+  }
+
+  TYM_DBG("\n");
+  tym_free_buffer(outbuf);
+}
+
+struct TymModel *
+tym_translate_program(struct TymProgram * program, const struct TymProgram * query, struct TymSymGen ** vg, struct TymAtomDatabase * adb, bool plan_bodies, struct TymPool * pool)
+{
+  for (size_t i = 0; i < program->no_clauses; i++) {
+    (void)tym_clause_database_add(program->program[i], adb, NULL);
+  }
+  struct TymBufferInfo * outbuf = tym_mk_buffer(TYM_BUF_SIZE);
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res = tym_atom_database_str(adb, outbuf);
+  assert(tym_is_ok_TymBufferWriteResult(res));
+  TYM_DBG_BUFFER(outbuf, "clause database")
+
+
+  struct TymPredicates * preds_cursor = tym_atom_database_to_predicates(adb);
+
+  // 0. If we're given a query, then slice the program to the predicates in its
+  //    cone of influence: the others cannot affect the query's answers. Of
+  //    the facts that only the query uses, we keep those that match it.
+  struct TymUniverse * uni = NULL;
+  if (NULL == query) {
+    uni = tym_mk_universe(adb->tdb->herbrand_universe);
+  } else {
+    size_t no_preds = 0;
+    for (const struct TymPredicates * cursor = preds_cursor; NULL != cursor; cursor = cursor->next) {
+      no_preds++;
     }
+    struct TymCone * cone = mk_cone(query, adb, no_preds);
+    preds_cursor = slice_predicates(cone, preds_cursor, query);
+    free_cone(cone);
+    uni = slice_universe(preds_cursor, query, adb);
+  }
+
+  // 1. Generate prologue: universe sort, and its inhabitants.
+  struct TymModel * mdl = tym_mk_model(uni);
 
+#if TYM_DEBUG
+  tym_reset_buffer(outbuf);
+  res = tym_model_str(mdl, outbuf);
+  assert(tym_is_ok_TymBufferWriteResult(res));
+  TYM_DBG_BUFFER(outbuf, "model")
+#endif
+
+
+  // 2. Add axiom characterising the provability of all elements of the Hilbert base.
+  //    Predicates don't depend on each other's translation: each one takes
+  //    as many variable names as its arity, so we know where its names
+  //    start. If we're given a pool then they're translated as its tasks.
+  //    Either way their statements are added to the model in order.
+  size_t no_preds = 0;
+  for (const struct TymPredicates * cursor = preds_cursor; NULL != cursor; cursor = cursor->next) {
+    no_preds++;
+  }
+  struct TymPredTranslation * trs = malloc(sizeof *trs * (no_preds + 1));
+  assert(NULL != trs);
+  struct TymPoolGroup group = {.pending = 0};
+  size_t i = 0;
+  for (const struct TymPredicates * cursor = preds_cursor; NULL != cursor; cursor = cursor->next) {
+    trs[i] = (struct TymPredTranslation){.predicate = cursor->predicate,
+      .adb = plan_bodies ? adb : NULL,
+      .vg = tym_copy_sym_gen(*vg), .pred = NULL, .def = NULL};
+    (*vg)->index += cursor->predicate->arity;
+    if (NULL == pool) {
+      translate_predicate(&trs[i]);
+    } else {
+      tym_pool_submit(pool, &group, translate_predicate, &trs[i]);
+    }
+    i++;
+  }
+  if (NULL != pool) {
+    tym_pool_wait(pool, &group);
+  }
+
+  for (i = 0; i < no_preds; i++) {
+    tym_strengthen_model(mdl, trs[i].pred);
+    tym_strengthen_model(mdl, trs[i].def);
+    tym_free_sym_gen(trs[i].vg);
+  }
+  free(trs);
+
+  while (NULL != preds_cursor) {
     struct TymPredicates * pre_preds_cursor = preds_cursor;
     preds_cursor = preds_cursor->next;
+    free_narrowed(pre_preds_cursor->predicate, adb);
     free((void *)pre_preds_cursor);
-
-    TYM_DBG("\n");
   }
 
   tym_free_buffer(outbuf);
@@ -434,3 +882,787 @@ tym_order_statements(struct TymStmts * stmts)
     return declarations;
   }
 }
+
+static bool
+is_element(const struct TymGrounder * g, const TymStr * s)
+{
+  size_t mask = g->no_slots - 1;
+  size_t i = (size_t)tym_hash_str(tym_decode_str(s)) & mask;
+  while (NULL != g->elements[i]) {
+    if (tym_eq_str(s, g->elements[i])) {
+      return true;
+    }
+    i = (i + 1) & mask;
+  }
+  return false;
+}
+
+// Whether atom is an equality, distinctness or ordering constraint, rather
+// than an instance of one of the program's predicates.
+static bool
+is_builtin(const struct TymFmlaAtom * atom)
+{
+  return 0 == strcmp(tym_decode_str(atom->pred_name), tym_eqK) ||
+    0 == strcmp(tym_decode_str(atom->pred_name), tym_distinctK) ||
+    0 == strcmp(tym_decode_str(atom->pred_name), tym_bvuleK);
+}
+
+static TYM_HASH_VTYPE
+hash_atom(const struct TymFmlaAtom * atom)
+{
+  TYM_HASH_VTYPE h = tym_hash_str(tym_decode_str(atom->pred_name));
+  for (size_t i = 0; i < atom->arity; i++) {
+    h = 31 * h + tym_hash_str(tym_decode_str(atom->predargs[i]->identifier));
+  }
+  // Mix the high bits into the low ones, which are the ones we use to index
+  // the table, since atoms' arguments tend to differ only in a few characters.
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return h;
+}
+
+static bool
+eq_atom(const struct TymFmlaAtom * a1, const struct TymFmlaAtom * a2)
+{
+  if (a1->arity != a2->arity || !tym_eq_str(a1->pred_name, a2->pred_name)) {
+    return false;
+  }
+  for (size_t i = 0; i < a1->arity; i++) {
+    if (!tym_eq_str(a1->predargs[i]->identifier, a2->predargs[i]->identifier)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the slot that holds atom, or else the empty slot where it would go.
+static struct TymGroundAtom *
+find_atom(const struct TymGrounder * g, const struct TymFmlaAtom * atom)
+{
+  size_t mask = g->no_atom_slots - 1;
+  size_t i = (size_t)hash_atom(atom) & mask;
+  while (NULL != g->atoms[i].atom && !eq_atom(atom, g->atoms[i].atom)) {
+    i = (i + 1) & mask;
+  }
+  return &g->atoms[i];
+}
+
+static void
+record_atom(struct TymGrounder * g, const struct TymFmlaAtom * atom, bool value)
+{
+  if (2 * (g->no_atoms + 1) > g->no_atom_slots) {
+    struct TymGroundAtom * old_atoms = g->atoms;
+    size_t old_no_atom_slots = g->no_atom_slots;
+    g->no_atom_slots = (0 == old_no_atom_slots) ? 64 : 2 * old_no_atom_slots;
+    g->atoms = calloc(g->no_atom_slots, sizeof(*g->atoms));
+    assert(NULL != g->atoms);
+    for (size_t i = 0; i < old_no_atom_slots; i++) {
+      if (NULL != old_atoms[i].atom) {
+        *find_atom(g, old_atoms[i].atom) = old_atoms[i];
+      }
+    }
+    if (NULL != old_atoms) {
+      free(old_atoms);
+    }
+  }
+
+  struct TymGroundAtom * slot = find_atom(g, atom);
+  if (NULL == slot->atom) {
+    slot->atom = atom;
+    slot->value = value;
+    g->no_atoms++;
+  }
+}
+
+// Records the atoms that fmla, a ground axiom, asserts or denies outright.
+static void
+record_units(struct TymGrounder * g, const struct TymFmla * fmla)
+{
+  switch (fmla->kind) {
+  case FMLA_ATOM:
+    if (!is_builtin(fmla->param.atom)) {
+      record_atom(g, fmla->param.atom, true);
+    }
+    break;
+  case FMLA_NOT:
+    if (FMLA_ATOM == fmla->param.args[0]->kind &&
+        !is_builtin(fmla->param.args[0]->param.atom)) {
+      record_atom(g, fmla->param.args[0]->param.atom, false);
+    }
+    break;
+  case FMLA_AND:
+    for (size_t i = 0; NULL != fmla->param.args[i]; i++) {
+      record_units(g, fmla->param.args[i]);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+static bool
+mentions(const struct TymFmla * fmla, const TymStr * name)
+{
+  bool result = false;
+  switch (fmla->kind) {
+  case FMLA_CONST:
+    break;
+  case FMLA_ATOM:
+    for (size_t i = 0; !result && i < fmla->param.atom->arity; i++) {
+      result = tym_eq_str(fmla->param.atom->predargs[i]->identifier, name);
+    }
+    break;
+  case FMLA_NOT:
+    result = mentions(fmla->param.args[0], name);
+    break;
+  case FMLA_AND:
+  case FMLA_OR:
+  case FMLA_IF:
+  case FMLA_IFF:
+    for (size_t i = 0; !result && NULL != fmla->param.args[i]; i++) {
+      result = mentions(fmla->param.args[i], name);
+    }
+    break;
+  case FMLA_EX:
+  case FMLA_ALL:
+    result = !tym_eq_str(fmla->param.quant->bv, name) &&
+      mentions(fmla->param.quant->body, name);
+    break;
+  default:
+    assert(0);
+  }
+  return result;
+}
+
+static struct TymFmla *
+fold_not(struct TymFmla * sub)
+{
+  if (tym_fmla_is_const(sub)) {
+    bool value = tym_fmla_as_const(sub);
+    tym_free_fmla(sub);
+    return tym_mk_fmla_const(!value);
+  }
+  return tym_mk_fmla_not(sub);
+}
+
+// Simplifies "l => r" or "l <=> r" if either side is constant.
+static struct TymFmla *
+fold_implication(enum TymFmlaKind kind, struct TymFmla * l, struct TymFmla * r)
+{
+  assert(FMLA_IF == kind || FMLA_IFF == kind);
+  if (tym_fmla_is_const(l)) {
+    bool value = tym_fmla_as_const(l);
+    tym_free_fmla(l);
+    if (value) {
+      return r;
+    } else if (FMLA_IF == kind) {
+      tym_free_fmla(r);
+      return tym_mk_fmla_const(true);
+    } else {
+      return fold_not(r);
+    }
+  } else if (tym_fmla_is_const(r)) {
+    bool value = tym_fmla_as_const(r);
+    tym_free_fmla(r);
+    if (value && FMLA_IF == kind) {
+      tym_free_fmla(l);
+      return tym_mk_fmla_const(true);
+    } else {
+      return value ? l : fold_not(l);
+    }
+  }
+  return (FMLA_IF == kind) ? tym_mk_fmla_if(l, r) : tym_mk_fmla_iff(l, r);
+}
+
+// Decides equalities between elements, which are distinct from each other
+// whether the universe is encoded as a sort or a datatype, and atoms whose
+// values we know.
+static struct TymFmla *
+fold_atom(const struct TymGrounder * g, struct TymFmla * fmla)
+{
+  const struct TymFmlaAtom * atom = fmla->param.atom;
+  if (!is_builtin(atom)) {
+    if (0 < g->no_atoms) {
+      const struct TymGroundAtom * known = find_atom(g, atom);
+      if (NULL != known->atom) {
+        bool value = known->value;
+        tym_free_fmla(fmla);
+        return tym_mk_fmla_const(value);
+      }
+    }
+    return fmla;
+  } else if (2 != atom->arity ||
+      0 != strcmp(tym_decode_str(atom->pred_name), tym_eqK)) {
+    return fmla;
+  }
+
+  const TymStr * l = atom->predargs[0]->identifier;
+  const TymStr * r = atom->predargs[1]->identifier;
+  if (tym_eq_str(l, r)) {
+    tym_free_fmla(fmla);
+    return tym_mk_fmla_const(true);
+  } else if (is_element(g, l) && is_element(g, r)) {
+    tym_free_fmla(fmla);
+    return tym_mk_fmla_const(false);
+  }
+  return fmla;
+}
+
+// Looks for a conjunct "bv = t" or "t = bv" in body, in which case
+// "exists bv. body" is equivalent to body with t in place of bv.
+// NOTE we only ground quantifiers after their enclosing quantifiers were
+//      eliminated, so t cannot be a bound variable.
+static const TymStr *
+one_point(const struct TymFmla * body, const TymStr * bv)
+{
+  const struct TymFmlaAtom * atom;
+  const TymStr * result = NULL;
+  switch (body->kind) {
+  case FMLA_ATOM:
+    atom = body->param.atom;
+    if (2 == atom->arity &&
+        0 == strcmp(tym_decode_str(atom->pred_name), tym_eqK)) {
+      const TymStr * l = atom->predargs[0]->identifier;
+      const TymStr * r = atom->predargs[1]->identifier;
+      if (tym_eq_str(l, bv) && !tym_eq_str(r, bv)) {
+        result = r;
+      } else if (tym_eq_str(r, bv) && !tym_eq_str(l, bv)) {
+        result = l;
+      }
+    }
+    break;
+  case FMLA_AND:
+    for (size_t i = 0; NULL == result && NULL != body->param.args[i]; i++) {
+      result = one_point(body->param.args[i], bv);
+    }
+    break;
+  default:
+    break;
+  }
+  return result;
+}
+
+// Returns a simplified copy of fmla in which the free occurrences of var (if
+// it's not NULL) are replaced by val. Quantifiers are not expanded.
+static struct TymFmla *
+instantiate_fmla(const struct TymGrounder * g, const struct TymFmla * fmla, const TymStr * var, const TymStr * val)
+{
+  struct TymFmla * result = NULL;
+  struct TymFmlas * fmlas = NULL;
+  struct TymTerm ** args = NULL;
+  const struct TymFmlaAtom * atom;
+  size_t no_args = 0;
+  bool is_and;
+
+  switch (fmla->kind) {
+  case FMLA_CONST:
+    result = tym_mk_fmla_const(fmla->param.const_value);
+    break;
+  case FMLA_ATOM:
+    atom = fmla->param.atom;
+    if (atom->arity > 0) {
+      args = malloc(sizeof *args * atom->arity);
+      for (size_t i = 0; i < atom->arity; i++) {
+        if (NULL != var && tym_eq_str(atom->predargs[i]->identifier, var)) {
+          args[i] = tym_mk_term(TYM_CONST, TYM_STR_DUPLICATE(val));
+        } else {
+          args[i] = tym_copy_term(atom->predargs[i]);
+        }
+      }
+    }
+    result = fold_atom(g,
+        tym_mk_fmla_atom(TYM_STR_DUPLICATE(atom->pred_name), atom->arity, args));
+    break;
+  case FMLA_AND:
+  case FMLA_OR:
+    // A conjunct that's false (or a disjunct that's true) makes the rest
+    // redundant.
+    is_and = (FMLA_AND == fmla->kind);
+    while (NULL != fmla->param.args[no_args]) {
+      no_args++;
+    }
+    for (size_t i = no_args; i > 0 && NULL == result; i--) {
+      struct TymFmla * sub = instantiate_fmla(g, fmla->param.args[i - 1], var, val);
+      if (!tym_fmla_is_const(sub)) {
+        fmlas = tym_mk_fmla_cell(sub, fmlas);
+      } else if (is_and != tym_fmla_as_const(sub)) {
+        result = sub;
+      } else {
+        // tym_mk_fmla_ands and tym_mk_fmla_ors would drop it, but not free it.
+        tym_free_fmla(sub);
+      }
+    }
+    if (NULL != result) {
+      if (NULL != fmlas) {
+        tym_free_fmlas(fmlas);
+      }
+    } else {
+      result = is_and ? tym_mk_fmla_ands(fmlas) : tym_mk_fmla_ors(fmlas);
+    }
+    break;
+  case FMLA_NOT:
+    result = fold_not(instantiate_fmla(g, fmla->param.args[0], var, val));
+    break;
+  case FMLA_IF:
+  case FMLA_IFF:
+    assert(NULL == fmla->param.args[2]);
+    result = fold_implication(fmla->kind,
+        instantiate_fmla(g, fmla->param.args[0], var, val),
+        instantiate_fmla(g, fmla->param.args[1], var, val));
+    break;
+  case FMLA_EX:
+  case FMLA_ALL:
+    if (NULL != var && tym_eq_str(fmla->param.quant->bv, var)) {
+      // var is shadowed.
+      result = tym_copy_fmla(fmla);
+    } else {
+      result = instantiate_fmla(g, fmla->param.quant->body, var, val);
+      // The universe isn't empty, so quantifying over a constant formula
+      // doesn't change it.
+      if (!tym_fmla_is_const(result)) {
+        result = tym_mk_fmla_quant(fmla->kind,
+            TYM_STR_DUPLICATE(fmla->param.quant->bv), result);
+      }
+    }
+    break;
+  default:
+    assert(0);
+  }
+
+  return result;
+}
+
+// Returns a simplified copy of fmla in which the quantifiers are expanded into
+// conjunctions or disjunctions over the universe's elements. Outer quantifiers
+// are expanded before inner ones, so that inner ones are expanded in formulas
+// that were already simplified.
+static struct TymFmla *
+ground_fmla(const struct TymGrounder * g, const struct TymFmla * fmla)
+{
+  struct TymFmla * result = NULL;
+  struct TymFmlas * fmlas = NULL;
+  size_t no_args = 0;
+  bool is_and;
+  bool is_ex;
+
+  switch (fmla->kind) {
+  case FMLA_CONST:
+    result = tym_copy_fmla(fmla);
+    break;
+  case FMLA_ATOM:
+    result = fold_atom(g, tym_copy_fmla(fmla));
+    break;
+  case FMLA_AND:
+  case FMLA_OR:
+    is_and = (FMLA_AND == fmla->kind);
+    while (NULL != fmla->param.args[no_args]) {
+      no_args++;
+    }
+    for (size_t i = no_args; i > 0 && NULL == result; i--) {
+      struct TymFmla * sub = ground_fmla(g, fmla->param.args[i - 1]);
+      if (!tym_fmla_is_const(sub)) {
+        fmlas = tym_mk_fmla_cell(sub, fmlas);
+      } else if (is_and != tym_fmla_as_const(sub)) {
+        result = sub;
+      } else {
+        tym_free_fmla(sub);
+      }
+    }
+    if (NULL != result) {
+      if (NULL != fmlas) {
+        tym_free_fmlas(fmlas);
+      }
+    } else {
+      result = is_and ? tym_mk_fmla_ands(fmlas) : tym_mk_fmla_ors(fmlas);
+    }
+    break;
+  case FMLA_NOT:
+    result = fold_not(ground_fmla(g, fmla->param.args[0]));
+    break;
+  case FMLA_IF:
+  case FMLA_IFF:
+    assert(NULL == fmla->param.args[2]);
+    result = fold_implication(fmla->kind,
+        ground_fmla(g, fmla->param.args[0]),
+        ground_fmla(g, fmla->param.args[1]));
+    break;
+  case FMLA_EX:
+  case FMLA_ALL:
+    is_ex = (FMLA_EX == fmla->kind);
+    if (is_ex) {
+      const TymStr * t = one_point(fmla->param.quant->body, fmla->param.quant->bv);
+      if (NULL != t) {
+        struct TymFmla * inst =
+          instantiate_fmla(g, fmla->param.quant->body, fmla->param.quant->bv, t);
+        result = ground_fmla(g, inst);
+        tym_free_fmla(inst);
+        break;
+      }
+    }
+    for (size_t i = g->uni->cardinality; i > 0 && NULL == result; i--) {
+      struct TymFmla * inst = instantiate_fmla(g, fmla->param.quant->body,
+          fmla->param.quant->bv, g->uni->element[i - 1]);
+      struct TymFmla * sub = ground_fmla(g, inst);
+      tym_free_fmla(inst);
+      // A true disjunct (or a false conjunct) decides the quantifier.
+      if (!tym_fmla_is_const(sub)) {
+        fmlas = tym_mk_fmla_cell(sub, fmlas);
+      } else if (is_ex == tym_fmla_as_const(sub)) {
+        result = sub;
+      } else {
+        tym_free_fmla(sub);
+      }
+    }
+    if (NULL != result) {
+      if (NULL != fmlas) {
+        tym_free_fmlas(fmlas);
+      }
+    } else {
+      result = is_ex ? tym_mk_fmla_ors(fmlas) : tym_mk_fmla_ands(fmlas);
+    }
+    break;
+  default:
+    assert(0);
+  }
+
+  return result;
+}
+
+// Expands fmla over the values of consts, which aren't elements: the result
+// is the disjunction, over tuples of elements, of "consts = tuple and fmla",
+// where fmla is grounded after consts are replaced by the tuple. Disjuncts
+// that are false are dropped.
+static struct TymFmla *
+ground_consts(const struct TymGrounder * g, const struct TymFmla * fmla, const TymStr ** consts, size_t no_consts)
+{
+  if (0 == no_consts) {
+    return ground_fmla(g, fmla);
+  }
+
+  struct TymFmlas * fmlas = NULL;
+  for (size_t i = g->uni->cardinality; i > 0; i--) {
+    const TymStr * element = g->uni->element[i - 1];
+    struct TymFmla * inst = instantiate_fmla(g, fmla, consts[0], element);
+    struct TymFmla * sub = ground_consts(g, inst, consts + 1, no_consts - 1);
+    tym_free_fmla(inst);
+    if (tym_fmla_is_const(sub) && !tym_fmla_as_const(sub)) {
+      tym_free_fmla(sub);
+      continue;
+    }
+
+    struct TymFmla * eq = tym_mk_fmla_atom_varargs(TYM_CSTR_DUPLICATE(tym_eqK), 2,
+        tym_mk_term(TYM_CONST, TYM_STR_DUPLICATE(consts[0])),
+        tym_mk_term(TYM_CONST, TYM_STR_DUPLICATE(element)));
+    if (tym_fmla_is_const(sub)) {
+      tym_free_fmla(sub);
+      fmlas = tym_mk_fmla_cell(eq, fmlas);
+    } else {
+      fmlas = tym_mk_fmla_cell(tym_mk_fmla_ands(
+            tym_mk_fmla_cell(eq, tym_mk_fmla_cell(sub, NULL))), fmlas);
+    }
+  }
+  return tym_mk_fmla_ors(fmlas);
+}
+
+// Replaces the model's axioms with quantifier-free ones, by expanding their
+// quantifiers over the universe's elements. The ground atoms that the axioms
+// assert or deny outright are then replaced by their values throughout, which
+// leaves the solver with much less to do than the instances themselves would.
+// Lastly the query's axioms -- those that were added to the model ahead of
+// program_stmts -- are grounded, and are also expanded over the values of the
+// query's constants, so that most of the expansion can be evaluated away.
+// The model must have been made with "grounded" set, so that the universe
+// wasn't given a (quantified) domain-closure axiom by
+// tym_statementise_universe.
+void
+tym_ground_model(struct TymModel * mdl, const struct TymStmts * program_stmts)
+{
+  assert(mdl->grounded);
+  struct TymUniverse * uni = mdl->universe;
+  if (0 == uni->cardinality) {
+    return;
+  }
+
+  struct TymGrounder g = {.uni = uni, .no_slots = 1, .atoms = NULL,
+    .no_atom_slots = 0, .no_atoms = 0};
+  while (g.no_slots < 2 * uni->cardinality) {
+    g.no_slots *= 2;
+  }
+  g.elements = calloc(g.no_slots, sizeof(*g.elements));
+  assert(NULL != g.elements);
+  for (size_t i = 0; i < uni->cardinality; i++) {
+    size_t mask = g.no_slots - 1;
+    size_t j = (size_t)tym_hash_str(tym_decode_str(uni->element[i])) & mask;
+    while (NULL != g.elements[j]) {
+      j = (j + 1) & mask;
+    }
+    g.elements[j] = uni->element[i];
+  }
+
+  size_t no_stmts = 0;
+  for (struct TymStmts * cursor = mdl->stmts; NULL != cursor; cursor = cursor->next) {
+    no_stmts++;
+  }
+  const TymStr ** consts = malloc(sizeof(*consts) * no_stmts);
+  const TymStr ** mentioned = malloc(sizeof(*mentioned) * no_stmts);
+  // Axioms that were superseded, but whose atoms are still in g.atoms.
+  const struct TymFmla ** spent = malloc(sizeof(*spent) * no_stmts);
+  assert(NULL != consts && NULL != mentioned && NULL != spent);
+  size_t no_consts = 0;
+  size_t no_spent = 0;
+  for (struct TymStmts * cursor = mdl->stmts; NULL != cursor; cursor = cursor->next) {
+    struct TymStmt * stmt = cursor->stmt;
+    if (TYM_STMT_CONST_DEF == stmt->kind &&
+        NULL == stmt->param.const_def->params &&
+        0 == strcmp(tym_decode_str(stmt->param.const_def->ty), TYM_UNIVERSE_TY) &&
+        !is_element(&g, stmt->param.const_def->const_name)) {
+      consts[no_consts++] = stmt->param.const_def->const_name;
+    }
+  }
+
+  // Pass 0 grounds the program's axioms and records their unit atoms; pass 1
+  // replaces those atoms by their values in the same axioms; pass 2 grounds
+  // the query's axioms.
+  for (int pass = 0; pass < 3; pass++) {
+    bool in_query = true;
+    for (struct TymStmts * cursor = mdl->stmts; NULL != cursor; cursor = cursor->next) {
+      if (program_stmts == cursor) {
+        in_query = false;
+      }
+      struct TymStmt * stmt = cursor->stmt;
+      if (TYM_STMT_AXIOM != stmt->kind || (2 == pass) != in_query) {
+        continue;
+      }
+
+      const struct TymFmla * axiom = stmt->param.axiom;
+      size_t no_mentioned = 0;
+      for (size_t i = 0; i < no_consts && 2 == pass; i++) {
+        if (mentions(axiom, consts[i])) {
+          mentioned[no_mentioned++] = consts[i];
+        }
+      }
+
+      switch (pass) {
+      case 0:
+        stmt->param.axiom = ground_consts(&g, axiom, mentioned, no_mentioned);
+        tym_free_fmla(axiom);
+        record_units(&g, stmt->param.axiom);
+        break;
+      case 1:
+        stmt->param.axiom = instantiate_fmla(&g, axiom, NULL, NULL);
+        spent[no_spent++] = axiom;
+        break;
+      default:
+        stmt->param.axiom = ground_consts(&g, axiom, mentioned, no_mentioned);
+        tym_free_fmla(axiom);
+        break;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < no_spent; i++) {
+    tym_free_fmla(spent[i]);
+  }
+  free(spent);
+  free(consts);
+  free(mentioned);
+  if (NULL != g.atoms) {
+    free(g.atoms);
+  }
+  free(g.elements);
+}
+
+// Whether a formula is free of quantifiers, and of atoms over a predicate.
+static bool
+test_folded(const struct TymFmla * fmla, const char * predicate)
+{
+  bool result = true;
+  switch (fmla->kind) {
+  case FMLA_CONST:
+    break;
+  case FMLA_ATOM:
+    result = 0 != strcmp(predicate, tym_decode_str(fmla->param.atom->pred_name));
+    break;
+  case FMLA_NOT:
+  case FMLA_AND:
+  case FMLA_OR:
+  case FMLA_IF:
+  case FMLA_IFF:
+    for (size_t i = 0; result && NULL != fmla->param.args[i]; i++) {
+      result = test_folded(fmla->param.args[i], predicate);
+    }
+    break;
+  case FMLA_EX:
+  case FMLA_ALL:
+    result = false;
+    break;
+  default:
+    assert(0);
+  }
+  return result;
+}
+
+void
+tym_test_translate(void)
+{
+  printf("***test_translate***\n");
+  struct TymTerms * terms =
+    tym_mk_term_cell(tym_mk_term(TYM_CONST, TYM_CSTR_DUPLICATE("a")), NULL);
+  terms = tym_mk_term_cell(tym_mk_term(TYM_CONST, TYM_CSTR_DUPLICATE("b")), terms);
+  struct TymModel * mdl = tym_mk_model(tym_mk_universe(terms));
+  tym_free_terms(terms);
+  mdl->grounded = true;
+  tym_statementise_universe(mdl);
+
+  // forall X. (X = a <=> p(X))
+  struct TymFmla * fmla = tym_mk_fmla_quant(FMLA_ALL, TYM_CSTR_DUPLICATE("X"),
+      tym_mk_fmla_iff(
+        tym_mk_fmla_atom_varargs(TYM_CSTR_DUPLICATE(tym_eqK), 2,
+          tym_mk_term(TYM_VAR, TYM_CSTR_DUPLICATE("X")),
+          tym_mk_term(TYM_CONST, TYM_CSTR_DUPLICATE("a"))),
+        tym_mk_fmla_atom_varargs(TYM_CSTR_DUPLICATE("p"), 1,
+          tym_mk_term(TYM_VAR, TYM_CSTR_DUPLICATE("X")))));
+  tym_strengthen_model(mdl, tym_mk_stmt_axiom(fmla));
+
+  // The query p(c0).
+  const struct TymStmts * program_stmts = mdl->stmts;
+  tym_strengthen_model(mdl, tym_mk_stmt_const(TYM_CSTR_DUPLICATE("c0"),
+        mdl->universe, TYM_CSTR_DUPLICATE(TYM_UNIVERSE_TY)));
+  tym_strengthen_model(mdl,
+      tym_mk_stmt_axiom(tym_mk_fmla_atom_varargs(TYM_CSTR_DUPLICATE("p"), 1,
+          tym_mk_term(TYM_CONST, TYM_CSTR_DUPLICATE("c0")))));
+
+  tym_ground_model(mdl, program_stmts);
+
+  struct TymBufferInfo * outbuf = tym_mk_buffer(TYM_BUF_SIZE);
+  struct TYM_LIFTED_TYPE_NAME(TymBufferWriteResult) res = tym_model_str(mdl, outbuf);
+  assert(tym_is_ok_TymBufferWriteResult(res));
+  TYM_DBG_BUFFER(outbuf, "grounded model")
+
+  // The axiom about p is folded away, since its instances are decided by
+  // the universe's elements, and the query is reduced to c0 = a.
+  bool reduced_query = false;
+  for (const struct TymStmts * cursor = mdl->stmts; NULL != cursor; cursor = cursor->next) {
+    if (TYM_STMT_AXIOM != cursor->stmt->kind) {
+      continue;
+    }
+    const struct TymFmla * axiom = cursor->stmt->param.axiom;
+    assert(test_folded(axiom, "p"));
+    if (FMLA_ATOM == axiom->kind &&
+        0 == strcmp(tym_eqK, tym_decode_str(axiom->param.atom->pred_name))) {
+      assert(!reduced_query);
+      assert(2 == axiom->param.atom->arity);
+      assert(0 == strcmp("c0", tym_decode_str(axiom->param.atom->predargs[0]->identifier)));
+      assert(0 == strcmp("a", tym_decode_str(axiom->param.atom->predargs[1]->identifier)));
+      reduced_query = true;
+    }
+  }
+  assert(reduced_query);
+
+  tym_free_model(mdl);
+
+  // Slicing p(X) :- q(X). q(a). r(b). to the query p(X) leaves out r and b.
+  struct TymClauses * cls =
+    tym_mk_clause_cell(tym_mk_clause(tym_test_atom("p", 1, "X"), 1,
+          tym_mk_atom_cell(tym_test_atom("q", 1, "X"), NULL)),
+      tym_mk_clause_cell(tym_mk_clause(tym_test_atom("q", 1, "a"), 0, NULL),
+        tym_mk_clause_cell(tym_mk_clause(tym_test_atom("r", 1, "b"), 0, NULL), NULL)));
+  struct TymProgram * program = tym_mk_program(3, cls);
+  struct TymProgram * query = tym_mk_program(1,
+      tym_mk_clause_cell(tym_mk_clause(tym_test_atom("p", 1, "X"), 0, NULL), NULL));
+
+  struct TymSymGen ** vg = malloc(sizeof *vg);
+  *vg = tym_mk_sym_gen(TYM_CSTR_DUPLICATE("V"));
+  struct TymAtomDatabase * adb = tym_mk_atom_database();
+  mdl = tym_translate_program(program, query, vg, adb, false, NULL);
+
+  assert(1 == mdl->universe->cardinality);
+  assert(0 == strcmp("a", tym_decode_str(mdl->universe->element[0])));
+  for (const struct TymStmts * cursor = mdl->stmts; NULL != cursor; cursor = cursor->next) {
+    assert(TYM_STMT_CONST_DEF != cursor->stmt->kind ||
+        0 != strcmp("r", tym_decode_str(cursor->stmt->param.const_def->const_name)));
+  }
+
+  tym_reset_buffer(outbuf);
+  res = tym_model_str(mdl, outbuf);
+  assert(tym_is_ok_TymBufferWriteResult(res));
+  TYM_DBG_BUFFER(outbuf, "sliced model")
+  tym_free_buffer(outbuf);
+
+  tym_free_model(mdl);
+  tym_free_atom_database(adb);
+  tym_free_program(query);
+  tym_free_program(program);
+
+  // Slicing q(a). q(b). r(b). to the query q(b) only keeps the fact q(b),
+  // which is found through q's fact index, so a drops out of the universe.
+  cls =
+    tym_mk_clause_cell(tym_mk_clause(tym_test_atom("q", 1, "a"), 0, NULL),
+      tym_mk_clause_cell(tym_mk_clause(tym_test_atom("q", 1, "b"), 0, NULL),
+        tym_mk_clause_cell(tym_mk_clause(tym_test_atom("r", 1, "b"), 0, NULL), NULL)));
+  program = tym_mk_program(3, cls);
+  query = tym_mk_program(1,
+      tym_mk_clause_cell(tym_mk_clause(tym_test_atom("q", 1, "b"), 0, NULL), NULL));
+  adb = tym_mk_atom_database();
+  mdl = tym_translate_program(program, query, vg, adb, false, NULL);
+
+  assert(1 == mdl->universe->cardinality);
+  assert(0 == strcmp("b", tym_decode_str(mdl->universe->element[0])));
+  const TymStr * q_name = TYM_CSTR_DUPLICATE("q");
+  struct TymPredicate * q_pred = tym_atom_database_find_pred(q_name, adb);
+  tym_free_str(q_name);
+  assert(NULL != q_pred && NULL != q_pred->fact_index);
+  assert(2 == q_pred->no_facts);
+  const TymStr * a_name = TYM_CSTR_DUPLICATE("a");
+  const struct TymClauses * facts = tym_predicate_facts_at(q_pred, 0, a_name);
+  tym_free_str(a_name);
+  assert(NULL != facts && NULL == facts->next);
+  assert(0 == strcmp("a", tym_decode_str(facts->clause->head->args[0]->identifier)));
+
+  tym_free_model(mdl);
+  tym_free_atom_database(adb);
+  tym_free_program(query);
+  tym_free_program(program);
+
+  // Translating p(X) :- q(X). q(a). r(b). s(X) :- r(X). s(X) :- p(X). as
+  // tasks of a pool gives the same model, and uses the same variable names,
+  // as translating it in one thread.
+  const char * models[2];
+  size_t indices[2];
+  struct TymPool * pool = tym_mk_pool(3);
+  for (size_t k = 0; k < 2; k++) {
+    cls =
+      tym_mk_clause_cell(tym_mk_clause(tym_test_atom("p", 1, "X"), 1,
+            tym_mk_atom_cell(tym_test_atom("q", 1, "X"), NULL)),
+        tym_mk_clause_cell(tym_mk_clause(tym_test_atom("q", 1, "a"), 0, NULL),
+          tym_mk_clause_cell(tym_mk_clause(tym_test_atom("r", 1, "b"), 0, NULL),
+            tym_mk_clause_cell(tym_mk_clause(tym_test_atom("s", 1, "X"), 1,
+                  tym_mk_atom_cell(tym_test_atom("r", 1, "X"), NULL)),
+              tym_mk_clause_cell(tym_mk_clause(tym_test_atom("s", 1, "X"), 1,
+                    tym_mk_atom_cell(tym_test_atom("p", 1, "X"), NULL)), NULL)))));
+    program = tym_mk_program(5, cls);
+    adb = tym_mk_atom_database();
+    (*vg)->index = 0;
+    mdl = tym_translate_program(program, NULL, vg, adb, true, (0 == k) ? NULL : pool);
+    indices[k] = (*vg)->index;
+
+    outbuf = tym_mk_buffer(TYM_BUF_SIZE);
+    res = tym_model_str(mdl, outbuf);
+    assert(tym_is_ok_TymBufferWriteResult(res));
+    models[k] = strdup(tym_buffer_contents(outbuf));
+    tym_free_buffer(outbuf);
+
+    tym_free_model(mdl);
+    tym_free_atom_database(adb);
+    tym_free_program(program);
+  }
+  tym_free_pool(pool);
+  assert(4 == indices[0] && indices[0] == indices[1]);
+  assert(0 == strcmp(models[0], models[1]));
+  free_const(models[0]);
+  free_const(models[1]);
+
+  tym_free_sym_gen(*vg);
+  free(vg);
+}
@@ -23,4 +23,4 @@
 
 OUTFILE=$1
 gcc ${CFLAGS} -c ${OUTFILE}.c
-gcc ${CFLAGS} -ltym -o ${OUTFILE} ${TYM}/tym_runtime.o ${OUTFILE}.o
+gcc ${CFLAGS} -ltym -o ${OUTFILE} ${TYM}/tym_runtime.o ${OUTFILE}.o -lpthread